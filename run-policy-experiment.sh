@@ -0,0 +1,22 @@
+# Compare the replacement policies on shifting workloads
+# Usage: ./run-policy-experiment.sh <SF> <queries per epoch>
+for dist in Zipf Norm;
+do
+    for policy in SemanticAware GDSF ARC LFUSegmented LRUSegmented;
+    do
+        if [ "$dist" == "Zipf" ]; then
+            dist_input=$'Zipf\n1.5'
+        else
+            dist_input="Norm"
+        fi
+        ./main${1}.bin > policy-${dist}-${policy}.log <<EOT
+dist
+${dist_input}
+3
+${2}
+${policy}
+6
+EOT
+        grep "RESULT- Cumulated Time\|Replacement traffic" policy-${dist}-${policy}.log
+    done
+done
@@ -113,6 +113,30 @@ int create_relation_fk(int*& keys, int*& vals, int num_tuples, const int maxid)
   return 0;
 }
 
+/**
+ * Generate a column of values drawn uniformly from [min_val, max_val].
+ * The range predicate [min_val, min_val + sel * (max_val - min_val + 1) - 1]
+ * then selects a fraction sel of the tuples.
+ */
+int
+create_column_uniform(int*& vals, int num_tuples, int min_val, int max_val)
+{
+  check_seed();
+
+  vals = (int*)_mm_malloc(num_tuples * sizeof(int), 256);
+
+  if (!vals) {
+    perror("out of memory");
+    return -1;
+  }
+
+  for (int i = 0; i < num_tuples; i++) {
+    vals[i] = min_val + (int) RAND_RANGE(max_val - min_val + 1);
+  }
+
+  return 0;
+}
+
 /*
 typedef struct rand_state_64 {
   uint64_t num[313];
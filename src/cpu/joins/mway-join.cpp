@@ -0,0 +1,675 @@
+#include "types.h"
+#include "generator.h"
+#include "barrier.h"
+#include "cpu_mapping.h"
+#include "rdtsc.h"
+#include <pthread.h>
+#include <immintrin.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+
+#include "utils/cpu_utils.h"
+
+using namespace std;
+
+#define CACHE_LINE_SIZE 64
+
+#ifdef KEY_8B
+#error "mway-join packs a 32-bit key and payload into one 64-bit sort item"
+#endif
+
+#ifndef BARRIER_ARRIVE
+/** barrier wait macro */
+#define BARRIER_ARRIVE(B,RV)                            \
+    RV = pthread_barrier_wait(B);                       \
+    if(RV !=0 && RV != PTHREAD_BARRIER_SERIAL_THREAD){  \
+        printf("Couldn't wait on barrier\n");           \
+        exit(EXIT_FAILURE);                             \
+    }
+#endif
+
+/** checks malloc() result */
+#ifndef MALLOC_CHECK
+#define MALLOC_CHECK(M)                                                 \
+    if(!M){                                                             \
+        printf("[ERROR] MALLOC_CHECK: %s : %d\n", __FILE__, __LINE__);  \
+        perror(": malloc() failed!\n");                                 \
+        exit(EXIT_FAILURE);                                             \
+    }
+#endif
+
+/* keys sampled per thread to choose the key ranges of the threads */
+#define MWAY_SAMPLES 64
+
+static void *
+alloc_aligned(size_t size)
+{
+    void * ret;
+    int rv;
+    rv = posix_memalign((void**)&ret, CACHE_LINE_SIZE, size);
+
+    if (rv) {
+        perror("alloc_aligned() failed: out of memory");
+        return 0;
+    }
+
+    return ret;
+}
+
+/*
+ * Tuples are sorted as one 64-bit item, key in the upper half. The sign bit
+ * is flipped so that the signed AVX2 comparison orders unsigned keys.
+ */
+typedef int64_t item_t;
+
+#define ITEM_BIAS ((item_t) 0x8000000000000000ULL)
+#define ITEM_MAX  ((item_t) 0x7FFFFFFFFFFFFFFFLL)
+
+static inline item_t
+to_item(tuple_t t)
+{
+  return (item_t) (((uint64_t) t.key << 32) | t.payload) ^ ITEM_BIAS;
+}
+
+static inline uint32_t
+item_key(item_t x)
+{
+  return (uint32_t) ((uint64_t) (x ^ ITEM_BIAS) >> 32);
+}
+
+static inline uint32_t
+item_payload(item_t x)
+{
+  return (uint32_t) (x ^ ITEM_BIAS);
+}
+
+/* smallest item with the given key */
+static inline item_t
+key_item(uint64_t key)
+{
+  return (item_t) (key << 32) ^ ITEM_BIAS;
+}
+
+#ifdef __AVX2__
+
+static inline __m256i
+vmin(__m256i a, __m256i b)
+{
+  return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+static inline __m256i
+vmax(__m256i a, __m256i b)
+{
+  return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+/* sorts a bitonic sequence of 4 items in a register */
+static inline __m256i
+bitonic_sort4(__m256i v)
+{
+  __m256i t = _mm256_permute4x64_epi64(v, 0x4E); /* 2 3 0 1 */
+  v = _mm256_blend_epi32(vmin(v, t), vmax(v, t), 0xF0);
+  t = _mm256_permute4x64_epi64(v, 0xB1);         /* 1 0 3 2 */
+  return _mm256_blend_epi32(vmin(v, t), vmax(v, t), 0xCC);
+}
+
+/* merges two sorted registers, a gets the lower and b the upper 4 items */
+static inline void
+bitonic_merge4(__m256i & a, __m256i & b)
+{
+  b = _mm256_permute4x64_epi64(b, 0x1B);         /* reverse */
+  __m256i lo = vmin(a, b);
+  __m256i hi = vmax(a, b);
+  a = bitonic_sort4(lo);
+  b = bitonic_sort4(hi);
+}
+
+/* sorts 16 items in registers into two sorted runs of 8 */
+static inline void
+sort16(item_t * p)
+{
+  __m256i r0 = _mm256_load_si256((__m256i *) p);
+  __m256i r1 = _mm256_load_si256((__m256i *) (p + 4));
+  __m256i r2 = _mm256_load_si256((__m256i *) (p + 8));
+  __m256i r3 = _mm256_load_si256((__m256i *) (p + 12));
+  __m256i t;
+
+  /* sorting network on the columns */
+  t = vmin(r0, r1); r1 = vmax(r0, r1); r0 = t;
+  t = vmin(r2, r3); r3 = vmax(r2, r3); r2 = t;
+  t = vmin(r0, r2); r2 = vmax(r0, r2); r0 = t;
+  t = vmin(r1, r3); r3 = vmax(r1, r3); r1 = t;
+  t = vmin(r1, r2); r2 = vmax(r1, r2); r1 = t;
+
+  /* transpose, every register is a sorted run of 4 */
+  __m256i t0 = _mm256_unpacklo_epi64(r0, r1);
+  __m256i t1 = _mm256_unpackhi_epi64(r0, r1);
+  __m256i t2 = _mm256_unpacklo_epi64(r2, r3);
+  __m256i t3 = _mm256_unpackhi_epi64(r2, r3);
+  r0 = _mm256_permute2x128_si256(t0, t2, 0x20);
+  r1 = _mm256_permute2x128_si256(t1, t3, 0x20);
+  r2 = _mm256_permute2x128_si256(t0, t2, 0x31);
+  r3 = _mm256_permute2x128_si256(t1, t3, 0x31);
+
+  bitonic_merge4(r0, r1);
+  bitonic_merge4(r2, r3);
+
+  _mm256_store_si256((__m256i *) p, r0);
+  _mm256_store_si256((__m256i *) (p + 4), r1);
+  _mm256_store_si256((__m256i *) (p + 8), r2);
+  _mm256_store_si256((__m256i *) (p + 12), r3);
+}
+
+/*
+ * Merges the sorted runs a and b into out with the bitonic network, 4 items
+ * per step. na and nb are multiples of 4.
+ */
+static void
+merge_avx(const item_t * a, uint64_t na, const item_t * b, uint64_t nb, item_t * out)
+{
+  if (na == 0 || nb == 0) {
+    memcpy(out, na ? a : b, (na + nb) * sizeof(item_t));
+    return;
+  }
+
+  const item_t * ea = a + na;
+  const item_t * eb = b + nb;
+  __m256i va = _mm256_loadu_si256((__m256i *) a);
+  __m256i vb = _mm256_loadu_si256((__m256i *) b);
+  a += 4;
+  b += 4;
+
+  while (1) {
+    bitonic_merge4(va, vb);
+    _mm256_storeu_si256((__m256i *) out, va);
+    out += 4;
+    va = vb;
+    /* the next 4 come from the run with the smaller head */
+    if (a < ea && (b >= eb || *a <= *b)) {
+      vb = _mm256_loadu_si256((__m256i *) a);
+      a += 4;
+    } else if (b < eb) {
+      vb = _mm256_loadu_si256((__m256i *) b);
+      b += 4;
+    } else {
+      break;
+    }
+  }
+  _mm256_storeu_si256((__m256i *) out, va);
+}
+
+/*
+ * Sorts n items, n a multiple of 16. Blocks of 16 are sorted in registers,
+ * then runs are merged pairwise between in and tmp. Returns the buffer that
+ * holds the result.
+ */
+static item_t *
+sort_run(item_t * in, item_t * tmp, uint64_t n)
+{
+  for (uint64_t i = 0; i < n; i += 16)
+    sort16(in + i);
+
+  for (uint64_t run = 8; run < n; run *= 2) {
+    for (uint64_t i = 0; i < n; i += 2 * run) {
+      uint64_t na = min(run, n - i);
+      uint64_t nb = min(run, n - i - na);
+      merge_avx(in + i, na, in + i + na, nb, tmp + i);
+    }
+    swap(in, tmp);
+  }
+  return in;
+}
+
+#else
+
+static item_t *
+sort_run(item_t * in, item_t * tmp, uint64_t n)
+{
+  sort(in, in + n);
+  return in;
+}
+
+#endif
+
+/* heap of run cursors ordered by their head item */
+static inline void
+heap_down(item_t ** pos, int * heap, int size, int i)
+{
+  while (1) {
+    int l = 2 * i + 1, r = l + 1, m = i;
+    if (l < size && *pos[heap[l]] < *pos[heap[m]]) m = l;
+    if (r < size && *pos[heap[r]] < *pos[heap[m]]) m = r;
+    if (m == i) return;
+    swap(heap[i], heap[m]);
+    i = m;
+  }
+}
+
+/*
+ * Merges the m sorted runs [pos[i], end[i]) into out in one pass.
+ * Returns the number of items written.
+ */
+static uint64_t
+multiway_merge(item_t ** pos, item_t ** end, int m, item_t * out)
+{
+  int heap[m];
+  int size = 0;
+  item_t * start = out;
+
+  for (int i = 0; i < m; i++)
+    if (pos[i] < end[i]) heap[size++] = i;
+  for (int i = size / 2 - 1; i >= 0; i--)
+    heap_down(pos, heap, size, i);
+
+  while (size > 0) {
+    int i = heap[0];
+    *out++ = *pos[i]++;
+    if (pos[i] == end[i])
+      heap[0] = heap[--size];
+    heap_down(pos, heap, size, 0);
+  }
+  return out - start;
+}
+
+static inline uint32_t item_key(const tuple_t & t) { return t.key; }
+static inline uint32_t item_payload(const tuple_t & t) { return t.payload; }
+
+/* first position in the sorted run with a key >= key, num if none */
+static uint64_t
+run_lower_bound(const item_t * run, uint64_t num, uint64_t key)
+{
+  if (key > UINT32_MAX)
+    return num;
+  return lower_bound(run, run + num, key_item(key)) - run;
+}
+
+static uint64_t
+run_lower_bound(const tuple_t * run, uint64_t num, uint64_t key)
+{
+  if (key > UINT32_MAX)
+    return num;
+  return lower_bound(run, run + num, key,
+      [](const tuple_t & t, uint64_t k) { return t.key < k; }) - run;
+}
+
+/* joins sorted R and S, both may contain duplicate keys */
+template<bool is_checksum, typename T>
+static void
+merge_join(const T * r, uint64_t nr, const T * s, uint64_t ns,
+           uint64_t & matches, uint64_t & checksum)
+{
+  uint64_t i = 0, j = 0;
+  while (i < nr && j < ns) {
+    uint32_t kr = item_key(r[i]);
+    uint32_t ks = item_key(s[j]);
+    if (kr < ks) {
+      ++i;
+    } else if (ks < kr) {
+      ++j;
+    } else {
+      uint64_t ie = i;
+      while (ie < nr && item_key(r[ie]) == kr) ++ie;
+      for (; j < ns && item_key(s[j]) == kr; ++j) {
+        matches += ie - i;
+        if (is_checksum)
+          for (uint64_t k = i; k < ie; ++k)
+            checksum += item_payload(s[j]) + item_payload(r[k]);
+      }
+      i = ie;
+    }
+  }
+}
+
+struct mway_shared_t {
+  item_t **         runR;       /* sorted run of every thread */
+  item_t **         runS;
+  uint64_t *        numR;       /* items in the runs, without padding */
+  uint64_t *        numS;
+  uint64_t *        splitter;   /* thread t joins the keys in [splitter[t], splitter[t+1]) */
+  relation_t *      R;
+  relation_t *      S;
+  int               nthreads;
+  int               presorted;  /* inputs are ordered by key: no sort and no merge */
+  pthread_barrier_t * barrier;
+  struct timeval    start, sorted, merged, end;
+};
+typedef struct mway_shared_t mway_shared_t;
+
+struct mway_arg_t {
+  int         tid;
+  uint64_t      matches;
+  uint64_t      checksum;
+  tuple_t *       relR;
+  tuple_t *     relS;
+  uint64_t        numR;
+  uint64_t        numS;
+  mway_shared_t * shared;
+};
+typedef struct mway_arg_t mway_arg_t;
+
+/* converts a chunk of tuples to items padded to 16 and sorts them */
+static item_t *
+sort_chunk(const tuple_t * rel, uint64_t num, item_t ** buffers)
+{
+  uint64_t padded = (num + 15) & ~15ULL;
+  item_t * in = (item_t *) alloc_aligned(padded * sizeof(item_t) + CACHE_LINE_SIZE);
+  item_t * tmp = (item_t *) alloc_aligned(padded * sizeof(item_t) + CACHE_LINE_SIZE);
+  MALLOC_CHECK(in);
+  MALLOC_CHECK(tmp);
+
+  for (uint64_t i = 0; i < num; ++i)
+    in[i] = to_item(rel[i]);
+  for (uint64_t i = num; i < padded; ++i)
+    in[i] = ITEM_MAX; /* sorts last, cut off by num */
+
+  buffers[0] = in;
+  buffers[1] = tmp;
+  return sort_run(in, tmp, padded);
+}
+
+/* key ranges of the threads from equally spaced samples of the sorted S runs */
+static void
+choose_splitters(mway_shared_t * sh)
+{
+  const int nthreads = sh->nthreads;
+  vector<uint32_t> sample;
+
+  sh->splitter[0] = 0;
+  sh->splitter[nthreads] = (uint64_t) UINT32_MAX + 1;
+
+  if (sh->presorted) {
+    const tuple_t * s = sh->S->tuples;
+    for (int t = 1; t < nthreads; ++t)
+      sh->splitter[t] = s[sh->S->num_tuples * t / nthreads].key;
+    return;
+  }
+
+  for (int t = 0; t < nthreads; ++t)
+    for (uint64_t i = 0; i < MWAY_SAMPLES && sh->numS[t] > 0; ++i)
+      sample.push_back(item_key(sh->runS[t][sh->numS[t] * i / MWAY_SAMPLES]));
+  sort(sample.begin(), sample.end());
+
+  for (int t = 1; t < nthreads; ++t)
+    sh->splitter[t] = sample.empty() ? 0 : sample[sample.size() * t / nthreads];
+}
+
+/* merges the parts of all runs in [lo, hi) into one freshly allocated run */
+static item_t *
+merge_range(item_t ** runs, uint64_t * nums, int nruns, uint64_t lo, uint64_t hi, uint64_t & num)
+{
+  item_t * pos[nruns];
+  item_t * end[nruns];
+
+  num = 0;
+  for (int i = 0; i < nruns; ++i) {
+    pos[i] = runs[i] + run_lower_bound(runs[i], nums[i], lo);
+    end[i] = runs[i] + run_lower_bound(runs[i], nums[i], hi);
+    num += end[i] - pos[i];
+  }
+
+  item_t * out = (item_t *) alloc_aligned(num * sizeof(item_t) + CACHE_LINE_SIZE);
+  MALLOC_CHECK(out);
+  multiway_merge(pos, end, nruns, out);
+  return out;
+}
+
+/*
+ * One thread of the m-way sort-merge join:
+ * 1. sort the own chunk of R and S (AVX2 bitonic sort and merge),
+ * 2. thread 0 samples S to cut the key domain into one range per thread,
+ * 3. multiway merge the parts of all runs in the own key range,
+ * 4. merge join the own key range.
+ * With presorted inputs 1 and 3 are skipped and the relations are joined
+ * in place.
+ */
+template<bool is_checksum>
+void *
+mway_join_thread(void * args)
+{
+  int rv;
+  uint64_t matches = 0;
+  uint64_t checksum = 0;
+
+  mway_arg_t * arg = (mway_arg_t *) args;
+  mway_shared_t * sh = arg->shared;
+  const int tid = arg->tid;
+  const int nthreads = sh->nthreads;
+  item_t * bufR[2] = {NULL, NULL};
+  item_t * bufS[2] = {NULL, NULL};
+  item_t * mergedR = NULL;
+  item_t * mergedS = NULL;
+
+  BARRIER_ARRIVE(sh->barrier, rv);
+  if (tid == 0)
+    gettimeofday(&sh->start, NULL);
+
+  if (!sh->presorted) {
+    sh->runR[tid] = sort_chunk(arg->relR, arg->numR, bufR);
+    sh->runS[tid] = sort_chunk(arg->relS, arg->numS, bufS);
+    sh->numR[tid] = arg->numR;
+    sh->numS[tid] = arg->numS;
+  }
+
+  BARRIER_ARRIVE(sh->barrier, rv);
+  if (tid == 0) {
+    gettimeofday(&sh->sorted, NULL);
+    choose_splitters(sh);
+  }
+  BARRIER_ARRIVE(sh->barrier, rv);
+
+  const uint64_t lo = sh->splitter[tid];
+  const uint64_t hi = sh->splitter[tid + 1];
+
+  if (sh->presorted) {
+    const tuple_t * r = sh->R->tuples;
+    const tuple_t * s = sh->S->tuples;
+    const uint64_t nr = sh->R->num_tuples;
+    const uint64_t ns = sh->S->num_tuples;
+    uint64_t r0 = run_lower_bound(r, nr, lo), r1 = run_lower_bound(r, nr, hi);
+    uint64_t s0 = run_lower_bound(s, ns, lo), s1 = run_lower_bound(s, ns, hi);
+
+    BARRIER_ARRIVE(sh->barrier, rv);
+    if (tid == 0)
+      gettimeofday(&sh->merged, NULL);
+
+    merge_join<is_checksum>(r + r0, r1 - r0, s + s0, s1 - s0, matches, checksum);
+  } else {
+    uint64_t nr, ns;
+    mergedR = merge_range(sh->runR, sh->numR, nthreads, lo, hi, nr);
+    mergedS = merge_range(sh->runS, sh->numS, nthreads, lo, hi, ns);
+
+    /* the runs are read by all threads until here */
+    BARRIER_ARRIVE(sh->barrier, rv);
+    if (tid == 0)
+      gettimeofday(&sh->merged, NULL);
+    free(bufR[0]); free(bufR[1]);
+    free(bufS[0]); free(bufS[1]);
+
+    merge_join<is_checksum>(mergedR, nr, mergedS, ns, matches, checksum);
+    free(mergedR);
+    free(mergedS);
+  }
+
+  arg->matches = matches;
+  arg->checksum = checksum;
+
+  BARRIER_ARRIVE(sh->barrier, rv);
+  if (tid == 0)
+    gettimeofday(&sh->end, NULL);
+  return 0;
+}
+
+/*
+ * MWAY: m-way sort-merge join
+ * both relations are sorted (unless presorted), range partitioned on the key
+ * by a multiway merge and merge joined, keys of R may repeat
+ *
+ * This is a benchmark only, gpudb has no merge join operator. gpudb loads the
+ * LINEORDERSORT columns, but they are ordered on one foreign key while a star
+ * query probes up to four dimensions per row. Its dimension tables are arrays
+ * of dim_len slots indexed by HASH(key, dim_len, min_key), i.e. key - min_key
+ * (crystal/join.cuh), so a probe is one load and the build only fills the
+ * array. A merge cursor would gain nothing over that, and it would serialize
+ * the segment groups that the CPU and GPU pipelines process in parallel.
+ */
+template<bool is_checksum>
+join_result_t
+MWAY(relation_t * R, relation_t * S, int nThreads, int presorted)
+{
+  int rv;
+  pthread_t tid[nThreads];
+  pthread_attr_t attr;
+  pthread_barrier_t barrier;
+  cpu_set_t set;
+  mway_arg_t args[nThreads];
+  mway_shared_t shared;
+  item_t * runR[nThreads];
+  item_t * runS[nThreads];
+  uint64_t numR_run[nThreads];
+  uint64_t numS_run[nThreads];
+  uint64_t splitter[nThreads + 1];
+  uint64_t checksum = 0;
+  uint64_t matches = 0;
+  uint64_t numR_per_thr = 0;
+  uint64_t numS_per_thr = 0;
+  uint64_t offsetR = 0;
+  uint64_t offsetS = 0;
+
+  const uint64_t numR = R->num_tuples;
+  const uint64_t numS = S->num_tuples;
+
+    rv = pthread_barrier_init(&barrier, NULL, nThreads);
+    if(rv != 0){
+        printf("[ERROR] Couldn't create the barrier\n");
+        exit(EXIT_FAILURE);
+    }
+
+  shared.runR = runR;
+  shared.runS = runS;
+  shared.numR = numR_run;
+  shared.numS = numS_run;
+  shared.splitter = splitter;
+  shared.R = R;
+  shared.S = S;
+  shared.nthreads = nThreads;
+  shared.presorted = presorted;
+  shared.barrier = &barrier;
+
+  pthread_attr_init(&attr);
+
+  numR_per_thr = numR / nThreads;
+  numS_per_thr = numS / nThreads;
+
+  for (int i = 0; i < nThreads; ++i)
+  {
+    int cpu_idx = get_cpu_id(i);
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu_idx, &set);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &set);
+
+    args[i].relR = R->tuples + offsetR;
+    args[i].relS = S->tuples + offsetS;
+
+    args[i].numR = (i == nThreads-1) ? (numR-numR_per_thr*i):numR_per_thr;
+    args[i].numS = (i == nThreads-1) ? (numS-numS_per_thr*i):numS_per_thr;
+
+    args[i].tid = i;
+    args[i].shared = &shared;
+
+    offsetR += numR_per_thr;
+    offsetS += numS_per_thr;
+
+    rv= pthread_create(&tid[i], &attr, mway_join_thread<is_checksum>, (void*)&args[i]);
+    if (rv)
+    {
+      printf("[ERROR] return code from pthread_create() is %d\n", rv);
+      exit(1);
+    }
+  }
+
+  for (int i = 0; i < nThreads; ++i)
+    pthread_join(tid[i], NULL);
+
+  for (int i = 0; i < nThreads; ++i)
+  {
+    matches += args[i].matches;
+    checksum += args[i].checksum;
+  }
+
+  pthread_barrier_destroy(&barrier);
+
+  join_result_t res = {matches, checksum,
+                       (uint64_t) diff_usec(&shared.start, &shared.end),
+                       (uint64_t) diff_usec(&shared.start, &shared.merged),
+                       (uint64_t) diff_usec(&shared.merged, &shared.end)};
+  return res;
+}
+
+template join_result_t MWAY<false>(relation_t * R, relation_t * S, int nThreads, int presorted);
+template join_result_t MWAY<true>(relation_t * R, relation_t * S, int nThreads, int presorted);
+
+
+int main(int argc, char** argv) {
+  int nthreads = 8;
+  int r_size   = 16 * (1 << 20);
+  int s_size   = 256 * (1 << 20);
+  int num_trials = 1;
+  int sorted = 0;
+
+  // Initialize command line
+  CommandLineArgs args(argc, argv);
+  args.GetCmdLineArgument("n", s_size);
+  args.GetCmdLineArgument("d", r_size);
+  args.GetCmdLineArgument("t", num_trials);
+  args.GetCmdLineArgument("threads", nthreads);
+  args.GetCmdLineArgument("sorted", sorted);
+
+  // Print usage
+  if (args.CheckCmdLineFlag("help"))
+  {
+    printf("%s "
+      "[--n=<num fact>] "
+      "[--d=<num dim>] "
+      "[--t=<num trials>] "
+      "[--threads=<num threads>] "
+      "[--sorted=<1: inputs ordered by key, join without sorting>] "
+      "\n", argv[0]);
+    exit(0);
+  }
+
+  relation_t relR;
+  relation_t relS;
+
+  cout << "RSize " << r_size << " SSize " << s_size << endl;
+
+  relR.tuples = (tuple_t*) alloc_aligned(r_size * sizeof(tuple_t));
+  relS.tuples = (tuple_t*) alloc_aligned(s_size * sizeof(tuple_t));
+
+  create_relation_pk(&relR, r_size);
+
+  create_relation_fk(&relS, s_size, r_size);
+
+  if (sorted) {
+    auto by_key = [](const tuple_t & a, const tuple_t & b) { return a.key < b.key; };
+    sort(relR.tuples, relR.tuples + r_size, by_key);
+    sort(relS.tuples, relS.tuples + s_size, by_key);
+  }
+
+  for (int t = 0; t < num_trials; t++) {
+    join_result_t res = MWAY<true>(&relR, &relS, nthreads, sorted);
+    cout << "Checksum: " << res.checksum << endl;
+    cout << "{\"matches\":" << res.matches
+         << ",\"time_sort_merge\":" << res.part_usec / 1000.0
+         << ",\"time_join\":" << res.join_usec / 1000.0
+         << ",\"time_total\":" << res.time_usec / 1000.0 << "}" << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file    cache_info.h
+ *
+ * @brief  Detects the data cache hierarchy and the TLB sizes of the machine
+ *         at runtime: caches from sysfs (sysconf as fallback), TLB entries
+ *         from CPUID leaf 0x18 on Intel and 0x80000005/6 on AMD.
+ *
+ */
+#ifndef CACHE_INFO_H
+#define CACHE_INFO_H
+
+#include <stdio.h>  /* FILE, fopen */
+#include <stdlib.h> /* atol */
+#include <string.h> /* strncmp */
+#include <unistd.h> /* sysconf */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>  /* __get_cpuid, __cpuid_count */
+#endif
+
+/**
+ * @defgroup CacheInfo Cache and TLB Detection
+ * @{
+ */
+
+typedef struct cache_info_t cache_info_t;
+
+/** sizes in bytes, TLB sizes in entries for 4KB pages, 0 if unknown */
+struct cache_info_t {
+    long l1d_size;
+    long l2_size;
+    long l3_size;
+    long line_size;
+    long l1_dtlb_entries;
+    long l2_tlb_entries;
+};
+
+/** reads a line of a sysfs file, returns 0 on failure */
+static int
+sysfs_read(const char * path, char * buf, int len)
+{
+    FILE * f = fopen(path, "r");
+    if(f == NULL)
+        return 0;
+    int ok = (fgets(buf, len, f) != NULL);
+    fclose(f);
+    return ok;
+}
+
+/** parses sizes like "32K", "1024K" or "32M" */
+static long
+parse_size(const char * s)
+{
+    char * end;
+    long v = strtol(s, &end, 10);
+    if(*end == 'K' || *end == 'k')
+        v <<= 10;
+    else if(*end == 'M' || *end == 'm')
+        v <<= 20;
+    return v;
+}
+
+/** data and unified caches of cpu0 from /sys/devices/system/cpu/cpu0/cache */
+static void
+detect_caches_sysfs(cache_info_t * info)
+{
+    char path[128], buf[64];
+    for(int idx = 0; idx < 16; idx++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+        if(!sysfs_read(path, buf, sizeof(buf)))
+            break;
+        int level = atoi(buf);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", idx);
+        if(!sysfs_read(path, buf, sizeof(buf)) || strncmp(buf, "Instruction", 11) == 0)
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", idx);
+        if(!sysfs_read(path, buf, sizeof(buf)))
+            continue;
+        long size = parse_size(buf);
+
+        if(level == 1) info->l1d_size = size;
+        else if(level == 2) info->l2_size = size;
+        else if(level == 3) info->l3_size = size;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/coherency_line_size", idx);
+        if(level == 1 && sysfs_read(path, buf, sizeof(buf)))
+            info->line_size = atol(buf);
+    }
+}
+
+static void
+detect_caches_sysconf(cache_info_t * info)
+{
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    if(info->l1d_size <= 0) info->l1d_size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    if(info->l2_size <= 0) info->l2_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if(info->l3_size <= 0) info->l3_size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if(info->line_size <= 0) info->line_size = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+}
+
+/** 4KB-page TLB entries from CPUID */
+static void
+detect_tlb_cpuid(cache_info_t * info)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid(0, &eax, &ebx, &ecx, &edx))
+        return;
+    unsigned int max_leaf = eax;
+    int intel = (ebx == 0x756e6547); /* "Genu" */
+
+    if(intel && max_leaf >= 0x18) {
+        /* deterministic address translation parameters */
+        __cpuid_count(0x18, 0, eax, ebx, ecx, edx);
+        unsigned int max_sub = eax;
+        for(unsigned int sub = 0; sub <= max_sub; sub++) {
+            __cpuid_count(0x18, sub, eax, ebx, ecx, edx);
+            unsigned int type  = edx & 0x1f;        /* 1 data, 2 instr, 3 unified */
+            unsigned int level = (edx >> 5) & 0x7;
+            if(type == 0 || type == 2 || !(ebx & 0x1)) /* no 4KB pages */
+                continue;
+            long entries = (long) (ebx >> 16) * ecx; /* ways * sets */
+            if(level == 1 && info->l1_dtlb_entries <= 0)
+                info->l1_dtlb_entries = entries;
+            else if(level == 2 && info->l2_tlb_entries <= 0)
+                info->l2_tlb_entries = entries;
+        }
+        return;
+    }
+
+    __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+    if(eax >= 0x80000006) {
+        __get_cpuid(0x80000005, &eax, &ebx, &ecx, &edx);
+        info->l1_dtlb_entries = (ebx >> 16) & 0xff;
+        __get_cpuid(0x80000006, &eax, &ebx, &ecx, &edx);
+        info->l2_tlb_entries = (ebx >> 16) & 0xfff;
+    }
+#endif
+}
+
+/**
+ * Detects caches and TLBs, anything unknown gets the defaults of
+ * prj_params.h (L1_CACHE_SIZE, CACHE_LINE_SIZE) or of a Skylake core.
+ */
+static cache_info_t
+detect_cache_info()
+{
+    cache_info_t info;
+    memset(&info, 0, sizeof(info));
+
+    detect_caches_sysfs(&info);
+    detect_caches_sysconf(&info);
+    detect_tlb_cpuid(&info);
+
+    if(info.l1d_size <= 0) info.l1d_size = L1_CACHE_SIZE;
+    if(info.line_size <= 0) info.line_size = CACHE_LINE_SIZE;
+    if(info.l2_size <= 0) info.l2_size = 256 << 10;
+    if(info.l3_size <= 0) info.l3_size = info.l2_size;
+    if(info.l1_dtlb_entries <= 0) info.l1_dtlb_entries = 64;
+    if(info.l2_tlb_entries <= 0) info.l2_tlb_entries = 1536;
+
+    return info;
+}
+
+/** @} */
+
+#endif /* CACHE_INFO_H */
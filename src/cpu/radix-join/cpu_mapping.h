@@ -292,7 +292,6 @@ get_cpu_id(int thread_id)
 #endif
     }
 
-    cout << cpumapping[thread_id % max_threads] << endl;
     return cpumapping[thread_id % max_threads];
 }
 
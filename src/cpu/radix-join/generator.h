@@ -201,4 +201,59 @@ create_relation_fk(relation_t *relation, int64_t num_tuples, const int64_t maxid
   return 0;
 }
 
+/**
+ * Create a foreign key relation with keys in [1,maxid] drawn from a Zipf
+ * distribution with the given factor, 0 is uniform. The rank of a key is
+ * assigned randomly, so the frequent keys are spread over the key range.
+ * relation must have been allocated
+ */
+int
+create_relation_zipf(relation_t *relation, int64_t num_tuples,
+                     const int64_t maxid, double zipf_factor)
+{
+    int64_t i;
+
+    check_seed();
+
+    relation->num_tuples = num_tuples;
+
+    if (!relation->tuples) {
+        perror("memory must be allocated first");
+        return -1;
+    }
+
+    /* cumulative probability of the ranks */
+    double * cdf = (double *) malloc(maxid * sizeof(double));
+    double sum = 0;
+    for (i = 0; i < maxid; i++) {
+        sum += 1.0 / pow((double) (i + 1), zipf_factor);
+        cdf[i] = sum;
+    }
+
+    /* key of every rank */
+    relation_t ranks;
+    ranks.num_tuples = maxid;
+    ranks.tuples = (tuple_t *) malloc(maxid * sizeof(tuple_t));
+    random_unique_gen(&ranks);
+
+    for (i = 0; i < num_tuples; i++) {
+        double u = RAND_RANGE(sum);
+        int64_t lo = 0, hi = maxid - 1;
+        while (lo < hi) {
+            int64_t mid = (lo + hi) / 2;
+            if (cdf[mid] < u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        relation->tuples[i].key = ranks.tuples[lo].key;
+        relation->tuples[i].payload = i + 1;
+    }
+
+    free(ranks.tuples);
+    free(cdf);
+
+    return 0;
+}
+
 #endif
@@ -58,11 +58,17 @@
 
 /** thresholds for skewed partitions in 3-phase parallel join */
 #ifndef SKEW_HANDLING
-#define SKEW_HANDLING 0
+#define SKEW_HANDLING 1
 #endif
 #define THRESHOLD1(NTHR) (NTHR*L1_CACHE_TUPLES)
 #define THRESHOLD2(NTHR) (NTHR*NTHR*L1_CACHE_TUPLES)
 
+/** a pass-1 partition is skewed when it holds more than 1/SKEW_FACTOR of the
+ *  tuples a thread gets on average, and more than THRESHOLD1 */
+#ifndef SKEW_FACTOR
+#define SKEW_FACTOR 4
+#endif
+
 /** }*/
 
 
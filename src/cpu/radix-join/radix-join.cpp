@@ -16,6 +16,7 @@
 // #include "Utils.h"
 // // #include "parallel_radix_join.h"
 #include "prj_params.h"         /* constant parameters */
+#include "cache_info.h"         /* detect_cache_info */
 #include "task_queue.h"         /* task_queue_* */
 #include "cpu_mapping.h"        /* get_cpu_id */
 #include "rdtsc.h"              /* startTimer, stopTimer */
@@ -23,9 +24,9 @@
 // #include "perf_counters.h"      /* PCM_x */
 // #endif
 
-#include "barrier.h"            /* pthread_barrier_* */
 // #include "affinity.h"           /* pthread_attr_setaffinity_np */
-#include "generator.h"          /* numa_localize() */
+#include "generator.h"          /* create_relation_pk, create_relation_fk */
+#include "../cpu_utils.h"       /* CommandLineArgs */
 // #ifdef VTUNE_PROFILE
 // #include "ittnotify.h"
 // #endif
@@ -37,16 +38,6 @@ using namespace std;
 
 /** \internal */
 
-#ifndef BARRIER_ARRIVE
-/** barrier wait macro */
-#define BARRIER_ARRIVE(B,RV)                            \
-    RV = pthread_barrier_wait(B);                       \
-    if(RV !=0 && RV != PTHREAD_BARRIER_SERIAL_THREAD){  \
-        printf("Couldn't wait on barrier\n");           \
-        exit(EXIT_FAILURE);                             \
-    }
-#endif
-
 /** checks malloc() result */
 #ifndef MALLOC_CHECK
 #define MALLOC_CHECK(M)                                                 \
@@ -80,33 +71,6 @@ using namespace std;
 
 #define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
 
-#ifdef SYNCSTATS
-#define SYNC_TIMERS_START(A, TID)               \
-    do {                                        \
-        uint64_t tnow;                          \
-        startTimer(&tnow);                      \
-        A->localtimer.sync1[0]      = tnow;     \
-        A->localtimer.sync1[1]      = tnow;     \
-        A->localtimer.sync3         = tnow;     \
-        A->localtimer.sync4         = tnow;     \
-        A->localtimer.finish_time   = tnow;     \
-        if(TID == 0) {                          \
-            A->globaltimer->sync1[0]    = tnow; \
-            A->globaltimer->sync1[1]    = tnow; \
-            A->globaltimer->sync3       = tnow; \
-            A->globaltimer->sync4       = tnow; \
-            A->globaltimer->finish_time = tnow; \
-        }                                       \
-    } while(0)
-
-#define SYNC_TIMER_STOP(T) stopTimer(T)
-#define SYNC_GLOBAL_STOP(T, TID) if(TID==0){ stopTimer(T); }
-#else
-#define SYNC_TIMERS_START(A, TID)
-#define SYNC_TIMER_STOP(T)
-#define SYNC_GLOBAL_STOP(T, TID)
-#endif
-
 /** Debug msg logging method */
 #define DEBUG 0
 #if DEBUG
@@ -132,27 +96,36 @@ static uint64_t PADDING_TUPLES;
 /** @warning This padding must be allocated at the end of relation */
 static uint64_t RELATION_PADDING;
 
+/** pass-1 uses software write-combining buffers, see radix_scatter_swwc() */
+#ifdef USE_SWWC_OPTIMIZED_PART
+static int USE_SWWC_PART = 1;
+#else
+static int USE_SWWC_PART = 0;
+#endif
+
 typedef struct arg_t  arg_t;
 typedef struct part_t part_t;
-typedef struct synctimer_t synctimer_t;
+typedef struct prj_sync_t prj_sync_t;
 typedef struct join_result_t join_result_t;
 typedef join_result_t (*JoinFunction)(const relation_t * const,
                                 const relation_t * const,
                                 relation_t * const, uint64_t);
 
-#ifdef SYNCSTATS
-/** holds syncronization timing stats if configured with --enable-syncstats */
-struct synctimer_t {
-    /** Barrier for computation of thread-local histogram */
-    uint64_t sync1[3]; /* for rel R and for rel S */
-    /** Barrier for end of radix partit. pass-1 */
-    uint64_t sync3;
-    /** Barrier before join (build-probe) begins */
-    uint64_t sync4;
-    /** Finish time */
-    uint64_t finish_time;
+/**
+ * Countdowns shared by all threads of a join. Each one sits on its own cache
+ * line; start, histogram and partition count the threads that have not
+ * reached the phase yet, pending counts the pass-1 tasks not yet created
+ * plus the tasks not yet finished.
+ */
+struct prj_sync_t {
+    int64_t start       __attribute__((aligned(CACHE_LINE_SIZE)));
+    int64_t histogram   __attribute__((aligned(CACHE_LINE_SIZE)));
+    int64_t partition   __attribute__((aligned(CACHE_LINE_SIZE)));
+    int64_t pending     __attribute__((aligned(CACHE_LINE_SIZE)));
+    /* full cache lines of the SW-buffers written, for R and S */
+    int64_t flushR      __attribute__((aligned(CACHE_LINE_SIZE)));
+    int64_t flushS      __attribute__((aligned(CACHE_LINE_SIZE)));
 };
-#endif
 
 /** holds the arguments passed to each thread */
 struct arg_t {
@@ -169,13 +142,12 @@ struct arg_t {
     uint32_t totalS;
     int      ratio_holes;
 
-    task_queue_t *      join_queue;
-    task_queue_t *      part_queue;
-#if SKEW_HANDLING
-    task_queue_t *      skew_queue;
-    task_t **           skewtask;
-#endif
-    pthread_barrier_t * barrier;
+    tuple_t *  baseR;    /* start of relR/relS, the chunks above are per thread */
+    tuple_t *  baseS;
+
+    task_deque_t *      deques;     /* one per thread, indexed by my_tid */
+    task_queue_t *      task_pool;  /* task_t slots of this thread */
+    prj_sync_t *        sync;
     JoinFunction        join_function;
     uint64_t result;
     uint32_t my_tid;
@@ -187,12 +159,6 @@ struct arg_t {
     uint64_t       timer1, timer2, timer3;
     struct timeval start, end;
   struct timeval part_end;
-#ifdef SYNCSTATS
-    /** Thread local timers : */
-    synctimer_t localtimer;
-    /** Global synchronization timers, only filled in by thread-0 */
-    synctimer_t * globaltimer;
-#endif
 } __attribute__((aligned(CACHE_LINE_SIZE)));
 
 /** holds arguments passed for partitioning */
@@ -208,6 +174,7 @@ struct part_t {
     uint32_t   D;
     int        relidx;  /* 0: R, 1: S */
     uint32_t   padding;
+    int64_t *  flush;   /* countdown of radix_scatter_swwc() */
 } __attribute__((aligned(CACHE_LINE_SIZE)));
 
 static void *
@@ -225,6 +192,29 @@ alloc_aligned(size_t size)
     return ret;
 }
 
+/** spins until another thread changes *C to a value <= 0 */
+static
+void
+countdown_spin(int64_t * c)
+{
+    uint32_t spins = 0;
+    while(__atomic_load_n(c, __ATOMIC_ACQUIRE) > 0) {
+        _mm_pause();
+        /* give up the core when there are more threads than cpus */
+        if(++spins % 1024 == 0)
+            sched_yield();
+    }
+}
+
+/** arrives at a countdown and waits until all threads did */
+static
+void
+countdown_wait(int64_t * c)
+{
+    __atomic_sub_fetch(c, 1, __ATOMIC_ACQ_REL);
+    countdown_spin(c);
+}
+
 /** \endinternal */
 
 /**
@@ -288,7 +278,8 @@ array_join(const relation_t * const R,
 {
   const uint64_t numR = R->num_tuples;
   const uint64_t numS = S->num_tuples;
-    uint64_t range = (totalNumR * R->ratio_holes)>>NUM_RADIX_BITS;
+    /* keys are at most totalNumR * ratio_holes, +1 for the highest one */
+    uint64_t range = ((totalNumR * R->ratio_holes)>>NUM_RADIX_BITS) + 1;
   uint64_t N = range;
   uint64_t matches = 0;
   uint64_t checksum = 0;
@@ -365,14 +356,15 @@ prefetch(void * addr)
  * Kim et al. The difference is that it does not compute
  * prefix-sum, instead the sum (offset in the code) is computed iteratively.
  *
- * @warning This method puts padding between clusters, see
- * radix_cluster_nopadding for the one without padding.
+ * @warning This method puts padding tuples between clusters, outRel needs
+ * room for fanOut * padding tuples more than inRel.
  *
  * @param outRel [out] result of the partitioning
  * @param inRel [in] input relation
  * @param hist [out] number of tuples in each partition
  * @param R cluster bits
  * @param D radix bits per pass
+ * @param padding tuples between clusters
  * @returns tuples per partition.
  */
 static
@@ -381,7 +373,8 @@ radix_cluster(relation_t * outRel,
               relation_t * inRel,
               uint32_t * hist,
               unsigned int R,
-              unsigned int D)
+              unsigned int D,
+              uint32_t padding)
 {
     uint32_t i;
     uint32_t M = ((1u << D) - 1u) << R;
@@ -404,7 +397,7 @@ radix_cluster(relation_t * outRel,
         /* dst[i]      = outRel->tuples + offset; */
         /* determine the beginning of each partitioning by adding some
            padding to avoid L1 conflict misses during scatter. */
-        dst[i] = offset + i * SMALL_PADDING_TUPLES;
+        dst[i] = offset + i * padding;
         offset += hist[i];
     }
 
@@ -486,33 +479,37 @@ radix_cluster(relation_t * outRel,
 /**
  * This function implements the radix clustering of a given input
  * relations. The relations to be clustered are defined in task_t and after
- * clustering, each partition pair is added to the join_queue to be joined.
+ * clustering, each partition pair is pushed to the deque of the calling
+ * thread as a join task, so that it is joined while still in the cache
+ * unless another thread steals it first.
  *
  * @param task description of the relation to be partitioned
- * @param join_queue task queue to add join tasks after clustering
+ * @param args arguments of the calling thread
  */
 static
 void serial_radix_partition(task_t * const task,
-                            task_queue_t * join_queue,
+                            arg_t * const args,
                             const int R, const int D)
 {
     uint32_t offsetR = 0, offsetS = 0;
     const size_t fanOut = 1u << D;  /*(NUM_RADIX_BITS / NUM_PASSES);*/
     uint32_t * outputR, * outputS;
+    int64_t ntasks = 0;
 
     outputR = (uint32_t*)calloc(fanOut+1, sizeof(uint32_t));
     outputS = (uint32_t*)calloc(fanOut+1, sizeof(uint32_t));
-    /* TODO: measure the effect of memset() */
-    /* memset(outputR, 0, fanOut * sizeof(int32_t)); */
-    radix_cluster(&task->tmpR, &task->relR, outputR, R, D);
+    radix_cluster(&task->tmpR, &task->relR, outputR, R, D, SMALL_PADDING_TUPLES);
+    radix_cluster(&task->tmpS, &task->relS, outputS, R, D, SMALL_PADDING_TUPLES);
 
-    /* memset(outputS, 0, fanOut * sizeof(int32_t)); */
-    radix_cluster(&task->tmpS, &task->relS, outputS, R, D);
+    for(unsigned int i = 0; i < fanOut; i++)
+        ntasks += (outputR[i] > 0 && outputS[i] > 0);
+    /* announce the new tasks before the parent task is marked done */
+    __atomic_add_fetch(&args->sync->pending, ntasks, __ATOMIC_RELAXED);
 
-    /* task_t t; */
     for(unsigned int i = 0; i < fanOut; i++) {
         if(outputR[i] > 0 && outputS[i] > 0) {
-            task_t * t = task_queue_get_slot_atomic(join_queue);
+            task_t * t = task_queue_get_slot(args->task_pool);
+            t->kind = TASK_JOIN;
             t->relR.num_tuples = outputR[i];
             t->relR.tuples = task->tmpR.tuples + offsetR
                              + i * SMALL_PADDING_TUPLES;
@@ -529,8 +526,7 @@ void serial_radix_partition(task_t * const task,
                              + i * SMALL_PADDING_TUPLES;
             offsetS += outputS[i];
 
-            /* task_queue_copy_atomic(join_queue, &t); */
-            task_queue_add_atomic(join_queue, t);
+            task_deque_push(&args->deques[args->my_tid], t);
         }
         else {
             offsetR += outputR[i];
@@ -541,42 +537,208 @@ void serial_radix_partition(task_t * const task,
     free(outputS);
 }
 
+/**
+ * @defgroup Skew Skewed Partitions
+ * A pass-1 partition that is much larger than the others would keep one
+ * thread busy long after the others finished. Its S side is cut into one
+ * chunk per thread. With two passes every chunk is partitioned by its own
+ * task, R by another one, and the last of these tasks creates the join
+ * tasks of all pairs of R cluster and S chunk cluster, so R is shared by
+ * all chunks. With one pass, every chunk is joined with the whole R.
+ * @{
+ */
+
+/** a pass-1 partition whose pass-2 is split into tasks */
+struct skew_t {
+    task_t     part;        /* the partition as a TASK_PART would see it */
+    int64_t    remaining;   /* TASK_SPLIT_* tasks not finished yet */
+    uint32_t   nchunks;
+    uint32_t   chunk_size;  /* tuples per S chunk, the last one gets the rest */
+    uint32_t * histR;       /* tuples per R cluster */
+    uint32_t * histS;       /* tuples per cluster of each S chunk */
+};
+
+/** whether a pass-1 partition is split, see SKEW_FACTOR */
+static
+inline
+int
+is_skewed(const arg_t * args, uint32_t ntupR, uint32_t ntupS)
+{
+#if SKEW_HANDLING
+    const uint64_t share = ((uint64_t) args->totalR + args->totalS)
+                           / (SKEW_FACTOR * args->nthreads);
+    return args->nthreads > 1 && ntupS >= args->nthreads
+        && (uint64_t) ntupR + ntupS > MAX(share, THRESHOLD1((uint64_t) args->nthreads));
+#else
+    return 0;
+#endif
+}
+
+/** number of S tuples in chunk K of a partition */
+static
+inline
+uint32_t
+chunk_tuples(uint32_t ntupS, uint32_t chunk_size, uint32_t nchunks, uint32_t k)
+{
+    return (k == nchunks - 1) ? ntupS - k * chunk_size : chunk_size;
+}
+
+/**
+ * Creates the tasks of a skewed pass-1 partition in the deque of the calling
+ * thread. The partition is described by PART like a pass-2 task.
+ */
+template<unsigned int NUM_PASSES>
+static
+void
+skew_create_tasks(task_t * const part, arg_t * const args, const int D)
+{
+    const uint32_t nchunks = args->nthreads;
+    const uint32_t ntupS = part->relS.num_tuples;
+    const uint32_t chunk_size = ntupS / nchunks;
+    task_deque_t * my_deque = &args->deques[args->my_tid];
+
+    if(NUM_PASSES == 1) {
+        /* each chunk is joined with the whole R */
+        for(uint32_t k = 0; k < nchunks; k++) {
+            task_t * t = task_queue_get_slot(args->task_pool);
+            *t = *part;
+            t->kind = TASK_JOIN;
+            t->relS.tuples += k * chunk_size;
+            t->relS.num_tuples = t->tmpS.num_tuples =
+                chunk_tuples(ntupS, chunk_size, nchunks, k);
+            task_deque_push(my_deque, t);
+        }
+        return;
+    }
+
+    const uint32_t fanOut = 1u << D;
+    skew_t * skew = (skew_t *) malloc(sizeof(skew_t));
+    skew->part       = *part;
+    skew->remaining  = nchunks + 1;
+    skew->nchunks    = nchunks;
+    skew->chunk_size = chunk_size;
+    skew->histR = (uint32_t *) calloc(fanOut, sizeof(uint32_t));
+    skew->histS = (uint32_t *) calloc((size_t) nchunks * fanOut, sizeof(uint32_t));
+    MALLOC_CHECK((skew && skew->histR && skew->histS));
+
+    for(uint32_t k = 0; k <= nchunks; k++) {
+        task_t * t = task_queue_get_slot(args->task_pool);
+        t->kind  = (k == nchunks) ? TASK_SPLIT_R : TASK_SPLIT_S;
+        t->chunk = k;
+        t->skew  = skew;
+        task_deque_push(my_deque, t);
+    }
+}
+
+/**
+ * Pass-2 of a part of a skewed partition: the whole R side or chunk
+ * TASK->chunk of the S side. Chunks are clustered without padding in place
+ * of the chunk, so that they fit into the space of the partition. The last
+ * task to finish creates the join tasks.
+ */
+static
+void
+skew_radix_partition(task_t * const task, arg_t * const args,
+                     const int R, const int D)
+{
+    skew_t * skew = task->skew;
+    task_t * part = &skew->part;
+    const uint32_t fanOut = 1u << D;
+
+    if(task->kind == TASK_SPLIT_R) {
+        radix_cluster(&part->tmpR, &part->relR, skew->histR, R, D, SMALL_PADDING_TUPLES);
+    }
+    else {
+        const uint32_t k = task->chunk;
+        relation_t in, out;
+        in.tuples      = part->relS.tuples + k * skew->chunk_size;
+        in.num_tuples  = chunk_tuples(part->relS.num_tuples, skew->chunk_size, skew->nchunks, k);
+        out.tuples     = part->tmpS.tuples + k * skew->chunk_size;
+        out.num_tuples = in.num_tuples;
+        radix_cluster(&out, &in, skew->histS + (size_t) k * fanOut, R, D, 0);
+    }
+
+    if(__atomic_sub_fetch(&skew->remaining, 1, __ATOMIC_ACQ_REL) > 0)
+        return;
+
+    /* both sides are partitioned: one join task per R cluster and S chunk */
+    int64_t ntasks = 0;
+    for(uint32_t i = 0; i < fanOut; i++) {
+        if(skew->histR[i] == 0)
+            continue;
+        for(uint32_t k = 0; k < skew->nchunks; k++)
+            ntasks += (skew->histS[(size_t) k * fanOut + i] > 0);
+    }
+    __atomic_add_fetch(&args->sync->pending, ntasks, __ATOMIC_RELAXED);
+
+    uint32_t offsetR = 0;
+    uint32_t * offsetS = (uint32_t *) calloc(skew->nchunks, sizeof(uint32_t));
+    for(uint32_t k = 0; k < skew->nchunks; k++)
+        offsetS[k] = k * skew->chunk_size;
+
+    for(uint32_t i = 0; i < fanOut; i++) {
+        for(uint32_t k = 0; k < skew->nchunks; k++) {
+            uint32_t ntupS = skew->histS[(size_t) k * fanOut + i];
+            if(skew->histR[i] > 0 && ntupS > 0) {
+                task_t * t = task_queue_get_slot(args->task_pool);
+                t->kind = TASK_JOIN;
+                t->relR.num_tuples = skew->histR[i];
+                t->relR.tuples = part->tmpR.tuples + offsetR + i * SMALL_PADDING_TUPLES;
+                t->relR.ratio_holes = part->relR.ratio_holes;
+                t->tmpR.tuples = part->relR.tuples + offsetR + i * SMALL_PADDING_TUPLES;
+                t->tmpR.ratio_holes = part->relR.ratio_holes;
+
+                t->relS.num_tuples = ntupS;
+                t->relS.tuples = part->tmpS.tuples + offsetS[k];
+                t->tmpS.tuples = part->relS.tuples + offsetS[k];
+
+                task_deque_push(&args->deques[args->my_tid], t);
+            }
+            offsetS[k] += ntupS;
+        }
+        offsetR += skew->histR[i];
+    }
+
+    DEBUGMSG(1, "Skewed partition: R: %d, S: %d, join tasks = %" PRId64 "\n",
+             (int) part->relR.num_tuples, (int) part->relS.num_tuples, ntasks);
+
+    free(offsetS);
+    free(skew->histR);
+    free(skew->histS);
+    free(skew);
+}
+
+/** @} */
+
 /**
  * This function implements the parallel radix partitioning of a given input
  * relation. Parallel partitioning is done by histogram-based relation
  * re-ordering as described by Kim et al. Parallel partitioning method is
  * commonly used by all parallel radix join algorithms.
  *
+ * The partitioning is split in two steps: radix_histogram() computes the
+ * local histogram of the thread, radix_scatter() copies the tuples once the
+ * histograms of all threads are complete.
+ *
  * @param part description of the relation to be partitioned
  */
 static
 void
-parallel_radix_partition(part_t * const part)
+radix_histogram(part_t * const part)
 {
     const tuple_t* rel    = part->rel;
-    uint32_t ** hist   = part->hist;
-    uint32_t * output = part->output;
-
-    const uint32_t my_tid     = part->thrargs->my_tid;
-    const uint32_t nthreads   = part->thrargs->nthreads;
+    uint32_t * my_hist    = part->hist[part->thrargs->my_tid];
     const uint32_t num_tuples = part->num_tuples;
 
     const int32_t  R       = part->R;
     const int32_t  D       = part->D;
     const uint32_t fanOut  = 1u << D;
     const uint32_t MASK    = (fanOut - 1) << R;
-    const uint32_t padding = part->padding;
 
     uint32_t sum = 0;
-    uint32_t i, j;
-    int rv;
-
-    uint32_t dst[fanOut+1];
+    uint32_t i;
 
     /* compute local histogram for the assigned region of rel */
-    /* compute histogram */
-    uint32_t * my_hist = hist[my_tid];
-
     for(i = 0; i < num_tuples; i++) {
         uint32_t idx = HASH_BIT_MODULO(rel[i].key, MASK, R);
         my_hist[idx] ++;
@@ -587,12 +749,29 @@ parallel_radix_partition(part_t * const part)
         sum += my_hist[i];
         my_hist[i] = sum;
     }
+}
+
+static
+void
+radix_scatter(part_t * const part)
+{
+    const tuple_t* rel    = part->rel;
+    uint32_t ** hist   = part->hist;
+    uint32_t * output = part->output;
 
-    SYNC_TIMER_STOP(&part->thrargs->localtimer.sync1[part->relidx]);
-    /* wait at a barrier until each thread complete histograms */
-    BARRIER_ARRIVE(part->thrargs->barrier, rv);
-    /* barrier global sync point-1 */
-    SYNC_GLOBAL_STOP(&part->thrargs->globaltimer->sync1[part->relidx], my_tid);
+    const uint32_t my_tid     = part->thrargs->my_tid;
+    const uint32_t nthreads   = part->thrargs->nthreads;
+    const uint32_t num_tuples = part->num_tuples;
+
+    const int32_t  R       = part->R;
+    const int32_t  D       = part->D;
+    const uint32_t fanOut  = 1u << D;
+    const uint32_t MASK    = (fanOut - 1) << R;
+    const uint32_t padding = part->padding;
+
+    uint32_t i, j;
+
+    uint32_t dst[fanOut+1];
 
     /* determine the start and end of each cluster */
     for(i = 0; i < my_tid; i++) {
@@ -620,6 +799,27 @@ parallel_radix_partition(part_t * const part)
     }
 }
 
+/**
+ * Start and size of pass-1 partition IDX over all threads, computed from the
+ * prefix-summed histograms. The per-thread output of radix_scatter() only
+ * gives the start of the thread's own region.
+ */
+static
+inline
+uint32_t
+partition_bounds(uint32_t ** hist, uint32_t nthreads, uint32_t idx,
+                 uint32_t padding, uint32_t * ntuples)
+{
+    uint32_t start = 0, end = 0;
+    for(uint32_t t = 0; t < nthreads; t++) {
+        uint32_t before = (idx > 0) ? hist[t][idx-1] : 0;
+        start += before;
+        end   += hist[t][idx];
+    }
+    *ntuples = end - start;
+    return start + idx * padding;
+}
+
 /**
  * @defgroup SoftwareManagedBuffer Optimized Partitioning Using SW-buffers
  * @{
@@ -682,130 +882,111 @@ store_nontemp_64B(void * dst, void * src)
 
 }
 
-// /**
-//  * This function implements the parallel radix partitioning of a given input
-//  * relation. Parallel partitioning is done by histogram-based relation
-//  * re-ordering as described by Kim et al. Parallel partitioning method is
-//  * commonly used by all parallel radix join algorithms. However this
-//  * implementation is further optimized to benefit from write-combining and
-//  * non-temporal writes.
-//  *
-//  * @param part description of the relation to be partitioned
-//  */
-// static
-// void
-// parallel_radix_partition_optimized(part_t * const part)
-// {
-//     const tuple_t * restrict rel    = part->rel;
-//     uint32_t **               hist   = part->hist;
-//     uint32_t *       restrict output = part->output;
-
-//     const uint32_t my_tid     = part->thrargs->my_tid;
-//     const uint32_t nthreads   = part->thrargs->nthreads;
-//     const uint32_t num_tuples = part->num_tuples;
-
-//     const int32_t  R       = part->R;
-//     const int32_t  D       = part->D;
-//     const uint32_t fanOut  = 1u << D;
-//     const uint32_t MASK    = (fanOut - 1) << R;
-//     const uint32_t padding = part->padding;
-
-//     uint32_t sum = 0;
-//     uint32_t i, j;
-//     int rv;
-
-//     /* compute local histogram for the assigned region of rel */
-//     /* compute histogram */
-//     uint32_t * my_hist = hist[my_tid];
-
-//     for(i = 0; i < num_tuples; i++) {
-//         uint32_t idx = HASH_BIT_MODULO(rel[i].key, MASK, R);
-//         my_hist[idx] ++;
-//     }
+/**
+ * This function implements the scatter step of the parallel radix
+ * partitioning like radix_scatter(), but is further optimized to benefit
+ * from write-combining and non-temporal writes: tuples are collected in a
+ * cache line sized buffer per partition, and full buffers are written out
+ * with store_nontemp_64B(). This keeps the number of written locations,
+ * and with it the TLB misses, independent of the fan-out.
+ *
+ * A full line may start before the region of this thread and overwrite the
+ * tail of the previous thread's region. The remainders of all buffers are
+ * therefore written after every thread has written its full lines.
+ *
+ * @param part description of the relation to be partitioned
+ */
+static
+void
+radix_scatter_swwc(part_t * const part)
+{
+    const tuple_t * rel    = part->rel;
+    uint32_t **     hist   = part->hist;
+    uint32_t *      output = part->output;
 
-//     /* compute local prefix sum on hist */
-//     for(i = 0; i < fanOut; i++){
-//         sum += my_hist[i];
-//         my_hist[i] = sum;
-//     }
+    const uint32_t my_tid     = part->thrargs->my_tid;
+    const uint32_t nthreads   = part->thrargs->nthreads;
+    const uint32_t num_tuples = part->num_tuples;
 
-//     SYNC_TIMER_STOP(&part->thrargs->localtimer.sync1[part->relidx]);
-//     /* wait at a barrier until each thread complete histograms */
-//     BARRIER_ARRIVE(part->thrargs->barrier, rv);
-//     /* barrier global sync point-1 */
-//     SYNC_GLOBAL_STOP(&part->thrargs->globaltimer->sync1[part->relidx], my_tid);
+    const int32_t  R       = part->R;
+    const int32_t  D       = part->D;
+    const uint32_t fanOut  = 1u << D;
+    const uint32_t MASK    = (fanOut - 1) << R;
+    const uint32_t padding = part->padding;
 
-//     /* determine the start and end of each cluster */
-//     for(i = 0; i < my_tid; i++) {
-//         for(j = 0; j < fanOut; j++)
-//             output[j] += hist[i][j];
-//     }
-//     for(i = my_tid; i < nthreads; i++) {
-//         for(j = 1; j < fanOut; j++)
-//             output[j] += hist[i][j-1];
-//     }
+    uint32_t i, j;
 
-//     /* uint32_t pre; /\* nr of tuples to cache-alignment *\/ */
-//     tuple_t * restrict tmp = part->tmp;
-//     /* software write-combining buffer */
-//     cacheline_t *buffer;
-//   posix_memalign((void**)(&buffer), CACHE_LINE_SIZE, sizeof(cacheline_t) * fanOut);
-
-//     for(i = 0; i < fanOut; i++ ) {
-//         uint32_t off = output[i] + i * padding;
-//         /* pre        = (off + TUPLESPERCACHELINE) & ~(TUPLESPERCACHELINE-1); */
-//         /* pre       -= off; */
-//         output[i]  = off;
-//         buffer[i].data.slot = off;
-//     }
-//     output[fanOut] = part->total_tuples + fanOut * padding;
-
-//     /* Copy tuples to their corresponding clusters */
-//     for(i = 0; i < num_tuples; i++ ){
-//         uint32_t  idx     = HASH_BIT_MODULO(rel[i].key, MASK, R);
-//         uint32_t  slot    = buffer[idx].data.slot;
-//         tuple_t * tup     = (tuple_t *)(buffer + idx);
-//         uint32_t  slotMod = (slot) & (TUPLESPERCACHELINE - 1);
-//         tup[slotMod]      = rel[i];
-
-//         if(slotMod == (TUPLESPERCACHELINE-1)){
-//             /* write out 64-Bytes with non-temporal store */
-//             store_nontemp_64B((tmp+slot-(TUPLESPERCACHELINE-1)), (buffer+idx));
-//             /* writes += TUPLESPERCACHELINE; */
-//         }
-
-//         buffer[idx].data.slot = slot+1;
-//     }
-//     /* _mm_sfence (); */
+    /* determine the start and end of each cluster */
+    for(i = 0; i < my_tid; i++) {
+        for(j = 0; j < fanOut; j++)
+            output[j] += hist[i][j];
+    }
+    for(i = my_tid; i < nthreads; i++) {
+        for(j = 1; j < fanOut; j++)
+            output[j] += hist[i][j-1];
+    }
 
-//     BARRIER_ARRIVE(part->thrargs->barrier, rv);
+    tuple_t * tmp = part->tmp;
+    /* software write-combining buffer */
+    cacheline_t * buffer = (cacheline_t *) alloc_aligned(sizeof(cacheline_t) * fanOut);
+    MALLOC_CHECK(buffer);
 
+    for(i = 0; i < fanOut; i++ ) {
+        uint32_t off = output[i] + i * padding;
+        output[i]  = off;
+        buffer[i].data.slot = off;
+    }
+    output[fanOut] = part->total_tuples + fanOut * padding;
 
-//     /* write out the remainders in the buffer */
-//     for(i = 0; i < fanOut; i++ ) {
-//         uint32_t slot  = buffer[i].data.slot;
-//         uint32_t sz    = (slot) & (TUPLESPERCACHELINE - 1);
-//         slot          -= sz;
-//     uint32_t startPos = (slot < output[i]) ? (output[i] - slot) : 0;
-//         for(uint32_t j = startPos; j < sz; j++) {
-//             tmp[slot+j]  = buffer[i].data.tuples[j];
-//         }
-//     }
+    /* Copy tuples to their corresponding clusters */
+    for(i = 0; i < num_tuples; i++ ){
+        uint32_t  idx     = HASH_BIT_MODULO(rel[i].key, MASK, R);
+        uint32_t  slot    = buffer[idx].data.slot;
+        tuple_t * tup     = (tuple_t *)(buffer + idx);
+        uint32_t  slotMod = (slot) & (TUPLESPERCACHELINE - 1);
+        tup[slotMod]      = rel[i];
+
+        if(slotMod == (TUPLESPERCACHELINE-1)){
+            /* write out 64-Bytes with non-temporal store */
+            store_nontemp_64B((tmp+slot-(TUPLESPERCACHELINE-1)), (buffer+idx));
+        }
 
-//   free(buffer);
-// }
+        buffer[idx].data.slot = slot+1;
+    }
+    _mm_sfence();
 
-// /** @} */
+    /* wait until each thread wrote its full lines */
+    countdown_wait(part->flush);
 
-// *
-//  * The main thread of parallel radix join. It does partitioning in parallel with
-//  * other threads and during the join phase, picks up join tasks from the task
-//  * queue and calls appropriate JoinFunction to compute the join task.
-//  *
-//  * @param param
-//  *
-//  * @return
+    /* write out the remainders in the buffer */
+    for(i = 0; i < fanOut; i++ ) {
+        uint32_t slot  = buffer[i].data.slot;
+        uint32_t sz    = (slot) & (TUPLESPERCACHELINE - 1);
+        slot          -= sz;
+        uint32_t startPos = (slot < output[i]) ? (output[i] - slot) : 0;
+        for(uint32_t j = startPos; j < sz; j++) {
+            tmp[slot+j]  = buffer[i].data.tuples[j];
+        }
+    }
+
+    free(buffer);
+}
 
+/** @} */
+
+/**
+ * The main thread of parallel radix join. The pass-1 partitioning is done
+ * together by all threads, the phases are separated by countdowns in
+ * prj_sync_t instead of barriers. Afterwards every thread creates the tasks
+ * of its share of the pass-1 partitions in its own deque and works on them:
+ * pass-2 partitioning tasks push their join tasks to the same deque, so a
+ * partition pair is joined as soon as both sides are partitioned. Threads
+ * that run out of work steal from the others until no task is pending.
+ *
+ * @param param
+ *
+ * @return
+ */
 template<unsigned int NUM_RADIX_BITS, unsigned int NUM_PASSES>
 static
 void *
@@ -813,34 +994,23 @@ prj_thread(void * param)
 {
     arg_t * args   = (arg_t*) param;
     int32_t my_tid = args->my_tid;
+    prj_sync_t * sync = args->sync;
 
     const size_t  fanOut = 1u << (NUM_RADIX_BITS / NUM_PASSES);
     const unsigned int R = (NUM_RADIX_BITS / NUM_PASSES);
     const int D = (NUM_RADIX_BITS - (NUM_RADIX_BITS / NUM_PASSES));
 
-
     uint64_t results = 0;
-    int rv;
+    uint64_t checksum = 0;
 
     part_t part;
     task_t * task;
-    task_queue_t * part_queue;
-    task_queue_t * join_queue;
-#if SKEW_HANDLING
-    task_queue_t * skew_queue;
-    const int thresh1 = MAX((1<<D), (1<<R)) * THRESHOLD1(args->nthreads);
-#endif
+    task_deque_t * my_deque = &args->deques[my_tid];
 
     uint32_t * outputR = (uint32_t *) calloc((fanOut+1), sizeof(int32_t));
     uint32_t * outputS = (uint32_t *) calloc((fanOut+1), sizeof(int32_t));
     MALLOC_CHECK((outputR && outputS));
 
-    part_queue = args->part_queue;
-    join_queue = args->join_queue;
-#if SKEW_HANDLING
-    skew_queue = args->skew_queue;
-#endif
-
     args->histR[my_tid] = (uint32_t *) calloc(fanOut, sizeof(int32_t));
     args->histS[my_tid] = (uint32_t *) calloc(fanOut, sizeof(int32_t));
 
@@ -848,20 +1018,10 @@ prj_thread(void * param)
 
     args->parts_processed = 0;
 
-#ifdef PERF_COUNTERS
-    if(my_tid == 0){
-        PCM_initPerformanceMonitor(NULL, NULL);
-        PCM_start();
-    }
-#endif
-
-    /* wait at a barrier until each thread starts and then start the timer */
-    BARRIER_ARRIVE(args->barrier, rv);
+    /* wait until each thread starts and then start the timer */
+    countdown_wait(&sync->start);
 
-    /* if monitoring synchronization stats */
-    SYNC_TIMERS_START(args, my_tid);
-
-#ifndef NO_TIMING
+#if !defined(NO_TIMING) || defined(ALGO_TIME)
     if(my_tid == 0){
         /* thread-0 checkpoints the time */
         gettimeofday(&args->start, NULL);
@@ -871,26 +1031,27 @@ prj_thread(void * param)
     }
 #endif
 
-#ifdef ALGO_TIME
-  if (my_tid == 0) {
-    gettimeofday(&args->start, NULL);
-  }
-#endif
-
-#ifdef VTUNE_PROFILE
-  if (my_tid == 0) {
-    __itt_resume();
-  }
-    BARRIER_ARRIVE(args->barrier, rv);
-#endif
-
     /********** 1st pass of multi-pass partitioning ************/
     part.R       = 0;
     part.D       = NUM_RADIX_BITS / NUM_PASSES;
     part.thrargs = args;
     part.padding = PADDING_TUPLES;
 
-    /* 1. partitioning for relation R */
+    /* 1. histograms of relation R and S */
+    part.rel          = args->relR;
+    part.hist         = args->histR;
+    part.num_tuples   = args->numR;
+    radix_histogram(&part);
+
+    part.rel          = args->relS;
+    part.hist         = args->histS;
+    part.num_tuples   = args->numS;
+    radix_histogram(&part);
+
+    /* wait until each thread completed its histograms */
+    countdown_wait(&sync->histogram);
+
+    /* 2. partitioning for relation R */
     part.rel          = args->relR;
     part.tmp          = args->tmpR;
     part.hist         = args->histR;
@@ -898,14 +1059,13 @@ prj_thread(void * param)
     part.num_tuples   = args->numR;
     part.total_tuples = args->totalR;
     part.relidx       = 0;
+    part.flush        = &sync->flushR;
+    if(USE_SWWC_PART)
+        radix_scatter_swwc(&part);
+    else
+        radix_scatter(&part);
 
-#ifdef USE_SWWC_OPTIMIZED_PART
-    parallel_radix_partition_optimized(&part);
-#else
-    parallel_radix_partition(&part);
-#endif
-
-    /* 1. partitioning for relation S */
+    /* 2. partitioning for relation S */
     part.rel          = args->relS;
     part.tmp          = args->tmpS;
     part.hist         = args->histS;
@@ -913,331 +1073,118 @@ prj_thread(void * param)
     part.num_tuples   = args->numS;
     part.total_tuples = args->totalS;
     part.relidx       = 1;
+    part.flush        = &sync->flushS;
+    if(USE_SWWC_PART)
+        radix_scatter_swwc(&part);
+    else
+        radix_scatter(&part);
 
-#ifdef USE_SWWC_OPTIMIZED_PART
-    parallel_radix_partition_optimized(&part);
-#else
-    parallel_radix_partition(&part);
-#endif
+    free(outputR);
+    free(outputS);
 
-    /* wait at a barrier until each thread copies out */
-    BARRIER_ARRIVE(args->barrier, rv);
+    /* wait until each thread copied out */
+    countdown_wait(&sync->partition);
 
     /********** end of 1st partitioning phase ******************/
 
-    /* 3. first thread creates partitioning tasks for 2nd pass */
+#if !defined(NO_TIMING) || defined(ALGO_TIME)
     if(my_tid == 0) {
-    unsigned int parts_in_one_numa = fanOut / args->nthreads;
-    for(unsigned int part_idx = 0; part_idx < parts_in_one_numa; part_idx++) {
-      for (unsigned int inner = 0; inner < args->nthreads; ++inner) {
-        unsigned int i = part_idx + inner * parts_in_one_numa;
-        uint32_t ntupR = outputR[i+1] - outputR[i] - PADDING_TUPLES;
-        uint32_t ntupS = outputS[i+1] - outputS[i] - PADDING_TUPLES;
-
-#if SKEW_HANDLING
-        if(ntupR > thresh1 || ntupS > thresh1){
-          DEBUGMSG(1, "Adding to skew_queue= R:%d, S:%d\n", ntupR, ntupS);
-
-          task_t * t = task_queue_get_slot(skew_queue);
+        stopTimer(&args->timer3); /* partitioning finished */
+        gettimeofday(&args->part_end, NULL);
+    }
+#endif
 
-          t->relR.num_tuples = t->tmpR.num_tuples = ntupR;
-          t->relR.tuples = args->tmpR + outputR[i];
-          t->tmpR.tuples = args->relR + outputR[i];
+    /* 3. each thread creates the tasks of its share of the pass-1 partitions.
+       With a single pass they are joined directly. */
+    const uint32_t from = (uint64_t) fanOut * my_tid / args->nthreads;
+    const uint32_t to   = (uint64_t) fanOut * (my_tid + 1) / args->nthreads;
+    const int kind = (NUM_PASSES == 1) ? TASK_JOIN : TASK_PART;
+    /* a skewed partition becomes a task per S chunk (+1 for R with 2 passes) */
+    const int64_t skew_tasks = args->nthreads + (NUM_PASSES == 1 ? 0 : 1);
+    int64_t ntasks = 0;
+
+    for(uint32_t i = from; i < to; i++) {
+        uint32_t ntupR, ntupS;
+        partition_bounds(args->histR, args->nthreads, i, PADDING_TUPLES, &ntupR);
+        partition_bounds(args->histS, args->nthreads, i, PADDING_TUPLES, &ntupS);
+        if(ntupR > 0 && ntupS > 0)
+            ntasks += is_skewed(args, ntupR, ntupS) ? skew_tasks : 1;
+    }
+    __atomic_add_fetch(&sync->pending, ntasks, __ATOMIC_RELAXED);
 
-          t->relS.num_tuples = t->tmpS.num_tuples = ntupS;
-          t->relS.tuples = args->tmpS + outputS[i];
-          t->tmpS.tuples = args->relS + outputS[i];
+    /* push in reverse so that the owner pops its partitions in order */
+    for(uint32_t i = to; i-- > from; ) {
+        uint32_t ntupR, ntupS;
+        uint32_t offR = partition_bounds(args->histR, args->nthreads, i, PADDING_TUPLES, &ntupR);
+        uint32_t offS = partition_bounds(args->histS, args->nthreads, i, PADDING_TUPLES, &ntupS);
 
-          task_queue_add(skew_queue, t);
-        }
-        else
-#endif
-          if(ntupR > 0 && ntupS > 0) {
-            task_t * t = task_queue_get_slot(part_queue);
+        if(ntupR > 0 && ntupS > 0) {
+            task_t * t = task_queue_get_slot(args->task_pool);
+            t->kind = kind;
 
             t->relR.num_tuples = t->tmpR.num_tuples = ntupR;
-            t->relR.tuples = args->tmpR + outputR[i];
-                        t->relR.ratio_holes = args->ratio_holes;
-            t->tmpR.tuples = args->relR + outputR[i] ;
-                        t->tmpR.ratio_holes = args->ratio_holes;
+            t->relR.tuples = args->tmpR + offR;
+            t->relR.ratio_holes = args->ratio_holes;
+            t->tmpR.tuples = args->baseR + offR;
+            t->tmpR.ratio_holes = args->ratio_holes;
 
             t->relS.num_tuples = t->tmpS.num_tuples = ntupS;
-            t->relS.tuples = args->tmpS + outputS[i];
-            t->tmpS.tuples = args->relS + outputS[i];
-
-            task_queue_add(part_queue, t);
-          }
-      }
-
-      /* debug partitioning task queue */
-      DEBUGMSG(1, "Pass-2: # partitioning tasks = %d\n", part_queue->count);
-    }
-    for (unsigned int i = parts_in_one_numa * args->nthreads; i < fanOut; ++i) {
-      uint32_t ntupR = outputR[i+1] - outputR[i] - PADDING_TUPLES;
-      uint32_t ntupS = outputS[i+1] - outputS[i] - PADDING_TUPLES;
-      if(ntupR > 0 && ntupS > 0) {
-        task_t * t = task_queue_get_slot(part_queue);
-
-        t->relR.num_tuples = t->tmpR.num_tuples = ntupR;
-        t->relR.tuples = args->tmpR + outputR[i];
-                t->relR.ratio_holes = args->ratio_holes;
-        t->tmpR.tuples = args->relR + outputR[i];
-                t->tmpR.ratio_holes = args->ratio_holes;
-
-        t->relS.num_tuples = t->tmpS.num_tuples = ntupS;
-        t->relS.tuples = args->tmpS + outputS[i];
-        t->tmpS.tuples = args->relS + outputS[i];
-
-        task_queue_add(part_queue, t);
-      }
-    }
-  }
+            t->relS.tuples = args->tmpS + offS;
+            t->tmpS.tuples = args->baseS + offS;
 
-  SYNC_TIMER_STOP(&args->localtimer.sync3);
-  /* wait at a barrier until first thread adds all partitioning tasks */
-  BARRIER_ARRIVE(args->barrier, rv);
-  /* global barrier sync point-3 */
-  SYNC_GLOBAL_STOP(&args->globaltimer->sync3, my_tid);
-
-  /************ 2nd pass of multi-pass partitioning ********************/
-    /* 4. now each thread further partitions and add to join task queue **/
-
-    if (NUM_PASSES==1) {
-        /* If the partitioning is single pass we directly add tasks from pass-1 */
-        task_queue_t *swap = join_queue;
-        join_queue = part_queue;
-        /* part_queue is used as a temporary queue for handling skewed parts */
-        part_queue = swap;
-    }
-    else if (NUM_PASSES == 2) {
-        while ((task = task_queue_get_atomic(part_queue))) {
-            serial_radix_partition(task, join_queue, R, D);
+            if(is_skewed(args, ntupR, ntupS))
+                skew_create_tasks<NUM_PASSES>(t, args, D);
+            else
+                task_deque_push(my_deque, t);
         }
     }
+    /* all tasks of this thread are announced */
+    __atomic_sub_fetch(&sync->pending, 1, __ATOMIC_ACQ_REL);
 
-    BARRIER_ARRIVE(args->barrier, rv);
-  if (my_tid == 0)
-    gettimeofday(&args->part_end, NULL);
-#ifdef VTUNE_PROFILE
-  if (my_tid == 0) {
-    __itt_pause();
-    usleep(50000);
-  }
-#endif
-
-    BARRIER_ARRIVE(args->barrier, rv);
-#if SKEW_HANDLING
-    /* Partitioning pass-2 for skewed relations */
-    part.R         = R;
-    part.D         = D;
-    part.thrargs   = args;
-    part.padding   = SMALL_PADDING_TUPLES;
+    DEBUGMSG(1, "Thread-%d: # pass-1 tasks = %" PRId64 "\n", my_tid, ntasks);
 
+    /* 4. run own tasks, steal when the own deque is empty */
+    uint32_t victim = my_tid;
+    uint32_t spins = 0;
+    join_result_t jres;
     while(1) {
-        if(my_tid == 0) {
-            *args->skewtask = task_queue_get_atomic(skew_queue);
+        task = task_deque_pop(my_deque);
+        for(uint32_t i = 1; task == NULL && i < args->nthreads; i++) {
+            victim = (victim + 1) % args->nthreads;
+            if(victim == (uint32_t) my_tid)
+                victim = (victim + 1) % args->nthreads;
+            task = task_deque_steal(&args->deques[victim]);
         }
-        BARRIER_ARRIVE(args->barrier, rv);
-        if( *args->skewtask == NULL)
-            break;
-
-        DEBUGMSG((my_tid==0), "Got skew task = R: %d, S: %d\n",
-                 (*args->skewtask)->relR.num_tuples,
-                 (*args->skewtask)->relS.num_tuples);
-
-        int32_t numperthr = (*args->skewtask)->relR.num_tuples / args->nthreads;
-        const int fanOut2 = (1 << D);
-
-        free(outputR);
-        free(outputS);
-
-        outputR = (int32_t*) calloc(fanOut2 + 1, sizeof(int32_t));
-        outputS = (int32_t*) calloc(fanOut2 + 1, sizeof(int32_t));
-
-        free(args->histR[my_tid]);
-        free(args->histS[my_tid]);
-
-        args->histR[my_tid] = (int32_t*) calloc(fanOut2, sizeof(int32_t));
-        args->histS[my_tid] = (int32_t*) calloc(fanOut2, sizeof(int32_t));
-
-        /* wait until each thread allocates memory */
-        BARRIER_ARRIVE(args->barrier, rv);
-
-        /* 1. partitioning for relation R */
-        part.rel          = (*args->skewtask)->relR.tuples + my_tid * numperthr;
-        part.tmp          = (*args->skewtask)->tmpR.tuples;
-        part.hist         = args->histR;
-        part.output       = outputR;
-        part.num_tuples   = (my_tid == (args->nthreads-1)) ?
-                            ((*args->skewtask)->relR.num_tuples - my_tid * numperthr)
-                            : numperthr;
-        part.total_tuples = (*args->skewtask)->relR.num_tuples;
-        part.relidx       = 2; /* meaning this is pass-2, no syncstats */
-        parallel_radix_partition(&part);
-
-        numperthr = (*args->skewtask)->relS.num_tuples / args->nthreads;
-        /* 2. partitioning for relation S */
-        part.rel          = (*args->skewtask)->relS.tuples + my_tid * numperthr;
-        part.tmp          = (*args->skewtask)->tmpS.tuples;
-        part.hist         = args->histS;
-        part.output       = outputS;
-        part.num_tuples   = (my_tid == (args->nthreads-1)) ?
-                            ((*args->skewtask)->relS.num_tuples - my_tid * numperthr)
-                            : numperthr;
-        part.total_tuples = (*args->skewtask)->relS.num_tuples;
-        part.relidx       = 2; /* meaning this is pass-2, no syncstats */
-        parallel_radix_partition(&part);
-
-        /* wait at a barrier until each thread copies out */
-        BARRIER_ARRIVE(args->barrier, rv);
-
-        /* first thread adds join tasks */
-        if(my_tid == 0) {
-            const int THR1 = THRESHOLD1(args->nthreads);
-
-            for(i = 0; i < fanOut2; i++) {
-                int32_t ntupR = outputR[i+1] - outputR[i] - SMALL_PADDING_TUPLES;
-                int32_t ntupS = outputS[i+1] - outputS[i] - SMALL_PADDING_TUPLES;
-                if(ntupR > THR1 || ntupS > THR1){
-
-                    DEBUGMSG(1, "Large join task = R: %d, S: %d\n", ntupR, ntupS);
-
-                    /* use part_queue temporarily */
-                    for(int k=0; k < args->nthreads; k++) {
-                        int ns = (k == args->nthreads-1)
-                                 ? (ntupS - k*(ntupS/args->nthreads))
-                                 : (ntupS/args->nthreads);
-                        task_t * t = task_queue_get_slot(part_queue);
-
-                        t->relR.num_tuples = t->tmpR.num_tuples = ntupR;
-                        t->relR.tuples = (*args->skewtask)->tmpR.tuples + outputR[i];
-                        t->tmpR.tuples = (*args->skewtask)->relR.tuples + outputR[i];
-
-                        t->relS.num_tuples = t->tmpS.num_tuples = ns; //ntupS;
-                        t->relS.tuples = (*args->skewtask)->tmpS.tuples + outputS[i] //;
-                                         + k*(ntupS/args->nthreads);
-                        t->tmpS.tuples = (*args->skewtask)->relS.tuples + outputS[i] //;
-                                         + k*(ntupS/args->nthreads);
-
-                        task_queue_add(part_queue, t);
-                    }
-                }
-                else
-                if(ntupR > 0 && ntupS > 0) {
-                    task_t * t = task_queue_get_slot(join_queue);
-
-                    t->relR.num_tuples = t->tmpR.num_tuples = ntupR;
-                    t->relR.tuples = (*args->skewtask)->tmpR.tuples + outputR[i];
-                    t->tmpR.tuples = (*args->skewtask)->relR.tuples + outputR[i];
-
-                    t->relS.num_tuples = t->tmpS.num_tuples = ntupS;
-                    t->relS.tuples = (*args->skewtask)->tmpS.tuples + outputS[i];
-                    t->tmpS.tuples = (*args->skewtask)->relS.tuples + outputS[i];
-
-                    task_queue_add(join_queue, t);
-
-                    DEBUGMSG(1, "Join added = R: %d, S: %d\n",
-                           t->relR.num_tuples, t->relS.num_tuples);
-                }
-            }
 
+        if(task == NULL) {
+            if(__atomic_load_n(&sync->pending, __ATOMIC_ACQUIRE) <= 0)
+                break;
+            _mm_pause();
+            if(++spins % 1024 == 0)
+                sched_yield();
+            continue;
         }
-    }
 
-    /* add large join tasks in part_queue to the front of the join queue */
-    if(my_tid == 0) {
-        while((task = task_queue_get_atomic(part_queue)))
-            task_queue_add(join_queue, task);
-    }
-
-#endif
-
-    free(outputR);
-    free(outputS);
-
-    SYNC_TIMER_STOP(&args->localtimer.sync4);
-    /* wait at a barrier until all threads add all join tasks */
-    BARRIER_ARRIVE(args->barrier, rv);
-#ifdef VTUNE_PROFILE
-  if (my_tid == 0) {
-    __itt_resume();
-  }
-    BARRIER_ARRIVE(args->barrier, rv);
-#endif
-
-    BARRIER_ARRIVE(args->barrier, rv);
-    /* global barrier sync point-4 */
-    SYNC_GLOBAL_STOP(&args->globaltimer->sync4, my_tid);
-
-#ifndef NO_TIMING
-    if(my_tid == 0) stopTimer(&args->timer3);/* partitioning finished */
-#endif
-
-    DEBUGMSG((my_tid == 0), "Number of join tasks = %d\n", join_queue->count);
-
-#ifdef PERF_COUNTERS
-    if(my_tid == 0){
-        PCM_stop();
-        PCM_log("======= Partitioning phase profiling results ======\n");
-        PCM_printResults();
-        PCM_start();
-    }
-    /* Just to make sure we get consistent performance numbers */
-    BARRIER_ARRIVE(args->barrier, rv);
-#endif
-  uint64_t checksum = 0;
-  join_result_t jres;
-    while((task = task_queue_get_atomic(join_queue))){
-        /* do the actual join. join method differs for different algorithms,
-           i.e. bucket chaining, histogram-based, histogram-based with simd &
-           prefetching  */
-        jres = args->join_function(&task->relR, &task->relS, &task->tmpR,args->totalR);
-    results += jres.matches;
-    checksum += jres.checksum;
-
-        args->parts_processed ++;
+        if(task->kind == TASK_PART) {
+            serial_radix_partition(task, args, R, D);
+        }
+        else if(task->kind == TASK_SPLIT_R || task->kind == TASK_SPLIT_S) {
+            skew_radix_partition(task, args, R, D);
+        }
+        else {
+            /* do the actual join. join method differs for different algorithms,
+               i.e. bucket chaining, histogram-based, histogram-based with simd &
+               prefetching  */
+            jres = args->join_function(&task->relR, &task->relS, &task->tmpR, args->totalR);
+            results += jres.matches;
+            checksum += jres.checksum;
+            args->parts_processed ++;
+        }
+        __atomic_sub_fetch(&sync->pending, 1, __ATOMIC_ACQ_REL);
     }
 
     args->result = results;
-  args->checksum = checksum;
-    /* this thread is finished */
-    SYNC_TIMER_STOP(&args->localtimer.finish_time);
-
-#ifdef ALGO_TIME
-    BARRIER_ARRIVE(args->barrier, rv);
-  if (my_tid == 0) {
-    gettimeofday(&args->end, NULL);
-#ifdef VTUNE_PROFILE
-    __itt_pause();
-#endif
-  }
-    BARRIER_ARRIVE(args->barrier, rv);
-#endif
-#ifndef NO_TIMING
-    /* this is for just reliable timing of finish time */
-    BARRIER_ARRIVE(args->barrier, rv);
-    if(my_tid == 0) {
-        /* Actually with this setup we're not timing build */
-        stopTimer(&args->timer2);/* build finished */
-        stopTimer(&args->timer1);/* probe finished */
-        gettimeofday(&args->end, NULL);
-    }
-#endif
-
-    /* global finish time */
-    SYNC_GLOBAL_STOP(&args->globaltimer->finish_time, my_tid);
-
-#ifdef PERF_COUNTERS
-    if(my_tid == 0) {
-        PCM_stop();
-        PCM_log("=========== Build+Probe profiling results =========\n");
-        PCM_printResults();
-        PCM_log("===================================================\n");
-        PCM_cleanup();
-    }
-    /* Just to make sure we get consistent performance numbers */
-    BARRIER_ARRIVE(args->barrier, rv);
-#endif
+    args->checksum = checksum;
 
     return 0;
 }
@@ -1280,14 +1227,15 @@ print_timing(uint64_t total, uint64_t build, uint64_t part,
 template<int NUM_RADIX_BITS , int NUM_PASSES >
 static
 join_result_t
-join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num_dim, int num_fact, JoinFunction jf,unsigned int nthreads)
+join_init_run(relation_t * relR, relation_t * relS, JoinFunction jf, unsigned int nthreads)
 {
     int  rv;
     pthread_t tid[nthreads];
     pthread_attr_t attr;
-    pthread_barrier_t barrier;
     cpu_set_t set;
-    arg_t args[nthreads];
+    arg_t * args;
+    task_deque_t * deques;
+    prj_sync_t sync;
 
     uint32_t ** histR, ** histS;
     tuple_t * tmpRelR, * tmpRelS;
@@ -1295,67 +1243,37 @@ join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num
     uint64_t result = 0;
   uint64_t checksum = 0;
 
-    task_queue_t * part_queue, * join_queue;
-#if SKEW_HANDLING
-    task_queue_t * skew_queue;
-    task_t * skewtask = NULL;
-    skew_queue = task_queue_init(FANOUT_PASS1);
-#endif
-    part_queue = task_queue_init(FANOUT_PASS1);
-    join_queue = task_queue_init((1<<NUM_RADIX_BITS));
-
+    sync.start     = nthreads;
+    sync.histogram = nthreads;
+    sync.partition = nthreads;
+    sync.pending   = nthreads; /* one creation token per thread */
+    sync.flushR    = nthreads;
+    sync.flushS    = nthreads;
 
     /* allocate temporary space for partitioning */
-// #ifdef HUGE_PAGE
-//     tmpRelR = (tuple_t*) Utils::malloc_huge(relR->num_tuples * sizeof(tuple_t) +
-//                                        RELATION_PADDING);
-//     tmpRelS = (tuple_t*) Utils::malloc_huge(relS->num_tuples * sizeof(tuple_t) +
-//                                        RELATION_PADDING);
-// #else
     tmpRelR = (tuple_t*) alloc_aligned(relR->num_tuples * sizeof(tuple_t) +
                                        RELATION_PADDING);
     tmpRelS = (tuple_t*) alloc_aligned(relS->num_tuples * sizeof(tuple_t) +
                                        RELATION_PADDING);
-// #endif
     MALLOC_CHECK((tmpRelR && tmpRelS));
-    /** Not an elegant way of passing whether we will numa-localize, but this
-        feature is experimental anyway. */
-
-    // if (numalocalize) {
-    //     numa_localize(tmpRelR, relR->num_tuples + RELATION_PADDING/sizeof(tuple_t), nthreads);
-    //     numa_localize(tmpRelS, relS->num_tuples + RELATION_PADDING/sizeof(tuple_t), nthreads);
-    // }
 
     /* allocate histograms arrays, actual allocation is local to threads */
     histR = (uint32_t**) alloc_aligned(nthreads * sizeof(uint32_t*));
     histS = (uint32_t**) alloc_aligned(nthreads * sizeof(uint32_t*));
-    MALLOC_CHECK((histR && histS));
-
-    rv = pthread_barrier_init(&barrier, NULL, nthreads);
-    if(rv != 0){
-        printf("[ERROR] Couldn't create the barrier\n");
-        exit(EXIT_FAILURE);
-    }
+    args = (arg_t*) alloc_aligned(nthreads * sizeof(arg_t));
+    deques = (task_deque_t*) alloc_aligned(nthreads * sizeof(task_deque_t));
+    MALLOC_CHECK((histR && histS && args && deques));
 
     pthread_attr_init(&attr);
 
-
-#ifdef SYNCSTATS
-    /* thread-0 keeps track of synchronization stats */
-    args[0].globaltimer = (synctimer_t*) malloc(sizeof(synctimer_t));
-#endif
-
     /* first assign chunks of relR & relS for each thread */
     numperthr[0] = ((relR->num_tuples / TUPLESPERCACHELINE) / nthreads) * TUPLESPERCACHELINE;
     numperthr[1] = ((relS->num_tuples / TUPLESPERCACHELINE) / nthreads) * TUPLESPERCACHELINE;
     size_t left_over_R = (relR->num_tuples / TUPLESPERCACHELINE) % nthreads;
     size_t left_over_S = (relS->num_tuples / TUPLESPERCACHELINE) % nthreads;
 
-    cout << "Creating Threads" << endl;
     for(unsigned int i = 0; i < nthreads; i++){
-        cout << "Bolo" << endl;
         int cpu_idx = get_cpu_id(i);
-        cout << "Hello" << endl;
         DEBUGMSG(1, "Assigning thread-%d to CPU-%d\n", i, cpu_idx);
 
         CPU_ZERO(&set);
@@ -1365,12 +1283,14 @@ join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num
         size_t small_paddingR = std::min((size_t)i, left_over_R) * TUPLESPERCACHELINE;
         args[i].relR = relR->tuples + i * numperthr[0] + small_paddingR;
         args[i].tmpR = tmpRelR;
+        args[i].baseR = relR->tuples;
         args[i].histR = histR;
         args[i].ratio_holes = relR->ratio_holes;
 
         size_t small_paddingS = std::min((size_t)i, left_over_S) * TUPLESPERCACHELINE;
         args[i].relS = relS->tuples + i * numperthr[1] + small_paddingS;
         args[i].tmpS = tmpRelS;
+        args[i].baseS = relS->tuples;
         args[i].histS = histS;
 
         args[i].numR = numperthr[0] + ((i < ((relR->num_tuples/TUPLESPERCACHELINE) % nthreads)) ?
@@ -1380,18 +1300,20 @@ join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num
         args[i].totalR = relR->num_tuples;
         args[i].totalS = relS->num_tuples;
 
+        /* deques start with room for the share of pass-1 tasks of a thread,
+           the task slots with room for its share of all join tasks */
+        task_deque_init(&deques[i], FANOUT_PASS1 / nthreads + 1);
+        args[i].task_pool = task_queue_init((1<<NUM_RADIX_BITS) / nthreads + 1);
+
         args[i].my_tid = i;
-        args[i].part_queue = part_queue;
-        args[i].join_queue = join_queue;
-#if SKEW_HANDLING
-        args[i].skew_queue = skew_queue;
-        args[i].skewtask   = &skewtask;
-#endif
-        args[i].barrier = &barrier;
+        args[i].deques = deques;
+        args[i].sync = &sync;
         args[i].join_function = jf;
         args[i].nthreads = nthreads;
+    }
 
-        cout << "Launching Threads" << endl;
+    /* launch after all deques are initialized, thieves read any of them */
+    for(unsigned int i = 0; i < nthreads; i++){
         rv = pthread_create(&tid[i], &attr, prj_thread<NUM_RADIX_BITS, NUM_PASSES>, (void*)&args[i]);
         if (rv){
             printf("[ERROR] return code from pthread_create() is %d\n", rv);
@@ -1399,8 +1321,6 @@ join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num
         }
     }
 
-    cout << "Created Threads" << endl;
-
     /* wait for threads to finish */
     for(unsigned int i = 0; i < nthreads; i++){
         pthread_join(tid[i], NULL);
@@ -1408,6 +1328,13 @@ join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num
         checksum += args[i].checksum;
     }
 
+#if !defined(NO_TIMING) || defined(ALGO_TIME)
+    /* the join ends with the last thread */
+    stopTimer(&args[0].timer2); /* build finished */
+    stopTimer(&args[0].timer1); /* probe finished */
+    gettimeofday(&args[0].end, NULL);
+#endif
+
   uint64_t time_usec = 0;
   uint64_t part_usec = 0;
   uint64_t join_usec = 0;
@@ -1417,29 +1344,6 @@ join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num
   join_usec = time_usec - part_usec;
 #endif
 
-#ifdef SYNCSTATS
-/* #define ABSDIFF(X,Y) (((X) > (Y)) ? ((X)-(Y)) : ((Y)-(X))) */
-    fprintf(stdout, "TID JTASKS T1.1 T1.1-IDLE T1.2 T1.2-IDLE "\
-            "T3 T3-IDLE T4 T4-IDLE T5 T5-IDLE\n");
-    for(i = 0; i < nthreads; i++){
-        synctimer_t * glob = args[0].globaltimer;
-        synctimer_t * local = & args[i].localtimer;
-        fprintf(stdout,
-                "%d %d %llu %llu %llu %llu %llu %llu %llu %llu "\
-                "%llu %llu\n",
-                (i+1), args[i].parts_processed, local->sync1[0],
-                glob->sync1[0] - local->sync1[0],
-                local->sync1[1] - glob->sync1[0],
-                glob->sync1[1] - local->sync1[1],
-                local->sync3 - glob->sync1[1],
-                glob->sync3 - local->sync3,
-                local->sync4 - glob->sync3,
-                glob->sync4 - local->sync4,
-                local->finish_time - glob->sync4,
-                glob->finish_time - local->finish_time);
-    }
-#endif
-
 #ifndef NO_TIMING
     /* now print the timing results: */
     print_timing(args[0].timer1, args[0].timer2, args[0].timer3,
@@ -1451,29 +1355,25 @@ join_init_run(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, int num
     for(unsigned int i = 0; i < nthreads; i++) {
         free(histR[i]);
         free(histS[i]);
+        task_deque_free(&deques[i]);
+        task_queue_free(args[i].task_pool);
     }
     free(histR);
     free(histS);
-    task_queue_free(part_queue);
-    task_queue_free(join_queue);
-#if SKEW_HANDLING
-    task_queue_free(skew_queue);
-#endif
+    free(deques);
+    free(args);
 
     free(tmpRelR);
     free(tmpRelS);
 
-#ifdef SYNCSTATS
-    free(args[0].globaltimer);
-#endif
-
     join_result_t ret_result = {result, checksum, time_usec, part_usec, join_usec};
     return ret_result;
 }
 
-template<bool is_checksum, int NUM_RADIX_BITS, int NUM_PASSES>
-join_result_t
-PRAiS(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, unsigned int nthreads)
+/** sets the fan-outs and paddings for the given radix bits and passes */
+static
+void
+prj_params_init(int NUM_RADIX_BITS, int NUM_PASSES)
 {
     FANOUT_PASS1 = (1u << (NUM_RADIX_BITS/NUM_PASSES));
     FANOUT_PASS2 = (1u << (NUM_RADIX_BITS-(NUM_RADIX_BITS/NUM_PASSES)));
@@ -1482,10 +1382,120 @@ PRAiS(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, unsigned int nt
     PADDING_TUPLES = (SMALL_PADDING_TUPLES*(FANOUT_PASS2+1));
 
     RELATION_PADDING = (PADDING_TUPLES*FANOUT_PASS1*sizeof(tuple_t));
+}
+
+template<bool is_checksum, int NUM_RADIX_BITS, int NUM_PASSES>
+join_result_t
+PRAiS(relation_t * relR, relation_t * relS, unsigned int nthreads)
+{
+    prj_params_init(NUM_RADIX_BITS, NUM_PASSES);
+    return join_init_run<NUM_RADIX_BITS, NUM_PASSES>(relR, relS, array_join<is_checksum, NUM_RADIX_BITS>, nthreads);
+}
 
-    return join_init_run<NUM_RADIX_BITS, NUM_PASSES>(dim_key, dim_val, fact_fkey, fact_val, array_join<is_checksum, NUM_RADIX_BITS>, nthreads);
+/**
+ * @defgroup Tuning Radix Bits and Passes from the Cache Hierarchy
+ * @{
+ */
+
+/** bits supported by PRAiS_tuned(), each one is a template instance */
+#define PRJ_MIN_BITS 4
+#define PRJ_MAX_BITS 18
+
+/** radix join configuration */
+typedef struct prj_config_t {
+    int bits;
+    int passes;
+    int swwc;   /* pass-1 with SW write-combining buffers */
+} prj_config_t;
+
+static int
+log2_floor(uint64_t v)
+{
+    int r = 0;
+    while(v >>= 1) r++;
+    return r;
 }
 
+/**
+ * Chooses the radix bits so that the join of one partition, the array of
+ * array_join() plus the R tuples, fits into half of L2. A partitioning pass
+ * writes to 2^bits locations at once: up to the L1 dTLB entries a plain
+ * scatter keeps its translations cached; up to the L2 TLB entries and half
+ * the lines of L1, SW-buffers do, since they only touch the output with
+ * full cache lines. More bits need a second pass, whose pass-1 is half of
+ * the bits. Relations larger than the last level cache use the SW-buffers
+ * regardless, the non-temporal stores do not read the output first.
+ */
+static prj_config_t
+prj_tune(const cache_info_t * ci, uint64_t numR, uint64_t numS, int ratio_holes)
+{
+    prj_config_t cfg;
+    const uint64_t part_bytes = numR * (ratio_holes * sizeof(value_t) + sizeof(tuple_t));
+    const uint64_t target = ci->l2_size / 2;
+
+    cfg.bits = PRJ_MIN_BITS;
+    while(cfg.bits < PRJ_MAX_BITS && (part_bytes >> cfg.bits) > target)
+        cfg.bits++;
+
+    const int plain_bits = log2_floor(ci->l1_dtlb_entries);
+    const int swwc_bits  = std::min(log2_floor(ci->l2_tlb_entries),
+                                    log2_floor(ci->l1d_size / ci->line_size / 2));
+
+    if(cfg.bits <= plain_bits) {
+        cfg.passes = 1;
+        cfg.swwc   = 0;
+    }
+    else if(cfg.bits <= swwc_bits) {
+        cfg.passes = 1;
+        cfg.swwc   = 1;
+    }
+    else {
+        cfg.passes = 2;
+        cfg.swwc   = (cfg.bits / 2 > plain_bits);
+    }
+
+    if((numR + numS) * sizeof(tuple_t) > (uint64_t) ci->l3_size)
+        cfg.swwc = 1;
+
+    return cfg;
+}
+
+/** maps runtime bits and passes to the PRAiS instance */
+template<bool is_checksum, int BITS>
+struct prj_dispatch {
+    static join_result_t
+    run(prj_config_t cfg, relation_t * relR, relation_t * relS, unsigned int nthreads)
+    {
+        if(cfg.bits != BITS)
+            return prj_dispatch<is_checksum, BITS + 1>::run(cfg, relR, relS, nthreads);
+        if(cfg.passes == 1)
+            return PRAiS<is_checksum, BITS, 1>(relR, relS, nthreads);
+        return PRAiS<is_checksum, BITS, 2>(relR, relS, nthreads);
+    }
+};
+
+template<bool is_checksum>
+struct prj_dispatch<is_checksum, PRJ_MAX_BITS + 1> {
+    static join_result_t
+    run(prj_config_t cfg, relation_t *, relation_t *, unsigned int)
+    {
+        fprintf(stderr, "[ERROR] %d radix bits are not supported (%d-%d)\n",
+                cfg.bits, PRJ_MIN_BITS, PRJ_MAX_BITS);
+        exit(EXIT_FAILURE);
+    }
+};
+
+/** PRAiS with bits, passes and partitioning chosen at runtime, see prj_tune() */
+template<bool is_checksum>
+join_result_t
+PRAiS_tuned(relation_t * relR, relation_t * relS, prj_config_t cfg, unsigned int nthreads)
+{
+    USE_SWWC_PART = cfg.swwc;
+    return prj_dispatch<is_checksum, PRJ_MIN_BITS>::run(cfg, relR, relS, nthreads);
+}
+
+/** @} */
+
 // template join_result_t PRAiS<true, 1, 1>(relation_t *relR, relation_t *relS,unsigned int nthreads);
 // template join_result_t PRAiS<true, 2, 1>(relation_t *relR, relation_t *relS,unsigned int nthreads);
 // template join_result_t PRAiS<true, 3, 1>(relation_t *relR, relation_t *relS,unsigned int nthreads);
@@ -1517,28 +1527,39 @@ PRAiS(int* dim_key, int* dim_val, int* fact_fkey, int* fact_val, unsigned int nt
 // template join_result_t PRAiS<true, 18, 2>(relation_t *relR, relation_t *relS,unsigned int nthreads);
 // template join_result_t PRAiS<false, 14, 1>(relation_t *relR, relation_t *relS,unsigned int nthreads);
 
-int main() {
-  int nthreads = 2;
-/*  int r_size   = 12800000;*/
-  //int s_size   = 12800000;
-
-  //cout << "Hello" << endl;
-
-  //relation_t relR;
-  //relation_t relS;
-
-  //relR.tuples = (tuple_t*) alloc_aligned(r_size * sizeof(tuple_t));
-  /*relS.tuples = (tuple_t*) alloc_aligned(s_size * sizeof(tuple_t));*/
+/** allocates a relation with the padding the partitioning writes into */
+static
+relation_t
+alloc_relation(uint64_t num_tuples)
+{
+    relation_t rel;
+    rel.num_tuples = num_tuples;
+    rel.ratio_holes = 1;
+    rel.tuples = (tuple_t*) alloc_aligned(num_tuples * sizeof(tuple_t) + RELATION_PADDING);
+    MALLOC_CHECK(rel.tuples);
+    return rel;
+}
 
+int main(int argc, char** argv) {
   int num_fact       = 256 * 1<<20;
   int num_dim      = 16 * 1<<20;
   int num_trials     = 3;
+  int nthreads       = sysconf(_SC_NPROCESSORS_ONLN);
+  double zipf        = 0; /* uniform foreign keys */
+  int bits           = 0; /* 0: chosen from the caches */
+  int passes         = 0;
+  int swwc           = -1;
 
   // Initialize command line
   CommandLineArgs args(argc, argv);
   args.GetCmdLineArgument("n", num_fact);
   args.GetCmdLineArgument("d", num_dim);
   args.GetCmdLineArgument("t", num_trials);
+  args.GetCmdLineArgument("threads", nthreads);
+  args.GetCmdLineArgument("zipf", zipf);
+  args.GetCmdLineArgument("bits", bits);
+  args.GetCmdLineArgument("passes", passes);
+  args.GetCmdLineArgument("swwc", swwc);
 
   // Print usage
   if (args.CheckCmdLineFlag("help"))
@@ -1547,27 +1568,49 @@ int main() {
       "[--n=<num fact>] "
       "[--d=<num dim>] "
       "[--t=<num trials>] "
-      "[--device=<device-id>] "
-      "[--v] "
+      "[--threads=<num threads>] "
+      "[--zipf=<zipf factor of fact keys>] "
+      "[--bits=<radix bits>] "
+      "[--passes=<1|2>] "
+      "[--swwc=<0|1>] "
       "\n", argv[0]);
     exit(0);
   }
 
-  int *h_dim_key = NULL;
-  int *h_dim_val = NULL;
-  int *h_fact_fkey = NULL;
-  int *h_fact_val = NULL;
-
-  create_relation_pk(h_dim_key, h_dim_val, num_dim);
-  create_relation_fk(h_fact_fkey, h_fact_val, num_fact, num_dim);
-
-  //create_relation_pk(&relR, r_size);
-  //create_relation_fk(&relS, s_size, r_size);
-
-  cout << "In HERE" << endl;
+  cache_info_t ci = detect_cache_info();
+  prj_config_t cfg = prj_tune(&ci, num_dim, num_fact, 1);
+  if (bits > 0) cfg.bits = bits;
+  if (passes > 0) cfg.passes = passes;
+  if (swwc >= 0) cfg.swwc = swwc;
+
+  fprintf(stderr, "[INFO ] L1d %ldK, L2 %ldK, L3 %ldK, line %ldB, L1 dTLB %ld, L2 TLB %ld "
+      "-> %d bits, %d passes, swwc %d\n", ci.l1d_size >> 10, ci.l2_size >> 10, ci.l3_size >> 10,
+      ci.line_size, ci.l1_dtlb_entries, ci.l2_tlb_entries, cfg.bits, cfg.passes, cfg.swwc);
+  if (ci.line_size != CACHE_LINE_SIZE)
+    fprintf(stderr, "[WARN ] cache line is %ldB, compiled for %dB (-DCACHE_LINE_SIZE)\n",
+        ci.line_size, CACHE_LINE_SIZE);
+
+  /* sets RELATION_PADDING for the allocation below */
+  prj_params_init(cfg.bits, cfg.passes);
+
+  relation_t relR = alloc_relation(num_dim);
+  relation_t relS = alloc_relation(num_fact);
+
+  for (int t = 0; t < num_trials; t++) {
+    /* pass-2 partitions back into the input relations, regenerate them */
+    create_relation_pk(&relR, num_dim);
+    if (zipf > 0)
+      create_relation_zipf(&relS, num_fact, num_dim, zipf);
+    else
+      create_relation_fk(&relS, num_fact, num_dim);
+    join_result_t res = PRAiS_tuned<true>(&relR, &relS, cfg, nthreads);
+    printf("{\"matches\":%llu,\"checksum\":%llu,\"threads\":%d,\"zipf\":%.2f,\"bits\":%d,\"passes\":%d,\"swwc\":%d}\n",
+        (unsigned long long) res.matches, (unsigned long long) res.checksum, nthreads, zipf,
+        cfg.bits, cfg.passes, cfg.swwc);
+  }
 
-  PRAiS<true, 10, 1>(h_dim_key, h_dim_val, h_fact_fkey, h_fact_val, nthreads);
+  free(relR.tuples);
+  free(relS.tuples);
 
   return 0;
 }
-
@@ -23,6 +23,7 @@
 typedef struct task_t task_t;
 typedef struct task_list_t task_list_t;
 typedef struct task_queue_t task_queue_t;
+typedef struct skew_t skew_t;
 
 struct task_t {
     relation_t relR;
@@ -30,8 +31,18 @@ struct task_t {
     relation_t relS;
     relation_t tmpS;
     task_t *   next;
+    int        kind;    /* TASK_* below */
+    int        chunk;   /* TASK_SPLIT_S: chunk of the S side */
+    skew_t *   skew;    /* TASK_SPLIT_*: the partition being split */
 };
 
+/** a task is either partitioned further (pass-2) or joined */
+#define TASK_PART 0
+#define TASK_JOIN 1
+/** pass-2 of a skewed partition: R as a whole, S in chunks */
+#define TASK_SPLIT_R 2
+#define TASK_SPLIT_S 3
+
 struct task_list_t {
     task_t *      tasks;
     task_list_t * next;
@@ -306,4 +317,137 @@ task_queue_free(task_queue_t * tq)
 
 /** @} */
 
+/**
+ * @defgroup TaskDeque Work-Stealing Task Deque
+ * Chase-Lev deque (Chase and Lev, SPAA'05) with the memory orderings of
+ * Le et al., PPoPP'13. The owner thread pushes and pops at the bottom
+ * without locks, other threads steal from the top with a single CAS.
+ * The buffer grows on demand; replaced buffers are kept until
+ * task_deque_free() since a thief may still read from them.
+ * @{
+ */
+
+typedef struct task_array_t task_array_t;
+typedef struct task_deque_t task_deque_t;
+
+struct task_array_t {
+    int64_t        size;    /* power of two */
+    task_array_t * prev;    /* replaced buffer, freed with the deque */
+    task_t *       tasks[];
+};
+
+struct task_deque_t {
+    int64_t        top     __attribute__((aligned(64)));
+    int64_t        bottom  __attribute__((aligned(64)));
+    task_array_t * array   __attribute__((aligned(64)));
+};
+
+inline
+task_array_t *
+task_array_alloc(int64_t size)
+{
+    task_array_t * a = (task_array_t*) malloc(sizeof(task_array_t) + size * sizeof(task_t*));
+    a->size = size;
+    a->prev = NULL;
+    return a;
+}
+
+/* initialize a deque, size is rounded up to a power of two */
+inline
+void
+task_deque_init(task_deque_t * dq, int64_t size)
+{
+    int64_t s = 2;
+    while(s < size) s <<= 1;
+    dq->top    = 0;
+    dq->bottom = 0;
+    dq->array  = task_array_alloc(s);
+}
+
+inline
+void
+task_deque_free(task_deque_t * dq)
+{
+    task_array_t * a = dq->array;
+    while(a) {
+        task_array_t * prev = a->prev;
+        free(a);
+        a = prev;
+    }
+    dq->array = NULL;
+}
+
+/* owner only: add a task at the bottom */
+inline
+void
+task_deque_push(task_deque_t * dq, task_t * t)
+{
+    int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    task_array_t * a = __atomic_load_n(&dq->array, __ATOMIC_RELAXED);
+
+    if(b - top > a->size - 1) {
+        /* full: copy the live range into a buffer twice as large */
+        task_array_t * na = task_array_alloc(a->size << 1);
+        for(int64_t i = top; i < b; i++)
+            na->tasks[i & (na->size - 1)] = a->tasks[i & (a->size - 1)];
+        na->prev = a;
+        __atomic_store_n(&dq->array, na, __ATOMIC_RELEASE);
+        a = na;
+    }
+
+    __atomic_store_n(&a->tasks[b & (a->size - 1)], t, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+/* owner only: take the most recently pushed task, NULL if empty */
+inline
+task_t *
+task_deque_pop(task_deque_t * dq)
+{
+    int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+    task_array_t * a = __atomic_load_n(&dq->array, __ATOMIC_RELAXED);
+    __atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+
+    task_t * ret = NULL;
+    if(top <= b) {
+        ret = __atomic_load_n(&a->tasks[b & (a->size - 1)], __ATOMIC_RELAXED);
+        if(top == b) {
+            /* last task: race against thieves */
+            if(!__atomic_compare_exchange_n(&dq->top, &top, top + 1, 0,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+                ret = NULL;
+            __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+        }
+    }
+    else {
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return ret;
+}
+
+/* any thread: take the oldest task, NULL if empty or lost a race */
+inline
+task_t *
+task_deque_steal(task_deque_t * dq)
+{
+    int64_t top = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+
+    if(top < b) {
+        task_array_t * a = __atomic_load_n(&dq->array, __ATOMIC_ACQUIRE);
+        task_t * ret = __atomic_load_n(&a->tasks[top & (a->size - 1)], __ATOMIC_RELAXED);
+        if(__atomic_compare_exchange_n(&dq->top, &top, top + 1, 0,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            return ret;
+    }
+    return NULL;
+}
+
+/** @} */
+
 #endif /* TASK_QUEUE_H */
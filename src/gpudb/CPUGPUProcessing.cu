@@ -9,9 +9,24 @@ CPUGPUProcessing::CPUGPUProcessing(size_t _cache_size, size_t _processing_size,
   if (custom) qo = new QueryOptimizer(_cache_size, _processing_size, _pinned_memsize, this);
   else qo = new QueryOptimizer(_cache_size, 0, 0, this);
   cm = qo->cm;
+  verbose = _verbose;
+  setup();
+}
+
+//engine of one more client on the cache of another engine, queries of the clients run concurrently
+CPUGPUProcessing::CPUGPUProcessing(CacheManager* _cm, bool _verbose, bool _custom, bool _skipping) {
+  custom = _custom;
+  skipping = _skipping;
+  qo = new QueryOptimizer(_cm, this);
+  cm = _cm;
+  verbose = _verbose;
+  setup();
+}
+
+void
+CPUGPUProcessing::setup() {
   begin_time = chrono::high_resolution_clock::now();
   col_idx = new int*[cm->TOT_COLUMN]();
-  verbose = _verbose;
   cpu_time = new double[MAX_GROUPS];
   gpu_time = new double[MAX_GROUPS];
   transfer_time = new double[MAX_GROUPS];
@@ -51,6 +66,7 @@ CPUGPUProcessing::resetTime() {
 
 void 
 CPUGPUProcessing::switch_device_fact(int** &off_col, int** &h_off_col, int* &d_total, int* h_total, int sg, int mode, int table, cudaStream_t stream) {
+  QueryParams* params = qo->params;
   // chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
   float time;
   SETUP_TIMING();
@@ -71,7 +87,7 @@ CPUGPUProcessing::switch_device_fact(int** &off_col, int** &h_off_col, int* &d_t
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL) {
         if (!custom) CubDebugExit(cudaMalloc((void**) &off_col[i], *h_total * sizeof(int)));
-        if (custom) off_col[i] = (int*) cm->customCudaMalloc<int>(*h_total);
+        if (custom) off_col[i] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, *h_total);
       }
     }
   } else {
@@ -90,7 +106,7 @@ CPUGPUProcessing::switch_device_fact(int** &off_col, int** &h_off_col, int* &d_t
       if (off_col[i] != NULL) {
         // if (!custom) CubDebugExit(cudaHostAlloc((void**) &h_off_col[i], *h_total * sizeof(int), cudaHostAllocDefault));
         if (!custom) h_off_col[i] = (int*) malloc(*h_total * sizeof(int));
-        if (custom) h_off_col[i] = (int*) cm->customCudaHostAlloc<int>(*h_total);
+        if (custom) h_off_col[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, *h_total);
       }
     }
   }
@@ -139,6 +155,7 @@ CPUGPUProcessing::switch_device_fact(int** &off_col, int** &h_off_col, int* &d_t
 
 void 
 CPUGPUProcessing::switch_device_dim(int* &d_off_col, int* &h_off_col, int* &d_total, int* h_total, int sg, int mode, int table, cudaStream_t stream) {
+  QueryParams* params = qo->params;
 
   float time;
   SETUP_TIMING();
@@ -154,7 +171,7 @@ CPUGPUProcessing::switch_device_dim(int* &d_off_col, int* &h_off_col, int* &d_to
     cpu_to_gpu[sg] += (1 * sizeof(int));
 
     if (!custom) CubDebugExit(cudaMalloc((void**) &d_off_col, *h_total * sizeof(int)));
-    if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(*h_total);
+    if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, *h_total);
   } else {
     if (d_off_col == NULL) return;
     assert(d_off_col != NULL);
@@ -166,7 +183,7 @@ CPUGPUProcessing::switch_device_dim(int* &d_off_col, int* &h_off_col, int* &d_to
 
     // if (!custom) CubDebugExit(cudaHostAlloc((void**) &h_off_col, *h_total * sizeof(int), cudaHostAllocDefault));
     if (!custom) h_off_col = (int*) malloc(*h_total * sizeof(int));
-    if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(*h_total);
+    if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, *h_total);
   }
 
   cudaEventRecord(stop, 0);
@@ -214,6 +231,9 @@ CPUGPUProcessing::switch_device_dim(int* &d_off_col, int* &h_off_col, int* &d_to
 
 void 
 CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, int* &d_total, int* h_total, int sg, int select_so_far, cudaStream_t stream) {
+
+  TRACE_SCOPE("call_pfilter_probe_GPU", sg);
+
   int **off_col_out;
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_idx[4] = {}; //initialize it to null
@@ -234,8 +254,8 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
     _compare2[select_so_far + i] = params->compare2[column];
@@ -248,8 +268,8 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
     ht[table_id - 1] = params->ht_GPU[pkey];
@@ -283,7 +303,7 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinGPUcheck[i]) {
         if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, output_estimate);
       }
     }
   } else {
@@ -292,7 +312,7 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0 || qo->joinGPUcheck[i]) {
         if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, output_estimate);
       }
     }
   }
@@ -311,16 +331,16 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
     short* d_segment_group;
-    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(qo->lo_total_segment));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, qo->lo_total_segment);
+    else CubDebugExit(cudaMalloc((void**) &d_segment_group, qo->lo_total_segment * sizeof(short)));
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
     CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
@@ -380,6 +400,10 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
 
 void 
 CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg, int select_so_far) {
+
+  TRACE_SCOPE("call_pfilter_probe_CPU", sg);
+  PerfRegion perf_region(OpPFilterProbe, sg);
+
   int **off_col_out;
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_col[4] = {};
@@ -407,7 +431,7 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
     int table_id = qo->fkey_pkey[column]->table_id;
     fkey_col[table_id - 1] = column->col_ptr;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    ht[table_id - 1] = params->ht_CPU[pkey];
+    ht[table_id - 1] = localHashTable(params, pkey);
     _min_key[table_id - 1] = params->min_key[pkey];
     _dim_len[table_id - 1] = params->dim_len[pkey];
     output_selectivity *= params->selectivity[column];
@@ -428,6 +452,14 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
     _dim_len[0], _dim_len[1], _dim_len[2], _dim_len[3],
     _min_key[0], _min_key[1], _min_key[2], _min_key[3]
   };
+  setPositional(pargs, sg);
+
+  //the join probed first no longer filters the tuples of this operator
+  ColumnInfo* radix_column = radixProbeFirst(params, pargs, h_off_col, h_total, sg);
+  if (radix_column != NULL) {
+    output_selectivity /= params->selectivity[radix_column];
+    if (*h_total == 0) return;
+  }
 
   SETUP_TIMING();
   float time;
@@ -439,7 +471,7 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
       if (i == 0 || qo->joinCPUcheck[i]) {
         // if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
         if (!custom) off_col_out[i] = (int*) malloc(output_estimate * sizeof(int));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, output_estimate);
       }
     }
   } else {
@@ -449,7 +481,7 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
       if (h_off_col[i] != NULL || i == 0 || qo->joinCPUcheck[i]) {
         // if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
         if (!custom) off_col_out[i] = (int*) malloc(output_estimate * sizeof(int));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, output_estimate);
       }
     }
   }
@@ -468,12 +500,12 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
 
     filter_probe_CPU(
       fargs, pargs, out_off, LEN, &out_total, 0, segment_group_ptr);
@@ -523,6 +555,8 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
 void
 CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, int* h_total, int sg, cudaStream_t stream) {
 
+  TRACE_SCOPE("call_probe_group_by_GPU", sg);
+
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_idx[4] = {}; //initialize it to null
   int _min_val[4] = {0}, _unique_val[4] = {0};
@@ -534,8 +568,8 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
     ht[table_id - 1] = params->ht_GPU[pkey];
@@ -545,8 +579,8 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
 
@@ -555,8 +589,8 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
     if (it->second.size() > 0) {
       ColumnInfo* column = it->second[0];
       ColumnInfo* column_key = it->first;
-      cm->indexTransfer(col_idx, column, stream, custom);
-      cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+      cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+      cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
       group_idx[column_key->table_id - 1] = col_idx[column->column_id];
       _min_val[column_key->table_id - 1] = params->min_val[column_key];
       _unique_val[column_key->table_id - 1] = params->unique_val[column_key];
@@ -584,16 +618,16 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
     short* d_segment_group;
-    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(qo->lo_total_segment));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, qo->lo_total_segment);
+    else CubDebugExit(cudaMalloc((void**) &d_segment_group, qo->lo_total_segment * sizeof(short)));
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
     CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
@@ -640,6 +674,9 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
 void
 CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg) {
 
+  TRACE_SCOPE("call_probe_group_by_CPU", sg);
+  PerfRegion perf_region(OpProbeGroupBy, sg);
+
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_col[4] = {};
   int _min_val[4] = {0}, _unique_val[4] = {0};
@@ -650,7 +687,7 @@ CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col,
     int table_id = qo->fkey_pkey[column]->table_id;
     fkey_col[table_id - 1] = column->col_ptr;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    ht[table_id - 1] = params->ht_CPU[pkey];
+    ht[table_id - 1] = localHashTable(params, pkey);
     _min_key[table_id - 1] = params->min_key[pkey];
     _dim_len[table_id - 1] = params->dim_len[pkey];
   }
@@ -677,6 +714,7 @@ CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col,
     _dim_len[0], _dim_len[1], _dim_len[2], _dim_len[3],
     _min_key[0], _min_key[1], _min_key[2], _min_key[3]
   };
+  setPositional(pargs, sg);
 
   struct groupbyArgsCPU gargs = {
     aggr_col[0], aggr_col[1], group_col[0], group_col[1], group_col[2], group_col[3],
@@ -685,6 +723,8 @@ CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col,
     params->total_val, params->mode_group, params->h_group_func
   };
 
+  radixProbeFirst(params, pargs, h_off_col, h_total, sg);
+
   float time;
   SETUP_TIMING();
   cudaEventRecord(start, 0);
@@ -693,12 +733,12 @@ CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col,
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
 
     probe_group_by_CPU(pargs, gargs, LEN , params->res, 0, segment_group_ptr);
   } else {
@@ -729,6 +769,8 @@ CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col,
 void 
 CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_total, int* h_total, int sg, cudaStream_t stream) {
 
+  TRACE_SCOPE("call_probe_GPU", sg);
+
   int **off_col_out;
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_idx[4] = {}; //initialize it to null
@@ -747,8 +789,8 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
     ht[table_id - 1] = params->ht_GPU[pkey];
@@ -774,7 +816,7 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinGPUcheck[i]) {
         if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, output_estimate);
       }
     }
   } else {
@@ -783,7 +825,7 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0 || qo->joinGPUcheck[i]) {
         if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, output_estimate);
       }
     }
   }
@@ -802,16 +844,16 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
     short* d_segment_group;
-    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(qo->lo_total_segment));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, qo->lo_total_segment);
+    else CubDebugExit(cudaMalloc((void**) &d_segment_group, qo->lo_total_segment * sizeof(short)));
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
     CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
@@ -874,10 +916,15 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
 
 void 
 CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg) {
-  int **off_col_out;
+
+  TRACE_SCOPE("call_probe_CPU", sg);
+  PerfRegion perf_region(OpProbe, sg);
+
+  int **off_col_out, **off_col_temp = NULL;
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_col[4] = {};
-  int out_total = 0;
+  int *radix_ht[4] = {}, *radix_fkey_col[4] = {};
+  int out_total = 0, temp_total = 0;
   float output_selectivity = 1.0;
   int output_estimate = 0;
 
@@ -890,18 +937,39 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
     int table_id = qo->fkey_pkey[column]->table_id;
     fkey_col[table_id - 1] = column->col_ptr;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    ht[table_id - 1] = params->ht_CPU[pkey];
+    ht[table_id - 1] = localHashTable(params, pkey);
     _min_key[table_id - 1] = params->min_key[pkey];
     _dim_len[table_id - 1] = params->dim_len[pkey];
     output_selectivity *= params->selectivity[column];
   }
 
+  //the join with a hash table larger than the cache is probed radix-partitioned after the other joins
+  ColumnInfo* radix_column = qo->radixProbeColumn(sg);
+  int radix_table = -1, radix_bits = 0;
+  if (radix_column != NULL) {
+    radix_table = qo->fkey_pkey[radix_column]->table_id - 1;
+    radix_bits = radix_bits_CPU(_dim_len[radix_table]);
+    radix_ht[radix_table] = ht[radix_table];
+    radix_fkey_col[radix_table] = fkey_col[radix_table];
+    ht[radix_table] = NULL;
+    fkey_col[radix_table] = NULL;
+  }
+
   struct probeArgsCPU pargs = {
     fkey_col[0], fkey_col[1], fkey_col[2], fkey_col[3],
     ht[0], ht[1], ht[2], ht[3], 
     _dim_len[0], _dim_len[1], _dim_len[2], _dim_len[3],
     _min_key[0], _min_key[1], _min_key[2], _min_key[3]
   };
+  setPositional(pargs, sg);
+
+  struct probeArgsCPU radix_pargs = {
+    radix_fkey_col[0], radix_fkey_col[1], radix_fkey_col[2], radix_fkey_col[3],
+    radix_ht[0], radix_ht[1], radix_ht[2], radix_ht[3],
+    _dim_len[0], _dim_len[1], _dim_len[2], _dim_len[3],
+    _min_key[0], _min_key[1], _min_key[2], _min_key[3]
+  };
+  ProcessingArena* radix_arena = custom ? &params->cpu_arena : NULL;
 
   float time;
   SETUP_TIMING();
@@ -913,7 +981,7 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
       if (i == 0 || qo->joinCPUcheck[i]) {
         // if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
         if (!custom) off_col_out[i] = (int*)malloc(output_estimate * sizeof(int));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, output_estimate);
       }
     }
   } else {
@@ -923,7 +991,19 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
       if (h_off_col[i] != NULL || i == 0 || qo->joinCPUcheck[i]) {
         // if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
         if (!custom) off_col_out[i] = (int*)malloc(output_estimate * sizeof(int));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, output_estimate);
+      }
+    }
+  }
+
+  //output of the other joins, input of the radix-partitioned one
+  if (radix_table != -1 && qo->joinCPUPipelineCol[sg].size() > 1) {
+    int temp_len = (h_off_col == NULL) ? SEGMENT_SIZE * qo->segment_group_count[0][sg] : *h_total;
+    off_col_temp = new int*[cm->TOT_TABLE] ();
+    for (int i = 0; i < cm->TOT_TABLE; i++) {
+      if (off_col_out[i] != NULL) {
+        if (!custom) off_col_temp[i] = (int*)malloc(temp_len * sizeof(int));
+        if (custom) off_col_temp[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, temp_len);
       }
     }
   }
@@ -942,14 +1022,25 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
 
-    probe_CPU(pargs, out_off, LEN, &out_total, 0, segment_group_ptr);
+    if (radix_table == -1) {
+      probe_CPU(pargs, out_off, LEN, &out_total, 0, segment_group_ptr);
+    } else if (off_col_temp == NULL) {
+      struct offsetCPU in_off = {NULL, NULL, NULL, NULL, NULL};
+      probe_radix_CPU(in_off, radix_pargs, out_off, LEN, &out_total, radix_bits, segment_group_ptr, radix_arena);
+    } else {
+      struct offsetCPU temp_off = {
+        off_col_temp[0], off_col_temp[1], off_col_temp[2], off_col_temp[3], off_col_temp[4]
+      };
+      probe_CPU(pargs, temp_off, LEN, &temp_total, 0, segment_group_ptr);
+      probe_radix_CPU(temp_off, radix_pargs, out_off, temp_total, &out_total, radix_bits, NULL, radix_arena);
+    }
 
   } else {
 
@@ -963,7 +1054,17 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
       off_col_out[0], off_col_out[1], off_col_out[2], off_col_out[3], off_col_out[4]
     };
 
-    probe_CPU2(in_off, pargs, out_off, *h_total, &out_total, 0);
+    if (radix_table == -1) {
+      probe_CPU2(in_off, pargs, out_off, *h_total, &out_total, 0);
+    } else if (off_col_temp == NULL) {
+      probe_radix_CPU(in_off, radix_pargs, out_off, *h_total, &out_total, radix_bits, NULL, radix_arena);
+    } else {
+      struct offsetCPU temp_off = {
+        off_col_temp[0], off_col_temp[1], off_col_temp[2], off_col_temp[3], off_col_temp[4]
+      };
+      probe_CPU2(in_off, pargs, temp_off, *h_total, &temp_total, 0);
+      probe_radix_CPU(temp_off, radix_pargs, out_off, temp_total, &out_total, radix_bits, NULL, radix_arena);
+    }
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
@@ -973,6 +1074,15 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
 
   }
 
+  if (off_col_temp != NULL) {
+    if (!custom) {
+      for (int i = 0; i < cm->TOT_TABLE; i++) {
+        if (off_col_temp[i] != NULL) free(off_col_temp[i]);
+      }
+    }
+    delete[] off_col_temp;
+  }
+
   h_off_col = off_col_out;
 
   for (int i = 0; i < cm->TOT_TABLE; i++)
@@ -992,9 +1102,98 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
   cpu_time[sg] += time;
 };
 
+//The fused CPU operators (probe_group_by, probe_aggr, pfilter_probe, pfilter_probe_aggr) probe the join of
+//radixProbeColumn(sg) radix-partitioned before they run: its table and key are taken out of pargs, h_off_col and
+//h_total become the tuples that matched, and the operator goes on with its *_CPU2 variant, which reads the
+//dimension row of that join from the offsets. Returns the join column, NULL if there is none (nothing changes).
+ColumnInfo*
+CPUGPUProcessing::radixProbeFirst(QueryParams* params, probeArgsCPU& pargs, int** &h_off_col, int* h_total, int sg) {
+
+  ColumnInfo* radix_column = qo->radixProbeColumn(sg);
+  if (radix_column == NULL) return NULL;
+
+  TRACE_SCOPE("radixProbeFirst", sg);
+
+  int table = qo->fkey_pkey[radix_column]->table_id - 1;
+  int** fkey_col[4] = {&pargs.key_col1, &pargs.key_col2, &pargs.key_col3, &pargs.key_col4};
+  int** ht[4] = {&pargs.ht1, &pargs.ht2, &pargs.ht3, &pargs.ht4};
+  int *radix_ht[4] = {}, *radix_fkey_col[4] = {};
+  radix_ht[table] = *ht[table];
+  radix_fkey_col[table] = *fkey_col[table];
+  *ht[table] = NULL;
+  *fkey_col[table] = NULL;
+
+  struct probeArgsCPU radix_pargs = {
+    radix_fkey_col[0], radix_fkey_col[1], radix_fkey_col[2], radix_fkey_col[3],
+    radix_ht[0], radix_ht[1], radix_ht[2], radix_ht[3],
+    pargs.dim_len1, pargs.dim_len2, pargs.dim_len3, pargs.dim_len4,
+    pargs.min_key1, pargs.min_key2, pargs.min_key3, pargs.min_key4
+  };
+  int dim_len[4] = {pargs.dim_len1, pargs.dim_len2, pargs.dim_len3, pargs.dim_len4};
+
+  float time;
+  SETUP_TIMING();
+  cudaEventRecord(start, 0);
+
+  int num_tuples;
+  short* segment_group_ptr = NULL;
+  if (h_off_col == NULL) {
+    if (sg == qo->last_segment[0]) {
+      num_tuples = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
+    } else {
+      num_tuples = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
+    }
+    segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
+  } else {
+    num_tuples = *h_total;
+  }
+
+  int** off_col_out = new int*[cm->TOT_TABLE] (); //initialize to null
+  for (int i = 0; i < cm->TOT_TABLE; i++) {
+    if (i == 0 || i == table + 1 || (h_off_col != NULL && h_off_col[i] != NULL)) {
+      if (!custom) off_col_out[i] = (int*) malloc(num_tuples * sizeof(int));
+      if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, num_tuples);
+    }
+  }
+
+  struct offsetCPU in_off = {NULL, NULL, NULL, NULL, NULL};
+  if (h_off_col != NULL) {
+    in_off = {h_off_col[0], h_off_col[1], h_off_col[2], h_off_col[3], h_off_col[4]};
+  }
+
+  struct offsetCPU out_off = {
+    off_col_out[0], off_col_out[1], off_col_out[2], off_col_out[3], off_col_out[4]
+  };
+
+  int out_total = 0;
+  probe_radix_CPU(in_off, radix_pargs, out_off, num_tuples, &out_total, radix_bits_CPU(dim_len[table]), segment_group_ptr,
+    custom ? &params->cpu_arena : NULL);
+
+  if (h_off_col != NULL && !custom) {
+    for (int i = 0; i < cm->TOT_TABLE; i++) {
+      if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+    }
+  }
+
+  h_off_col = off_col_out;
+  *h_total = out_total;
+
+  cudaEventRecord(stop, 0);
+  cudaEventSynchronize(stop);
+  cudaEventElapsedTime(&time, start, stop);
+
+  if (verbose) cout << "Radix Probe Kernel time CPU: " << time << " h_total: " << *h_total << " sg: " << sg << endl;
+  cpu_time[sg] += time;
+
+  return radix_column;
+}
+
 //WONT WORK IF JOIN HAPPEN BEFORE FILTER (ONLY WRITE OUTPUT AS A SINGLE COLUMN OFF_COL_OUT[0])
 void
 CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_total, int* h_total, int sg, int select_so_far, cudaStream_t stream) {
+
+  TRACE_SCOPE("call_pfilter_GPU", sg);
+
   int tile_items = 128*4;
   int **off_col_out;
   int *filter_idx[2] = {};
@@ -1012,8 +1211,8 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
     _compare2[select_so_far + i] = params->compare2[column];
@@ -1038,14 +1237,14 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[0], output_estimate * sizeof(int)));
-    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(output_estimate);
+    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, output_estimate);
   } else {
     assert(*h_total > 0);
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0) {
         if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, output_estimate);
       }
     }
   }
@@ -1060,16 +1259,16 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
     short* d_segment_group;
-    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(qo->lo_total_segment));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, qo->lo_total_segment);
+    else CubDebugExit(cudaMalloc((void**) &d_segment_group, qo->lo_total_segment * sizeof(short)));
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
     CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
@@ -1122,6 +1321,10 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
 //WONT WORK IF JOIN HAPPEN BEFORE FILTER (ONLY WRITE OUTPUT AS A SINGLE COLUMN OFF_COL_OUT[0])
 void
 CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg, int select_so_far) {
+
+  TRACE_SCOPE("call_pfilter_CPU", sg);
+  PerfRegion perf_region(OpPFilter, sg);
+
   int **off_col_out;
   ColumnInfo *filter_col[2] = {};
   int out_total = 0;
@@ -1160,7 +1363,7 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     // if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[0], output_estimate * sizeof(int), cudaHostAllocDefault));
     if (!custom) off_col_out[0] = (int*)malloc(output_estimate * sizeof(int));
-    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, output_estimate);
   } else {
     assert(filter_col[0] == NULL);
     assert(filter_col[1] != NULL);
@@ -1170,7 +1373,7 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
       if (h_off_col[i] != NULL || i == 0) {
         // if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
         if (!custom) off_col_out[i] = (int*)malloc(output_estimate * sizeof(int));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, output_estimate);
       }
     }
   }
@@ -1189,12 +1392,12 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
 
     filter_CPU(fargs, off_col_out[0], LEN, &out_total, 0, segment_group_ptr);
 
@@ -1235,6 +1438,9 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
 
 void 
 CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, int* h_total, int sg, int table, cudaStream_t stream) {
+
+  TRACE_SCOPE("call_bfilter_build_GPU", sg);
+
   int tile_items = 128*4;
   int* dimkey_idx, *group_idx = NULL, *filter_idx = NULL;
   ColumnInfo* column, *filter_col;
@@ -1250,21 +1456,21 @@ CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, i
     if (qo->groupby_build.size() > 0 && qo->groupby_build[column].size() > 0) {
       if (qo->groupGPUcheck) {
         ColumnInfo* group_col = qo->groupby_build[column][0];
-        cm->indexTransfer(col_idx, group_col, stream, custom);
-        cpu_to_gpu[sg] += (group_col->total_segment * sizeof(int));
+        cm->indexTransfer(col_idx, group_col, qo->segmentList(group_col), qo->totalSegment(group_col), stream, &params->gpu_arena, custom);
+        cpu_to_gpu[sg] += (qo->totalSegment(group_col) * sizeof(int));
         group_idx = col_idx[group_col->column_id];
       }
     }
 
     if (qo->select_build[column].size() > 0) {
       filter_col = qo->select_build[column][0];
-      cm->indexTransfer(col_idx, filter_col, stream, custom);
-      cpu_to_gpu[sg] += (filter_col->total_segment * sizeof(int));
+      cm->indexTransfer(col_idx, filter_col, qo->segmentList(filter_col), qo->totalSegment(filter_col), stream, &params->gpu_arena, custom);
+      cpu_to_gpu[sg] += (qo->totalSegment(filter_col) * sizeof(int));
       filter_idx = col_idx[filter_col->column_id];
     }
 
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
 
     dimkey_idx = col_idx[column->column_id];
 
@@ -1295,7 +1501,7 @@ CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, i
 
       short* d_segment_group;
       // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(column->total_segment));
-      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment);
+      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, column->total_segment);
       else CubDebugExit(cudaMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
       short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
       CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
@@ -1331,6 +1537,9 @@ CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, i
 void 
 CPUGPUProcessing::call_bfilter_build_CPU(QueryParams* params, int* &h_off_col, int* h_total, int sg, int table) {
 
+  TRACE_SCOPE("call_bfilter_build_CPU", sg);
+  PerfRegion perf_region(OpBFilterBuild, sg);
+
   ColumnInfo* column, *filter_col;
   int* group_ptr = NULL, *filter_ptr = NULL;
 
@@ -1378,11 +1587,17 @@ CPUGPUProcessing::call_bfilter_build_CPU(QueryParams* params, int* &h_off_col, i
 
       short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
 
-      build_CPU(fargs, bargs, LEN, params->ht_CPU[column], 0, segment_group_ptr);
+      if (qo->positionalJoin(column))
+        build_positional_CPU(fargs, LEN, (unsigned int*) params->ht_CPU[column], 0, segment_group_ptr);
+      else
+        build_CPU(fargs, bargs, LEN, params->ht_CPU[column], 0, segment_group_ptr);
 
     } else {
 
-      build_CPU2(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
+      if (qo->positionalJoin(column))
+        build_positional_CPU2(h_off_col, *h_total, (unsigned int*) params->ht_CPU[column], 0);
+      else
+        build_CPU2(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
 
       if (!custom) cudaFreeHost(h_off_col);
 
@@ -1400,6 +1615,9 @@ CPUGPUProcessing::call_bfilter_build_CPU(QueryParams* params, int* &h_off_col, i
 
 void 
 CPUGPUProcessing::call_build_GPU(QueryParams* params, int* &d_off_col, int* h_total, int sg, int table, cudaStream_t stream) {
+
+  TRACE_SCOPE("call_build_GPU", sg);
+
   int tile_items = 128*4;
   int* dimkey_idx, *group_idx = NULL;
   ColumnInfo* column;
@@ -1415,14 +1633,14 @@ CPUGPUProcessing::call_build_GPU(QueryParams* params, int* &d_off_col, int* h_to
     if (qo->groupby_build.size() > 0 && qo->groupby_build[column].size() > 0) {
       if (qo->groupGPUcheck) {
         ColumnInfo* group_col = qo->groupby_build[column][0];
-        cm->indexTransfer(col_idx, group_col, stream, custom);
-        cpu_to_gpu[sg] += (group_col->total_segment * sizeof(int));
+        cm->indexTransfer(col_idx, group_col, qo->segmentList(group_col), qo->totalSegment(group_col), stream, &params->gpu_arena, custom);
+        cpu_to_gpu[sg] += (qo->totalSegment(group_col) * sizeof(int));
         group_idx = col_idx[group_col->column_id];
       }
     }
 
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
 
     dimkey_idx = col_idx[column->column_id];
 
@@ -1448,7 +1666,7 @@ CPUGPUProcessing::call_build_GPU(QueryParams* params, int* &d_off_col, int* h_to
 
       short* d_segment_group;
       // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(column->total_segment));
-      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment);
+      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, column->total_segment);
       else CubDebugExit(cudaMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
       short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
       CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
@@ -1484,6 +1702,9 @@ CPUGPUProcessing::call_build_GPU(QueryParams* params, int* &d_off_col, int* h_to
 void 
 CPUGPUProcessing::call_build_CPU(QueryParams* params, int* &h_off_col, int* h_total, int sg, int table) {
 
+  TRACE_SCOPE("call_build_CPU", sg);
+  PerfRegion perf_region(OpBuild, sg);
+
   ColumnInfo* column;
   int* group_ptr = NULL;
 
@@ -1521,11 +1742,17 @@ CPUGPUProcessing::call_build_CPU(QueryParams* params, int* &h_off_col, int* h_to
 
       short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
 
-      build_CPU(fargs, bargs, LEN, params->ht_CPU[column], 0, segment_group_ptr);
+      if (qo->positionalJoin(column))
+        build_positional_CPU(fargs, LEN, (unsigned int*) params->ht_CPU[column], 0, segment_group_ptr);
+      else
+        build_CPU(fargs, bargs, LEN, params->ht_CPU[column], 0, segment_group_ptr);
 
     } else {
 
-      build_CPU2(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
+      if (qo->positionalJoin(column))
+        build_positional_CPU2(h_off_col, *h_total, (unsigned int*) params->ht_CPU[column], 0);
+      else
+        build_CPU2(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
 
       if (!custom) cudaFreeHost(h_off_col);
 
@@ -1544,6 +1771,8 @@ CPUGPUProcessing::call_build_CPU(QueryParams* params, int* &h_off_col, int* h_to
 void
 CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d_total, int* h_total, int sg, int table, cudaStream_t stream) {
 
+  TRACE_SCOPE("call_bfilter_GPU", sg);
+
   ColumnInfo* temp;
   int tile_items = 128*4;
 
@@ -1565,7 +1794,7 @@ CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d
   cudaEventRecord(start, 0);
   
   // d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate);
-  if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate);
+  if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, output_estimate);
   else CubDebugExit(cudaMalloc((void**) &d_off_col, output_estimate * sizeof(int)));
 
   cudaEventRecord(stop, 0);
@@ -1583,8 +1812,8 @@ CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d
     LEN = qo->segment_group_count[table][sg] * SEGMENT_SIZE;
   }
 
-  cm->indexTransfer(col_idx, column, stream, custom);
-  cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+  cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+  cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
   int* filter_idx = col_idx[column->column_id];
 
   struct filterArgsGPU fargs = {
@@ -1595,7 +1824,7 @@ CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d
 
   short* d_segment_group;
   // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(column->total_segment));
-  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment);
+  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, column->total_segment);
   else CubDebugExit(cudaMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
   short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
   CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
@@ -1627,6 +1856,9 @@ CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d
 void
 CPUGPUProcessing::call_bfilter_CPU(QueryParams* params, int* &h_off_col, int* h_total, int sg, int table) {
 
+  TRACE_SCOPE("call_bfilter_CPU", sg);
+  PerfRegion perf_region(OpBFilter, sg);
+
   ColumnInfo* temp;
 
   for (int i = 0; i < qo->join.size(); i++) {
@@ -1647,7 +1879,7 @@ CPUGPUProcessing::call_bfilter_CPU(QueryParams* params, int* &h_off_col, int* h_
   float time;
   cudaEventRecord(start, 0);
 
-  if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+  if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, output_estimate);
   else CubDebugExit(cudaHostAlloc((void**) &h_off_col, output_estimate * sizeof(int), cudaHostAllocDefault));
 
   cudaEventRecord(stop, 0);
@@ -1688,6 +1920,9 @@ CPUGPUProcessing::call_bfilter_CPU(QueryParams* params, int* &h_off_col, int* h_
 
 void
 CPUGPUProcessing::call_group_by_GPU(QueryParams* params, int** &off_col, int* h_total, int sg, cudaStream_t stream) {
+
+  TRACE_SCOPE("call_group_by_GPU", sg);
+
   int _min_val[4] = {0}, _unique_val[4] = {0};
   int *aggr_idx[2] = {}, *group_idx[4] = {};
   int tile_items = 128 * 4;
@@ -1696,8 +1931,8 @@ CPUGPUProcessing::call_group_by_GPU(QueryParams* params, int** &off_col, int* h_
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
 
@@ -1706,8 +1941,8 @@ CPUGPUProcessing::call_group_by_GPU(QueryParams* params, int** &off_col, int* h_
     if (it->second.size() > 0) {
       ColumnInfo* column = it->second[0];
       ColumnInfo* column_key = it->first;
-      cm->indexTransfer(col_idx, column, stream, custom);
-      cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+      cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+      cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
       group_idx[column_key->table_id - 1] = col_idx[column->column_id];
       _min_val[column_key->table_id - 1] = params->min_val[column_key];
       _unique_val[column_key->table_id - 1] = params->unique_val[column_key];
@@ -1752,6 +1987,10 @@ CPUGPUProcessing::call_group_by_GPU(QueryParams* params, int** &off_col, int* h_
 
 void
 CPUGPUProcessing::call_group_by_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg) {
+
+  TRACE_SCOPE("call_group_by_CPU", sg);
+  PerfRegion perf_region(OpGroupBy, sg);
+
   int _min_val[4] = {0}, _unique_val[4] = {0};
   int *aggr_col[2] = {}, *group_col[4] = {};
 
@@ -1808,6 +2047,8 @@ CPUGPUProcessing::call_group_by_CPU(QueryParams* params, int** &h_off_col, int*
 void
 CPUGPUProcessing::call_aggregation_GPU(QueryParams* params, int* &off_col, int* h_total, int sg, cudaStream_t stream) {
 
+  TRACE_SCOPE("call_aggregation_GPU", sg);
+
   int *aggr_idx[2] = {};
   int tile_items = 128 * 4;
 
@@ -1815,8 +2056,8 @@ CPUGPUProcessing::call_aggregation_GPU(QueryParams* params, int* &off_col, int*
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
 
@@ -1850,6 +2091,10 @@ CPUGPUProcessing::call_aggregation_GPU(QueryParams* params, int* &off_col, int*
 
 void 
 CPUGPUProcessing::call_aggregation_CPU(QueryParams* params, int* &h_off_col, int* h_total, int sg) {
+
+  TRACE_SCOPE("call_aggregation_CPU", sg);
+  PerfRegion perf_region(OpAggregation, sg);
+
   int *aggr_col[2] = {};
 
   if (qo->aggregation[cm->lo_orderdate].size() == 0) return;
@@ -1886,6 +2131,9 @@ CPUGPUProcessing::call_aggregation_CPU(QueryParams* params, int* &h_off_col, int
 
 void 
 CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int* h_total, int sg, cudaStream_t stream) {
+
+  TRACE_SCOPE("call_probe_aggr_GPU", sg);
+
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_idx[4] = {}; //initialize it to null
   int *aggr_idx[2] = {};
@@ -1896,8 +2144,8 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
     ht[table_id - 1] = params->ht_GPU[pkey];
@@ -1907,8 +2155,8 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
 
@@ -1936,16 +2184,16 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
     short* d_segment_group;
-    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(qo->lo_total_segment));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, qo->lo_total_segment);
+    else CubDebugExit(cudaMalloc((void**) &d_segment_group, qo->lo_total_segment * sizeof(short)));
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
     CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
@@ -1987,6 +2235,9 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
 void 
 CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg) {
 
+  TRACE_SCOPE("call_probe_aggr_CPU", sg);
+  PerfRegion perf_region(OpProbeAggr, sg);
+
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_col[4] = {};
   int *aggr_col[2] = {};
@@ -1996,7 +2247,7 @@ CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int
     int table_id = qo->fkey_pkey[column]->table_id;
     fkey_col[table_id - 1] = column->col_ptr;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    ht[table_id - 1] = params->ht_CPU[pkey];
+    ht[table_id - 1] = localHashTable(params, pkey);
     _min_key[table_id - 1] = params->min_key[pkey];
     _dim_len[table_id - 1] = params->dim_len[pkey];
   }
@@ -2012,6 +2263,7 @@ CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int
     _dim_len[0], _dim_len[1], _dim_len[2], _dim_len[3],
     _min_key[0], _min_key[1], _min_key[2], _min_key[3]
   };
+  setPositional(pargs, sg);
 
   struct groupbyArgsCPU gargs = {
     aggr_col[0], aggr_col[1], NULL, NULL, NULL, NULL,
@@ -2020,6 +2272,8 @@ CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int
     0, params->mode_group, params->h_group_func
   };
 
+  radixProbeFirst(params, pargs, h_off_col, h_total, sg);
+
   cudaEvent_t start, stop;
   float time;
   cudaEventCreate(&start);
@@ -2030,12 +2284,12 @@ CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
 
     probe_aggr_CPU(pargs, gargs, LEN, params->res, 0, segment_group_ptr);
   } else {
@@ -2060,6 +2314,8 @@ CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int
 void
 CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_col, int* h_total, int sg, int select_so_far, cudaStream_t stream) {
 
+  TRACE_SCOPE("call_pfilter_probe_aggr_GPU", sg);
+
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_idx[4] = {}; //initialize it to null
   int *filter_idx[2] = {};
@@ -2072,8 +2328,8 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
     _compare2[select_so_far + i] = params->compare2[column];
@@ -2084,8 +2340,8 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
     ht[table_id - 1] = params->ht_GPU[pkey];
@@ -2095,8 +2351,8 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
-    cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
+    cm->indexTransfer(col_idx, column, qo->segmentList(column), qo->totalSegment(column), stream, &params->gpu_arena, custom);
+    cpu_to_gpu[sg] += (qo->totalSegment(column) * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
 
@@ -2132,16 +2388,16 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
     short* d_segment_group;
-    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(qo->lo_total_segment));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(&params->gpu_arena, qo->lo_total_segment);
+    else CubDebugExit(cudaMalloc((void**) &d_segment_group, qo->lo_total_segment * sizeof(short)));
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
     CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
@@ -2182,6 +2438,10 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
 
 void 
 CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg, int select_so_far) {
+
+  TRACE_SCOPE("call_pfilter_probe_aggr_CPU", sg);
+  PerfRegion perf_region(OpPFilterProbeAggr, sg);
+
   int _min_key[4] = {0}, _dim_len[4] = {0};
   int *ht[4] = {}, *fkey_col[4] = {};
   ColumnInfo* filter_col[2] = {};
@@ -2201,7 +2461,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_
     int table_id = qo->fkey_pkey[column]->table_id;
     fkey_col[table_id - 1] = column->col_ptr;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    ht[table_id - 1] = params->ht_CPU[pkey];
+    ht[table_id - 1] = localHashTable(params, pkey);
     _min_key[table_id - 1] = params->min_key[pkey];
     _dim_len[table_id - 1] = params->dim_len[pkey];
   }
@@ -2226,6 +2486,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_
     _dim_len[0], _dim_len[1], _dim_len[2], _dim_len[3],
     _min_key[0], _min_key[1], _min_key[2], _min_key[3]
   };
+  setPositional(pargs, sg);
 
   struct groupbyArgsCPU gargs = {
     aggr_col[0], aggr_col[1], NULL, NULL, NULL, NULL,
@@ -2234,6 +2495,8 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_
     0, params->mode_group, params->h_group_func
   };
 
+  radixProbeFirst(params, pargs, h_off_col, h_total, sg);
+
   cudaEvent_t start, stop;   // variables that holds 2 events 
   float time;                // Variable that will hold the time
   cudaEventCreate(&start);   // creating the event 1
@@ -2244,12 +2507,12 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_
 
     int LEN;
     if (sg == qo->last_segment[0]) {
-      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + cm->lo_orderdate->LEN % SEGMENT_SIZE;
+      LEN = (qo->segment_group_count[0][sg] - 1) * SEGMENT_SIZE + qo->lo_len % SEGMENT_SIZE;
     } else { 
       LEN = qo->segment_group_count[0][sg] * SEGMENT_SIZE;
     }
 
-    short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
+    short* segment_group_ptr = qo->segment_group[0] + (sg * qo->lo_total_segment);
 
     filter_probe_aggr_CPU(fargs, pargs, gargs, LEN, params->res, 0, segment_group_ptr);
   } else {
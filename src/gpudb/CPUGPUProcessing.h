@@ -43,6 +43,10 @@ public:
 
   CPUGPUProcessing(size_t _cache_size, size_t _processing_size, size_t _pinned_memsize, bool _verbose, bool _custom = true, bool _skipping = true, double alpha = 0.1);
 
+  CPUGPUProcessing(CacheManager* _cm, bool _verbose, bool _custom = true, bool _skipping = true);
+
+  void setup();
+
   ~CPUGPUProcessing() {
     delete[] col_idx;
     delete[] transfer_time;
@@ -64,6 +68,28 @@ public:
 
   void resetTime();
 
+  //replica of a dimension hash table on the node of the calling thread
+  int* localHashTable(QueryParams* params, ColumnInfo* pkey) {
+    map<ColumnInfo*, vector<int*>>::iterator it = params->ht_CPU_node.find(pkey);
+    if (it == params->ht_CPU_node.end()) return params->ht_CPU[pkey];
+    return it->second[cm->numa->currentNode()];
+  }
+
+  //positional joins of the CPU pipeline of segment group sg probe a qualification bitmap by key - dense_base
+  void setPositional(probeArgsCPU& pargs, int sg) {
+    int* min_key[4] = {&pargs.min_key1, &pargs.min_key2, &pargs.min_key3, &pargs.min_key4};
+    int** pos_val[4] = {&pargs.pos_val1, &pargs.pos_val2, &pargs.pos_val3, &pargs.pos_val4};
+    for (int i = 0; i < qo->joinCPUPipelineCol[sg].size(); i++) {
+      ColumnInfo* pkey = qo->fkey_pkey[qo->joinCPUPipelineCol[sg][i]];
+      if (!qo->positionalJoin(pkey)) continue;
+      int table = pkey->table_id - 1;
+      pargs.positional |= 1 << table;
+      *min_key[table] = pkey->dense_base;
+      if (qo->groupby_build.size() > 0 && qo->groupby_build[pkey].size() > 0)
+        *pos_val[table] = qo->groupby_build[pkey][0]->col_ptr;
+    }
+  }
+
   void switch_device_fact(int** &off_col, int** &h_off_col, int* &d_total, int* h_total, int sg, int mode, int table, cudaStream_t stream);
 
   void call_pfilter_probe_GPU(QueryParams* params, int** &off_col, int* &d_total, int* h_total, int sg, int select_so_far, cudaStream_t stream);
@@ -78,6 +104,8 @@ public:
 
   void call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg);
 
+  ColumnInfo* radixProbeFirst(QueryParams* params, probeArgsCPU& pargs, int** &h_off_col, int* h_total, int sg);
+
   void call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_total, int* h_total, int sg, int select_so_far, cudaStream_t stream);
 
   void call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg, int select_so_far);
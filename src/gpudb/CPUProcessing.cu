@@ -1,4 +1,9 @@
 #include "CPUProcessing.h"
+#include "../cpu/radix-join/types.h"
+
+bool PerfCounters::enabled = false;
+PerfSlot PerfCounters::slot[TOT_PERF_OP][PERF_MAX_GROUPS];
+thread_local PerfSlot* PerfCounters::current = NULL;
 
 void filter_probe_CPU(
   struct filterArgsCPU fargs, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
@@ -10,7 +15,11 @@ void filter_probe_CPU(
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -26,7 +35,6 @@ void filter_probe_CPU(
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
               long long slot;
               int slot4 = 1;
               int lo_offset;
@@ -37,8 +45,7 @@ void filter_probe_CPU(
 
                 if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
 
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
                 slot4 = slot >> 32;
 
@@ -51,7 +58,6 @@ void filter_probe_CPU(
           }
 
           for (int i = end_batch ; i < end; i++) {
-              int hash;
               long long slot;
               int slot4 = 1;
               int lo_offset;
@@ -62,8 +68,7 @@ void filter_probe_CPU(
 
                 if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
 
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
                 slot4 = slot >> 32;
 
@@ -95,7 +100,11 @@ void filter_probe_CPU2(struct offsetCPU in_off, struct filterArgsCPU fargs, stru
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -110,7 +119,6 @@ void filter_probe_CPU2(struct offsetCPU in_off, struct filterArgsCPU fargs, stru
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
               long long slot;
               int slot4 = 1;
               int lo_offset;
@@ -121,10 +129,13 @@ void filter_probe_CPU2(struct offsetCPU in_off, struct filterArgsCPU fargs, stru
 
                 if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
 
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
-                slot4 = slot >> 32;
+                if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
+                  slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
+                  if (slot == 0) continue;
+                  slot4 = slot >> 32;
+                } else if (in_off.h_dim_off4 != NULL) {
+                  slot4 = in_off.h_dim_off4[start_offset + i] + 1;
+                }
 
               temp[0][count] = lo_offset;
               temp[4][count] = slot4-1;
@@ -134,7 +145,6 @@ void filter_probe_CPU2(struct offsetCPU in_off, struct filterArgsCPU fargs, stru
           }
 
           for (int i = end_batch ; i < end; i++) {
-            int hash;
             long long slot;
             int slot4 = 1;
             int lo_offset;
@@ -145,10 +155,13 @@ void filter_probe_CPU2(struct offsetCPU in_off, struct filterArgsCPU fargs, stru
 
               if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
 
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
-              slot4 = slot >> 32;
+              if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
+                if (slot == 0) continue;
+                slot4 = slot >> 32;
+              } else if (in_off.h_dim_off4 != NULL) {
+                slot4 = in_off.h_dim_off4[start_offset + i] + 1;
+              }
 
 
             temp[0][count] = lo_offset;
@@ -177,7 +190,11 @@ void probe_CPU(
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -193,7 +210,6 @@ void probe_CPU(
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-            int hash;
             long long slot;
             int slot1 = 1, slot2 = 1, slot3 = 1, slot4 = 1;
             int lo_offset;
@@ -201,29 +217,25 @@ void probe_CPU(
             lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
 
             if (pargs.ht1 != NULL && pargs.key_col1 != NULL) {
-              hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-              slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+              slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
               if (slot == 0) continue;
               slot1 = slot >> 32;
             }
 
             if (pargs.ht2 != NULL && pargs.key_col2 != NULL) {
-              hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-              slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+              slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
               if (slot == 0) continue;
               slot2 = slot >> 32;
             }
 
             if (pargs.ht3 != NULL && pargs.key_col3 != NULL) {
-              hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-              slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+              slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
               if (slot == 0) continue;
               slot3 = slot >> 32;
             }
 
             if (pargs.ht4 != NULL && pargs.key_col4 != NULL) {
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+              slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
               if (slot == 0) continue;
               slot4 = slot >> 32;
             }
@@ -239,7 +251,6 @@ void probe_CPU(
           }
 
           for (int i = end_batch ; i < end; i++) {
-            int hash;
             long long slot;
             int slot1 = 1, slot2 = 1, slot3 = 1, slot4 = 1;
             int lo_offset;
@@ -247,29 +258,25 @@ void probe_CPU(
             lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
 
             if (pargs.ht1 != NULL && pargs.key_col1 != NULL) {
-              hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-              slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+              slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
               if (slot == 0) continue;
               slot1 = slot >> 32;
             }
 
             if (pargs.ht2 != NULL && pargs.key_col2 != NULL) {
-              hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-              slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+              slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
               if (slot == 0) continue;
               slot2 = slot >> 32;
             }
 
             if (pargs.ht3 != NULL && pargs.key_col3 != NULL) {
-              hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-              slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+              slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
               if (slot == 0) continue;
               slot3 = slot >> 32;
             }
 
             if (pargs.ht4 != NULL && pargs.key_col4 != NULL) {
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+              slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
               if (slot == 0) continue;
               slot4 = slot >> 32;
             }
@@ -307,7 +314,11 @@ void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offse
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -322,7 +333,6 @@ void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offse
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
               long long slot;
               int slot1 = 1, slot2 = 1, slot3 = 1, slot4 = 1;
               int lo_offset;
@@ -330,32 +340,28 @@ void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offse
               lo_offset = in_off.h_lo_off[start_offset + i];
 
               if (pargs.ht1 != NULL && pargs.key_col1 != NULL) {
-                hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-                slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+                slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
                 if (slot == 0) continue;
                 slot1 = slot >> 32;
               } else if (in_off.h_dim_off1 != NULL) slot1 = in_off.h_dim_off1[start_offset + i] + 1;
 
 
               if (pargs.ht2 != NULL && pargs.key_col2 != NULL) {
-                hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-                slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+                slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
                 if (slot == 0) continue;
                 slot2 = slot >> 32;
               } else if (in_off.h_dim_off2 != NULL) slot2 = in_off.h_dim_off2[start_offset + i] + 1;
 
 
               if (pargs.ht3 != NULL && pargs.key_col3 != NULL) {
-                hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-                slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+                slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
                 if (slot == 0) continue;
                 slot3 = slot >> 32;
               } else if (in_off.h_dim_off3 != NULL) slot3 = in_off.h_dim_off3[start_offset + i] + 1;
 
 
               if (pargs.ht4 != NULL && pargs.key_col4 != NULL) {
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
                 slot4 = slot >> 32;
               } else if (in_off.h_dim_off4 != NULL) slot4 = in_off.h_dim_off4[start_offset + i] + 1;
@@ -373,7 +379,6 @@ void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offse
           }
 
           for (int i = end_batch ; i < end; i++) {
-              int hash;
               long long slot;
               int slot1 = 1, slot2 = 1, slot3 = 1, slot4 = 1;
               int lo_offset;
@@ -381,32 +386,28 @@ void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offse
               lo_offset = in_off.h_lo_off[start_offset + i];
 
               if (pargs.ht1 != NULL && pargs.key_col1 != NULL) {
-                hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-                slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+                slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
                 if (slot == 0) continue;
                 slot1 = slot >> 32;
               } else if (in_off.h_dim_off1 != NULL) slot1 = in_off.h_dim_off1[start_offset + i] + 1;
 
 
               if (pargs.ht2 != NULL && pargs.key_col2 != NULL) {
-                hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-                slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+                slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
                 if (slot == 0) continue;
                 slot2 = slot >> 32;
               } else if (in_off.h_dim_off2 != NULL) slot2 = in_off.h_dim_off2[start_offset + i] + 1;
 
 
               if (pargs.ht3 != NULL && pargs.key_col3 != NULL) {
-                hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-                slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+                slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
                 if (slot == 0) continue;
                 slot3 = slot >> 32;
               } else if (in_off.h_dim_off3 != NULL) slot3 = in_off.h_dim_off3[start_offset + i] + 1;
 
 
               if (pargs.ht4 != NULL && pargs.key_col4 != NULL) {
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
                 slot4 = slot >> 32;
               } else if (in_off.h_dim_off4 != NULL) slot4 = in_off.h_dim_off4[start_offset + i] + 1;
@@ -436,6 +437,154 @@ void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offse
 }
 
 
+//radix bits so that one partition probes at most RADIX_PARTITION_BYTES of a hash table with dim_len slots
+int radix_bits_CPU(int dim_len) {
+  int bits = 0;
+  while (bits < RADIX_MAX_BITS && (((size_t) dim_len * 2 * sizeof(int)) >> bits) > RADIX_PARTITION_BYTES) bits++;
+  return bits;
+}
+
+//Radix-partitioned probe of a single hash table (parallel radix join of src/cpu/radix-join).
+//The CPU hash tables are perfect hashes on key - min_key, so the dimension side is already clustered:
+//the fact tuples are partitioned on the high bits of their slot and each partition then probes
+//one cache-resident slice of the table instead of missing to DRAM on every tuple.
+//Input is in_off (or the segment group when in_off.h_lo_off is NULL), output is written to out_off like probe_CPU2.
+//The histograms and the partitioned tuples come from arena, the processing memory of the query (malloc if NULL).
+void probe_radix_CPU(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
+  int* total, int radix_bits, short* segment_group = NULL, ProcessingArena* arena = NULL) {
+
+  assert(in_off.h_lo_off != NULL || segment_group != NULL);
+  assert(out_off.h_lo_off != NULL);
+
+  int* key_col[4] = {pargs.key_col1, pargs.key_col2, pargs.key_col3, pargs.key_col4};
+  int* ht[4] = {pargs.ht1, pargs.ht2, pargs.ht3, pargs.ht4};
+  int dim_len[4] = {pargs.dim_len1, pargs.dim_len2, pargs.dim_len3, pargs.dim_len4};
+  int min_key[4] = {pargs.min_key1, pargs.min_key2, pargs.min_key3, pargs.min_key4};
+  int* in_dim[4] = {in_off.h_dim_off1, in_off.h_dim_off2, in_off.h_dim_off3, in_off.h_dim_off4};
+  int* out_dim[4] = {out_off.h_dim_off1, out_off.h_dim_off2, out_off.h_dim_off3, out_off.h_dim_off4};
+
+  //exactly one hash table is probed here, the other joins of the pipeline are done by probe_CPU
+  int table = -1;
+  for (int t = 0; t < 4; t++) {
+    if (ht[t] != NULL && key_col[t] != NULL) {
+      assert(table == -1);
+      table = t;
+    }
+  }
+  assert(table != -1);
+  if (num_tuples == 0) return;
+
+  int* fkey = key_col[table];
+  long long* slots = reinterpret_cast<long long*>(ht[table]);
+  int len = dim_len[table], min_val = min_key[table];
+
+  int shift = 0;
+  while (((len - 1) >> shift) >= (1 << radix_bits)) shift++;
+  int fanout = ((len - 1) >> shift) + 1;
+
+  int chunk_count = min((num_tuples + TASK_SIZE - 1)/TASK_SIZE, RADIX_MAX_CHUNKS);
+  int chunk_size = (num_tuples + chunk_count - 1)/chunk_count;
+
+  auto lo_offset = [&](int i) {
+    if (in_off.h_lo_off != NULL) return in_off.h_lo_off[i];
+    return segment_group[i / SEGMENT_SIZE] * SEGMENT_SIZE + (i % SEGMENT_SIZE);
+  };
+
+  size_t hist_bytes = (size_t) chunk_count * fanout * sizeof(unsigned int), part_bytes = (size_t) num_tuples * sizeof(tuple_t);
+  unsigned int* hist;
+  tuple_t* part;
+  if (arena != NULL) {
+    hist = (unsigned int*) arena->allocate((hist_bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    part = (tuple_t*) arena->allocate((part_bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  } else {
+    hist = (unsigned int*) malloc(hist_bytes);
+    part = (tuple_t*) malloc(part_bytes);
+  }
+  memset(hist, 0, hist_bytes);
+
+  PerfSlot* perf_slot = PerfCounters::current;
+
+  //1. histogram per chunk
+  parallel_for(blocked_range<size_t>(0, chunk_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
+    for (int chunk = range.begin(); chunk < range.end(); chunk++) {
+      unsigned int* my_hist = hist + chunk * fanout;
+      int end = min(num_tuples, (chunk + 1) * chunk_size);
+      for (int i = chunk * chunk_size; i < end; i++) {
+        int hash = HASH(fkey[lo_offset(i)], len, min_val);
+        my_hist[hash >> shift]++;
+      }
+    }
+  }, simple_partitioner());
+
+  //2. partition-major prefix sum, chunk c writes partition p at hist[c][p]
+  unsigned int sum = 0;
+  for (int p = 0; p < fanout; p++) {
+    for (int chunk = 0; chunk < chunk_count; chunk++) {
+      unsigned int count = hist[chunk * fanout + p];
+      hist[chunk * fanout + p] = sum;
+      sum += count;
+    }
+  }
+
+  //3. scatter (input index, slot) pairs
+  parallel_for(blocked_range<size_t>(0, chunk_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
+    for (int chunk = range.begin(); chunk < range.end(); chunk++) {
+      unsigned int* dst = hist + chunk * fanout;
+      int end = min(num_tuples, (chunk + 1) * chunk_size);
+      for (int i = chunk * chunk_size; i < end; i++) {
+        int hash = HASH(fkey[lo_offset(i)], len, min_val);
+        tuple_t& tuple = part[dst[hash >> shift]++];
+        tuple.payload = i;
+        tuple.key = hash;
+      }
+    }
+  }, simple_partitioner());
+
+  //4. probe in TASK_SIZE blocks of the partitioned tuples, consecutive blocks hit the same slice of the table
+  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
+
+  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
+    for (int task = range.begin(); task < range.end(); task++) {
+      int start = task * TASK_SIZE;
+      int end = min(num_tuples, start + TASK_SIZE);
+
+      unsigned int count = 0;
+      unsigned int temp[2][end - start];
+
+      for (int j = start; j < end; j++) {
+        long long slot = slots[part[j].key];
+        if (slot == 0) continue;
+        temp[0][count] = part[j].payload;
+        temp[1][count] = (slot >> 32) - 1;
+        count++;
+      }
+
+      int thread_off = __atomic_fetch_add(total, count, __ATOMIC_RELAXED);
+
+      for (int j = 0; j < count; j++) {
+        int i = temp[0][j];
+        out_off.h_lo_off[thread_off+j] = lo_offset(i);
+        for (int t = 0; t < 4; t++) {
+          if (out_dim[t] == NULL) continue;
+          if (t == table) out_dim[t][thread_off+j] = temp[1][j];
+          else out_dim[t][thread_off+j] = (in_dim[t] != NULL) ? in_dim[t][i] : 0;
+        }
+      }
+    }
+  }, simple_partitioner());
+
+  if (arena == NULL) {
+    free(part);
+    free(hist);
+  }
+}
+
 void probe_group_by_CPU(
   struct probeArgsCPU pargs,  struct groupbyArgsCPU gargs, int num_tuples, 
   int* res, int start_offset = 0, short* segment_group = NULL) {
@@ -445,7 +594,11 @@ void probe_group_by_CPU(
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -467,29 +620,25 @@ void probe_group_by_CPU(
               lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
 
               if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-                hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-                slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+                slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
                 if (slot == 0) continue;
                 dim_val1 = slot;
               }
 
               if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-                hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-                slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+                slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
                 if (slot == 0) continue;
                 dim_val2 = slot;
               }
 
               if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-                hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-                slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+                slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
                 if (slot == 0) continue;
                 dim_val3 = slot;
               }
 
               if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
                 dim_val4 = slot;
               }
@@ -520,29 +669,25 @@ void probe_group_by_CPU(
             lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
 
             if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-              hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-              slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+              slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
               if (slot == 0) continue;
               dim_val1 = slot;
             }
 
             if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-              hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-              slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+              slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
               if (slot == 0) continue;
               dim_val2 = slot;
             }
 
             if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-              hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-              slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+              slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
               if (slot == 0) continue;
               dim_val3 = slot;
             }
 
             if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+              slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
               if (slot == 0) continue;
               dim_val4 = slot;
             }
@@ -576,7 +721,11 @@ void probe_group_by_CPU2(struct offsetCPU offset,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -596,8 +745,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               lo_offset = offset.h_lo_off[start_offset + i];
 
               if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-                hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-                slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+                slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
                 if (slot == 0) continue;
                 dim_val1 = slot;
               } else if (gargs.group_col1 != NULL) {
@@ -606,8 +754,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-                hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-                slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+                slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
                 if (slot == 0) continue;
                 dim_val2 = slot;
               } else if (gargs.group_col2 != NULL) {
@@ -616,8 +763,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-                hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-                slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+                slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
                 if (slot == 0) continue;
                 dim_val3 = slot;
               } else if (gargs.group_col3 != NULL) {
@@ -626,8 +772,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
                 dim_val4 = slot;
               } else if (gargs.group_col4 != NULL) {
@@ -661,8 +806,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               lo_offset = offset.h_lo_off[start_offset + i];
 
               if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-                hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-                slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
+                slot = PROBE_SLOT(pargs, 1, pargs.key_col1[lo_offset]);
                 if (slot == 0) continue;
                 dim_val1 = slot;
               } else if (gargs.group_col1 != NULL) {
@@ -671,8 +815,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-                hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-                slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
+                slot = PROBE_SLOT(pargs, 2, pargs.key_col2[lo_offset]);
                 if (slot == 0) continue;
                 dim_val2 = slot;
               } else if (gargs.group_col2 != NULL) {
@@ -681,8 +824,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-                hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-                slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
+                slot = PROBE_SLOT(pargs, 3, pargs.key_col3[lo_offset]);
                 if (slot == 0) continue;
                 dim_val3 = slot;
               } else if (gargs.group_col3 != NULL) {
@@ -691,8 +833,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
                 dim_val4 = slot;
               } else if (gargs.group_col4 != NULL) {
@@ -731,7 +872,11 @@ void build_CPU(struct filterArgsCPU fargs,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -803,7 +948,11 @@ void build_CPU2(int *dim_off, struct filterArgsCPU fargs,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -843,6 +992,86 @@ void build_CPU2(int *dim_off, struct filterArgsCPU fargs,
   }, simple_partitioner());
 }
 
+//Build of a positional join: sets the bit of every qualifying dimension row, the key column and the group column
+//are not read. A task covers whole words of the bitmap (TASK_SIZE and SEGMENT_SIZE are multiples of 32).
+void build_positional_CPU(struct filterArgsCPU fargs, int num_tuples, unsigned int* qual,
+  int start_offset = 0, short* segment_group = NULL) {
+
+  assert(qual != NULL);
+  assert(segment_group != NULL);
+
+  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
+  int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
+
+  PerfSlot* perf_slot = PerfCounters::current;
+
+  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
+    unsigned int start_task = range.begin();
+    unsigned int end_task = range.end();
+
+    for (int task = start_task; task < end_task; task++) {
+          unsigned int start = task * TASK_SIZE;
+          unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
+
+          int segment_idx = segment_group[start / SEGMENT_SIZE];
+
+          for (unsigned int word_start = start; word_start < end; word_start += 32) {
+            int table_offset = segment_idx * SEGMENT_SIZE + (word_start % SEGMENT_SIZE);
+            int n = min(end - word_start, 32u);
+            unsigned int word;
+
+            if (fargs.filter_col1 == NULL) {
+              word = (n == 32) ? (~0u) : ((1u << n) - 1);
+            } else {
+              word = 0;
+              for (int j = 0; j < n; j++) {
+                int flag = 1;
+                if (fargs.mode1 == 1)
+                  flag = (fargs.filter_col1[table_offset + j] >= fargs.compare1 && fargs.filter_col1[table_offset + j] <= fargs.compare2);
+                else if (fargs.mode1 == 2)
+                  flag = (fargs.filter_col1[table_offset + j] == fargs.compare1 || fargs.filter_col1[table_offset + j] == fargs.compare2);
+                word |= (unsigned int) flag << j;
+              }
+            }
+
+            if (word != 0) __atomic_fetch_or(&qual[table_offset >> 5], word, __ATOMIC_RELAXED);
+          }
+    }
+
+  });
+}
+
+void build_positional_CPU2(int *dim_off, int num_tuples, unsigned int* qual,
+  int start_offset = 0) {
+
+  assert(qual != NULL);
+  assert(dim_off != NULL);
+
+  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
+  int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
+
+  PerfSlot* perf_slot = PerfCounters::current;
+
+  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
+    unsigned int start_task = range.begin();
+    unsigned int end_task = range.end();
+
+    for (int task = start_task; task < end_task; task++) {
+          unsigned int start = task * TASK_SIZE;
+          unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
+
+          for (int i = start; i < end; i++) {
+            int table_offset = dim_off[start_offset + i];
+            __atomic_fetch_or(&qual[table_offset >> 5], 1u << (table_offset & 31), __ATOMIC_RELAXED);
+          }
+    }
+
+  }, simple_partitioner());
+}
 
 void filter_CPU(struct filterArgsCPU fargs,
   int* out_off, int num_tuples, int* total,
@@ -853,7 +1082,11 @@ void filter_CPU(struct filterArgsCPU fargs,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -943,7 +1176,11 @@ void filter_CPU2(int* off_col, struct filterArgsCPU fargs,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1027,7 +1264,11 @@ void groupByCPU(struct offsetCPU offset,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1134,7 +1375,11 @@ void aggregationCPU(int* lo_off,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
     long long local_sum = 0;
@@ -1186,7 +1431,11 @@ void probe_aggr_CPU(
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1202,14 +1451,12 @@ void probe_aggr_CPU(
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
               long long slot;
               int lo_offset;
 
               lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
 
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
 
               int aggrval1 = 0, aggrval2 = 0;
@@ -1221,15 +1468,12 @@ void probe_aggr_CPU(
           }
 
           for (int i = end_batch ; i < end; i++) {
-
-            int hash;
             long long slot;
             int lo_offset;
 
             lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
 
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+              slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
               if (slot == 0) continue;
 
             int aggrval1 = 0, aggrval2 = 0;
@@ -1255,7 +1499,11 @@ void probe_aggr_CPU2(struct offsetCPU offset,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1269,15 +1517,15 @@ void probe_aggr_CPU2(struct offsetCPU offset,
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
               long long slot;
               int lo_offset;
 
               lo_offset = offset.h_lo_off[start_offset + i];
 
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
+                if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
+                  slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
+                  if (slot == 0) continue;
+                }
 
               int aggrval1 = 0, aggrval2 = 0;
               if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
@@ -1289,16 +1537,15 @@ void probe_aggr_CPU2(struct offsetCPU offset,
           }
 
           for (int i = end_batch ; i < end; i++) {
-
-            int hash;
             long long slot;
             int lo_offset;
 
             lo_offset = offset.h_lo_off[start_offset + i];
 
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
+              if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
+                if (slot == 0) continue;
+              }
 
               int aggrval1 = 0, aggrval2 = 0;
               if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
@@ -1323,7 +1570,11 @@ void filter_probe_aggr_CPU(
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1339,7 +1590,6 @@ void filter_probe_aggr_CPU(
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
               long long slot;
               int lo_offset;
 
@@ -1351,8 +1601,7 @@ void filter_probe_aggr_CPU(
                 if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
                 // if (!(*(fargs.h_filter_func2))(fargs.filter_col2[lo_offset], fargs.compare3, fargs.compare4)) continue;
 
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
                 if (slot == 0) continue;
 
               int aggrval1 = 0, aggrval2 = 0;
@@ -1365,8 +1614,6 @@ void filter_probe_aggr_CPU(
           }
 
           for (int i = end_batch ; i < end; i++) {
-
-            int hash;
             long long slot;
             int lo_offset;
 
@@ -1378,8 +1625,7 @@ void filter_probe_aggr_CPU(
               if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
               // if (!(*(fargs.h_filter_func2))(fargs.filter_col2[lo_offset], fargs.compare3, fargs.compare4)) continue;
 
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+              slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
               if (slot == 0) continue;
 
               int aggrval1 = 0, aggrval2 = 0;
@@ -1407,7 +1653,11 @@ void filter_probe_aggr_CPU2(struct offsetCPU offset,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1421,18 +1671,19 @@ void filter_probe_aggr_CPU2(struct offsetCPU offset,
           for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
               long long slot;
               int lo_offset;
 
               lo_offset = offset.h_lo_off[start_offset + i];
 
+                if (fargs.filter_col1 != NULL && !(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //filter_col1 is NULL if an earlier operator applied it
                 if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
                 // if (!(*(fargs.h_filter_func2))(fargs.filter_col2[lo_offset], fargs.compare3, fargs.compare4)) continue;
 
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
+                if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
+                  slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
+                  if (slot == 0) continue;
+                }
 
               int aggrval1 = 0, aggrval2 = 0;
               if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
@@ -1443,19 +1694,19 @@ void filter_probe_aggr_CPU2(struct offsetCPU offset,
           }
 
           for (int i = end_batch ; i < end; i++) {
-
-            int hash;
             long long slot;
             int lo_offset;
 
             lo_offset = offset.h_lo_off[start_offset + i];
 
+              if (fargs.filter_col1 != NULL && !(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //filter_col1 is NULL if an earlier operator applied it
               if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
               // if (!(*(fargs.h_filter_func2))(fargs.filter_col2[lo_offset], fargs.compare3, fargs.compare4)) continue;
 
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
+              if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
+                slot = PROBE_SLOT(pargs, 4, pargs.key_col4[lo_offset]);
+                if (slot == 0) continue;
+              }
 
               int aggrval1 = 0, aggrval2 = 0;
               if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
@@ -1477,7 +1728,11 @@ void merge(int* resCPU, int* resGPU, int num_tuples) {
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1518,7 +1773,11 @@ void build_CPU_minmax(struct filterArgsCPU fargs,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -1607,7 +1866,11 @@ void build_CPU_minmax2(int *dim_off, struct filterArgsCPU fargs,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  PerfSlot* perf_slot = PerfCounters::current;
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    PerfScope perf_scope(perf_slot);
+
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
 
@@ -3,10 +3,34 @@
 
 #include "common.h"
 #include "KernelArgs.h"
+#include "PerfCounters.h"
 
+//BATCH_SIZE and TASK_SIZE can be overridden at compile time (see the microbench target of the Makefile)
+#ifndef BATCH_SIZE
 #define BATCH_SIZE 256
+#endif
 #define NUM_THREADS 48
+#ifndef TASK_SIZE
 #define TASK_SIZE 1024 //! TASK_SIZE must be a factor of SEGMENT_SIZE and must be less than 20000
+#endif
+
+//radix-partitioned probe: one partition covers at most RADIX_PARTITION_BYTES of the hash table (about the L2 cache)
+#define RADIX_PARTITION_BYTES (256 << 10)
+#define RADIX_MAX_BITS 16
+#define RADIX_MAX_CHUNKS 256 //input chunks with their own histogram
+
+//positional join: the slot of a qualifying dimension row, group value in the low and row + 1 in the high half like a
+//hash table slot, 0 if the row does not qualify
+inline long long positional_slot(unsigned int* qual, int* val, int row) {
+  if (((qual[row >> 5] >> (row & 31)) & 1) == 0) return 0;
+  return ((long long) (row + 1) << 32) | (unsigned int) ((val != NULL) ? val[row] : 0);
+}
+
+//slot of join N of the probe args P for KEY, by hash or, for a positional join, by row key - min_key
+#define PROBE_SLOT(P, N, KEY) \
+  ((((P).positional >> ((N) - 1)) & 1) ? \
+    positional_slot(reinterpret_cast<unsigned int*>((P).ht##N), (P).pos_val##N, (KEY) - (P).min_key##N) : \
+    reinterpret_cast<long long*>((P).ht##N)[HASH(KEY, (P).dim_len##N, (P).min_key##N)])
 
 void filter_probe_CPU(
   struct filterArgsCPU fargs, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
@@ -22,6 +46,11 @@ void probe_CPU(
 void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
   int* total, int start_offset);
 
+void probe_radix_CPU(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
+  int* total, int radix_bits, short* segment_group, ProcessingArena* arena);
+
+int radix_bits_CPU(int dim_len);
+
 void probe_group_by_CPU(
   struct probeArgsCPU pargs,  struct groupbyArgsCPU gargs, int num_tuples, 
   int* res, int start_offset, short* segment_group);
@@ -38,6 +67,12 @@ void build_CPU2(int *dim_off, struct filterArgsCPU fargs,
   struct buildArgsCPU bargs, int num_tuples, int* hash_table,
   int start_offset);
 
+void build_positional_CPU(struct filterArgsCPU fargs, int num_tuples, unsigned int* qual,
+  int start_offset, short* segment_group);
+
+void build_positional_CPU2(int *dim_off, int num_tuples, unsigned int* qual,
+  int start_offset);
+
 void filter_CPU(struct filterArgsCPU fargs,
   int* out_off, int num_tuples, int* total,
   int start_offset, short* segment_group);
@@ -2,18 +2,65 @@
 
 Segment::Segment(ColumnInfo* _column, int* _seg_ptr, int _priority)
 : column(_column), seg_ptr(_seg_ptr), priority(_priority), seg_size(SEGMENT_SIZE) {
-	stats = new Statistics();
 	col_ptr = column->col_ptr;
 	segment_id = (seg_ptr - col_ptr)/seg_size;
-	weight = 0;
+	stats_idx = -1;
 }
 
 Segment::Segment(ColumnInfo* _column, int* _seg_ptr)
 : column(_column), seg_ptr(_seg_ptr), priority(0), seg_size(SEGMENT_SIZE) {
-	stats = new Statistics();
 	col_ptr = column->col_ptr;
 	segment_id = (seg_ptr - col_ptr)/seg_size;
-	weight = 0;
+	stats_idx = -1;
+}
+
+SegmentStatistics::SegmentStatistics(vector<ColumnInfo*>& columns) {
+	TOT_COLUMN = columns.size();
+	offset = new int[TOT_COLUMN];
+	total_segment = 0;
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		offset[i] = total_segment;
+		total_segment += columns[i]->max_segment;
+	}
+	data_size = total_segment * (7 * sizeof(double) + sizeof(char));
+	data = (char*) malloc(data_size);
+	memset(data, 0, data_size);
+	setPointers();
+}
+
+SegmentStatistics::SegmentStatistics(const SegmentStatistics& other) {
+	TOT_COLUMN = other.TOT_COLUMN;
+	total_segment = other.total_segment;
+	offset = new int[TOT_COLUMN];
+	memcpy(offset, other.offset, TOT_COLUMN * sizeof(int));
+	data_size = other.data_size;
+	data = (char*) malloc(data_size);
+	memcpy(data, other.data, data_size);
+	setPointers();
+}
+
+SegmentStatistics::~SegmentStatistics() {
+	delete[] offset;
+	free(data);
+}
+
+void
+SegmentStatistics::setPointers() {
+	double* base = reinterpret_cast<double*>(data);
+	col_freq = base;
+	timestamp = base + total_segment;
+	speedup = base + 2 * total_segment;
+	backward_t = base + 3 * total_segment;
+	weight = base + 4 * total_segment;
+	decay_t = base + 5 * total_segment;
+	cost = base + 6 * total_segment;
+	cached = reinterpret_cast<char*>(base + 7 * total_segment);
+}
+
+void
+SegmentStatistics::copyFrom(const SegmentStatistics* other) {
+	assert(data_size == other->data_size);
+	memcpy(data, other->data, data_size);
 }
 
 ColumnInfo::ColumnInfo(string _column_name, string _table_name, int _LEN, int _column_id, int _table_id, int* _col_ptr)
@@ -22,7 +69,10 @@ ColumnInfo::ColumnInfo(string _column_name, string _table_name, int _LEN, int _c
 	tot_seg_in_GPU = 0;
 	weight = 0;
 	seg_ptr = col_ptr;
+	dense = false;
+	dense_base = 0;
 	total_segment = (LEN+SEGMENT_SIZE-1)/SEGMENT_SIZE;
+	max_segment = total_segment;
 	printf("ColumnInfo: Column %s has %d entries total_segment %d\n", column_name.c_str(), LEN, total_segment);
 }
 
@@ -32,7 +82,7 @@ ColumnInfo::getSegment(int index) {
 	return seg;
 }
 
-CacheManager::CacheManager(size_t _cache_size, size_t _processing_size, size_t _pinned_memsize) {
+CacheManager::CacheManager(size_t _cache_size, size_t _processing_size, size_t _pinned_memsize, GPUCacheTier* _tier) {
 	cache_size = _cache_size;
 	cache_total_seg = _cache_size/SEGMENT_SIZE;
 	processing_size = _processing_size;
@@ -40,14 +90,19 @@ CacheManager::CacheManager(size_t _cache_size, size_t _processing_size, size_t _
 	TOT_COLUMN = 25;
 	TOT_TABLE = 5;
 
-	CubDebugExit(cudaMalloc((void**) &gpuCache, (cache_size) * sizeof(int)));
-	CubDebugExit(cudaMemset(gpuCache, 0, (cache_size) * sizeof(int)));
+	host_only = false;
+	numa = new NumaTopology();
+	tier = (_tier != NULL) ? _tier : new GPUCacheTier();
+	tier->allocate(cache_size);
+	migration = NULL;
+	defer_placement = false;
+	gpuCache = tier->buffer;
 	CubDebugExit(cudaMalloc((void**) &gpuProcessing, _processing_size * sizeof(uint64_t)));
 
 	printf ("(cache_size) * sizeof(int): %ld\n", (cache_size) * sizeof(int));
 	printf ("_processing_size * sizeof(uint64_t): %ld\n", _processing_size * sizeof(uint64_t));
 
-	cpuProcessing = (uint64_t*) malloc(_processing_size * sizeof(uint64_t));
+	cpuProcessing = (uint64_t*) numa->allocate(_processing_size * sizeof(uint64_t), NumaInterleave);
 	{   size_t free_byte ;
         size_t total_byte ;
         cudaError_t cuda_status = cudaMemGetInfo( &free_byte, &total_byte ) ;
@@ -64,17 +119,25 @@ CacheManager::CacheManager(size_t _cache_size, size_t _processing_size, size_t _
     }
 
 	printf ("_pinned_memsize * sizeof(uint64_t): %ld\n", _pinned_memsize * sizeof(uint64_t));
-	// CubDebugExit(cudaHostAlloc((void**) &pinnedMemory, _pinned_memsize * sizeof(uint64_t), cudaHostAllocDefault));
-	pinnedMemory = (uint64_t*) malloc (_pinned_memsize * sizeof(uint64_t));
-	gpuPointer = 0;
-	cpuPointer = 0;
-	pinnedPointer = 0;
+	//pinned as in resetCache, which frees it with cudaFreeHost; its spills are pinned too
+	CubDebugExit(cudaHostAlloc((void**) &pinnedMemory, _pinned_memsize * sizeof(uint64_t), cudaHostAllocDefault));
+	cpu_pool = new ChunkPool(cpuProcessing, _processing_size, HostChunk);
+	pinned_pool = new ChunkPool(pinnedMemory, _pinned_memsize, PinnedChunk);
+	gpu_pool = new ChunkPool(gpuProcessing, _processing_size, DeviceChunk);
+
+	decay_clock = 0;
+	logical_time = 0;
+	half_life = 0;
+
+	gdsf_clock = 0;
+	arc_target = 0;
 
 	cached_seg_in_GPU.resize(TOT_COLUMN);
 	allColumn.resize(TOT_COLUMN);
 
 	index_to_segment.resize(TOT_COLUMN);
 
+	residency_epoch = 0;
 	for(int i = 0; i < cache_total_seg; i++) {
 		empty_gpu_segment.push(i);
 	}
@@ -85,76 +148,198 @@ CacheManager::CacheManager(size_t _cache_size, size_t _processing_size, size_t _
 	segment_list = (int**) malloc (TOT_COLUMN * sizeof(int*));
 	segment_min = (int**) malloc (TOT_COLUMN * sizeof(int*));
 	segment_max = (int**) malloc (TOT_COLUMN * sizeof(int*));
+	lo_segment_min = (int**) calloc (TOT_COLUMN, sizeof(int*));
+	lo_segment_max = (int**) calloc (TOT_COLUMN, sizeof(int*));
+
+	seg_stats = new SegmentStatistics(allColumn);
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
-		int n = allColumn[i]->total_segment;
-		segment_bitmap[i] = (char*) malloc(n * sizeof(char));
-		CubDebugExit(cudaHostAlloc((void**) &(segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
+		int n = allColumn[i]->max_segment;
+		segment_bitmap[i] = seg_stats->cached + seg_stats->offset[i];
+		segment_list[i] = allocSegmentList(n);
 
 		segment_min[i] = (int*) malloc(n * sizeof(int));
 		segment_max[i] = (int*) malloc(n * sizeof(int));
-
-		memset(segment_bitmap[i], 0, n * sizeof(char));
-		memset(segment_list[i], -1, n * sizeof(int));
 	}
 
 	readSegmentMinMax();
+	detectDenseKeys();
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		index_to_segment[i].resize(allColumn[i]->max_segment, NULL);
+		for (int j = 0; j < allColumn[i]->total_segment; j++) {
+			index_to_segment[i][j] = allColumn[i]->getSegment(j);
+			index_to_segment[i][j]->stats_idx = seg_stats->index(i, j);
+		}
+	}
+
+	lo_watermark = allColumn[columns_in_table[0][0]]->LEN;
+}
+
+//Cache of columns built by the caller (column_id i at position i) in a host tier. Makes no CUDA call and
+//has no query processing memory: the replacement policies, the migration engine, the statistics and the
+//snapshots work as with the SSB columns, queries cannot run. The caller keeps ownership of the columns.
+CacheManager::CacheManager(vector<ColumnInfo*>& columns, int _TOT_TABLE, size_t _cache_size, HostCacheTier* _tier) {
+	cache_size = _cache_size;
+	cache_total_seg = _cache_size/SEGMENT_SIZE;
+	processing_size = 0;
+	pinned_memsize = 0;
+	TOT_COLUMN = columns.size();
+	TOT_TABLE = _TOT_TABLE;
+
+	host_only = true;
+	numa = new NumaTopology();
+	tier = _tier;
+	tier->allocate(cache_size);
+	migration = NULL;
+	defer_placement = false;
+	gpuCache = tier->buffer;
+	gpuProcessing = cpuProcessing = pinnedMemory = NULL;
+	cpu_pool = pinned_pool = gpu_pool = NULL;
+
+	decay_clock = 0;
+	logical_time = 0;
+	half_life = 0;
+
+	gdsf_clock = 0;
+	arc_target = 0;
+
+	allColumn = columns;
+	cached_seg_in_GPU.resize(TOT_COLUMN);
+	index_to_segment.resize(TOT_COLUMN);
+	columns_in_table.resize(TOT_TABLE);
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		assert(allColumn[i]->column_id == i && allColumn[i]->table_id < TOT_TABLE);
+		columns_in_table[allColumn[i]->table_id].push_back(i);
+		//the columns may have been cached by an earlier instance
+		*(allColumn[i]->stats) = Statistics();
+		allColumn[i]->weight = 0;
+		allColumn[i]->tot_seg_in_GPU = 0;
+		allColumn[i]->seg_ptr = allColumn[i]->col_ptr;
+	}
+
+	residency_epoch = 0;
+	for(int i = 0; i < cache_total_seg; i++) {
+		empty_gpu_segment.push(i);
+	}
+
+	segment_bitmap = (char**) malloc (TOT_COLUMN * sizeof(char*));
+	segment_list = (int**) malloc (TOT_COLUMN * sizeof(int*));
+	segment_min = (int**) malloc (TOT_COLUMN * sizeof(int*));
+	segment_max = (int**) malloc (TOT_COLUMN * sizeof(int*));
+	lo_segment_min = (int**) calloc (TOT_COLUMN, sizeof(int*));
+	lo_segment_max = (int**) calloc (TOT_COLUMN, sizeof(int*));
+
+	seg_stats = new SegmentStatistics(allColumn);
+
+	//zone maps are computed from the data instead of read from DATA_DIR
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		ColumnInfo* column = allColumn[i];
+		int n = column->max_segment;
+		segment_bitmap[i] = seg_stats->cached + seg_stats->offset[i];
+		segment_list[i] = allocSegmentList(n);
+
+		segment_min[i] = (int*) malloc(n * sizeof(int));
+		segment_max[i] = (int*) malloc(n * sizeof(int));
+		for (int j = 0; j < column->total_segment; j++) {
+			int end = min(column->LEN, (j + 1) * SEGMENT_SIZE);
+			segment_min[i][j] = INT_MAX;
+			segment_max[i][j] = INT_MIN;
+			for (int row = j * SEGMENT_SIZE; row < end; row++) {
+				segment_min[i][j] = min(segment_min[i][j], column->col_ptr[row]);
+				segment_max[i][j] = max(segment_max[i][j], column->col_ptr[row]);
+			}
+		}
+	}
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
-		index_to_segment[i].resize(allColumn[i]->total_segment);
+		index_to_segment[i].resize(allColumn[i]->max_segment, NULL);
 		for (int j = 0; j < allColumn[i]->total_segment; j++) {
 			index_to_segment[i][j] = allColumn[i]->getSegment(j);
+			index_to_segment[i][j]->stats_idx = seg_stats->index(i, j);
 		}
 	}
-	
+
+	lo_watermark = allColumn[columns_in_table[0][0]]->LEN;
+}
+
+//slot of every segment of a column in the cache tier (-1 if not cached), each query copies it (QueryOptimizer::snapshotResidency)
+int*
+CacheManager::allocSegmentList(int n) {
+	int* list;
+	if (host_only) list = (int*) malloc(n * sizeof(int));
+	else CubDebugExit(cudaHostAlloc((void**) &list, n * sizeof(int), cudaHostAllocDefault));
+	memset(list, -1, n * sizeof(int));
+	return list;
+}
+
+void
+CacheManager::freeSegmentList(int* list) {
+	if (host_only) free(list);
+	else CubDebugExit(cudaFreeHost(list));
 }
 
 void
 CacheManager::resetCache(size_t _cache_size, size_t _processing_size, size_t _pinned_memsize) {
 
-	CubDebugExit(cudaFree(gpuCache));
-	CubDebugExit(cudaFree(gpuProcessing));
-	delete[] cpuProcessing;
-	CubDebugExit(cudaFreeHost(pinnedMemory));
+	if (migration != NULL) migration->cancel();
+	tier->release();
+	if (!host_only) {
+		delete cpu_pool;
+		delete pinned_pool;
+		delete gpu_pool;
+		CubDebugExit(cudaFree(gpuProcessing));
+		numa->release(cpuProcessing);
+		CubDebugExit(cudaFreeHost(pinnedMemory));
+	}
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
-		CubDebugExit(cudaFreeHost(segment_list[i]));
-		free(segment_bitmap[i]);
+		freeSegmentList(segment_list[i]);
 	}
 	free(segment_list);
-	free(segment_bitmap);
 
 	cache_size = _cache_size;
 	cache_total_seg = _cache_size/SEGMENT_SIZE;
-	processing_size = _processing_size;
-	pinned_memsize = _pinned_memsize;
 
-	CubDebugExit(cudaMalloc((void**) &gpuCache, (cache_size) * sizeof(int)));
-	CubDebugExit(cudaMemset(gpuCache, 0, (cache_size) * sizeof(int)));
-	CubDebugExit(cudaMalloc((void**) &gpuProcessing, _processing_size * sizeof(uint64_t)));
+	tier->allocate(cache_size);
+	gpuCache = tier->buffer;
 
-	cpuProcessing = (uint64_t*) malloc(_processing_size * sizeof(uint64_t));
-	CubDebugExit(cudaHostAlloc((void**) &pinnedMemory, _pinned_memsize * sizeof(uint64_t), cudaHostAllocDefault));
-	gpuPointer = 0;
-	cpuPointer = 0;
-	pinnedPointer = 0;
+	if (!host_only) {
+		processing_size = _processing_size;
+		pinned_memsize = _pinned_memsize;
+		CubDebugExit(cudaMalloc((void**) &gpuProcessing, _processing_size * sizeof(uint64_t)));
 
-	while (!empty_gpu_segment.empty()) {
-		empty_gpu_segment.pop();
+		cpuProcessing = (uint64_t*) numa->allocate(_processing_size * sizeof(uint64_t), NumaInterleave);
+		CubDebugExit(cudaHostAlloc((void**) &pinnedMemory, _pinned_memsize * sizeof(uint64_t), cudaHostAllocDefault));
+		cpu_pool = new ChunkPool(cpuProcessing, _processing_size, HostChunk);
+		pinned_pool = new ChunkPool(pinnedMemory, _pinned_memsize, PinnedChunk);
+		gpu_pool = new ChunkPool(gpuProcessing, _processing_size, DeviceChunk);
 	}
 
-	for(int i = 0; i < cache_total_seg; i++) {
-		empty_gpu_segment.push(i);
+	{
+		unique_lock<mutex> free_list(free_list_lock);
+		while (!empty_gpu_segment.empty()) {
+			empty_gpu_segment.pop();
+		}
+		retired_slots.clear();
+
+		for(int i = 0; i < cache_total_seg; i++) {
+			empty_gpu_segment.push(i);
+		}
 	}
 
-	segment_bitmap = (char**) malloc (TOT_COLUMN * sizeof(char*));
+	gdsf_clock = 0;
+	gdsf_priority.clear();
+	gdsf_last_seen.clear();
+	arc_target = 0;
+	for (int i = 0; i < 4; i++) arc_list[i].clear();
+	arc_directory.clear();
+	arc_last_seen.clear();
+
+	memset(seg_stats->cached, 0, seg_stats->total_segment * sizeof(char));
 	segment_list = (int**) malloc (TOT_COLUMN * sizeof(int*));
 	for (int i = 0; i < TOT_COLUMN; i++) {
-		int n = allColumn[i]->total_segment;
-		segment_bitmap[i] = (char*) malloc(n * sizeof(char));
-		CubDebugExit(cudaHostAlloc((void**) &(segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
-		memset(segment_bitmap[i], 0, n * sizeof(char));
-		memset(segment_list[i], -1, n * sizeof(int));
+		segment_list[i] = allocSegmentList(allColumn[i]->max_segment);
 	}
 }
 
@@ -190,57 +375,87 @@ CacheManager::readSegmentMinMax() {
 		}
 
 	}
+
+	//a lineorder clustered by zorderSort also has zone maps of the clustering dimension columns
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		if (allColumn[i]->table_id == 0) continue;
+		ifstream myfile (DATA_DIR + string("lo_") + allColumn[i]->column_name + "minmax");
+		if (!myfile.is_open()) continue;
+		cout << "Reading " << DATA_DIR + string("lo_") + allColumn[i]->column_name + "minmax" << endl;
+
+		int n = lo_orderdate->total_segment;
+		lo_segment_min[i] = (int*) malloc(lo_orderdate->max_segment * sizeof(int));
+		lo_segment_max[i] = (int*) malloc(lo_orderdate->max_segment * sizeof(int));
+		int segment_idx = 0;
+		while (segment_idx < n && myfile >> lo_segment_min[i][segment_idx] >> lo_segment_max[i][segment_idx]) {
+			segment_idx++;
+		}
+		cout << "segment_idx: " << segment_idx << " total_segment: " << n << endl;
+		assert(segment_idx == n);
+		myfile.close();
+	}
 }
 
+//A dimension key column is dense if row i holds key col_ptr[0] + i. Its key is then the row id and the
+//CPU joins can probe the dimension by position (QueryOptimizer::positionalJoin) instead of by hash.
+void
+CacheManager::detectDenseKeys() {
+	ColumnInfo* keys[4] = {c_custkey, s_suppkey, p_partkey, d_datekey};
+	for (int k = 0; k < 4; k++) {
+		ColumnInfo* column = keys[k];
+		column->dense_base = column->col_ptr[0];
+		column->dense = true;
+		for (int i = 1; i < column->LEN; i++) {
+			if (column->col_ptr[i] != column->dense_base + i) {
+				column->dense = false;
+				break;
+			}
+		}
+		cout << "Key column " << column->column_name << (column->dense ? " is dense" : " is not dense") << endl;
+	}
+}
+
+//processing memory of a query from its arena (QueryParams::cpu_arena, pinned_arena or gpu_arena),
+//returned to the pool when the query ends
 template <typename T>
 T*
-CacheManager::customMalloc(int size) {
-	int alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
-	int start = __atomic_fetch_add(&cpuPointer, alloc, __ATOMIC_RELAXED);
-	assert((start + alloc) < processing_size);
-	return reinterpret_cast<T*>(cpuProcessing + start);
+CacheManager::customMalloc(ProcessingArena* arena, int size) {
+	assert(arena->pool == cpu_pool);
+	size_t alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
+	return reinterpret_cast<T*>(arena->allocate(alloc));
 };
 
 template <typename T>
 T*
-CacheManager::customCudaMalloc(int size) {
-	int alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
-	int start = __atomic_fetch_add(&gpuPointer, alloc, __ATOMIC_RELAXED);
-	assert((start + alloc) < processing_size);
-	return reinterpret_cast<T*>(gpuProcessing + start);
+CacheManager::customCudaMalloc(ProcessingArena* arena, int size) {
+	assert(arena->pool == gpu_pool);
+	size_t alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
+	return reinterpret_cast<T*>(arena->allocate(alloc));
 };
 
 template <typename T>
 T*
-CacheManager::customCudaHostAlloc(int size) {
-	int alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
-	int start = __atomic_fetch_add(&pinnedPointer, alloc, __ATOMIC_RELAXED);
-	assert((start + alloc) < processing_size);
-	return reinterpret_cast<T*>(pinnedMemory + start);
+CacheManager::customCudaHostAlloc(ProcessingArena* arena, int size) {
+	assert(arena->pool == pinned_pool);
+	size_t alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
+	return reinterpret_cast<T*>(arena->allocate(alloc));
 };
 
 
 void
-CacheManager::indexTransfer(int** col_idx, ColumnInfo* column, cudaStream_t stream, bool custom) {
+CacheManager::indexTransfer(int** col_idx, ColumnInfo* column, int* seg_list, int total_segment, cudaStream_t stream, ProcessingArena* arena, bool custom) {
     if (col_idx[column->column_id] == NULL) {
       int* desired;
-      if (custom) desired = (int*) customCudaMalloc<int>(column->total_segment); 
-      else CubDebugExit(cudaMalloc((void**) &desired, column->total_segment * sizeof(int)));
+      if (custom) desired = (int*) customCudaMalloc<int>(arena, total_segment); 
+      else CubDebugExit(cudaMalloc((void**) &desired, total_segment * sizeof(int)));
       int* expected = NULL;
-      CubDebugExit(cudaMemcpyAsync(desired, segment_list[column->column_id], column->total_segment * sizeof(int), cudaMemcpyHostToDevice, stream));
+      CubDebugExit(cudaMemcpyAsync(desired, seg_list, total_segment * sizeof(int), cudaMemcpyHostToDevice, stream));
       CubDebugExit(cudaStreamSynchronize(stream));
       __atomic_compare_exchange_n(&(col_idx[column->column_id]), &expected, desired, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
     }
 };
 
 
-void
-CacheManager::resetPointer() {
-	gpuPointer = 0;
-	cpuPointer = 0;
-	pinnedPointer = 0;
-};
-
 void
 CacheManager::cacheColumnSegmentInGPU(ColumnInfo* column, int total_segment) {
 	assert(column->tot_seg_in_GPU + total_segment <= column->total_segment);
@@ -262,15 +477,16 @@ CacheManager::cacheColumnSegmentInGPU(ColumnInfo* column, int total_segment) {
 
 void 
 CacheManager::cacheSegmentInGPU(Segment* seg) {
-	int idx = empty_gpu_segment.front();
-	empty_gpu_segment.pop();
+	int idx = takeFreeSlot();
+	assert(idx != -1);
+	tier->copySegment(idx, seg->seg_ptr, SEGMENT_SIZE);
 	assert(cache_mapper.find(seg) == cache_mapper.end());
 	cache_mapper[seg] = idx;
+	assert(segment_list[seg->column->column_id][seg->segment_id] == -1);
+	//a query snapshots the slot, so publish it only once the data is in place
+	__atomic_store_n(&segment_list[seg->column->column_id][seg->segment_id], idx, __ATOMIC_RELEASE);
 	assert(segment_bitmap[seg->column->column_id][seg->segment_id] == 0x00);
 	segment_bitmap[seg->column->column_id][seg->segment_id] = 0x01;
-	assert(segment_list[seg->column->column_id][seg->segment_id] == -1);
-	segment_list[seg->column->column_id][seg->segment_id] = idx;
-	CubDebugExit(cudaMemcpy(&gpuCache[idx * SEGMENT_SIZE], seg->seg_ptr, SEGMENT_SIZE * sizeof(int), cudaMemcpyHostToDevice));
 	allColumn[seg->column->column_id]->tot_seg_in_GPU++;
 	assert(allColumn[seg->column->column_id]->tot_seg_in_GPU <= allColumn[seg->column->column_id]->total_segment);
 }
@@ -306,15 +522,65 @@ void
 CacheManager::deleteSegmentInGPU(Segment* seg) {
 	assert(cache_mapper.find(seg) != cache_mapper.end());
 	int idx = cache_mapper[seg];
-	int ret = cache_mapper.erase(seg);
-	assert(ret == 1);
+	assert(segment_list[seg->column->column_id][seg->segment_id] == idx);
+	__atomic_store_n(&segment_list[seg->column->column_id][seg->segment_id], -1, __ATOMIC_RELEASE);
 	assert(segment_bitmap[seg->column->column_id][seg->segment_id] == 0x01);
 	segment_bitmap[seg->column->column_id][seg->segment_id] = 0x00;
-	assert(segment_list[seg->column->column_id][seg->segment_id] != -1);
-	segment_list[seg->column->column_id][seg->segment_id] = -1;
-	empty_gpu_segment.push(idx);
+	int ret = cache_mapper.erase(seg);
+	assert(ret == 1);
 	seg->column->tot_seg_in_GPU--;
 	assert(seg->column->tot_seg_in_GPU >= 0);
+	//queries that snapshot the slot before the flip may still read it
+	retireSlot(idx);
+}
+
+//a query reads the slots of the residency snapshot it takes after entering (QueryOptimizer::snapshotResidency),
+//the epoch it enters at keeps every slot evicted after that point off the free list until it exits
+unsigned long long
+CacheManager::enterQuery() {
+	unique_lock<mutex> free_list(free_list_lock);
+	active_queries.insert(residency_epoch);
+	return residency_epoch;
+}
+
+void
+CacheManager::exitQuery(unsigned long long epoch) {
+	unique_lock<mutex> free_list(free_list_lock);
+	multiset<unsigned long long>::iterator it = active_queries.find(epoch);
+	assert(it != active_queries.end());
+	active_queries.erase(it);
+	reclaimSlots();
+}
+
+//a free slot, waiting for the running queries to release a retired one if needed, -1 if the tier is full
+int
+CacheManager::takeFreeSlot() {
+	unique_lock<mutex> free_list(free_list_lock);
+	slot_cv.wait(free_list, [this] {return !empty_gpu_segment.empty() || retired_slots.empty();});
+	if (empty_gpu_segment.empty()) return -1;
+	int idx = empty_gpu_segment.front();
+	empty_gpu_segment.pop();
+	return idx;
+}
+
+void
+CacheManager::retireSlot(int idx) {
+	unique_lock<mutex> free_list(free_list_lock);
+	retired_slots.push_back(make_pair(++residency_epoch, idx));
+	reclaimSlots();
+}
+
+//called with free_list_lock held, a slot retired at epoch e is free once no query entered before e is running
+void
+CacheManager::reclaimSlots() {
+	unsigned long long oldest = active_queries.empty() ? ULLONG_MAX : *active_queries.begin();
+	bool reclaimed = false;
+	while (!retired_slots.empty() && retired_slots.front().first <= oldest) {
+		empty_gpu_segment.push(retired_slots.front().second);
+		retired_slots.pop_front();
+		reclaimed = true;
+	}
+	if (reclaimed) slot_cv.notify_all();
 }
 
 void
@@ -343,39 +609,50 @@ CacheManager::updateColumnWeightDirect(ColumnInfo* column, double speedup) {
 
 void
 CacheManager::updateSegmentWeightDirect(ColumnInfo* column, Segment* segment, double speedup) {
+	int idx = segment->stats_idx;
+	decaySegment(idx);
 	if (speedup > 0) {
 		if (column->table_id == 0) {
-			segment->stats->speedup += speedup/column->total_segment;
-			segment->weight += speedup/column->total_segment;
+			seg_stats->speedup[idx] += speedup/column->total_segment;
+			seg_stats->weight[idx] += speedup/column->total_segment;
+			seg_stats->cost[idx] = speedup/column->total_segment;
 		} else {
-			segment->stats->speedup += speedup*3/column->total_segment;
-			segment->weight += speedup*3/column->total_segment;
+			seg_stats->speedup[idx] += speedup*3/column->total_segment;
+			seg_stats->weight[idx] += speedup*3/column->total_segment;
+			seg_stats->cost[idx] = speedup*3/column->total_segment;
 		}
 	}
 }
 
 void
 CacheManager::updateSegmentWeightCostDirect(ColumnInfo* column, Segment* segment, double speedup) {
+	int idx = segment->stats_idx;
+	decaySegment(idx);
 	if (speedup > 0) {
 		if (column->table_id == 0) {
-			segment->stats->speedup += (speedup/column->total_segment);
-			segment->weight += (speedup/column->total_segment);
+			seg_stats->speedup[idx] += (speedup/column->total_segment);
+			seg_stats->weight[idx] += (speedup/column->total_segment);
 		} else {
-			segment->stats->speedup += (speedup/column->total_segment);
-			segment->weight += (speedup/column->total_segment);
+			seg_stats->speedup[idx] += (speedup/column->total_segment);
+			seg_stats->weight[idx] += (speedup/column->total_segment);
 		}
+		seg_stats->cost[idx] = (speedup/column->total_segment);
 	}
 }
 
 void
 CacheManager::updateSegmentFreqDirect(ColumnInfo* column, Segment* segment) {
-	segment->stats->col_freq += (1.0 / column->total_segment);
+	int idx = segment->stats_idx;
+	decaySegment(idx);
+	seg_stats->col_freq[idx] += (1.0 / column->total_segment);
 }
 
 void
 CacheManager::updateSegmentTimeDirect(ColumnInfo* column, Segment* segment, double timestamp) {
-	segment->stats->backward_t = timestamp - (segment->stats->timestamp * column->total_segment);
-	segment->stats->timestamp = (timestamp/ column->total_segment);
+	int idx = segment->stats_idx;
+	decaySegment(idx);
+	seg_stats->backward_t[idx] = timestamp - (seg_stats->timestamp[idx] * column->total_segment);
+	seg_stats->timestamp[idx] = (timestamp/ column->total_segment);
 }
 
 void
@@ -454,14 +731,28 @@ CacheManager::weightAdjustment() {
 float
 CacheManager::runReplacement(ReplacementPolicy strategy, unsigned long long* traffic) {
 
-  cudaEvent_t start, stop; cudaEventCreate(&start); cudaEventCreate(&stop);
+  TRACE_SCOPE("runReplacement", strategy);
+
+  //a host-only cache has no device to time on
+  cudaEvent_t start, stop;
+  chrono::high_resolution_clock::time_point host_start = chrono::high_resolution_clock::now();
   float time;
-  cudaEventRecord(start, 0);
+  if (!host_only) {
+    cudaEventCreate(&start); cudaEventCreate(&stop);
+    cudaEventRecord(start, 0);
+  }
 
   unsigned long long traf = 0;
 
   if (traffic != NULL) traf = (*traffic);
 
+  //a synchronous replacement must not race with the background one
+  if (migration != NULL) migration->cancel();
+
+  //nor with appendLineorder publishing new segments
+  unique_lock<mutex> lock(residency_lock, defer_lock);
+  if (!defer_placement) lock.lock();
+
 	if (strategy == LFU) { //LEAST FREQUENTLY USED
 		traf += LFUReplacement();
 	} else if (strategy == LRU) { //LEAST RECENTLY USED
@@ -476,13 +767,21 @@ CacheManager::runReplacement(ReplacementPolicy strategy, unsigned long long* tra
 		traf += LRUSegmentedReplacement();
 	} else if (strategy == Segmented) {
 		traf += SegmentReplacement();
+	} else if (strategy == GDSF) { //GREEDYDUAL-SIZE-FREQUENCY
+		traf += GDSFReplacement();
+	} else if (strategy == ARC) { //ADAPTIVE REPLACEMENT CACHE
+		traf += ARCReplacement();
 	}
 
   if (traffic != NULL) (*traffic) = traf;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  if (!host_only) {
+    cudaEventRecord(stop, 0);
+    cudaEventSynchronize(stop);
+    cudaEventElapsedTime(&time, start, stop);
+  } else {
+    time = chrono::duration<float, milli>(chrono::high_resolution_clock::now() - host_start).count();
+  }
 
   return time;
 };
@@ -494,9 +793,10 @@ CacheManager::SegmentReplacement() {
 
 	for (int i = TOT_COLUMN-1; i >= 0; i--) {
 		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_weight_map.insert({segment->weight, segment});
-			cout << allColumn[i]->column_name << " " << j << " " << segment->weight << endl;
+			int idx = seg_stats->index(i, j);
+			decaySegment(idx);
+			access_weight_map.insert({seg_stats->weight[idx], index_to_segment[i][j]});
+			cout << allColumn[i]->column_name << " " << j << " " << seg_stats->weight[idx] << endl;
 		}
 	}
 
@@ -516,31 +816,371 @@ CacheManager::SegmentReplacement() {
     cout << "Cached segment: " << temp_buffer_size << " Cache total: " << cache_total_seg << endl;
     assert(temp_buffer_size <= cache_total_seg);
 
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						cout << "Deleting segment ";
-						cout << segment->column->column_name << " segment " << segment->segment_id << endl;
-						deleteSegmentInGPU(segment);
-					}
+    traffic = applyPlacement(segments_to_place);
+    cout << "Successfully cached" << endl;
+
+    return traffic;
+}
+
+unsigned long long
+CacheManager::applyPlacement(set<Segment*>& segments_to_place) {
+	unsigned long long traffic = 0;
+
+	if (defer_placement) {
+		planned_placement = segments_to_place;
+		return 0;
+	}
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		for (int j = 0; j < allColumn[i]->total_segment; j++) {
+			Segment* segment = index_to_segment[i][j];
+			if (segments_to_place.find(segment) == segments_to_place.end()) {
+				if (segment_bitmap[i][j]) {
+					deleteSegmentInGPU(segment);
 				}
 			}
-    }
+		}
+	}
+
+	set<Segment*>::const_iterator cit;
+	for(cit = segments_to_place.cbegin();cit != segments_to_place.cend(); ++cit){
+		if (segment_bitmap[(*cit)->column->column_id][(*cit)->segment_id] == 0) {
+			cacheSegmentInGPU(*cit);
+			traffic += SEGMENT_SIZE * sizeof(int);
+		}
+	}
+
+	return traffic;
+}
+
+void
+CacheManager::runReplacementAsync(ReplacementPolicy strategy) {
+	//column-level policies place whole columns through seg_ptr, they are applied synchronously
+	if (migration == NULL || strategy == LRU || strategy == LFU || strategy == LRU2) {
+		runReplacement(strategy);
+		return;
+	}
+
+	migration->cancel();
+
+	defer_placement = true;
+	planned_placement.clear();
+	runReplacement(strategy);
+	defer_placement = false;
+
+	migration->submit(planned_placement);
+}
+
+void
+CacheManager::startMigration(double bandwidth) {
+	stopMigration();
+	migration = new MigrationEngine(this, bandwidth);
+}
 
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cout << "Caching segment ";
-				cout << (*cit2)->column->column_name << " " << (*cit2)->segment_id << endl;
-				cacheSegmentInGPU(*cit2);
+void
+CacheManager::stopMigration() {
+	if (migration != NULL) {
+		delete migration;
+		migration = NULL;
+	}
+}
+
+//only called by the migration thread
+bool
+CacheManager::migrateSegmentIn(Segment* seg) {
+	TRACE_SCOPE("migrateSegmentIn", seg->segment_id);
+	int column_id = seg->column->column_id;
+	if (segment_bitmap[column_id][seg->segment_id]) return false;
+
+	int idx = takeFreeSlot();
+	if (idx == -1) return false;
+	//nothing points to a free slot, the copy can overlap with running queries
+	unsigned long long mark = lo_watermark.load(memory_order_acquire);
+	tier->copySegment(idx, seg->seg_ptr, SEGMENT_SIZE);
+
+	unique_lock<mutex> lock(residency_lock);
+	//rows appended to a lineorder tail segment were published during the copy
+	if (seg->column->table_id == 0 && lo_watermark.load(memory_order_acquire) != mark) tier->copySegment(idx, seg->seg_ptr, SEGMENT_SIZE);
+	assert(cache_mapper.find(seg) == cache_mapper.end());
+	cache_mapper[seg] = idx;
+	assert(segment_list[column_id][seg->segment_id] == -1);
+	//the flip: queries that snapshot the slot list from now on read the segment from the slot
+	__atomic_store_n(&segment_list[column_id][seg->segment_id], idx, __ATOMIC_RELEASE);
+	segment_bitmap[column_id][seg->segment_id] = 0x01;
+	allColumn[column_id]->tot_seg_in_GPU++;
+	return true;
+}
+
+//only called by the migration thread
+bool
+CacheManager::migrateSegmentOut(Segment* seg) {
+	TRACE_SCOPE("migrateSegmentOut", seg->segment_id);
+	if (segment_bitmap[seg->column->column_id][seg->segment_id] == 0) return false;
+
+	unique_lock<mutex> lock(residency_lock);
+	deleteSegmentInGPU(seg);
+	return true;
+}
+
+MigrationEngine::MigrationEngine(CacheManager* _cm, double _bandwidth) {
+	cm = _cm;
+	bandwidth = _bandwidth;
+	traffic = 0;
+	busy = false;
+	stop = false;
+	worker = thread(&MigrationEngine::run, this);
+}
+
+MigrationEngine::~MigrationEngine() {
+	{
+		unique_lock<mutex> lock(plan_lock);
+		stop = true;
+	}
+	plan_cv.notify_all();
+	worker.join();
+}
+
+void
+MigrationEngine::submit(set<Segment*>& segments_to_place) {
+	unique_lock<mutex> lock(plan_lock);
+	to_evict.clear();
+	to_cache.clear();
+
+	for (int i = 0; i < cm->TOT_COLUMN; i++) {
+		for (int j = 0; j < cm->allColumn[i]->total_segment; j++) {
+			Segment* segment = cm->index_to_segment[i][j];
+			bool cached = __atomic_load_n(&cm->segment_bitmap[i][j], __ATOMIC_ACQUIRE);
+			bool place = segments_to_place.find(segment) != segments_to_place.end();
+			if (cached && !place) to_evict.push_back(segment);
+			else if (!cached && place) to_cache.push_back(segment);
+		}
+	}
+
+	if (!to_evict.empty() || !to_cache.empty()) {
+		busy = true;
+		plan_cv.notify_one();
+	}
+}
+
+void
+MigrationEngine::cancel() {
+	unique_lock<mutex> lock(plan_lock);
+	to_evict.clear();
+	to_cache.clear();
+	idle_cv.wait(lock, [this] {return !busy;});
+}
+
+void
+MigrationEngine::wait() {
+	unique_lock<mutex> lock(plan_lock);
+	idle_cv.wait(lock, [this] {return !busy;});
+}
+
+void
+MigrationEngine::run() {
+	chrono::steady_clock::time_point start;
+	unsigned long long copied = 0; //bytes copied since the plan was picked up
+
+	while (true) {
+		Segment* seg;
+		bool load;
+
+		{
+			unique_lock<mutex> lock(plan_lock);
+			if (to_evict.empty() && to_cache.empty()) {
+				busy = false;
+				idle_cv.notify_all();
+				copied = 0;
+			}
+			plan_cv.wait(lock, [this] {return stop || !to_evict.empty() || !to_cache.empty();});
+			if (stop) {
+				busy = false;
+				idle_cv.notify_all();
+				return;
+			}
+			if (copied == 0) start = chrono::steady_clock::now();
+
+			//cache into a free slot if there is one, otherwise evict first
+			bool free_slot;
+			{
+				unique_lock<mutex> free_list(cm->free_list_lock);
+				free_slot = !cm->empty_gpu_segment.empty();
+			}
+			if (!to_cache.empty() && (free_slot || to_evict.empty())) {
+				seg = to_cache.front(); to_cache.pop_front(); load = true;
+			} else {
+				seg = to_evict.front(); to_evict.pop_front(); load = false;
+			}
+		}
+
+		if (load) {
+			if (cm->migrateSegmentIn(seg)) {
+				copied += SEGMENT_SIZE * sizeof(int);
 				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-    cout << "Successfully cached" << endl;
+				if (bandwidth > 0) {
+					chrono::duration<double> budget(copied / bandwidth);
+					this_thread::sleep_until(start + chrono::duration_cast<chrono::steady_clock::duration>(budget));
+				}
+			}
+		} else {
+			cm->migrateSegmentOut(seg);
+		}
+	}
+}
 
-    return traffic;
+//GreedyDual-Size-Frequency: H = L + F * C / S
+//F is the number of queries that touched the segment, C is the speedup credited by its last touch
+//and S is the number of cache slots occupied (always one segment). Segments touched since the
+//last replacement get a fresh H based on the current L, untouched segments keep their old H
+//and therefore age as L is inflated to the priority of the evicted segments.
+unsigned long long
+CacheManager::GDSFReplacement() {
+	multimap<double, Segment*> access_priority_map;
+
+	for (int i = TOT_COLUMN-1; i >= 0; i--) {
+		for (int j = 0; j < allColumn[i]->total_segment; j++) {
+			Segment* segment = index_to_segment[i][j];
+			int idx = seg_stats->index(i, j);
+			decaySegment(idx);
+			if (seg_stats->col_freq[idx] > 0 && seg_stats->cost[idx] > 0) {
+				double F = seg_stats->col_freq[idx] * allColumn[i]->total_segment;
+				double C = seg_stats->cost[idx] * allColumn[i]->total_segment;
+				double S = 1; //every segment occupies one cache slot
+				double timestamp = seg_stats->timestamp[idx] * allColumn[i]->total_segment;
+				if (gdsf_last_seen.find(segment) == gdsf_last_seen.end() || gdsf_last_seen[segment] != timestamp) {
+					gdsf_priority[segment] = gdsf_clock + F * C / S;
+					gdsf_last_seen[segment] = timestamp;
+				}
+				access_priority_map.insert({gdsf_priority[segment], segment});
+			}
+		}
+	}
+
+	int temp_buffer_size = 0; // in segment
+	set<Segment*> segments_to_place;
+	multimap<double, Segment*>::reverse_iterator cit;
+
+	for(cit = access_priority_map.rbegin();cit != access_priority_map.rend(); ++cit){
+		if(temp_buffer_size + 1 < cache_total_seg && cit->first > 0){
+			temp_buffer_size+=1;
+			segments_to_place.insert(cit->second);
+		}
+	}
+
+	assert(temp_buffer_size <= cache_total_seg);
+
+	//L is raised to the highest priority among the evicted segments
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		for (int j = 0; j < allColumn[i]->total_segment; j++) {
+			Segment* segment = index_to_segment[i][j];
+			if (segment_bitmap[i][j] && segments_to_place.find(segment) == segments_to_place.end()) {
+				if (gdsf_priority.find(segment) != gdsf_priority.end()) {
+					gdsf_clock = max(gdsf_clock, gdsf_priority[segment]);
+				}
+			}
+		}
+	}
+
+	return applyPlacement(segments_to_place);
+}
+
+void
+CacheManager::ARCMove(Segment* seg, ARCList dest) {
+	unordered_map<Segment*, pair<ARCList, list<Segment*>::iterator>>::iterator it = arc_directory.find(seg);
+	if (it != arc_directory.end()) {
+		arc_list[it->second.first].erase(it->second.second);
+	}
+	arc_list[dest].push_front(seg);
+	arc_directory[seg] = make_pair(dest, arc_list[dest].begin());
+}
+
+void
+CacheManager::ARCReplace(bool in_b2) {
+	int t1 = arc_list[ARC_T1].size();
+	if (t1 > 0 && (t1 > arc_target || (in_b2 && t1 == (int) arc_target) || arc_list[ARC_T2].empty())) {
+		ARCMove(arc_list[ARC_T1].back(), ARC_B1);
+	} else if (!arc_list[ARC_T2].empty()) {
+		ARCMove(arc_list[ARC_T2].back(), ARC_B2);
+	}
+}
+
+void
+CacheManager::ARCRequest(Segment* seg, int capacity) {
+	int t1 = arc_list[ARC_T1].size(), t2 = arc_list[ARC_T2].size();
+	int b1 = arc_list[ARC_B1].size(), b2 = arc_list[ARC_B2].size();
+	bool full = (t1 + t2 >= capacity);
+
+	unordered_map<Segment*, pair<ARCList, list<Segment*>::iterator>>::iterator it = arc_directory.find(seg);
+
+	if (it != arc_directory.end() && (it->second.first == ARC_T1 || it->second.first == ARC_T2)) {
+		ARCMove(seg, ARC_T2);
+	} else if (it != arc_directory.end() && it->second.first == ARC_B1) {
+		double delta = (b1 >= b2) ? 1 : (b2 * 1.0 / b1);
+		arc_target = min(arc_target + delta, (double) capacity);
+		if (full) ARCReplace(false);
+		ARCMove(seg, ARC_T2);
+	} else if (it != arc_directory.end() && it->second.first == ARC_B2) {
+		double delta = (b2 >= b1) ? 1 : (b1 * 1.0 / b2);
+		arc_target = max(arc_target - delta, 0.0);
+		if (full) ARCReplace(true);
+		ARCMove(seg, ARC_T2);
+	} else {
+		if (t1 + b1 >= capacity) {
+			if (t1 < capacity) {
+				arc_directory.erase(arc_list[ARC_B1].back());
+				arc_list[ARC_B1].pop_back();
+				if (full) ARCReplace(false);
+			} else {
+				arc_directory.erase(arc_list[ARC_T1].back());
+				arc_list[ARC_T1].pop_back();
+			}
+		} else if (t1 + t2 + b1 + b2 >= capacity) {
+			if (t1 + t2 + b1 + b2 >= 2 * capacity) {
+				arc_directory.erase(arc_list[ARC_B2].back());
+				arc_list[ARC_B2].pop_back();
+			}
+			if (full) ARCReplace(false);
+		}
+		ARCMove(seg, ARC_T1);
+	}
+}
+
+//Adaptive Replacement Cache at segment granularity: every segment touched since the last
+//replacement is replayed into ARC as one request, in the order of its logical timestamp.
+//T1 and T2 hold the segments that should be cached, B1 and B2 are the ghost lists.
+//Segments without any speedup are not admitted since caching them gives no benefit.
+unsigned long long
+CacheManager::ARCReplacement() {
+	multimap<double, Segment*> access_timestamp_map;
+	int capacity = cache_total_seg - 1;
+
+	for (int i = TOT_COLUMN-1; i >= 0; i--) {
+		for (int j = 0; j < allColumn[i]->total_segment; j++) {
+			Segment* segment = index_to_segment[i][j];
+			int idx = seg_stats->index(i, j);
+			decaySegment(idx);
+			double timestamp = seg_stats->timestamp[idx] * allColumn[i]->total_segment;
+			if (timestamp > 0 && seg_stats->weight[idx] > 0) {
+				if (arc_last_seen.find(segment) == arc_last_seen.end() || arc_last_seen[segment] != timestamp) {
+					access_timestamp_map.insert({timestamp, segment});
+					arc_last_seen[segment] = timestamp;
+				}
+			}
+		}
+	}
+
+	multimap<double, Segment*>::iterator cit;
+	for(cit = access_timestamp_map.begin();cit != access_timestamp_map.end(); ++cit){
+		ARCRequest(cit->second, capacity);
+	}
+
+	set<Segment*> segments_to_place;
+	segments_to_place.insert(arc_list[ARC_T1].begin(), arc_list[ARC_T1].end());
+	segments_to_place.insert(arc_list[ARC_T2].begin(), arc_list[ARC_T2].end());
+
+	assert(segments_to_place.size() <= cache_total_seg);
+
+	return applyPlacement(segments_to_place);
 }
 
 unsigned long long
@@ -585,12 +1225,11 @@ CacheManager::LRUReplacement() {
 unsigned long long
 CacheManager::LRUSegmentedReplacement() {
 	multimap<double, Segment*> access_timestamp_map;
-	unsigned long long traffic = 0;
 
 	for (int i = TOT_COLUMN-1; i >= 0; i--) {
 		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_timestamp_map.insert({segment->stats->timestamp, segment});
+			int idx = seg_stats->index(i, j);
+			access_timestamp_map.insert({seg_stats->timestamp[idx], index_to_segment[i][j]});
 		}
 	}
 
@@ -607,26 +1246,7 @@ CacheManager::LRUSegmentedReplacement() {
 
     assert(temp_buffer_size <= cache_total_seg);
 
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						deleteSegmentInGPU(segment);
-					}
-				}
-			}
-    }
-
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cacheSegmentInGPU(*cit2);
-				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-
-    return traffic;
+    return applyPlacement(segments_to_place);
 }
 
 unsigned long long
@@ -671,12 +1291,12 @@ CacheManager::LRU_2Replacement() {
 unsigned long long
 CacheManager::LRU_2SegmentedReplacement() {
 	multimap<double, Segment*> access_backward_map;
-	unsigned long long traffic = 0;
 
 	for (int i = TOT_COLUMN-1; i >= 0; i--) {
 		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_backward_map.insert({segment->stats->backward_t, segment});
+			int idx = seg_stats->index(i, j);
+			decaySegment(idx);
+			access_backward_map.insert({seg_stats->backward_t[idx], index_to_segment[i][j]});
 		}
 	}
 
@@ -693,37 +1313,18 @@ CacheManager::LRU_2SegmentedReplacement() {
 
     assert(temp_buffer_size <= cache_total_seg);
 
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						deleteSegmentInGPU(segment);
-					}
-				}
-			}
-    }
-
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cacheSegmentInGPU(*cit2);
-				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-
-    return traffic;
+    return applyPlacement(segments_to_place);
 }
 
 unsigned long long
 CacheManager::LFUSegmentedReplacement() {
 	multimap<double, Segment*> access_frequency_map;
-	unsigned long long traffic = 0;
 
 	for (int i = TOT_COLUMN-1; i >= 0; i--) {
 		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_frequency_map.insert({segment->stats->col_freq, segment});
+			int idx = seg_stats->index(i, j);
+			decaySegment(idx);
+			access_frequency_map.insert({seg_stats->col_freq[idx], index_to_segment[i][j]});
 		}
 	}
 
@@ -740,26 +1341,7 @@ CacheManager::LFUSegmentedReplacement() {
 
     assert(temp_buffer_size <= cache_total_seg);
 
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						deleteSegmentInGPU(segment);
-					}
-				}
-			}
-    }
-
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cacheSegmentInGPU(*cit2);
-				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-
-    return traffic;
+    return applyPlacement(segments_to_place);
 }
 
 unsigned long long
@@ -1080,29 +1662,59 @@ CacheManager::New2Replacement() {
 void
 CacheManager::newEpoch(double param) {
 
-	for (int i = 0; i < TOT_COLUMN; i++) {
-		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[allColumn[i]->column_id][j];
-			segment->weight = param * segment->weight;
-		}
+	int n = seg_stats->total_segment;
+	double* weight = seg_stats->weight;
+	double* col_freq = seg_stats->col_freq;
+	double* backward_t = seg_stats->backward_t;
+
+	for (int i = 0; i < n; i++) {
+		weight[i] = param * weight[i];
 	}
 
-	for (int i = 0; i < TOT_COLUMN; i++) {
-		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[allColumn[i]->column_id][j];
-			segment->stats->col_freq = param * segment->stats->col_freq;
-		}
+	for (int i = 0; i < n; i++) {
+		col_freq[i] = param * col_freq[i];
 	}
 
-	for (int i = 0; i < TOT_COLUMN; i++) {
-		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[allColumn[i]->column_id][j];
-			segment->stats->backward_t = param * segment->stats->backward_t;
-		}
+	for (int i = 0; i < n; i++) {
+		backward_t[i] = param * backward_t[i];
 	}
 
 };
 
+void
+CacheManager::setHalfLife(double _half_life) {
+	//bring every segment to the current clock so that the old half-life is not applied retroactively
+	for (int i = 0; i < seg_stats->total_segment; i++) {
+		decaySegment(i);
+	}
+	half_life = _half_life;
+}
+
+void
+CacheManager::advanceClock(double time) {
+	decay_clock += time;
+}
+
+//Lazily apply the decay accumulated since the segment was last touched: every half_life queries
+//col_freq, speedup and weight are halved and backward_t is doubled, so that old accesses count less
+//for every policy (the reverse if half_life is negative). This is the continuous equivalent of
+//newEpoch(0.5) for the frequency policies and newEpoch(2.0) for LRU2 at every epoch boundary.
+void
+CacheManager::decaySegment(int idx) {
+	if (half_life == 0) {
+		seg_stats->decay_t[idx] = decay_clock;
+		return;
+	}
+	double elapsed = decay_clock - seg_stats->decay_t[idx];
+	if (elapsed == 0) return;
+	double factor = pow(2.0, -elapsed / half_life);
+	seg_stats->weight[idx] = factor * seg_stats->weight[idx];
+	seg_stats->col_freq[idx] = factor * seg_stats->col_freq[idx];
+	seg_stats->speedup[idx] = factor * seg_stats->speedup[idx];
+	seg_stats->backward_t[idx] = seg_stats->backward_t[idx] / factor;
+	seg_stats->decay_t[idx] = decay_clock;
+}
+
 int
 CacheManager::cacheSpecificColumn(string column_name) {
 	ColumnInfo* column;
@@ -1152,6 +1764,7 @@ CacheManager::deleteSpecificColumnFromGPU(string column_name) {
 
 void
 CacheManager::deleteAll() {
+	if (migration != NULL) migration->cancel();
 	for (int i = 0; i < TOT_COLUMN; i++) {
 		ColumnInfo* column = allColumn[i];
 		for (int j = 0; j < column->total_segment; j++) {
@@ -1167,16 +1780,16 @@ CacheManager::deleteAll() {
 void
 CacheManager::loadColumnToCPU() {
 
-	h_lo_orderkey = loadColumnPinnedSort<int>("lo_orderkey", LO_LEN);
-	h_lo_suppkey = loadColumnPinnedSort<int>("lo_suppkey", LO_LEN);
-	h_lo_custkey = loadColumnPinnedSort<int>("lo_custkey", LO_LEN);
-	h_lo_partkey = loadColumnPinnedSort<int>("lo_partkey", LO_LEN);
-	h_lo_orderdate = loadColumnPinnedSort<int>("lo_orderdate", LO_LEN);
-	h_lo_revenue = loadColumnPinnedSort<int>("lo_revenue", LO_LEN);
-	h_lo_discount = loadColumnPinnedSort<int>("lo_discount", LO_LEN);
-	h_lo_quantity = loadColumnPinnedSort<int>("lo_quantity", LO_LEN);
-	h_lo_extendedprice = loadColumnPinnedSort<int>("lo_extendedprice", LO_LEN);
-	h_lo_supplycost = loadColumnPinnedSort<int>("lo_supplycost", LO_LEN);
+	h_lo_orderkey = loadColumnNumaSort<int>("lo_orderkey", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_suppkey = loadColumnNumaSort<int>("lo_suppkey", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_custkey = loadColumnNumaSort<int>("lo_custkey", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_partkey = loadColumnNumaSort<int>("lo_partkey", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_orderdate = loadColumnNumaSort<int>("lo_orderdate", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_revenue = loadColumnNumaSort<int>("lo_revenue", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_discount = loadColumnNumaSort<int>("lo_discount", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_quantity = loadColumnNumaSort<int>("lo_quantity", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_extendedprice = loadColumnNumaSort<int>("lo_extendedprice", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
+	h_lo_supplycost = loadColumnNumaSort<int>("lo_supplycost", LO_LEN, numa, NumaSegment, LO_APPEND_SEGMENT);
 
 	h_c_custkey = loadColumnPinned<int>("c_custkey", C_LEN);
 	h_c_nation = loadColumnPinned<int>("c_nation", C_LEN);
@@ -1238,6 +1851,11 @@ CacheManager::loadColumnToCPU() {
 	allColumn[8] = lo_extendedprice;
 	allColumn[9] = lo_supplycost;
 
+	//lineorder is append-only, its buffers have room for LO_APPEND_SEGMENT more segments (appendLineorder)
+	for (int i = 0; i <= 9; i++) {
+		allColumn[i]->max_segment += LO_APPEND_SEGMENT;
+	}
+
 	allColumn[10] = c_custkey;
 	allColumn[11] = c_nation;
 	allColumn[12] = c_region;
@@ -1263,96 +1881,430 @@ CacheManager::loadColumnToCPU() {
 	}
 }
 
+//Appends count rows to lineorder, rows[i] holds the new values of column i (lo_orderkey ... lo_supplycost).
+//The rows, zone maps and Segment objects are written past the published end, into buffers and tables sized
+//for max_segment, without any lock. The new end is published with a single release store of lo_watermark;
+//a query loads it once when it is parsed (QueryOptimizer::lo_len) and runs on that row count. Only the
+//refresh of a cached copy of the old tail segment, and the publication after it, are serialized with the
+//placement. Returns the number of rows appended, fewer than count once the reserved segments are full.
+int
+CacheManager::appendLineorder(int** rows, int count) {
+	unique_lock<mutex> append(append_lock);
+
+	unsigned long long mark = lo_watermark.load(memory_order_relaxed);
+	int old_len = (int) (mark & 0xffffffff);
+	long long capacity = (long long) lo_orderdate->max_segment * SEGMENT_SIZE;
+	count = (int) min((long long) count, capacity - old_len);
+	if (count <= 0) return 0;
+	int new_len = old_len + count;
+
+	for (int i = 0; i < columns_in_table[0].size(); i++) {
+		ColumnInfo* column = allColumn[columns_in_table[0][i]];
+		memcpy(column->col_ptr + old_len, rows[i], count * sizeof(int));
+	}
+
+	int first_segment = old_len / SEGMENT_SIZE;
+	int old_segment = (old_len + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+	int new_segment = (new_len + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+	vector<int> seg_min(TOT_COLUMN), seg_max(TOT_COLUMN);
+	for (int j = first_segment; j < new_segment; j++) {
+		computeAppendZoneMaps(j, min(new_len, (j + 1) * SEGMENT_SIZE), seg_min.data(), seg_max.data());
+		//the zone map of the old tail only widens, so a query of the previous epoch may read either value
+		for (int i = 0; i < TOT_COLUMN; i++) {
+			if (allColumn[i]->table_id != 0 && lo_segment_min[i] == NULL) continue;
+			int* col_min = (allColumn[i]->table_id == 0) ? segment_min[i] : lo_segment_min[i];
+			int* col_max = (allColumn[i]->table_id == 0) ? segment_max[i] : lo_segment_max[i];
+			__atomic_store_n(&col_min[j], seg_min[i], __ATOMIC_RELAXED);
+			__atomic_store_n(&col_max[j], seg_max[i], __ATOMIC_RELAXED);
+		}
+	}
+
+	for (int i = 0; i < columns_in_table[0].size(); i++) {
+		ColumnInfo* column = allColumn[columns_in_table[0][i]];
+		for (int j = old_segment; j < new_segment; j++) {
+			index_to_segment[column->column_id][j] = column->getSegment(j);
+			index_to_segment[column->column_id][j]->stats_idx = seg_stats->index(column->column_id, j);
+		}
+	}
+
+	unsigned long long epoch = (mark >> 32) + 1;
+	{
+		unique_lock<mutex> lock(residency_lock);
+		//the cached copy of the old tail segment misses the new rows
+		if (first_segment < old_segment) {
+			for (int i = 0; i < columns_in_table[0].size(); i++) {
+				int column_id = columns_in_table[0][i];
+				if (segment_bitmap[column_id][first_segment]) {
+					tier->copySegment(segment_list[column_id][first_segment], index_to_segment[column_id][first_segment]->seg_ptr, SEGMENT_SIZE);
+				}
+			}
+		}
+		lo_watermark.store((epoch << 32) | (unsigned long long) new_len, memory_order_release);
+	}
+
+	//for the placement and the statistics, which do not run on a query snapshot
+	for (int i = 0; i < columns_in_table[0].size(); i++) {
+		ColumnInfo* column = allColumn[columns_in_table[0][i]];
+		__atomic_store_n(&column->LEN, new_len, __ATOMIC_RELAXED);
+		__atomic_store_n(&column->total_segment, new_segment, __ATOMIC_RELAXED);
+	}
+
+	cout << "Appended " << count << " rows to lineorder: " << new_len << " rows, " << new_segment << " segments, epoch " << epoch << endl;
+	return count;
+}
+
+//Zone maps of every column over the lineorder rows [segment_idx * SEGMENT_SIZE, end), indexed by column_id.
+//The dimension columns of a clustered lineorder (lo_segment_min) are reached through the foreign key, which
+//needs a dense dimension key; otherwise the zone map covers every value and the segment is never skipped.
+void
+CacheManager::computeAppendZoneMaps(int segment_idx, int end, int* seg_min, int* seg_max) {
+	ColumnInfo* fkey[5] = {NULL, lo_suppkey, lo_custkey, lo_partkey, lo_orderdate};
+	int start = segment_idx * SEGMENT_SIZE;
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		ColumnInfo* column = allColumn[i];
+		seg_min[i] = INT_MAX;
+		seg_max[i] = INT_MIN;
+
+		if (column->table_id == 0) {
+			for (int row = start; row < end; row++) {
+				seg_min[i] = min(seg_min[i], column->col_ptr[row]);
+				seg_max[i] = max(seg_max[i], column->col_ptr[row]);
+			}
+		} else if (lo_segment_min[i] != NULL) {
+			ColumnInfo* key = allColumn[columns_in_table[column->table_id][0]];
+			int* fk = fkey[column->table_id]->col_ptr;
+			for (int row = start; row < end; row++) {
+				int pos = fk[row] - key->dense_base;
+				if (!key->dense || pos < 0 || pos >= key->LEN) {
+					seg_min[i] = INT_MIN;
+					seg_max[i] = INT_MAX;
+					break;
+				}
+				seg_min[i] = min(seg_min[i], column->col_ptr[pos]);
+				seg_max[i] = max(seg_max[i], column->col_ptr[pos]);
+			}
+		}
+	}
+}
+
+//Warm-state snapshot: header, column statistics and weights, the segment statistics table
+//(including the cached flags) in one block, decay/epoch state and the GDSF and ARC bookkeeping.
+//It is written to filename.tmp and renamed over filename only when every write succeeded, so a
+//failed save leaves the previous snapshot in place. Returns false on failure.
+bool
+CacheManager::saveSnapshot(string filename, double logical_time) {
+	if (migration != NULL) migration->wait();
+
+	string tmp = filename + ".tmp";
+	FILE *fptr = fopen(tmp.c_str(), "wb");
+	if (fptr == NULL) {
+		printf("Could not open file %s\n", tmp.c_str());
+		return false;
+	}
+
+	bool ok = true;
+	auto write = [&] (const void* ptr, size_t size, size_t count) {
+		ok = ok && fwrite(ptr, size, count, fptr) == count;
+	};
+
+	int header[5] = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, TOT_COLUMN, seg_stats->total_segment, SEGMENT_SIZE};
+	write(header, sizeof(int), 5);
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		write(allColumn[i]->stats, sizeof(Statistics), 1);
+		write(&(allColumn[i]->weight), sizeof(double), 1);
+	}
+
+	write(seg_stats->data, 1, seg_stats->data_size);
+
+	double clocks[5] = {logical_time, decay_clock, half_life, gdsf_clock, arc_target};
+	write(clocks, sizeof(double), 5);
+
+	//GDSF: stats index, H and last refresh of every tracked segment
+	int count = gdsf_priority.size();
+	write(&count, sizeof(int), 1);
+	unordered_map<Segment*, double>::iterator it;
+	for (it = gdsf_priority.begin(); it != gdsf_priority.end(); ++it) {
+		double last_seen = gdsf_last_seen[it->first];
+		write(&(it->first->stats_idx), sizeof(int), 1);
+		write(&(it->second), sizeof(double), 1);
+		write(&last_seen, sizeof(double), 1);
+	}
+
+	//ARC: every list from MRU to LRU, then the last replayed access of each segment
+	for (int l = 0; l < 4; l++) {
+		count = arc_list[l].size();
+		write(&count, sizeof(int), 1);
+		list<Segment*>::iterator lit;
+		for (lit = arc_list[l].begin(); lit != arc_list[l].end(); ++lit) {
+			write(&((*lit)->stats_idx), sizeof(int), 1);
+		}
+	}
+	count = arc_last_seen.size();
+	write(&count, sizeof(int), 1);
+	for (it = arc_last_seen.begin(); it != arc_last_seen.end(); ++it) {
+		write(&(it->first->stats_idx), sizeof(int), 1);
+		write(&(it->second), sizeof(double), 1);
+	}
+
+	ok = (fclose(fptr) == 0) && ok;
+	if (!ok || rename(tmp.c_str(), filename.c_str()) != 0) {
+		printf("Could not save warm state to %s\n", filename.c_str());
+		remove(tmp.c_str());
+		return false;
+	}
+	cout << "Saved warm state to " << filename << endl;
+	return true;
+}
+
+//Restores a snapshot written by saveSnapshot and caches the segments that were cached when it
+//was taken. The whole file is read and checked first: returns false and leaves the current state
+//untouched if the snapshot does not match, is truncated or refers to segments out of range.
+bool
+CacheManager::loadSnapshot(string filename, double* logical_time) {
+	FILE *fptr = fopen(filename.c_str(), "rb");
+	if (fptr == NULL) {
+		printf("Could not open file %s\n", filename.c_str());
+		return false;
+	}
+
+	int header[5];
+	if (fread(header, sizeof(int), 5, fptr) != 5 || header[0] != SNAPSHOT_MAGIC || header[1] != SNAPSHOT_VERSION ||
+			header[2] != TOT_COLUMN || header[3] != seg_stats->total_segment || header[4] != SEGMENT_SIZE) {
+		printf("Snapshot %s does not match this database\n", filename.c_str());
+		fclose(fptr);
+		return false;
+	}
+
+	int total_segment = seg_stats->total_segment;
+	vector<Segment*> segment_at(total_segment);
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		for (int j = 0; j < allColumn[i]->total_segment; j++) {
+			segment_at[seg_stats->index(i, j)] = index_to_segment[i][j];
+		}
+	}
+
+	//a count or a stats index that is out of range fails the snapshot like a short read
+	bool ok = true;
+	auto readCount = [&] (int& count) {
+		ok = ok && fread(&count, sizeof(int), 1, fptr) == 1 && count >= 0 && count <= total_segment;
+		if (!ok) count = 0;
+	};
+	auto readIndex = [&] (int& idx) {
+		ok = ok && fread(&idx, sizeof(int), 1, fptr) == 1 && idx >= 0 && idx < total_segment;
+	};
+	auto readDouble = [&] (double& value) {
+		ok = ok && fread(&value, sizeof(double), 1, fptr) == 1;
+	};
+
+	vector<Statistics> col_stats(TOT_COLUMN);
+	vector<double> col_weight(TOT_COLUMN);
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		ok = ok && fread(&col_stats[i], sizeof(Statistics), 1, fptr) == 1;
+		readDouble(col_weight[i]);
+	}
+
+	SegmentStatistics* snapshot = new SegmentStatistics(*seg_stats);
+	ok = ok && fread(snapshot->data, 1, snapshot->data_size, fptr) == snapshot->data_size;
+	double clocks[5];
+	ok = ok && fread(clocks, sizeof(double), 5, fptr) == 5;
+
+	//GDSF: stats index, H and last refresh of every tracked segment
+	int count = 0;
+	readCount(count);
+	vector<int> gdsf_idx(count);
+	vector<double> gdsf_value(count), gdsf_seen(count);
+	for (int i = 0; i < count && ok; i++) {
+		readIndex(gdsf_idx[i]);
+		readDouble(gdsf_value[i]);
+		readDouble(gdsf_seen[i]);
+	}
+
+	//ARC: every list from MRU to LRU, then the last replayed access of each segment
+	vector<int> arc_idx[4];
+	for (int l = 0; l < 4; l++) {
+		readCount(count);
+		arc_idx[l].resize(count);
+		for (int i = 0; i < count && ok; i++) readIndex(arc_idx[l][i]);
+	}
+	readCount(count);
+	vector<int> seen_idx(count);
+	vector<double> seen_value(count);
+	for (int i = 0; i < count && ok; i++) {
+		readIndex(seen_idx[i]);
+		readDouble(seen_value[i]);
+	}
+
+	fclose(fptr);
+	if (!ok) {
+		printf("Snapshot %s is truncated or corrupt\n", filename.c_str());
+		delete snapshot;
+		return false;
+	}
+
+	deleteAll();
+
+	//segments appended after the snapshot was taken may not exist yet, their entries are dropped
+	set<Segment*> segments_to_place;
+	for (int idx = 0; idx < total_segment; idx++) {
+		if (snapshot->cached[idx] && segment_at[idx] != NULL) segments_to_place.insert(segment_at[idx]);
+	}
+	memset(snapshot->cached, 0, total_segment * sizeof(char));
+	seg_stats->copyFrom(snapshot);
+	delete snapshot;
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		*(allColumn[i]->stats) = col_stats[i];
+		allColumn[i]->weight = col_weight[i];
+	}
+
+	*logical_time = clocks[0];
+	decay_clock = clocks[1];
+	half_life = clocks[2];
+	gdsf_clock = clocks[3];
+	arc_target = clocks[4];
+
+	gdsf_priority.clear();
+	gdsf_last_seen.clear();
+	for (int i = 0; i < gdsf_idx.size(); i++) {
+		Segment* segment = segment_at[gdsf_idx[i]];
+		if (segment == NULL) continue;
+		gdsf_priority[segment] = gdsf_value[i];
+		gdsf_last_seen[segment] = gdsf_seen[i];
+	}
+
+	for (int l = 0; l < 4; l++) arc_list[l].clear();
+	arc_directory.clear();
+	arc_last_seen.clear();
+	for (int l = 0; l < 4; l++) {
+		for (int i = arc_idx[l].size() - 1; i >= 0; i--) {
+			Segment* segment = segment_at[arc_idx[l][i]];
+			if (segment != NULL) ARCMove(segment, (ARCList) l);
+		}
+	}
+	for (int i = 0; i < seen_idx.size(); i++) {
+		Segment* segment = segment_at[seen_idx[i]];
+		if (segment != NULL) arc_last_seen[segment] = seen_value[i];
+	}
+
+	//the placement is restored segment by segment, so it is only meaningful for the segment-level policies
+	if (segments_to_place.size() <= cache_total_seg) {
+		applyPlacement(segments_to_place);
+	} else {
+		printf("Snapshot placement does not fit in the cache, run a replacement to place segments\n");
+		segments_to_place.clear();
+	}
+
+	cout << "Restored warm state from " << filename << ": " << segments_to_place.size() << " segments cached" << endl;
+	return true;
+}
+
 CacheManager::~CacheManager() {
-	CubDebugExit(cudaFree(gpuCache));
-	CubDebugExit(cudaFree(gpuProcessing));
-	delete[] cpuProcessing;
-	CubDebugExit(cudaFreeHost(pinnedMemory));
-
-	CubDebugExit(cudaFreeHost(h_lo_orderkey));
-	CubDebugExit(cudaFreeHost(h_lo_suppkey));
-	CubDebugExit(cudaFreeHost(h_lo_custkey));
-	CubDebugExit(cudaFreeHost(h_lo_partkey));
-	CubDebugExit(cudaFreeHost(h_lo_orderdate));
-	CubDebugExit(cudaFreeHost(h_lo_revenue));
-	CubDebugExit(cudaFreeHost(h_lo_discount)); 
-	CubDebugExit(cudaFreeHost(h_lo_quantity));
-	CubDebugExit(cudaFreeHost(h_lo_extendedprice));
-	CubDebugExit(cudaFreeHost(h_lo_supplycost));
-
-	CubDebugExit(cudaFreeHost(h_c_custkey));
-	CubDebugExit(cudaFreeHost(h_c_nation));
-	CubDebugExit(cudaFreeHost(h_c_region));
-	CubDebugExit(cudaFreeHost(h_c_city));
-
-	CubDebugExit(cudaFreeHost(h_s_suppkey));
-	CubDebugExit(cudaFreeHost(h_s_nation));
-	CubDebugExit(cudaFreeHost(h_s_region));
-	CubDebugExit(cudaFreeHost(h_s_city));
-
-	CubDebugExit(cudaFreeHost(h_p_partkey));
-	CubDebugExit(cudaFreeHost(h_p_brand1));
-	CubDebugExit(cudaFreeHost(h_p_category));
-	CubDebugExit(cudaFreeHost(h_p_mfgr));
-
-	CubDebugExit(cudaFreeHost(h_d_datekey));
-	CubDebugExit(cudaFreeHost(h_d_year));
-	CubDebugExit(cudaFreeHost(h_d_yearmonthnum));
-
-	delete lo_orderkey;
-	delete lo_orderdate;
-	delete lo_custkey;
-	delete lo_suppkey;
-	delete lo_partkey;
-	delete lo_revenue;
-	delete lo_discount;
-	delete lo_quantity;
-	delete lo_extendedprice;
-	delete lo_supplycost;
-
-	delete c_custkey;
-	delete c_nation;
-	delete c_region;
-	delete c_city;
-
-	delete s_suppkey;	
-	delete s_nation;
-	delete s_region;
-	delete s_city;
-
-	delete p_partkey;
-	delete p_brand1;
-	delete p_category;
-	delete p_mfgr;
-
-	delete d_datekey;
-	delete d_year;
-	delete d_yearmonthnum;
+	stopMigration();
+	tier->release();
+	delete tier;
+
+	//the columns of a host-only cache belong to the caller
+	if (!host_only) {
+		delete cpu_pool;
+		delete pinned_pool;
+		delete gpu_pool;
+		CubDebugExit(cudaFree(gpuProcessing));
+		numa->release(cpuProcessing);
+		CubDebugExit(cudaFreeHost(pinnedMemory));
+
+		numa->release(h_lo_orderkey);
+		numa->release(h_lo_suppkey);
+		numa->release(h_lo_custkey);
+		numa->release(h_lo_partkey);
+		numa->release(h_lo_orderdate);
+		numa->release(h_lo_revenue);
+		numa->release(h_lo_discount); 
+		numa->release(h_lo_quantity);
+		numa->release(h_lo_extendedprice);
+		numa->release(h_lo_supplycost);
+
+		CubDebugExit(cudaFreeHost(h_c_custkey));
+		CubDebugExit(cudaFreeHost(h_c_nation));
+		CubDebugExit(cudaFreeHost(h_c_region));
+		CubDebugExit(cudaFreeHost(h_c_city));
+
+		CubDebugExit(cudaFreeHost(h_s_suppkey));
+		CubDebugExit(cudaFreeHost(h_s_nation));
+		CubDebugExit(cudaFreeHost(h_s_region));
+		CubDebugExit(cudaFreeHost(h_s_city));
+
+		CubDebugExit(cudaFreeHost(h_p_partkey));
+		CubDebugExit(cudaFreeHost(h_p_brand1));
+		CubDebugExit(cudaFreeHost(h_p_category));
+		CubDebugExit(cudaFreeHost(h_p_mfgr));
+
+		CubDebugExit(cudaFreeHost(h_d_datekey));
+		CubDebugExit(cudaFreeHost(h_d_year));
+		CubDebugExit(cudaFreeHost(h_d_yearmonthnum));
+
+		delete lo_orderkey;
+		delete lo_orderdate;
+		delete lo_custkey;
+		delete lo_suppkey;
+		delete lo_partkey;
+		delete lo_revenue;
+		delete lo_discount;
+		delete lo_quantity;
+		delete lo_extendedprice;
+		delete lo_supplycost;
+
+		delete c_custkey;
+		delete c_nation;
+		delete c_region;
+		delete c_city;
+
+		delete s_suppkey;	
+		delete s_nation;
+		delete s_region;
+		delete s_city;
+
+		delete p_partkey;
+		delete p_brand1;
+		delete p_category;
+		delete p_mfgr;
+
+		delete d_datekey;
+		delete d_year;
+		delete d_yearmonthnum;
+	}
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
-		CubDebugExit(cudaFreeHost(segment_list[i]));
-		//free(segment_list[i]);
-		free(segment_bitmap[i]);
+		freeSegmentList(segment_list[i]);
 	}
 	free(segment_list);
 	free(segment_bitmap);
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		free(lo_segment_min[i]);
+		free(lo_segment_max[i]);
+	}
+	free(lo_segment_min);
+	free(lo_segment_max);
+	delete seg_stats;
+	delete numa;
 }
 
 
 template int*
-CacheManager::customMalloc<int>(int size);
+CacheManager::customMalloc<int>(ProcessingArena* arena, int size);
 
 template int*
-CacheManager::customCudaMalloc<int>(int size);
+CacheManager::customCudaMalloc<int>(ProcessingArena* arena, int size);
 
 template int*
-CacheManager::customCudaHostAlloc<int>(int size);
+CacheManager::customCudaHostAlloc<int>(ProcessingArena* arena, int size);
 
 template short*
-CacheManager::customMalloc<short>(int size);
+CacheManager::customMalloc<short>(ProcessingArena* arena, int size);
 
 template short*
-CacheManager::customCudaMalloc<short>(int size);
+CacheManager::customCudaMalloc<short>(ProcessingArena* arena, int size);
 
 template short*
-CacheManager::customCudaHostAlloc<short>(int size);
\ No newline at end of file
+CacheManager::customCudaHostAlloc<short>(ProcessingArena* arena, int size);
\ No newline at end of file
@@ -2,18 +2,44 @@
 #define _CACHE_MANAGER_H_
 
 #include "common.h"
+#include "CacheTier.h"
+#include "ProcessingArena.h"
+#include "NumaPlacement.h"
+#include "QueryTrace.h"
 
 #define CUB_STDERR
 
 class Statistics;
+class SegmentStatistics;
 class CacheManager;
+class MigrationEngine;
 class Segment;
 class ColumnInfo;
 class priority_stack;
 class custom_priority_queue;
 
 enum ReplacementPolicy {
-    LRU, LFU, LFUSegmented, LRUSegmented, Segmented, LRU2, LRU2Segmented
+    LRU, LFU, LFUSegmented, LRUSegmented, Segmented, LRU2, LRU2Segmented, GDSF, ARC
+};
+
+//policy from its name, anything else is Segmented
+inline ReplacementPolicy parsePolicy(string policy) {
+	if (policy == "LRU") return LRU;
+	else if (policy == "LFU") return LFU;
+	else if (policy == "LRUSegmented") return LRUSegmented;
+	else if (policy == "LFUSegmented") return LFUSegmented;
+	else if (policy == "LRU2") return LRU2;
+	else if (policy == "LRU2Segmented") return LRU2Segmented;
+	else if (policy == "GDSF") return GDSF;
+	else if (policy == "ARC") return ARC;
+	return Segmented;
+}
+
+#define SNAPSHOT_MAGIC 0x4d524453 //"MRDS"
+#define SNAPSHOT_VERSION 2
+
+enum ARCList {
+	ARC_T1, ARC_T2, ARC_B1, ARC_B2
 };
 
 class Statistics{
@@ -42,9 +68,40 @@ public:
 	int* seg_ptr; //ptr to the beginning of the segment
 	int priority;
 	int seg_size;
-	double weight;
+	int stats_idx; //index of this segment in SegmentStatistics
+};
 
-	Statistics* stats;
+//Structure-of-arrays statistics of every segment, indexed by offset[column_id] + segment_id.
+//All arrays live in a single allocation so that the whole table can be copied at once.
+class SegmentStatistics {
+public:
+	SegmentStatistics(vector<ColumnInfo*>& columns);
+	SegmentStatistics(const SegmentStatistics& other);
+	~SegmentStatistics();
+
+	int TOT_COLUMN;
+	int total_segment; //total segments of all columns
+	int* offset; //index of the first segment of each column
+	size_t data_size; //size of the allocation in bytes
+	char* data;
+
+	double* col_freq;
+	double* timestamp;
+	double* speedup;
+	double* backward_t;
+	double* weight;
+	double* decay_t; //logical time at which col_freq, speedup, backward_t and weight were last decayed
+	double* cost; //speedup credited by the last query that touched the segment (GDSF per-touch benefit)
+	char* cached; //1 if the segment is cached in GPU, backs segment_bitmap
+
+	int index(int column_id, int segment_id) {
+		return offset[column_id] + segment_id;
+	}
+
+	void copyFrom(const SegmentStatistics* other);
+
+private:
+	void setPointers();
 };
 
 class ColumnInfo{
@@ -61,6 +118,9 @@ public:
 	int tot_seg_in_GPU; //total segments in GPU (based on current weight)
 	double weight;
 	int total_segment;
+	int max_segment; //segments the buffer has room for, above total_segment if rows can be appended
+	bool dense; //key column holds dense_base, dense_base + 1, ... in row order (checked at load)
+	int dense_base;
 
 	Segment* getSegment(int index);
 };
@@ -131,11 +191,43 @@ public:
     }
 };
 
+//Applies a replacement plan in the background: evictions and copies into the cache tier are
+//issued one segment at a time under a copy bandwidth budget, and every residency change is
+//published with a single store of its slot (CacheManager::segment_list); an evicted slot is reused only
+//after the queries that may still read it have ended, so a running query never sees its segments move.
+class MigrationEngine {
+public:
+	MigrationEngine(CacheManager* _cm, double _bandwidth);
+	~MigrationEngine();
+
+	CacheManager* cm;
+	double bandwidth; //copy budget in bytes per second (0 is unlimited)
+	atomic<unsigned long long> traffic; //bytes copied into the cache tier
+
+	void submit(set<Segment*>& segments_to_place); //replace the pending plan
+	void cancel(); //drop the pending plan and wait for the segment in flight
+	void wait(); //block until the pending plan is applied
+
+private:
+	thread worker;
+	mutex plan_lock;
+	condition_variable plan_cv, idle_cv;
+	deque<Segment*> to_evict;
+	deque<Segment*> to_cache;
+	bool busy;
+	bool stop;
+
+	void run();
+};
+
 class CacheManager {
 public:
-	int* gpuCache;
+	NumaTopology* numa; //placement of columns and processing memory across NUMA nodes
+	CacheTier* tier; //fast tier holding the cached segments
+	bool host_only; //caller columns on a HostCacheTier, no CUDA call is made
+	int* gpuCache; //buffer of the fast tier
 	uint64_t* gpuProcessing, *cpuProcessing, *pinnedMemory;
-	unsigned int gpuPointer, cpuPointer, pinnedPointer;
+	ChunkPool* cpu_pool, *pinned_pool, *gpu_pool; //chunks of cpuProcessing, pinnedMemory and gpuProcessing, lent to the arenas of the queries
 	int cache_total_seg;
 	size_t cache_size, processing_size, pinned_memsize;
 	int TOT_COLUMN;
@@ -143,15 +235,44 @@ public:
 	vector<ColumnInfo*> allColumn;
 
 	queue<int> empty_gpu_segment; //free list
+	mutex free_list_lock; //guards empty_gpu_segment, retired_slots and active_queries
+	condition_variable slot_cv; //a retired slot went back to the free list
+	deque<pair<unsigned long long, int>> retired_slots; //evicted slots not reusable yet (residency epoch of the eviction, slot)
+	multiset<unsigned long long> active_queries; //residency epoch at which each running query started
+	unsigned long long residency_epoch; //bumped by every eviction
+	mutex stats_lock; //serializes the statistics updates of concurrent queries
+	double logical_time; //query clock of the statistics, advanced by every query under stats_lock
 	vector<priority_stack> cached_seg_in_GPU; //track segments that are already cached in GPU
 	int** segment_list; //segment list in GPU for each column
 	unordered_map<Segment*, int> cache_mapper; //map segment to index in GPU
 	vector<vector<Segment*>> index_to_segment; //track which segment has been created from a particular segment id
-	char** segment_bitmap; //bitmap to store information which segment is in GPU
+	char** segment_bitmap; //bitmap to store information which segment is in GPU (points into seg_stats->cached)
+	SegmentStatistics* seg_stats; //statistics of all segments
+
+	mutex residency_lock; //serializes the placement, the migration thread and the tail refresh of appendLineorder
+	mutex append_lock; //serializes appendLineorder
+	atomic<unsigned long long> lo_watermark; //published lineorder end: append epoch << 32 | rows (appendLineorder)
+	MigrationEngine* migration; //background repopulation (NULL if replacement is synchronous)
+	bool defer_placement; //record the placement computed by a policy instead of applying it
+	set<Segment*> planned_placement;
+
+	double decay_clock; //logical time (in queries) used for continuous decay
+	double half_life; //half-life of segment statistics in queries (0 disables continuous decay)
+
+	double gdsf_clock; //GreedyDual-Size-Frequency inflation value (L)
+	unordered_map<Segment*, double> gdsf_priority; //H value of each segment
+	unordered_map<Segment*, double> gdsf_last_seen; //timestamp at which H was last refreshed
+
+	double arc_target; //ARC adaptive target size of T1 (p)
+	list<Segment*> arc_list[4]; //T1, T2, B1, B2 (front is MRU)
+	unordered_map<Segment*, pair<ARCList, list<Segment*>::iterator>> arc_directory;
+	unordered_map<Segment*, double> arc_last_seen; //timestamp of the last access replayed into ARC
 
 	vector<vector<int>> columns_in_table;
 	int** segment_min;
 	int** segment_max;
+	int** lo_segment_min; //zone maps of dimension columns over the lineorder segments (zorderSort), NULL if absent
+	int** lo_segment_max;
 
 	int *h_lo_orderkey, *h_lo_orderdate, *h_lo_custkey, *h_lo_suppkey, *h_lo_partkey, *h_lo_revenue, *h_lo_discount, *h_lo_quantity, *h_lo_extendedprice, *h_lo_supplycost;
 	int *h_c_custkey, *h_c_nation, *h_c_region, *h_c_city;
@@ -165,7 +286,9 @@ public:
 	ColumnInfo *p_partkey, *p_brand1, *p_category, *p_mfgr;
 	ColumnInfo *d_datekey, *d_year, *d_yearmonthnum;
 
-	CacheManager(size_t cache_size, size_t _processing_size, size_t _pinned_memsize);
+	CacheManager(size_t cache_size, size_t _processing_size, size_t _pinned_memsize, GPUCacheTier* _tier = NULL);
+
+	CacheManager(vector<ColumnInfo*>& columns, int _TOT_TABLE, size_t _cache_size, HostCacheTier* _tier);
 
 	void resetCache(size_t cache_size, size_t _processing_size, size_t _pinned_memsize);
 
@@ -233,25 +356,71 @@ public:
 
 	unsigned long long SegmentReplacement();
 
+	unsigned long long GDSFReplacement();
+
+	unsigned long long ARCReplacement();
+
+	void ARCRequest(Segment* seg, int capacity);
+
+	void ARCReplace(bool in_b2);
+
+	void ARCMove(Segment* seg, ARCList dest);
+
+	unsigned long long applyPlacement(set<Segment*>& segments_to_place);
+
+	void runReplacementAsync(ReplacementPolicy strategy);
+
+	void startMigration(double bandwidth);
+
+	void stopMigration();
+
+	bool migrateSegmentIn(Segment* seg);
+
+	bool migrateSegmentOut(Segment* seg);
+
+	unsigned long long enterQuery();
+
+	void exitQuery(unsigned long long epoch);
+
+	int takeFreeSlot();
+
+	void retireSlot(int idx);
+
+	void reclaimSlots();
+
 	void loadColumnToCPU();
 
+	int appendLineorder(int** rows, int count);
+
+	void computeAppendZoneMaps(int segment_idx, int end, int* seg_min, int* seg_max);
+
 	void newEpoch(double param = 0.75);
 
+	void setHalfLife(double _half_life);
+
+	void advanceClock(double time = 1);
+
+	void decaySegment(int idx);
+
 	template <typename T>
-	T* customMalloc(int size);
+	T* customMalloc(ProcessingArena* arena, int size);
 
 	template <typename T>
-	T* customCudaMalloc(int size);
+	T* customCudaMalloc(ProcessingArena* arena, int size);
 
 	template <typename T>
-	T* customCudaHostAlloc(int size);
+	T* customCudaHostAlloc(ProcessingArena* arena, int size);
+
+	void indexTransfer(int** col_idx, ColumnInfo* column, int* seg_list, int total_segment, cudaStream_t stream, ProcessingArena* arena, bool custom = true);
 
-	void indexTransfer(int** col_idx, ColumnInfo* column, cudaStream_t stream, bool custom = true);
+	int* allocSegmentList(int n);
 
-	void resetPointer();
+	void freeSegmentList(int* list);
 
 	void readSegmentMinMax();
 
+	void detectDenseKeys();
+
 	int cacheSpecificColumn(string column_name);
 
 	int deleteSpecificColumnFromGPU(string column_name);
@@ -259,6 +428,10 @@ public:
 	void deleteColumnsFromGPU();
 
 	void deleteAll();
+
+	bool saveSnapshot(string filename, double logical_time);
+
+	bool loadSnapshot(string filename, double* logical_time);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef _CACHE_TIER_H_
+#define _CACHE_TIER_H_
+
+#include "common.h"
+
+enum TierType {
+	GPUTier, HostTier
+};
+
+//Fast tier that stores the cached segments. CacheManager owns the placement logic
+//(weights, replacement policies, free list and segment_bitmap), the tier only holds
+//the data of the occupied segment slots.
+class CacheTier {
+public:
+	TierType type;
+	size_t cache_size; //in number of ints
+	int* buffer;
+
+	CacheTier(TierType _type) : type(_type), cache_size(0), buffer(NULL) {};
+	virtual ~CacheTier() {};
+
+	virtual void allocate(size_t _cache_size) = 0;
+	virtual void release() = 0;
+	//copy len ints from the slow tier into segment slot idx
+	virtual void copySegment(int idx, int* src, int len) = 0;
+
+	int* slotPtr(int idx) {
+		return buffer + (size_t) idx * SEGMENT_SIZE;
+	}
+};
+
+class GPUCacheTier : public CacheTier {
+public:
+	GPUCacheTier() : CacheTier(GPUTier) {};
+
+	void allocate(size_t _cache_size) {
+		cache_size = _cache_size;
+		CubDebugExit(cudaMalloc((void**) &buffer, (cache_size) * sizeof(int)));
+		CubDebugExit(cudaMemset(buffer, 0, (cache_size) * sizeof(int)));
+	}
+
+	void release() {
+		if (buffer != NULL) CubDebugExit(cudaFree(buffer));
+		buffer = NULL;
+	}
+
+	void copySegment(int idx, int* src, int len) {
+		CubDebugExit(cudaMemcpy(slotPtr(idx), src, len * sizeof(int), cudaMemcpyHostToDevice));
+	}
+};
+
+//Host-memory tier, e.g. a decompressed copy of compressed columns, DRAM in front of CXL/PMEM
+//or the local NUMA node in front of a remote one. Needs no GPU.
+class HostCacheTier : public CacheTier {
+public:
+	HostCacheTier() : CacheTier(HostTier) {};
+
+	void allocate(size_t _cache_size) {
+		cache_size = _cache_size;
+		buffer = (int*) malloc(cache_size * sizeof(int));
+		assert(buffer != NULL);
+		memset(buffer, 0, cache_size * sizeof(int));
+	}
+
+	void release() {
+		free(buffer);
+		buffer = NULL;
+	}
+
+	void copySegment(int idx, int* src, int len) {
+		memcpy(slotPtr(idx), src, len * sizeof(int));
+	}
+};
+
+#endif
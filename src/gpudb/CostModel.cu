@@ -99,9 +99,9 @@ CostModel::permute_cost() {
 			}
 			for (int col = 0; col < cur_op->supporting_columns.size(); col++) {
 				ColumnInfo* column = cur_op->supporting_columns[col];
-				for (int seg_id = 0; seg_id < column->total_segment; seg_id++) {
+				for (int seg_id = 0; seg_id < qo->totalSegment(column); seg_id++) {
 					Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
-					qo->cm->updateSegmentWeightCostDirect(column, segment, (cost - default_cost) / column->total_segment);
+					qo->cm->updateSegmentWeightCostDirect(column, segment, (cost - default_cost) / qo->totalSegment(column));
 				}
 			}
 		} else if (cur_op->device == GPU) {
@@ -116,9 +116,9 @@ CostModel::permute_cost() {
 			}
 			for (int col = 0; col < cur_op->supporting_columns.size(); col++) {
 				ColumnInfo* column = cur_op->supporting_columns[col];
-				for (int seg_id = 0; seg_id < column->total_segment; seg_id++) {
+				for (int seg_id = 0; seg_id < qo->totalSegment(column); seg_id++) {
 					Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
-					qo->cm->updateSegmentWeightCostDirect(column, segment, (default_cost - cost) / column->total_segment);
+					qo->cm->updateSegmentWeightCostDirect(column, segment, (default_cost - cost) / qo->totalSegment(column));
 				}
 			}
 		}
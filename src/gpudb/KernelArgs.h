@@ -2,6 +2,7 @@
 #define _KERNEL_ARGS_H_
 
 #include "common.h"
+#include "ProcessingArena.h"
 
 // #define BLOCK_T 128
 // #define ITEMS_PER_T 4
@@ -100,6 +101,8 @@ __device__ filter_func_t_dev<T, BLOCK_THREADS, ITEMS_PER_THREADS> p_pred_eq_or_e
 template<typename T, int BLOCK_THREADS, int ITEMS_PER_THREADS>
 __device__ filter_func_t_dev<T, BLOCK_THREADS, ITEMS_PER_THREADS> p_pred_between = pred_between<T, BLOCK_THREADS, ITEMS_PER_THREADS>;
 
+#define SPEC_QUERY_BASE 101 //ids of the query specs, the SSB queries are 11 to 43
+
 class QueryParams{
 public:
 
@@ -112,6 +115,7 @@ public:
   map<ColumnInfo*, int> dim_len;
 
   map<ColumnInfo*, int*> ht_CPU;
+  map<ColumnInfo*, vector<int*>> ht_CPU_node; //per-node replicas of the small CPU hash tables
   map<ColumnInfo*, int*> ht_GPU;
 
   map<ColumnInfo*, int> compare1;
@@ -135,12 +139,22 @@ public:
   map<ColumnInfo*, filter_func_t_dev<int, 128, 4>> map_filter_func_dev;
   map<ColumnInfo*, filter_func_t_host<int>> map_filter_func_host;
 
-  QueryParams(int _query): query(_query) {
+  //processing memory of this query, from the pools shared by all running queries (released by releaseArenas)
+  ProcessingArena cpu_arena, pinned_arena, gpu_arena;
+
+  QueryParams(int _query, ChunkPool* cpu_pool, ChunkPool* pinned_pool, ChunkPool* gpu_pool):
+    query(_query), cpu_arena(cpu_pool), pinned_arena(pinned_pool), gpu_arena(gpu_pool) {
     assert(_query == 11 || _query == 12 || _query == 13 ||
           _query == 21 || _query == 22 || _query == 23 ||
           _query == 31 || _query == 32 || _query == 33 || _query == 34 ||
-          _query == 41 || _query == 42 || _query == 43); 
+          _query == 41 || _query == 42 || _query == 43 || _query >= SPEC_QUERY_BASE); 
   };
+
+  void releaseArenas() {
+    cpu_arena.release();
+    pinned_arena.release();
+    gpu_arena.release();
+  }
 };
 
 typedef struct probeArgsGPU {
@@ -185,6 +199,12 @@ typedef struct probeArgsCPU {
 	int min_key2;
 	int min_key3;
 	int min_key4;
+	//positional join: bit n-1 set if htn is the qualification bitmap of dimension rows, indexed by key - min_keyn
+	int* pos_val1; //group column of the dimension, read by row instead of from the hash table
+	int* pos_val2;
+	int* pos_val3;
+	int* pos_val4;
+	int positional;
 
 	// probeArgsCPU()
 	// : key_col1(NULL), key_col2(NULL), key_col3(NULL), key_col4(NULL),
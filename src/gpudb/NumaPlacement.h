@@ -0,0 +1,244 @@
+#ifndef _NUMA_PLACEMENT_H_
+#define _NUMA_PLACEMENT_H_
+
+#include "common.h"
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unordered_set>
+
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#define MPOL_INTERLEAVE 3
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+#define HUGE_PAGE_SIZE (2UL << 20)
+#define GIANT_PAGE_SIZE (1UL << 30)
+#define MAX_NUMA_NODE 64
+#define NUMA_REPLICATE_SIZE (16UL << 20) //hash tables up to this size are replicated on every node
+
+enum NumaPolicy {
+	NumaLocal, //first touch
+	NumaInterleave, //pages spread round robin over all nodes
+	NumaSegment //segment i is bound to node i % num_node
+};
+
+//pins the threads of one task arena to the cpus of a node while they work in it, a thread
+//gets its previous affinity back when it leaves the arena
+class NodeObserver : public tbb::task_scheduler_observer {
+public:
+	cpu_set_t mask;
+	tbb::enumerable_thread_specific<cpu_set_t> saved; //affinity of each thread before it entered
+
+	NodeObserver(tbb::task_arena& arena, cpu_set_t _mask) : tbb::task_scheduler_observer(arena), mask(_mask) {
+		observe(true);
+	}
+
+	void on_scheduler_entry(bool) {
+		sched_getaffinity(0, sizeof(cpu_set_t), &saved.local());
+		sched_setaffinity(0, sizeof(cpu_set_t), &mask);
+	}
+
+	void on_scheduler_exit(bool) {
+		sched_setaffinity(0, sizeof(cpu_set_t), &saved.local());
+	}
+};
+
+//NUMA topology read from sysfs, huge-page backed allocation with a placement policy and
+//one task arena per node. On a single node machine everything degenerates to plain THP
+//backed memory and the default arena.
+class NumaTopology {
+public:
+	int num_node;
+	vector<vector<int>> node_cpus;
+	vector<int> cpu_node;
+	vector<tbb::task_arena*> arena;
+	vector<NodeObserver*> observer;
+
+	NumaTopology() {
+		num_node = 0;
+		for (int node = 0; node < MAX_NUMA_NODE; node++) {
+			ifstream cpulist("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+			if (!cpulist) continue;
+			string list;
+			getline(cpulist, list);
+			node_cpus.resize(node + 1);
+			parseCpuList(list, node_cpus[node]);
+			num_node = node + 1;
+		}
+
+		if (num_node == 0) {
+			num_node = 1;
+			node_cpus.resize(1);
+			for (int cpu = 0; cpu < thread::hardware_concurrency(); cpu++) node_cpus[0].push_back(cpu);
+		}
+
+		for (int node = 0; node < num_node; node++) {
+			for (int i = 0; i < node_cpus[node].size(); i++) {
+				int cpu = node_cpus[node][i];
+				if (cpu >= cpu_node.size()) cpu_node.resize(cpu + 1, 0);
+				cpu_node[cpu] = node;
+			}
+		}
+
+		if (num_node > 1) {
+			for (int node = 0; node < num_node; node++) {
+				cpu_set_t mask;
+				CPU_ZERO(&mask);
+				for (int i = 0; i < node_cpus[node].size(); i++) CPU_SET(node_cpus[node][i], &mask);
+				int concurrency = max((int) node_cpus[node].size(), 1);
+				arena.push_back(new tbb::task_arena(concurrency));
+				arena[node]->initialize();
+				observer.push_back(new NodeObserver(*arena[node], mask));
+			}
+		}
+
+		printf("NUMA nodes: %d\n", num_node);
+	}
+
+	~NumaTopology() {
+		for (int node = 0; node < observer.size(); node++) {
+			observer[node]->observe(false);
+			delete observer[node];
+			delete arena[node];
+		}
+	}
+
+	int segmentNode(int segment_id) {
+		return segment_id % num_node;
+	}
+
+	int currentNode() {
+		int cpu = sched_getcpu();
+		if (cpu < 0 || cpu >= cpu_node.size()) return 0;
+		return cpu_node[cpu];
+	}
+
+	//node owning most of the given segments
+	int majorityNode(short* segment, int count) {
+		if (num_node == 1) return 0;
+		vector<int> owned(num_node, 0);
+		for (int i = 0; i < count; i++) owned[segmentNode(segment[i])]++;
+		return max_element(owned.begin(), owned.end()) - owned.begin();
+	}
+
+	//run f on the threads of a node
+	template <typename F>
+	void execute(int node, F f) {
+		if (arena.empty()) f();
+		else arena[node]->execute(f);
+	}
+
+	//huge page backed allocation, 1 GB pages are used when they are reserved and the buffer is large enough.
+	//NumaSegment stays on 2 MB pages: a segment is smaller than a 1 GB page, which mbind cannot split.
+	void* allocate(size_t bytes, NumaPolicy policy, int node = 0) {
+		size_t len = 0;
+		char* ptr = (char*) MAP_FAILED;
+
+		if (bytes >= GIANT_PAGE_SIZE && policy != NumaSegment) {
+			len = (bytes + GIANT_PAGE_SIZE - 1) / GIANT_PAGE_SIZE * GIANT_PAGE_SIZE;
+			ptr = (char*) mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+		}
+
+		char* base = ptr;
+		if (ptr == MAP_FAILED) {
+			//over-allocate so that the buffer starts on a 2 MB boundary
+			len = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE + HUGE_PAGE_SIZE;
+			base = (char*) mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			assert(base != MAP_FAILED);
+			ptr = (char*) (((uintptr_t) base + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+			madvise(ptr, len - (ptr - base), MADV_HUGEPAGE);
+		}
+
+		if (num_node > 1) {
+			size_t span = len - (ptr - base);
+			if (policy == NumaInterleave) {
+				bind(ptr, span, MPOL_INTERLEAVE, -1);
+			} else if (policy == NumaSegment) {
+				size_t seg_bytes = SEGMENT_SIZE * sizeof(int);
+				for (size_t off = 0, seg = 0; off < span; off += seg_bytes, seg++) {
+					bind(ptr + off, min(seg_bytes, span - off), MPOL_BIND, segmentNode(seg));
+				}
+			} else if (policy == NumaLocal && node >= 0) {
+				bind(ptr, span, MPOL_BIND, node);
+			}
+		}
+
+		unique_lock<mutex> guard(lock);
+		mapping[ptr] = make_pair(base, len);
+		return ptr;
+	}
+
+	//page-lock a whole allocation for the copies to the GPU, as cudaHostAlloc memory is. The pages keep
+	//the placement of the policy, and every page is backed from now on.
+	void pin(void* ptr) {
+		unique_lock<mutex> guard(lock);
+		unordered_map<void*, pair<char*, size_t>>::iterator it = mapping.find(ptr);
+		assert(it != mapping.end());
+		size_t span = it->second.second - ((char*) ptr - it->second.first);
+		CubDebugExit(cudaHostRegister(ptr, span, cudaHostRegisterPortable));
+		pinned.insert(ptr);
+	}
+
+	void release(void* ptr) {
+		if (ptr == NULL) return;
+		unique_lock<mutex> guard(lock);
+		unordered_map<void*, pair<char*, size_t>>::iterator it = mapping.find(ptr);
+		assert(it != mapping.end());
+		if (pinned.erase(ptr)) CubDebugExit(cudaHostUnregister(ptr));
+		munmap(it->second.first, it->second.second);
+		mapping.erase(it);
+	}
+
+private:
+	mutex lock;
+	unordered_map<void*, pair<char*, size_t>> mapping; //aligned pointer to (mmap base, length)
+	unordered_set<void*> pinned; //allocations registered with CUDA
+	atomic<bool> bind_warned{false};
+
+	void bind(void* ptr, size_t len, int mode, int node) {
+		unsigned long nodemask[MAX_NUMA_NODE / (8 * sizeof(unsigned long))] = {0};
+		for (int n = 0; n < num_node; n++) {
+			if (node < 0 || n == node) nodemask[n / (8 * sizeof(unsigned long))] |= 1UL << (n % (8 * sizeof(unsigned long)));
+		}
+		//binding is a hint, memory stays usable if the kernel refuses it
+		if (syscall(SYS_mbind, ptr, len, mode, nodemask, MAX_NUMA_NODE, 0) != 0 && !bind_warned.exchange(true)) {
+			perror("mbind failed, memory is placed on first touch");
+		}
+	}
+
+	static void parseCpuList(string list, vector<int>& cpus) {
+		stringstream ss(list);
+		string range;
+		while (getline(ss, range, ',')) {
+			if (range.empty()) continue;
+			size_t dash = range.find('-');
+			int lo = stoi(range.substr(0, dash));
+			int hi = (dash == string::npos) ? lo : stoi(range.substr(dash + 1));
+			for (int cpu = lo; cpu <= hi; cpu++) cpus.push_back(cpu);
+		}
+	}
+};
+
+//pinned like the columns of loadColumnPinnedSort, the reserved segments included so that
+//appended rows are copied to the GPU as fast as the loaded ones
+template<typename T>
+T* loadColumnNumaSort(string col_name, int num_entries, NumaTopology* numa, NumaPolicy policy, int reserve_segment = 0) {
+  T* h_col = (T*) numa->allocate((size_t) ((num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE + reserve_segment) * SEGMENT_SIZE * sizeof(T), policy);
+  string filename = DATA_DIR + lookupSort(col_name);
+  ifstream colData (filename.c_str(), ios::in | ios::binary);
+  if (!colData) {
+    numa->release(h_col);
+    return NULL;
+  }
+
+  colData.read((char*)h_col, num_entries * sizeof(T));
+  numa->pin(h_col);
+  return h_col;
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include "common.h"
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define PERF_MAX_GROUPS MAX_GROUPS //one slot per segment group
+
+enum PerfEvent {
+	PerfCycles, PerfInstructions, PerfLLCMisses, PerfDTLBMisses, PerfBranchMisses, TOT_PERF_EVENT
+};
+
+//one entry per call_*_CPU operator of CPUGPUProcessing
+enum PerfOperator {
+	OpPFilterProbe, OpProbeGroupBy, OpProbe, OpPFilter, OpBFilterBuild, OpBuild, OpBFilter,
+	OpGroupBy, OpAggregation, OpProbeAggr, OpPFilterProbeAggr, TOT_PERF_OP
+};
+
+struct PerfSlot {
+	atomic<unsigned long long> count[TOT_PERF_EVENT];
+	atomic<unsigned long long> calls;
+};
+
+//Counters of the calling thread. They are opened once per thread and read from user space
+//with rdpmc when the kernel allows it, which costs tens of cycles instead of a syscall.
+class ThreadPerf {
+public:
+	bool ok;
+
+	ThreadPerf() {
+		unsigned long long config[TOT_PERF_EVENT][2] = {
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+			{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+		};
+		for (int e = 0; e < TOT_PERF_EVENT; e++) {
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = config[e][0];
+			attr.config = config[e][1];
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd[e] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+			page[e] = NULL;
+			if (fd[e] < 0) continue; //events the cpu does not support read as 0
+			void* p = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd[e], 0);
+			if (p != MAP_FAILED) page[e] = (struct perf_event_mmap_page*) p;
+		}
+		ok = (fd[PerfCycles] >= 0);
+	}
+
+	~ThreadPerf() {
+		for (int e = 0; e < TOT_PERF_EVENT; e++) {
+			if (page[e] != NULL) munmap(page[e], sysconf(_SC_PAGESIZE));
+			if (fd[e] >= 0) close(fd[e]);
+		}
+	}
+
+	void read(unsigned long long* value) {
+		for (int e = 0; e < TOT_PERF_EVENT; e++) {
+			value[e] = readEvent(e);
+		}
+	}
+
+	static ThreadPerf& local() {
+		static thread_local ThreadPerf perf;
+		return perf;
+	}
+
+private:
+	int fd[TOT_PERF_EVENT];
+	struct perf_event_mmap_page* page[TOT_PERF_EVENT];
+
+	unsigned long long readEvent(int e) {
+		if (fd[e] < 0) return 0;
+#if defined(__x86_64__)
+		struct perf_event_mmap_page* pc = page[e];
+		if (pc != NULL && pc->cap_user_rdpmc) {
+			unsigned int seq;
+			unsigned long long count;
+			do {
+				seq = pc->lock;
+				__sync_synchronize();
+				unsigned int idx = pc->index;
+				count = pc->offset;
+				if (idx != 0) {
+					unsigned int lo, hi;
+					asm volatile("rdpmc" : "=a" (lo), "=d" (hi) : "c" (idx - 1));
+					long long pmc = ((unsigned long long) hi << 32) | lo;
+					pmc <<= 64 - pc->pmc_width;
+					pmc >>= 64 - pc->pmc_width;
+					count += pmc;
+				}
+				__sync_synchronize();
+			} while (pc->lock != seq);
+			return count;
+		}
+#endif
+		unsigned long long count = 0;
+		if (::read(fd[e], &count, sizeof(count)) != sizeof(count)) return 0;
+		return count;
+	}
+};
+
+//Counters aggregated per operator and segment group. Disabled by default; when disabled
+//the instrumentation is a NULL check per task.
+class PerfCounters {
+public:
+	static bool enabled;
+	static PerfSlot slot[TOT_PERF_OP][PERF_MAX_GROUPS];
+	static thread_local PerfSlot* current; //operator the calling thread is running
+
+	static void enable(bool _enabled) {
+		if (_enabled && !ThreadPerf::local().ok) {
+			printf("perf_event_open failed, check /proc/sys/kernel/perf_event_paranoid\n");
+			_enabled = false;
+		}
+		enabled = _enabled;
+	}
+
+	static void reset() {
+		for (int op = 0; op < TOT_PERF_OP; op++) {
+			for (int sg = 0; sg < PERF_MAX_GROUPS; sg++) {
+				for (int e = 0; e < TOT_PERF_EVENT; e++) slot[op][sg].count[e] = 0;
+				slot[op][sg].calls = 0;
+			}
+		}
+	}
+
+	//one CSV line per operator and segment group that ran
+	static void report(ostream& out) {
+		const char* op_name[TOT_PERF_OP] = {"pfilter_probe", "probe_group_by", "probe", "pfilter", "bfilter_build", "build",
+			"bfilter", "group_by", "aggregation", "probe_aggr", "pfilter_probe_aggr"};
+		out << "operator,sg,calls,cycles,instructions,ipc,llc_misses,dtlb_misses,branch_misses" << endl;
+		for (int op = 0; op < TOT_PERF_OP; op++) {
+			for (int sg = 0; sg < PERF_MAX_GROUPS; sg++) {
+				PerfSlot& s = slot[op][sg];
+				if (s.calls == 0) continue;
+				double ipc = s.count[PerfCycles] ? (double) s.count[PerfInstructions] / s.count[PerfCycles] : 0;
+				out << op_name[op] << "," << sg << "," << s.calls << "," << s.count[PerfCycles] << "," << s.count[PerfInstructions] << ","
+					<< ipc << "," << s.count[PerfLLCMisses] << "," << s.count[PerfDTLBMisses] << "," << s.count[PerfBranchMisses] << endl;
+			}
+		}
+	}
+};
+
+//marks the calling thread as running an operator for a segment group
+class PerfRegion {
+public:
+	PerfSlot* prev;
+
+	PerfRegion(PerfOperator op, int sg) {
+		prev = PerfCounters::current;
+		PerfCounters::current = NULL;
+		if (PerfCounters::enabled && sg < PERF_MAX_GROUPS) {
+			PerfCounters::current = &PerfCounters::slot[op][sg];
+			PerfCounters::current->calls++;
+		}
+	}
+
+	~PerfRegion() {
+		PerfCounters::current = prev;
+	}
+};
+
+//counts the work of one task on the executing thread into the operator slot
+class PerfScope {
+public:
+	PerfSlot* slot;
+	unsigned long long begin[TOT_PERF_EVENT];
+
+	PerfScope(PerfSlot* _slot) : slot(_slot) {
+		if (slot != NULL) ThreadPerf::local().read(begin);
+	}
+
+	~PerfScope() {
+		if (slot == NULL) return;
+		unsigned long long end[TOT_PERF_EVENT];
+		ThreadPerf::local().read(end);
+		for (int e = 0; e < TOT_PERF_EVENT; e++) {
+			slot->count[e].fetch_add(end[e] - begin[e], memory_order_relaxed);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef _PROCESSING_ARENA_H_
+#define _PROCESSING_ARENA_H_
+
+#include "common.h"
+#include <array>
+
+#define ARENA_CHUNK_SIZE 262144 //in uint64_t (2 MB)
+#define ARENA_SIZE_CLASSES 3
+#define ARENA_SMALL_SIZE (ARENA_CHUNK_SIZE/8) //larger requests get their own run of chunks
+
+//largest request of each size class, in uint64_t
+static const size_t arena_class_size[ARENA_SIZE_CLASSES] = {ARENA_CHUNK_SIZE/256, ARENA_CHUNK_SIZE/32, ARENA_SMALL_SIZE};
+
+enum ChunkMemory {
+	HostChunk, //cpuProcessing, spills with malloc
+	PinnedChunk, //pinnedMemory, spills with cudaHostAlloc
+	DeviceChunk //gpuProcessing, spills with cudaMalloc
+};
+
+//Preallocated processing region (cpuProcessing, pinnedMemory or gpuProcessing) cut into fixed-size
+//chunks. Chunks are lent to query arenas and returned when the query ends; the pool is shared by all
+//running queries. A request that does not fit in the region spills to a fresh allocation instead of failing.
+class ChunkPool {
+public:
+	uint64_t* base;
+	int total_chunk;
+	ChunkMemory memory;
+
+	size_t used_bytes; //bytes lent out, including spills
+	size_t high_water; //maximum of used_bytes
+	size_t spilled_bytes; //bytes that did not fit in the region since the last reset
+
+	ChunkPool(uint64_t* _base, size_t size, ChunkMemory _memory) {
+		base = _base;
+		total_chunk = size / ARENA_CHUNK_SIZE;
+		memory = _memory;
+		used.assign(total_chunk, 0);
+		used_bytes = 0;
+		high_water = 0;
+		spilled_bytes = 0;
+	}
+
+	//first fit of n contiguous chunks, returns NULL if there is none
+	uint64_t* acquire(int n) {
+		unique_lock<mutex> guard(lock);
+		int run = 0;
+		for (int i = 0; i < total_chunk; i++) {
+			run = used[i] ? 0 : run + 1;
+			if (run == n) {
+				int first = i - n + 1;
+				memset(&used[first], 1, n);
+				account(n * ARENA_CHUNK_SIZE * sizeof(uint64_t));
+				return base + (size_t) first * ARENA_CHUNK_SIZE;
+			}
+		}
+		return NULL;
+	}
+
+	void release(uint64_t* ptr, int n) {
+		unique_lock<mutex> guard(lock);
+		int first = (ptr - base) / ARENA_CHUNK_SIZE;
+		assert(first >= 0 && first + n <= total_chunk);
+		memset(&used[first], 0, n);
+		used_bytes -= n * ARENA_CHUNK_SIZE * sizeof(uint64_t);
+	}
+
+	uint64_t* spill(size_t size) {
+		uint64_t* ptr;
+		if (memory == PinnedChunk) CubDebugExit(cudaHostAlloc((void**) &ptr, size * sizeof(uint64_t), cudaHostAllocDefault));
+		else if (memory == DeviceChunk) CubDebugExit(cudaMalloc((void**) &ptr, size * sizeof(uint64_t)));
+		else ptr = (uint64_t*) malloc(size * sizeof(uint64_t));
+		assert(ptr != NULL);
+		unique_lock<mutex> guard(lock);
+		spilled_bytes += size * sizeof(uint64_t);
+		account(size * sizeof(uint64_t));
+		return ptr;
+	}
+
+	void freeSpill(uint64_t* ptr, size_t size) {
+		if (memory == PinnedChunk) CubDebugExit(cudaFreeHost(ptr));
+		else if (memory == DeviceChunk) CubDebugExit(cudaFree(ptr));
+		else free(ptr);
+		unique_lock<mutex> guard(lock);
+		used_bytes -= size * sizeof(uint64_t);
+	}
+
+	void resetHighWater() {
+		unique_lock<mutex> guard(lock);
+		high_water = used_bytes;
+		spilled_bytes = 0;
+	}
+
+private:
+	mutex lock;
+	vector<char> used; //1 if the chunk is lent out
+
+	void account(size_t bytes) {
+		used_bytes += bytes;
+		high_water = max(high_water, used_bytes);
+	}
+};
+
+//Memory of one query in one pool. Small requests are bumped from a chunk owned by the calling thread,
+//one chunk per size class, so that a small request does not throw away the rest of a chunk that a
+//larger one did not fit in. Large requests take a run of contiguous chunks. Everything goes back to
+//the pool on release().
+class ProcessingArena {
+public:
+	ChunkPool* pool;
+
+	ProcessingArena(ChunkPool* _pool) : pool(_pool) {};
+
+	~ProcessingArena() {
+		release();
+	}
+
+	//size in uint64_t
+	uint64_t* allocate(size_t size) {
+		if (size > ARENA_SMALL_SIZE) {
+			return grab((size + ARENA_CHUNK_SIZE - 1) / ARENA_CHUNK_SIZE);
+		}
+
+		int size_class = 0;
+		while (size > arena_class_size[size_class]) size_class++;
+		LocalChunk& chunk = local.local()[size_class];
+		if (chunk.left < size) {
+			chunk.ptr = grab(1);
+			chunk.left = ARENA_CHUNK_SIZE;
+		}
+		uint64_t* ptr = chunk.ptr;
+		chunk.ptr += size;
+		chunk.left -= size;
+		return ptr;
+	}
+
+	void release() {
+		unique_lock<mutex> guard(lock);
+		for (int i = 0; i < runs.size(); i++) {
+			pool->release(runs[i].first, runs[i].second);
+		}
+		for (int i = 0; i < spills.size(); i++) {
+			pool->freeSpill(spills[i].first, spills[i].second);
+		}
+		runs.clear();
+		spills.clear();
+		local.clear();
+	}
+
+private:
+	struct LocalChunk {
+		uint64_t* ptr = NULL;
+		size_t left = 0; //in uint64_t
+	};
+
+	tbb::enumerable_thread_specific<array<LocalChunk, ARENA_SIZE_CLASSES>> local;
+	mutex lock;
+	vector<pair<uint64_t*, int>> runs; //chunks lent by the pool (first chunk, number of chunks)
+	vector<pair<uint64_t*, size_t>> spills; //allocations outside of the pool (pointer, size)
+
+	uint64_t* grab(int n) {
+		uint64_t* ptr = pool->acquire(n);
+		unique_lock<mutex> guard(lock);
+		if (ptr != NULL) {
+			runs.push_back({ptr, n});
+		} else {
+			ptr = pool->spill((size_t) n * ARENA_CHUNK_SIZE);
+			spills.push_back({ptr, (size_t) n * ARENA_CHUNK_SIZE});
+		}
+		return ptr;
+	}
+};
+
+#endif
@@ -3,11 +3,22 @@
 #include "CacheManager.h"
 #include "CPUGPUProcessing.h"
 
-QueryOptimizer::QueryOptimizer(size_t _cache_size, size_t _processing_size, size_t _pinned_memsize, CPUGPUProcessing* _cgp) {
-	cm = new CacheManager(_cache_size, _processing_size, _pinned_memsize);
+QueryOptimizer::QueryOptimizer(size_t _cache_size, size_t _processing_size, size_t _pinned_memsize, CPUGPUProcessing* _cgp)
+: QueryOptimizer(new CacheManager(_cache_size, _processing_size, _pinned_memsize), _cgp) {
+	own_cm = true;
+}
+
+//optimizer of one client on a cache shared with other clients, each client plans and runs its own queries
+QueryOptimizer::QueryOptimizer(CacheManager* _cm, CPUGPUProcessing* _cgp) {
+	cm = _cm;
+	own_cm = false;
 	cgp = _cgp;
+	params = NULL;
+	lo_len = lo_total_segment = 0;
 	custom = cgp->custom;
 	skipping = cgp->skipping;
+	radix_probe_threshold = RADIX_PROBE_THRESHOLD;
+	positional_join = POSITIONAL_JOIN;
 	fkey_pkey[cm->lo_orderdate] = cm->d_datekey;
 	fkey_pkey[cm->lo_partkey] = cm->p_partkey;
 	fkey_pkey[cm->lo_custkey] = cm->c_custkey;
@@ -19,8 +30,15 @@ QueryOptimizer::QueryOptimizer(size_t _cache_size, size_t _processing_size, size
 
 	speedup_segment = new double*[cm->TOT_COLUMN];
 	for (int i = 0; i < cm->TOT_COLUMN; i++) {
-		speedup_segment[i] = new double[cm->allColumn[i]->total_segment];
-		memset(speedup_segment[i], 0, cm->allColumn[i]->total_segment * sizeof(double));
+		speedup_segment[i] = new double[cm->allColumn[i]->max_segment];
+		memset(speedup_segment[i], 0, cm->allColumn[i]->max_segment * sizeof(double));
+	}
+
+	seg_list = new int*[cm->TOT_COLUMN];
+	seg_cached = new int[cm->TOT_COLUMN];
+	for (int i = 0; i < cm->TOT_COLUMN; i++) {
+		CubDebugExit(cudaHostAlloc((void**) &(seg_list[i]), cm->allColumn[i]->max_segment * sizeof(int), cudaHostAllocDefault));
+		seg_cached[i] = 0;
 	}
 
 	double alpha = 0.1;
@@ -62,8 +80,12 @@ QueryOptimizer::QueryOptimizer(size_t _cache_size, size_t _processing_size, size
 QueryOptimizer::~QueryOptimizer() {
 	fkey_pkey.clear();
 	pkey_fkey.clear();
-	delete cm;
+	for (map<int, QuerySpec*>::iterator it = specs.begin(); it != specs.end(); it++) delete it->second;
 	delete params;
+	for (int i = 0; i < cm->TOT_COLUMN; i++) CubDebugExit(cudaFreeHost(seg_list[i]));
+	delete[] seg_list;
+	delete[] seg_cached;
+	if (own_cm) delete cm;
 }
 
 void
@@ -104,6 +126,10 @@ QueryOptimizer::setDistributionNormal(double mean, double stddev) {
 void 
 QueryOptimizer::parseQuery(int query) {
 
+	//the query runs on the lineorder rows published when it starts, appendLineorder may publish more meanwhile
+	lo_len = (int) (cm->lo_watermark.load(memory_order_acquire) & 0xffffffff);
+	lo_total_segment = (lo_len + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+
 	if (query == 11) parseQuery11();
 	else if (query == 12) parseQuery12();
 	else if (query == 13) parseQuery13();
@@ -117,9 +143,24 @@ QueryOptimizer::parseQuery(int query) {
 	else if (query == 41) parseQuery41();
 	else if (query == 42) parseQuery42();
 	else if (query == 43) parseQuery43();
+	else if (specs.find(query) != specs.end()) parseQuerySpec(specs[query]);
 	else assert(0);
 }
 
+//registers a star-join query given as text (QuerySpec.h), returns its query id or -1 if the text is not a query the kernels can run
+int
+QueryOptimizer::addQuerySpec(string text) {
+	QuerySpec* spec = new QuerySpec(cm, text);
+	if (!spec->error.empty()) {
+		fprintf(stderr, "Query spec \"%s\": %s\n", text.c_str(), spec->error.c_str());
+		delete spec;
+		return -1;
+	}
+	int query = SPEC_QUERY_BASE + specs.size();
+	specs[query] = spec;
+	return query;
+}
+
 void
 QueryOptimizer::clearPlacement() {
 
@@ -1340,6 +1381,83 @@ QueryOptimizer::parseQuery43() {
 	opParsed[4].push_back(op);
 }
 
+//the plan of parseQueryNN for the columns of a spec: lineorder filters, one probe per joined dimension
+//in table order, then the group by (or the aggregate); every dimension filters at most once and builds
+void
+QueryOptimizer::parseQuerySpec(QuerySpec* spec) {
+
+	queryColumn.resize(cm->TOT_TABLE);
+	opParsed.resize(cm->TOT_TABLE);
+
+	auto addColumn = [&] (int table_id, ColumnInfo* column) {
+		if (find(queryColumn[table_id].begin(), queryColumn[table_id].end(), column) == queryColumn[table_id].end())
+			queryColumn[table_id].push_back(column);
+	};
+
+	Operator* op;
+	for (int i = 0; i < spec->predicates.size(); i++) {
+		ColumnInfo* column = spec->predicates[i].column;
+		if (column->table_id != 0) continue;
+		addColumn(0, column);
+		querySelectColumn.push_back(column);
+		select_probe[cm->lo_orderdate].push_back(column);
+		op = new Operator(CPU, 0, 0, Filter);
+		op->columns.push_back(column);
+		opParsed[0].push_back(op);
+	}
+
+	join.resize(spec->tables.size());
+	for (int i = 0; i < spec->tables.size(); i++) {
+		int table_id = spec->tables[i];
+		ColumnInfo* pkey = cm->allColumn[cm->columns_in_table[table_id][0]];
+		ColumnInfo* fkey = pkey_fkey[pkey];
+		join[i] = pair<ColumnInfo*, ColumnInfo*> (fkey, pkey);
+
+		addColumn(0, fkey);
+		addColumn(table_id, pkey);
+		queryBuildColumn.push_back(pkey);
+		queryProbeColumn.push_back(fkey);
+
+		op = new Operator(CPU, 0, 0, Probe);
+		op->columns.push_back(fkey);
+		op->supporting_columns.push_back(pkey);
+		opParsed[0].push_back(op);
+
+		SpecPredicate* predicate = spec->predicateOn(table_id);
+		if (predicate != NULL) {
+			addColumn(table_id, predicate->column);
+			querySelectColumn.push_back(predicate->column);
+			select_build[pkey].push_back(predicate->column);
+			op = new Operator(CPU, 0, table_id, Filter);
+			op->columns.push_back(predicate->column);
+			opParsed[table_id].push_back(op);
+		}
+
+		ColumnInfo* group = spec->groupOn(table_id);
+		if (group != NULL) {
+			addColumn(table_id, group);
+			queryGroupByColumn.push_back(group);
+			groupby_build[pkey].push_back(group);
+		}
+
+		op = new Operator(CPU, 0, table_id, Build);
+		op->columns.push_back(pkey);
+		op->supporting_columns.push_back(fkey);
+		opParsed[table_id].push_back(op);
+	}
+
+	//the kernels compute aggr1 - aggr2 (grouped) or aggr1 * aggr2
+	op = new Operator(CPU, 0, 0, (spec->group.size() > 0) ? GroupBy : Aggr);
+	for (int i = 0; i < spec->aggr.size(); i++) {
+		addColumn(0, spec->aggr[i]);
+		queryAggrColumn.push_back(spec->aggr[i]);
+		aggregation[cm->lo_orderdate].push_back(spec->aggr[i]);
+		op->columns.push_back(spec->aggr[i]);
+	}
+	for (int i = 0; i < spec->group.size(); i++) op->supporting_columns.push_back(spec->group[i]);
+	opParsed[0].push_back(op);
+}
+
 // 
 
 void
@@ -1383,7 +1501,7 @@ QueryOptimizer::prepareOperatorPlacement() {
 	// segment_group_temp_count = (short**) malloc (cm->TOT_TABLE * sizeof(short*));
 	par_segment = (short**) malloc (cm->TOT_TABLE * sizeof(short*));
 	for (int i = 0; i < cm->TOT_TABLE; i++) {
-		CubDebugExit(cudaHostAlloc((void**) &(segment_group[i]), MAX_GROUPS * cm->lo_orderdate->total_segment * sizeof(short), cudaHostAllocDefault));
+		CubDebugExit(cudaHostAlloc((void**) &(segment_group[i]), MAX_GROUPS * cm->lo_orderdate->max_segment * sizeof(short), cudaHostAllocDefault));
 		segment_group_count[i] = (short*) malloc (MAX_GROUPS * sizeof(short));
 		par_segment[i] = (short*) malloc (MAX_GROUPS * sizeof(short));
 		joinGPU[i] = (bool*) malloc(MAX_GROUPS * sizeof(bool));
@@ -1398,12 +1516,14 @@ QueryOptimizer::prepareOperatorPlacement() {
 	par_segment_count = new short[cm->TOT_TABLE];
 	memset(par_segment_count, 0, cm->TOT_TABLE * sizeof(short));
 
+	snapshotResidency();
+
 	groupGPUcheck = true;
 
 	for (int i = 0; i < join.size(); i++) {
 		if (groupby_build.size() > 0) {
 			for (int j = 0; j < groupby_build[join[i].second].size(); j++) {
-				int tot_seg_in_GPU = groupby_build[join[i].second][j]->tot_seg_in_GPU;
+				int tot_seg_in_GPU = cachedSegments(groupby_build[join[i].second][j]);
 				int total_segment = groupby_build[join[i].second][j]->total_segment;
 				if (tot_seg_in_GPU < total_segment) {
 					groupGPUcheck = false;
@@ -1415,15 +1535,15 @@ QueryOptimizer::prepareOperatorPlacement() {
 
 	joinGPUall = true;
 	for (int i = 0; i < join.size(); i++) {
-		if (join[i].second->tot_seg_in_GPU < join[i].second->total_segment) {
+		if (cachedSegments(join[i].second) < join[i].second->total_segment) {
 			joinCPUcheck[join[i].second->table_id] = true;
 			joinGPUcheck[join[i].second->table_id] = false;
 			joinGPUall = false;
 		} else {
-			if (pkey_fkey[join[i].second]->tot_seg_in_GPU == pkey_fkey[join[i].second]->total_segment) {
+			if (cachedSegments(pkey_fkey[join[i].second]) == totalSegment(pkey_fkey[join[i].second])) {
 				joinCPUcheck[join[i].second->table_id] = false;
 				joinGPUcheck[join[i].second->table_id] = true;
-			} else if (pkey_fkey[join[i].second]->tot_seg_in_GPU == 0) {
+			} else if (cachedSegments(pkey_fkey[join[i].second]) == 0) {
 				joinCPUcheck[join[i].second->table_id] = true;
 				joinGPUcheck[join[i].second->table_id] = false;
 			} else {
@@ -1436,6 +1556,75 @@ QueryOptimizer::prepareOperatorPlacement() {
 
 }
 
+//CPU join of segment group sg with the largest hash table above radix_probe_threshold (NULL if there is none).
+//Its hash table does not fit in the cache, so call_probe_CPU, and radixProbeFirst ahead of the fused CPU operators,
+//probe it radix-partitioned instead of tuple at a time.
+ColumnInfo*
+QueryOptimizer::radixProbeColumn(int sg) {
+	ColumnInfo* radix_column = NULL;
+	size_t max_size = radix_probe_threshold;
+	if (radix_probe_threshold == 0) return NULL;
+	for (int i = 0; i < joinCPUPipelineCol[sg].size(); i++) {
+		ColumnInfo* column = joinCPUPipelineCol[sg][i];
+		if (positionalJoin(fkey_pkey[column])) continue;
+		size_t ht_size = (size_t) htCPULen(fkey_pkey[column]) * sizeof(int);
+		if (ht_size > max_size) {
+			radix_column = column;
+			max_size = ht_size;
+		}
+	}
+	return radix_column;
+}
+
+//rows and segments of a column for the running query, lineorder is cut at the watermark loaded by parseQuery
+int
+QueryOptimizer::columnLen(ColumnInfo* column) {
+	return (column->table_id == 0) ? lo_len : column->LEN;
+}
+
+int
+QueryOptimizer::totalSegment(ColumnInfo* column) {
+	return (column->table_id == 0) ? lo_total_segment : column->total_segment;
+}
+
+//the migration thread flips the residency of a segment at any time, a query plans and reads the cache tier
+//through one snapshot of the slot list taken after CacheManager::enterQuery, so the slots it sees stay valid
+void
+QueryOptimizer::snapshotResidency() {
+	for (int i = 0; i < cm->TOT_COLUMN; i++) {
+		int total_segment = totalSegment(cm->allColumn[i]);
+		seg_cached[i] = 0;
+		for (int j = 0; j < total_segment; j++) {
+			seg_list[i][j] = __atomic_load_n(&(cm->segment_list[i][j]), __ATOMIC_ACQUIRE);
+			if (seg_list[i][j] != -1) seg_cached[i]++;
+		}
+	}
+}
+
+int*
+QueryOptimizer::segmentList(ColumnInfo* column) {
+	return seg_list[column->column_id];
+}
+
+int
+QueryOptimizer::cachedSegments(ColumnInfo* column) {
+	return seg_cached[column->column_id];
+}
+
+//CPU joins with a dense dimension key skip the hash table: the build only marks the qualifying rows in a bitmap
+//and the probe reads bit key - dense_base (and the group column at that row). The GPU keeps its hash tables.
+bool
+QueryOptimizer::positionalJoin(ColumnInfo* pkey) {
+	return positional_join && pkey->dense;
+}
+
+//ints of the CPU hash table of pkey: (value, row + 1) per slot, or one bit per row for a positional join
+int
+QueryOptimizer::htCPULen(ColumnInfo* pkey) {
+	if (positionalJoin(pkey)) return (pkey->LEN + 31) / 32;
+	return 2 * params->dim_len[pkey];
+}
+
 bool
 QueryOptimizer::checkPredicate(int table_id, int segment_idx) {
 	assert(table_id <= cm->TOT_TABLE);
@@ -1454,11 +1643,24 @@ QueryOptimizer::checkPredicate(int table_id, int segment_idx) {
 			}
 		}
 	}
+
+	//a lineorder segment without a row that passes a dimension predicate joins nothing
+	if (table_id == 0) {
+		map<ColumnInfo*, int>::iterator it;
+		for (it = params->compare1.begin(); it != params->compare1.end(); it++) {
+			int column = it->first->column_id;
+			if (cm->lo_segment_min[column] == NULL) continue;
+			if (params->compare2[it->first] < cm->lo_segment_min[column][segment_idx] || it->second > cm->lo_segment_max[column][segment_idx]) {
+				return false;
+			}
+		}
+	}
 	return true;
 }
 
 void
 QueryOptimizer::updateSegmentStats(int table_id, int segment_idx, int query) {
+	unique_lock<mutex> stats(cm->stats_lock);
  	for (int i = 0; i < queryColumn[table_id].size(); i++) {
 	    int column = queryColumn[table_id][i]->column_id;
 	    Segment* segment = cm->index_to_segment[column][segment_idx];
@@ -1469,8 +1671,11 @@ QueryOptimizer::updateSegmentStats(int table_id, int segment_idx, int query) {
 void
 QueryOptimizer::groupBitmapSegmentTable(int table_id, int query, bool isprofile) {
 
-	int LEN = cm->allColumn[cm->columns_in_table[table_id][0]]->LEN;
-	int total_segment = cm->allColumn[cm->columns_in_table[table_id][0]]->total_segment;
+	int LEN = columnLen(cm->allColumn[cm->columns_in_table[table_id][0]]);
+	int total_segment = totalSegment(cm->allColumn[cm->columns_in_table[table_id][0]]);
+
+	//LEN changes with appendLineorder, a previous query may have left a partial last segment behind
+	last_segment[table_id] = -1;
 
 	for (int i = 0; i < total_segment; i++) {
 		unsigned short temp = 0;
@@ -1480,7 +1685,8 @@ QueryOptimizer::groupBitmapSegmentTable(int table_id, int query, bool isprofile)
 			temp = temp << op->columns.size();
 			for (int k = 0; k < op->columns.size(); k++) {
 				ColumnInfo* column = op->columns[k];
-				bool isGPU = cm->segment_bitmap[column->column_id][i];
+				//segments are grouped by their residency in the fast tier (GPU or host cache tier)
+				bool isGPU = segmentList(column)[i] != -1;
 				temp = temp | (isGPU << k);
 			}
 		}
@@ -1665,9 +1871,15 @@ QueryOptimizer::groupBitmapSegmentTable(int table_id, int query, bool isprofile)
 void
 QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
-	params = new QueryParams(query);
+	//the previous query has released its arenas in endQuery
+	delete params;
+	params = new QueryParams(query, cm->cpu_pool, cm->pinned_pool, cm->gpu_pool);
+
+	if (specs.find(query) != specs.end()) {
+
+		prepareQuerySpec(specs[query]);
 
-	if (query == 11 || query == 12 || query == 13) {
+	} else if (query == 11 || query == 12 || query == 13) {
 
 		if (query == 11) {
 			params->selectivity[cm->d_year] = 1;
@@ -1842,15 +2054,15 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 			params->ht_CPU[cm->p_partkey] = NULL;
 			params->ht_CPU[cm->c_custkey] = NULL;
 			params->ht_CPU[cm->s_suppkey] = NULL;
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);	
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->d_datekey));	
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], htCPULen(cm->d_datekey) * sizeof(int), cudaHostAllocDefault));
 		}
 
 		if (custom) {
 			params->ht_GPU[cm->p_partkey] = NULL;
 			params->ht_GPU[cm->s_suppkey] = NULL;
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->d_datekey]);
 			params->ht_GPU[cm->c_custkey] = NULL;
 		} else {
 			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));			
@@ -1860,7 +2072,7 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 	  cudaEventElapsedTime(&time, start, stop);
 	  cgp->malloc_time_total += time;		
 
-	  memset(params->ht_CPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int));
+	  memset(params->ht_CPU[cm->d_datekey], 0, htCPULen(cm->d_datekey) * sizeof(int));
 		CubDebugExit(cudaMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
 
 
@@ -2037,20 +2249,20 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 		cudaEventRecord(start, 0);
 
 		if (custom) {
-			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->p_partkey]);
+			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->p_partkey));
 			params->ht_CPU[cm->c_custkey] = NULL;
-			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);			
+			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->s_suppkey));
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->d_datekey));			
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));	
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->p_partkey], htCPULen(cm->p_partkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], htCPULen(cm->s_suppkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], htCPULen(cm->d_datekey) * sizeof(int), cudaHostAllocDefault));	
 		}
 
 		if (custom) {
-			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->p_partkey]);
-			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
+			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->p_partkey]);
+			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->s_suppkey]);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->d_datekey]);
 			params->ht_GPU[cm->c_custkey] = NULL;			
 		} else {
 			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
@@ -2064,9 +2276,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 	  cgp->malloc_time_total += time;
 	  // cout << "malloc time: " << cgp->malloc_time_total << endl;
 
-		memset(params->ht_CPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int));
-		memset(params->ht_CPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int));
-		memset(params->ht_CPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int));	
+		memset(params->ht_CPU[cm->d_datekey], 0, htCPULen(cm->d_datekey) * sizeof(int));
+		memset(params->ht_CPU[cm->p_partkey], 0, htCPULen(cm->p_partkey) * sizeof(int));
+		memset(params->ht_CPU[cm->s_suppkey], 0, htCPULen(cm->s_suppkey) * sizeof(int));	
 
 		CubDebugExit(cudaMemset(params->ht_GPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
 		CubDebugExit(cudaMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
@@ -2347,20 +2559,20 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 		if (custom) {
 			params->ht_CPU[cm->p_partkey] = NULL;
-			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->c_custkey]);
-			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);			
+			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->c_custkey));
+			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->s_suppkey));
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->d_datekey));			
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));			
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->c_custkey], htCPULen(cm->c_custkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], htCPULen(cm->s_suppkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], htCPULen(cm->d_datekey) * sizeof(int), cudaHostAllocDefault));			
 		}
 
 		if (custom) {
 			params->ht_GPU[cm->p_partkey] = NULL;
-			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
-			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->c_custkey]);			
+			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->s_suppkey]);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->d_datekey]);
+			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->c_custkey]);			
 		} else {
 			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
 			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
@@ -2371,9 +2583,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 		cudaEventElapsedTime(&time, start, stop);
 		cgp->malloc_time_total += time;		
 
-		memset(params->ht_CPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int));
-		memset(params->ht_CPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int));
-		memset(params->ht_CPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int));
+		memset(params->ht_CPU[cm->d_datekey], 0, htCPULen(cm->d_datekey) * sizeof(int));
+		memset(params->ht_CPU[cm->s_suppkey], 0, htCPULen(cm->s_suppkey) * sizeof(int));
+		memset(params->ht_CPU[cm->c_custkey], 0, htCPULen(cm->c_custkey) * sizeof(int));
 
 		CubDebugExit(cudaMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
 		CubDebugExit(cudaMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
@@ -2605,22 +2817,22 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 		SETUP_TIMING();
 		cudaEventRecord(start, 0);
 		if (custom) {
-			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->p_partkey]);
-			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->c_custkey]);
-			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);			
+			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->p_partkey));
+			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->c_custkey));
+			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->s_suppkey));
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(cm->d_datekey));			
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));				
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->p_partkey], htCPULen(cm->p_partkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->c_custkey], htCPULen(cm->c_custkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], htCPULen(cm->s_suppkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], htCPULen(cm->d_datekey) * sizeof(int), cudaHostAllocDefault));				
 		}
 
 		if (custom) {
-			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->p_partkey]);
-			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
-			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->c_custkey]);			
+			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->p_partkey]);
+			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->s_suppkey]);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->d_datekey]);
+			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[cm->c_custkey]);			
 		} else {
 			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
 			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
@@ -2632,10 +2844,10 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 		cudaEventElapsedTime(&time, start, stop);
 		cgp->malloc_time_total += time;	
 
-		memset(params->ht_CPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int));
-		memset(params->ht_CPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int));
-		memset(params->ht_CPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int));
-		memset(params->ht_CPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int));
+		memset(params->ht_CPU[cm->d_datekey], 0, htCPULen(cm->d_datekey) * sizeof(int));
+		memset(params->ht_CPU[cm->p_partkey], 0, htCPULen(cm->p_partkey) * sizeof(int));
+		memset(params->ht_CPU[cm->s_suppkey], 0, htCPULen(cm->s_suppkey) * sizeof(int));
+		memset(params->ht_CPU[cm->c_custkey], 0, htCPULen(cm->c_custkey) * sizeof(int));
 
 		CubDebugExit(cudaMemset(params->ht_GPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
 		CubDebugExit(cudaMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
@@ -2665,14 +2877,20 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 	params->min_val[cm->s_suppkey] = 0;
 	params->min_val[cm->d_datekey] = 1992;
 
+	if (specs.find(query) != specs.end()) {
+		QuerySpec* spec = specs[query];
+		for (int i = 0; i < spec->group.size(); i++)
+			params->min_val[cm->allColumn[cm->columns_in_table[spec->group[i]->table_id][0]]] = spec->group_min[i];
+	}
+
 	int res_array_size = params->total_val * 6;
 
 	float time;
 	SETUP_TIMING();
 	cudaEventRecord(start, 0);
-	if (custom) params->res = (int*) cm->customCudaHostAlloc<int>(res_array_size);
+	if (custom) params->res = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, res_array_size);
 	else CubDebugExit(cudaHostAlloc((void**) &params->res, res_array_size * sizeof(int), cudaHostAllocDefault));
-	if (custom) params->d_res = (int*) cm->customCudaMalloc<int>(res_array_size);
+	if (custom) params->d_res = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, res_array_size);
 	else CubDebugExit(cudaMalloc((void**) &params->d_res, res_array_size * sizeof(int)));
 	cudaEventRecord(stop, 0);
 	cudaEventSynchronize(stop);
@@ -2685,6 +2903,107 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 };
 
+//the parameters of a prepareQuery branch from a spec; the predicates are fixed, so the distribution does not apply
+void
+QueryOptimizer::prepareQuerySpec(QuerySpec* spec) {
+
+	ColumnInfo* pkeys[4] = {cm->s_suppkey, cm->c_custkey, cm->p_partkey, cm->d_datekey};
+
+	params->dim_len[cm->p_partkey] = spec->joins(3) ? P_LEN : 0;
+	params->dim_len[cm->c_custkey] = spec->joins(2) ? C_LEN : 0;
+	params->dim_len[cm->s_suppkey] = spec->joins(1) ? S_LEN : 0;
+	params->dim_len[cm->d_datekey] = spec->joins(4) ? 19981230 - 19920101 + 1 : 0;
+
+	//lineorder segments are skipped on the keys of the dimension rows that pass
+	params->compare1[cm->lo_orderdate] = 19920101;
+	params->compare2[cm->lo_orderdate] = 19981231;
+
+	for (int i = 0; i < spec->tables.size(); i++) {
+		ColumnInfo* fkey = pkey_fkey[pkeys[spec->tables[i] - 1]];
+		params->selectivity[fkey] = 1;
+		params->real_selectivity[fkey] = 1;
+
+		SpecPredicate* predicate = spec->predicateOn(spec->tables[i]);
+		if (predicate == NULL) continue;
+		params->selectivity[fkey] = min(1.0, predicate->selectivity * 1.5);
+		params->real_selectivity[fkey] = predicate->selectivity;
+		if (predicate->key_min <= predicate->key_max) {
+			params->compare1[fkey] = predicate->key_min;
+			params->compare2[fkey] = predicate->key_max;
+		} else {
+			params->compare1[fkey] = INT_MIN;
+			params->compare2[fkey] = INT_MIN;
+		}
+	}
+
+	for (int i = 0; i < spec->predicates.size(); i++) {
+		SpecPredicate& predicate = spec->predicates[i];
+		ColumnInfo* column = predicate.column;
+
+		params->selectivity[column] = min(1.0, predicate.selectivity * 1.5);
+		params->real_selectivity[column] = predicate.selectivity;
+
+		params->compare1[column] = predicate.compare1;
+		params->compare2[column] = predicate.compare2;
+		params->mode[column] = predicate.mode;
+
+		if (predicate.mode == 2) {
+			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[column]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			params->map_filter_func_host[column] = &host_pred_eq_or_eq;
+		} else if (predicate.eq) {
+			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[column]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			params->map_filter_func_host[column] = &host_pred_eq;
+		} else {
+			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[column]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			params->map_filter_func_host[column] = &host_pred_between;
+		}
+	}
+
+	for (int i = 0; i < 4; i++) params->unique_val[pkeys[i]] = 0;
+	for (int i = 0; i < spec->group.size(); i++) {
+		params->selectivity[spec->group[i]] = 1;
+		params->real_selectivity[spec->group[i]] = 1;
+		params->unique_val[pkeys[spec->group[i]->table_id - 1]] = spec->unique_val[i];
+	}
+	params->total_val = spec->total_val;
+
+	if (spec->aggr_op == '*') {
+		CubDebugExit(cudaMemcpyFromSymbol(&(params->d_group_func), p_mul_func<int>, sizeof(group_func_t<int>)));
+		params->h_group_func = &host_mul_func;
+	} else {
+		CubDebugExit(cudaMemcpyFromSymbol(&(params->d_group_func), p_sub_func<int>, sizeof(group_func_t<int>)));
+		params->h_group_func = &host_sub_func;
+	}
+
+	float time;
+	SETUP_TIMING();
+	cudaEventRecord(start, 0);
+	for (int i = 0; i < 4; i++) {
+		ColumnInfo* pkey = pkeys[i];
+		if (params->dim_len[pkey] == 0) {
+			params->ht_CPU[pkey] = NULL;
+			params->ht_GPU[pkey] = NULL;
+		} else if (custom) {
+			params->ht_CPU[pkey] = (int*) cm->customMalloc<int>(&params->cpu_arena, htCPULen(pkey));
+			params->ht_GPU[pkey] = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 2 * params->dim_len[pkey]);
+		} else {
+			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[pkey], htCPULen(pkey) * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[pkey], 2 * params->dim_len[pkey] * sizeof(int)));
+		}
+	}
+	cudaEventRecord(stop, 0);
+	cudaEventSynchronize(stop);
+	cudaEventElapsedTime(&time, start, stop);
+	cgp->malloc_time_total += time;
+
+	for (int i = 0; i < 4; i++) {
+		ColumnInfo* pkey = pkeys[i];
+		if (params->dim_len[pkey] == 0) continue;
+		memset(params->ht_CPU[pkey], 0, htCPULen(pkey) * sizeof(int));
+		CubDebugExit(cudaMemset(params->ht_GPU[pkey], 0, 2 * params->dim_len[pkey] * sizeof(int)));
+	}
+}
+
 void
 QueryOptimizer::clearPrepare() {
 
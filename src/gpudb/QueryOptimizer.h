@@ -3,11 +3,12 @@
 
 #include "CacheManager.h"
 #include "KernelArgs.h"
+#include "QuerySpec.h"
 #include "common.h"
 
 #define NUM_QUERIES 13
-// #define MAX_GROUPS 128
-#define MAX_GROUPS 229
+#define RADIX_PROBE_THRESHOLD (32 << 20) //CPU hash tables above this size (about the last-level cache) are probed radix-partitioned
+#define POSITIONAL_JOIN 1 //CPU joins with dense dimension keys index the dimension by key instead of building a hash table
 
 class CPUGPUProcessing;
 
@@ -265,8 +266,13 @@ public:
 class QueryOptimizer {
 public:
 	CacheManager* cm;
+	bool own_cm; //false if the cache is shared with the optimizers of other clients
 	CPUGPUProcessing* cgp;
 
+	int lo_len, lo_total_segment; //lineorder as seen by the running query, from CacheManager::lo_watermark at parseQuery
+	int** seg_list; //slot of every segment in the cache tier as seen by the running query (snapshotResidency), pinned
+	int* seg_cached; //cached segments of every column in seg_list
+
 	vector<ColumnInfo*> querySelectColumn;
 	vector<ColumnInfo*> queryBuildColumn;
 	vector<ColumnInfo*> queryProbeColumn;
@@ -313,15 +319,19 @@ public:
 	double** speedup_segment;
 	map<int, Zipfian*> zipfian;
 	map<int, Normal*> normal;
+	map<int, QuerySpec*> specs; //star-join queries added at runtime, from SPEC_QUERY_BASE on
 	QueryParams* params;
 
 	bool custom;
 	bool skipping;
+	size_t radix_probe_threshold; //0 disables the radix-partitioned probe
+	bool positional_join;
 
 	int processed_segment;
 	int skipped_segment;
 
 	QueryOptimizer(size_t _cache_size, size_t _processing_size, size_t _pinned_memsize, CPUGPUProcessing* _cgp);
+	QueryOptimizer(CacheManager* _cm, CPUGPUProcessing* _cgp);
 	~QueryOptimizer();
 
 	void setDistributionZipfian(double alpha);
@@ -342,7 +352,11 @@ public:
 	void parseQuery42();
 	void parseQuery43();
 
+	int addQuerySpec(string text);
+	void parseQuerySpec(QuerySpec* spec);
+
 	void prepareQuery(int query, Distribution dist = None);
+	void prepareQuerySpec(QuerySpec* spec);
 
 	void clearParsing();
 	void clearPlacement();
@@ -350,10 +364,21 @@ public:
 
 	void dataDrivenOperatorPlacement(int query, bool isprofile = 0);
 	void prepareOperatorPlacement();
+	void snapshotResidency();
 	void groupBitmap(bool isprofile = 0);
 	void groupBitmapSegment(int query, bool isprofile = 0);
 	void groupBitmapSegmentTable(int table_id, int query, bool isprofile = 0);
 
+	ColumnInfo* radixProbeColumn(int sg);
+
+	int columnLen(ColumnInfo* column);
+	int totalSegment(ColumnInfo* column);
+	int* segmentList(ColumnInfo* column);
+	int cachedSegments(ColumnInfo* column);
+
+	bool positionalJoin(ColumnInfo* pkey);
+	int htCPULen(ColumnInfo* pkey);
+
 	bool checkPredicate(int table_id, int segment_idx);
 	void updateSegmentStats(int table_id, int segment_idx, int query);
 
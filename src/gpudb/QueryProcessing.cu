@@ -8,14 +8,15 @@ int queries[13] = {11, 12, 13, 21, 22, 23, 31, 32, 33, 34, 41, 42, 43};
 
 void
 QueryProcessing::executeTableDim(int table_id, int sg) {
+    TRACE_SCOPE("executeTableDim", sg);
     int *h_off_col = NULL, *d_off_col = NULL;
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, 1);
     else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 1);
     else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
 
     if (sg == 0 || sg == 1) {
@@ -51,14 +52,15 @@ QueryProcessing::executeTableDim(int table_id, int sg) {
 
 void
 QueryProcessing::executeTableFact_v1(int sg) {
+    TRACE_SCOPE("executeTableFact_v1", sg);
     int** h_off_col = NULL, **off_col = NULL;
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, 1);
     else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 1);
     else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
 
     // printf("fact sg = %d\n", sg);
@@ -290,14 +292,15 @@ QueryProcessing::executeTableFact_v1(int sg) {
 
 void
 QueryProcessing::executeTableFact_v2(int sg) {
+    TRACE_SCOPE("executeTableFact_v2", sg);
     int** h_off_col = NULL, **off_col = NULL;
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, 1);
     else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(&params->gpu_arena, 1);
     else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
 
     if (verbose) printf("sg = %d\n", sg);
@@ -568,31 +571,39 @@ QueryProcessing::runQuery() {
   if (verbose) cout << "Build time " << time << endl;
   cgp->execution_total += time;
 
+  replicateHashTable();
+
   cudaEventRecord(start, 0);
 
   parallel_for(short(0), qo->par_segment_count[0], [=](short i){
 
     int sg = qo->par_segment[0][i];
+    int node = cm->numa->majorityNode(qo->segment_group[0] + sg * qo->lo_total_segment, qo->segment_group_count[0][sg]);
 
-    CubDebugExit(cudaStreamCreate(&streams[sg]));
+    //run the segment group on the node that owns most of its segments
+    cm->numa->execute(node, [&] {
 
-    float time_;
-    cudaEvent_t start_, stop_; 
-    cudaEventCreate(&start_); cudaEventCreate(&stop_);
-    cudaEventRecord(start_, 0);
+      CubDebugExit(cudaStreamCreate(&streams[sg]));
 
-    if (qo->segment_group_count[0][sg] > 0) {
-      executeTableFact_v1(sg);
-    }
+      float time_;
+      cudaEvent_t start_, stop_; 
+      cudaEventCreate(&start_); cudaEventCreate(&stop_);
+      cudaEventRecord(start_, 0);
+
+      if (qo->segment_group_count[0][sg] > 0) {
+        executeTableFact_v1(sg);
+      }
+
+      cudaEventRecord(stop_, 0);
+      cudaEventSynchronize(stop_);
+      cudaEventElapsedTime(&time_, start_, stop_);
 
-    cudaEventRecord(stop_, 0);
-    cudaEventSynchronize(stop_);
-    cudaEventElapsedTime(&time_, start_, stop_);
+      if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
 
-    if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
+      CubDebugExit(cudaStreamSynchronize(streams[sg]));
+      CubDebugExit(cudaStreamDestroy(streams[sg]));
 
-    CubDebugExit(cudaStreamSynchronize(streams[sg]));
-    CubDebugExit(cudaStreamDestroy(streams[sg]));
+    });
 
   });
 
@@ -607,7 +618,7 @@ QueryProcessing::runQuery() {
   cudaEventRecord(start, 0);
 
   int* resGPU;
-  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6);
+  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, params->total_val * 6);
   else CubDebugExit(cudaHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
   CubDebugExit(cudaMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
   cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
@@ -619,7 +630,10 @@ QueryProcessing::runQuery() {
 
   cudaEventRecord(start, 0);
 
-  merge(params->res, resGPU, params->total_val);
+  {
+    TRACE_SCOPE("merge", -1);
+    merge(params->res, resGPU, params->total_val);
+  }
 
   cudaEventRecord(stop, 0);
   cudaEventSynchronize(stop);
@@ -669,30 +683,38 @@ QueryProcessing::runQuery2() {
   if (verbose) cout << "Build time " << time << endl;
   cgp->execution_total += time;
 
+  replicateHashTable();
+
   cudaEventRecord(start, 0);
 
   parallel_for(short(0), qo->par_segment_count[0], [=](short i){
     int sg = qo->par_segment[0][i];
+    int node = cm->numa->majorityNode(qo->segment_group[0] + sg * qo->lo_total_segment, qo->segment_group_count[0][sg]);
 
-    CubDebugExit(cudaStreamCreate(&streams[sg]));
+    //run the segment group on the node that owns most of its segments
+    cm->numa->execute(node, [&] {
 
-    float time_;
-    cudaEvent_t start_, stop_; 
-    cudaEventCreate(&start_); cudaEventCreate(&stop_);
-    cudaEventRecord(start_, 0);
+      CubDebugExit(cudaStreamCreate(&streams[sg]));
 
-    if (qo->segment_group_count[0][sg] > 0) {
-      executeTableFact_v2(sg);
-    }
+      float time_;
+      cudaEvent_t start_, stop_; 
+      cudaEventCreate(&start_); cudaEventCreate(&stop_);
+      cudaEventRecord(start_, 0);
+
+      if (qo->segment_group_count[0][sg] > 0) {
+        executeTableFact_v2(sg);
+      }
 
-    cudaEventRecord(stop_, 0);
-    cudaEventSynchronize(stop_);
-    cudaEventElapsedTime(&time_, start_, stop_);
+      cudaEventRecord(stop_, 0);
+      cudaEventSynchronize(stop_);
+      cudaEventElapsedTime(&time_, start_, stop_);
 
-    if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
+      if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
 
-    CubDebugExit(cudaStreamSynchronize(streams[sg]));
-    CubDebugExit(cudaStreamDestroy(streams[sg]));
+      CubDebugExit(cudaStreamSynchronize(streams[sg]));
+      CubDebugExit(cudaStreamDestroy(streams[sg]));
+
+    });
 
   });
 
@@ -707,7 +729,7 @@ QueryProcessing::runQuery2() {
   cudaEventRecord(start, 0);
 
   int* resGPU;
-  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6);
+  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(&params->pinned_arena, params->total_val * 6);
   else CubDebugExit(cudaHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
   CubDebugExit(cudaMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
   cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
@@ -719,7 +741,10 @@ QueryProcessing::runQuery2() {
 
   cudaEventRecord(start, 0);
 
-  merge(params->res, resGPU, params->total_val);
+  {
+    TRACE_SCOPE("merge", -1);
+    merge(params->res, resGPU, params->total_val);
+  }
 
   cudaEventRecord(stop, 0);
   cudaEventSynchronize(stop);
@@ -884,9 +909,14 @@ QueryProcessing::profile() {
 double
 QueryProcessing::processQuery(bool printall) {
 
+  TRACE_SCOPE("query", query);
+
   SETUP_TIMING();
   float time;
 
+  //slots evicted while the query runs are not reused before it ends, it reads the residency snapshot of its placement
+  unsigned long long epoch = cgp->cm->enterQuery();
+
   cudaEventRecord(start, 0);
 
   qo->parseQuery(query);
@@ -954,9 +984,12 @@ QueryProcessing::processQuery(bool printall) {
 
   updateStatsQuery();
 
+  if (keep_result) collectResult();
+
   qo->clearPlacement();
   endQuery();
   qo->clearParsing();
+  cgp->cm->exitQuery(epoch);
 
   return cgp->execution_total + cgp->merging_total + cgp->optimization_total;
 
@@ -965,10 +998,15 @@ QueryProcessing::processQuery(bool printall) {
 double
 QueryProcessing::processQuery2() {
 
+  TRACE_SCOPE("query", query);
+
   // cudaEvent_t start, stop;   // variables that holds 2 events 
   SETUP_TIMING();
   float time;
 
+  //slots evicted while the query runs are not reused before it ends, it reads the residency snapshot of its placement
+  unsigned long long epoch = cgp->cm->enterQuery();
+
   cudaEventRecord(start, 0);
 
   qo->parseQuery(query);
@@ -1035,9 +1073,12 @@ QueryProcessing::processQuery2() {
 
   // updateStatsQuery();
 
+  if (keep_result) collectResult();
+
   qo->clearPlacement();
   endQuery();
   qo->clearParsing();
+  cgp->cm->exitQuery(epoch);
 
   return cgp->execution_total + cgp->merging_total + cgp->optimization_total;
 
@@ -1100,14 +1141,26 @@ QueryProcessing::percentageData() {
 
 }
 
+void
+QueryProcessing::collectResult() {
+  last_result.clear();
+  for (int i = 0; i < params->total_val; i++) {
+    long long aggr = reinterpret_cast<long long*>(&params->res[6*i+4])[0];
+    if (aggr == 0) continue;
+    last_result.push_back({params->res[6*i], params->res[6*i+1], params->res[6*i+2], params->res[6*i+3], aggr});
+  }
+}
+
 void
 QueryProcessing::endQuery() {
 
+  releaseHashTableReplica();
+
   qo->clearPrepare();
 
   // qo->clearVector();
 
-  cm->resetPointer();
+  params->releaseArenas();
 
   cgp->resetCGP();
 
@@ -1115,11 +1168,44 @@ QueryProcessing::endQuery() {
 
 }
 
+//copy the small CPU hash tables to every NUMA node once the build phase is done
+void
+QueryProcessing::replicateHashTable() {
+  if (cm->numa->num_node == 1) return;
+
+  map<ColumnInfo*, int*>::iterator it;
+  for (it = params->ht_CPU.begin(); it != params->ht_CPU.end(); ++it) {
+    size_t bytes = qo->htCPULen(it->first) * sizeof(int);
+    if (it->second == NULL || bytes > NUMA_REPLICATE_SIZE) continue;
+
+    vector<int*>& replica = params->ht_CPU_node[it->first];
+    replica.resize(cm->numa->num_node);
+    for (int node = 0; node < cm->numa->num_node; node++) {
+      replica[node] = (int*) cm->numa->allocate(bytes, NumaLocal, node);
+      memcpy(replica[node], it->second, bytes);
+    }
+  }
+}
+
+void
+QueryProcessing::releaseHashTableReplica() {
+  map<ColumnInfo*, vector<int*>>::iterator it;
+  for (it = params->ht_CPU_node.begin(); it != params->ht_CPU_node.end(); ++it) {
+    for (int node = 0; node < it->second.size(); node++) {
+      cm->numa->release(it->second[node]);
+    }
+  }
+  params->ht_CPU_node.clear();
+}
+
 void
 QueryProcessing::updateStatsQuery() {
   chrono::high_resolution_clock::time_point cur_time = chrono::high_resolution_clock::now();
   chrono::duration<double> timestamp = cur_time - cgp->begin_time;
 
+  //the statistics are shared with the queries of the other clients
+  unique_lock<mutex> stats(cm->stats_lock);
+
   double time_count = logical_time;
   logical_time += 20;
 
@@ -1127,7 +1213,7 @@ QueryProcessing::updateStatsQuery() {
     for (int col = 0; col < qo->select_build[qo->join[i].second].size(); col++) {  
       cm->updateColumnTimestamp(qo->select_build[qo->join[i].second][col], time_count++);
       ColumnInfo* column = qo->select_build[qo->join[i].second][col];
-      for (int seg_id = 0; seg_id < column->total_segment; seg_id++) {
+      for (int seg_id = 0; seg_id < qo->totalSegment(column); seg_id++) {
         Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
         cm->updateSegmentTimeDirect(column, segment, time_count);
         cm->updateSegmentFreqDirect(column, segment);
@@ -1135,7 +1221,7 @@ QueryProcessing::updateStatsQuery() {
     }
     cm->updateColumnTimestamp(qo->join[i].second, time_count++);
     ColumnInfo* column = qo->join[i].second;
-    for (int seg_id = 0; seg_id < column->total_segment; seg_id++) {
+    for (int seg_id = 0; seg_id < qo->totalSegment(column); seg_id++) {
       Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
       cm->updateSegmentTimeDirect(column, segment, time_count);
       cm->updateSegmentFreqDirect(column, segment);
@@ -1152,7 +1238,7 @@ QueryProcessing::updateStatsQuery() {
         ColumnInfo* column = qo->selectCPUPipelineCol[sg][col];
         cm->updateColumnTimestamp(column, par_time_count++);
         for (int seg = 0; seg < qo->segment_group_count[column->table_id][sg]; seg++) {
-          int seg_id = qo->segment_group[column->table_id][sg * column->total_segment + seg];
+          int seg_id = qo->segment_group[column->table_id][sg * qo->totalSegment(column) + seg];
           Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
           cm->updateSegmentTimeDirect(column, segment, par_time_count);
           cm->updateSegmentFreqDirect(column, segment);
@@ -1162,7 +1248,7 @@ QueryProcessing::updateStatsQuery() {
         ColumnInfo* column = qo->selectGPUPipelineCol[sg][col];
         cm->updateColumnTimestamp(column, par_time_count++);
         for (int seg = 0; seg < qo->segment_group_count[column->table_id][sg]; seg++) {
-          int seg_id = qo->segment_group[column->table_id][sg * column->total_segment + seg];
+          int seg_id = qo->segment_group[column->table_id][sg * qo->totalSegment(column) + seg];
           Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
           cm->updateSegmentTimeDirect(column, segment, par_time_count);
           cm->updateSegmentFreqDirect(column, segment);
@@ -1172,7 +1258,7 @@ QueryProcessing::updateStatsQuery() {
         ColumnInfo* column = qo->joinGPUPipelineCol[sg][col];
         cm->updateColumnTimestamp(column, par_time_count++);
         for (int seg = 0; seg < qo->segment_group_count[column->table_id][sg]; seg++) {
-          int seg_id = qo->segment_group[column->table_id][sg * column->total_segment + seg];
+          int seg_id = qo->segment_group[column->table_id][sg * qo->totalSegment(column) + seg];
           Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
           cm->updateSegmentTimeDirect(column, segment, par_time_count);
           cm->updateSegmentFreqDirect(column, segment);
@@ -1182,7 +1268,7 @@ QueryProcessing::updateStatsQuery() {
         ColumnInfo* column = qo->joinCPUPipelineCol[sg][col];
         cm->updateColumnTimestamp(column, par_time_count++);
         for (int seg = 0; seg < qo->segment_group_count[column->table_id][sg]; seg++) {
-          int seg_id = qo->segment_group[column->table_id][sg * column->total_segment + seg];
+          int seg_id = qo->segment_group[column->table_id][sg * qo->totalSegment(column) + seg];
           Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
           cm->updateSegmentTimeDirect(column, segment, par_time_count);
           cm->updateSegmentFreqDirect(column, segment);
@@ -1192,7 +1278,7 @@ QueryProcessing::updateStatsQuery() {
         ColumnInfo* column = qo->queryGroupByColumn[col];
         cm->updateColumnTimestamp(column, par_time_count++);
         for (int seg = 0; seg < qo->segment_group_count[column->table_id][sg]; seg++) {
-          int seg_id = qo->segment_group[column->table_id][sg * column->total_segment + seg];
+          int seg_id = qo->segment_group[column->table_id][sg * qo->totalSegment(column) + seg];
           Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
           cm->updateSegmentTimeDirect(column, segment, par_time_count);
           cm->updateSegmentFreqDirect(column, segment);
@@ -1202,7 +1288,7 @@ QueryProcessing::updateStatsQuery() {
         ColumnInfo* column = qo->queryAggrColumn[col];
         cm->updateColumnTimestamp(column, par_time_count++);
         for (int seg = 0; seg < qo->segment_group_count[column->table_id][sg]; seg++) {
-          int seg_id = qo->segment_group[column->table_id][sg * column->total_segment + seg];
+          int seg_id = qo->segment_group[column->table_id][sg * qo->totalSegment(column) + seg];
           Segment* segment = qo->cm->index_to_segment[column->column_id][seg_id];
           cm->updateSegmentTimeDirect(column, segment, par_time_count);
           cm->updateSegmentFreqDirect(column, segment);
@@ -1241,6 +1327,8 @@ QueryProcessing::updateStatsQuery() {
     cm->updateColumnFrequency(column);
     cm->updateColumnWeightDirect(column, qo->speedup[query][column]);
   }
+
+  cm->advanceClock();
 }
 
 void
@@ -1340,7 +1428,7 @@ QueryProcessing::dumpTrace(string filename) {
 
 void
 QueryProcessing::countTouchedSegment(int table_id, int* t_segment, int* t_c_segment) {
-  int total_segment = cm->allColumn[cm->columns_in_table[table_id][0]]->total_segment;
+  int total_segment = qo->totalSegment(cm->allColumn[cm->columns_in_table[table_id][0]]);
   for (int i = 0; i < total_segment; i++) {
     if (qo->checkPredicate(table_id, i)) {
       for (int j = 0; j < qo->queryColumn[table_id].size(); j++) {
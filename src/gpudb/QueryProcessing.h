@@ -21,11 +21,14 @@ public:
   bool custom;
   bool skipping;
 
-  double logical_time;
+  double& logical_time; //clock of the shared statistics (CacheManager::logical_time)
+
+  bool keep_result; //copy the groups of every query into last_result before its memory is released
+  vector<vector<long long>> last_result; //group values followed by the aggregate, one entry per non-empty group
 
   Distribution dist;
 
-  QueryProcessing(CPUGPUProcessing* _cgp, bool _verbose, Distribution _dist = None) {
+  QueryProcessing(CPUGPUProcessing* _cgp, bool _verbose, Distribution _dist = None) : logical_time(_cgp->cm->logical_time) {
     cgp = _cgp;
     qo = cgp->qo;
     cm = cgp->cm;
@@ -34,7 +37,7 @@ public:
     dist = _dist;
     custom = cgp->custom;
     skipping = cgp->skipping;
-    logical_time = 0;
+    keep_result = false;
   }
 
   ~QueryProcessing() {
@@ -57,6 +60,12 @@ public:
 
   void endQuery();
 
+  void collectResult();
+
+  void replicateHashTable();
+
+  void releaseHashTableReplica();
+
   void updateStatsQuery();
 
   double processQuery(bool printall);
@@ -0,0 +1,267 @@
+#ifndef _QUERY_SPEC_H_
+#define _QUERY_SPEC_H_
+
+#include "CacheManager.h"
+#include "common.h"
+
+#define SPEC_MAX_GROUPS (1 << 24) //result slots of a query spec, 6 ints each
+#define SPEC_MAX_LO_COLUMNS 6 //columns of the lineorder filters, probes and aggregate, one bit each of the segment group (as SSB Q4)
+
+//A star-join query over lineorder given as text, instead of a parseQueryNN function and a prepareQuery branch:
+//
+//  sum(lo_revenue - lo_supplycost) by d_year, c_nation where c_region = 1 and s_region = 1 and p_mfgr in (0, 1)
+//
+//Every dimension that a predicate or a group column names is joined on its key. The query runs on the fused
+//kernels, so it has their shape:
+//  - sum(a) or sum(a - b) with group columns, sum(a * b) without, over lineorder columns
+//  - predicates col = v, col between v1 and v2, col in (v1, v2), joined by and
+//  - at most two predicates on lineorder, at most one predicate and one group column per dimension
+//  - at most SPEC_MAX_LO_COLUMNS lineorder columns over the predicates, the joins and the sum
+//Values are the integers of the columnar files (the dictionary codes for nation, region, mfgr, ...).
+
+struct SpecPredicate {
+	ColumnInfo* column;
+	int mode; //1: compare1 <= v <= compare2 (= is compare1 == compare2), 2: v == compare1 or v == compare2
+	int compare1, compare2;
+	bool eq;
+	double selectivity; //fraction of the rows that pass, measured when the spec is parsed
+	int key_min, key_max; //range of the keys of the dimension rows that pass (key_min > key_max if none)
+};
+
+class QuerySpec {
+public:
+	string text;
+	vector<ColumnInfo*> aggr;
+	char aggr_op; //'-', '*' or 0
+	vector<ColumnInfo*> group; //in table_id order
+	vector<int> group_min, unique_val;
+	int total_val;
+	vector<SpecPredicate> predicates;
+	vector<int> tables; //joined dimensions in table_id order
+	string error; //empty if the text is a valid query
+
+	vector<string> tokens;
+	int pos;
+
+	QuerySpec(CacheManager* cm, string _text) : text(_text), aggr_op(0), total_val(1), pos(0) {
+		tokenize();
+		if (parse(cm) && check()) measure(cm);
+	}
+
+	SpecPredicate* predicateOn(int table_id) {
+		for (int i = 0; i < predicates.size(); i++)
+			if (predicates[i].column->table_id == table_id) return &predicates[i];
+		return NULL;
+	}
+
+	ColumnInfo* groupOn(int table_id) {
+		for (int i = 0; i < group.size(); i++)
+			if (group[i]->table_id == table_id) return group[i];
+		return NULL;
+	}
+
+	bool joins(int table_id) {
+		return find(tables.begin(), tables.end(), table_id) != tables.end();
+	}
+
+	static bool pass(SpecPredicate& p, int v) {
+		if (p.mode == 2) return v == p.compare1 || v == p.compare2;
+		return v >= p.compare1 && v <= p.compare2;
+	}
+
+private:
+	//identifiers and numbers, every other character is a token of its own; keywords and columns are lower case
+	void tokenize() {
+		for (int i = 0; i < text.size();) {
+			if (isspace(text[i])) i++;
+			else if (isalnum(text[i]) || text[i] == '_') {
+				int j = i;
+				while (j < text.size() && (isalnum(text[j]) || text[j] == '_')) j++;
+				string token = text.substr(i, j - i);
+				transform(token.begin(), token.end(), token.begin(), ::tolower);
+				tokens.push_back(token);
+				i = j;
+			} else tokens.push_back(string(1, text[i++]));
+		}
+	}
+
+	bool fail(string message) {
+		if (error.empty()) error = message;
+		return false;
+	}
+
+	bool accept(string token) {
+		if (pos < tokens.size() && tokens[pos] == token) {
+			pos++;
+			return true;
+		}
+		return false;
+	}
+
+	bool expect(string token) {
+		if (accept(token)) return true;
+		return fail("expected '" + token + "'" + (pos < tokens.size() ? " at '" + tokens[pos] + "'" : " at the end"));
+	}
+
+	ColumnInfo* column(CacheManager* cm) {
+		if (pos < tokens.size()) {
+			for (int i = 0; i < cm->TOT_COLUMN; i++)
+				if (cm->allColumn[i]->column_name == tokens[pos]) {
+					pos++;
+					return cm->allColumn[i];
+				}
+		}
+		fail(pos < tokens.size() ? "unknown column '" + tokens[pos] + "'" : "expected a column at the end");
+		return NULL;
+	}
+
+	bool number(int& v) {
+		bool negative = accept("-");
+		if (pos < tokens.size() && isdigit(tokens[pos][0])) {
+			char* end;
+			long long value = strtoll(tokens[pos].c_str(), &end, 10);
+			if (*end == '\0' && value <= INT_MAX) {
+				v = negative ? -value : value;
+				pos++;
+				return true;
+			}
+		}
+		return fail(pos < tokens.size() ? "expected an integer at '" + tokens[pos] + "'" : "expected an integer at the end");
+	}
+
+	bool predicate(CacheManager* cm) {
+		SpecPredicate p = {NULL, 1, 0, 0, false, 1, 0, -1};
+		p.column = column(cm);
+		if (p.column == NULL) return false;
+		if (accept("=")) {
+			if (!number(p.compare1)) return false;
+			p.compare2 = p.compare1;
+			p.eq = true;
+		} else if (accept("between")) {
+			if (!number(p.compare1) || !expect("and") || !number(p.compare2)) return false;
+			if (p.compare1 > p.compare2) return fail("empty range on " + p.column->column_name);
+		} else if (accept("in")) {
+			if (!expect("(") || !number(p.compare1) || !expect(",") || !number(p.compare2) || !expect(")")) return false;
+			if (p.compare1 > p.compare2) swap(p.compare1, p.compare2);
+			if (p.compare1 == p.compare2) p.eq = true;
+			else p.mode = 2;
+		} else return fail("expected =, between or in after " + p.column->column_name);
+		predicates.push_back(p);
+		return true;
+	}
+
+	bool parse(CacheManager* cm) {
+		if (!expect("sum") || !expect("(")) return false;
+		ColumnInfo* a = column(cm);
+		if (a == NULL) return false;
+		aggr.push_back(a);
+		if (accept("-")) aggr_op = '-';
+		else if (accept("*")) aggr_op = '*';
+		if (aggr_op != 0) {
+			ColumnInfo* b = column(cm);
+			if (b == NULL) return false;
+			aggr.push_back(b);
+		}
+		if (!expect(")")) return false;
+
+		if (accept("by")) {
+			do {
+				ColumnInfo* g = column(cm);
+				if (g == NULL) return false;
+				group.push_back(g);
+			} while (accept(","));
+		}
+
+		if (accept("where")) {
+			do {
+				if (!predicate(cm)) return false;
+			} while (accept("and"));
+		}
+
+		if (pos < tokens.size()) return fail("unexpected '" + tokens[pos] + "'");
+		return true;
+	}
+
+	//the shapes the fused kernels compute
+	bool check() {
+		for (int i = 0; i < aggr.size(); i++)
+			if (aggr[i]->table_id != 0) return fail("sum over " + aggr[i]->column_name + ", which is not a lineorder column");
+		if (group.size() > 0 && aggr_op == '*') return fail("queries with group columns compute sum(a) or sum(a - b)");
+		if (group.size() == 0 && aggr_op != '*') return fail("queries without group columns compute sum(a * b)");
+
+		sort(group.begin(), group.end(), [] (ColumnInfo* x, ColumnInfo* y) { return x->table_id < y->table_id; });
+		for (int i = 0; i < group.size(); i++) {
+			if (group[i]->table_id == 0) return fail("group column " + group[i]->column_name + " is not a dimension column");
+			if (i > 0 && group[i]->table_id == group[i - 1]->table_id)
+				return fail("more than one group column on table " + group[i]->table_name);
+			tables.push_back(group[i]->table_id);
+		}
+
+		int lo_predicates = 0;
+		for (int i = 0; i < predicates.size(); i++) {
+			ColumnInfo* c = predicates[i].column;
+			for (int j = 0; j < i; j++) {
+				if (predicates[j].column == c) return fail("more than one predicate on " + c->column_name);
+				if (c->table_id != 0 && predicates[j].column->table_id == c->table_id)
+					return fail("more than one predicate on table " + c->table_name);
+			}
+			if (c->table_id == 0) lo_predicates++;
+			else if (!joins(c->table_id)) tables.push_back(c->table_id);
+		}
+		if (lo_predicates > 2) return fail("more than two predicates on lineorder");
+		if (tables.empty()) return fail("no dimension to join, name a dimension column in a predicate or in the group columns");
+		if (lo_predicates + tables.size() + aggr.size() > SPEC_MAX_LO_COLUMNS)
+			return fail("more than " + to_string(SPEC_MAX_LO_COLUMNS) + " lineorder columns in the predicates, joins and sum");
+		sort(tables.begin(), tables.end());
+		return true;
+	}
+
+	//selectivity and passing keys of the predicates, range of the group columns (the dimensions are not appended to)
+	void measure(CacheManager* cm) {
+		for (int i = 0; i < predicates.size(); i++) {
+			SpecPredicate& p = predicates[i];
+			ColumnInfo* key = (p.column->table_id == 0) ? NULL : cm->allColumn[cm->columns_in_table[p.column->table_id][0]];
+			int LEN = p.column->LEN;
+			long long count = 0;
+			p.key_min = INT_MAX;
+			p.key_max = INT_MIN;
+			for (int j = 0; j < LEN; j++) {
+				if (!pass(p, p.column->col_ptr[j])) continue;
+				count++;
+				if (key != NULL) {
+					p.key_min = min(p.key_min, key->col_ptr[j]);
+					p.key_max = max(p.key_max, key->col_ptr[j]);
+				}
+			}
+			p.selectivity = (LEN > 0) ? (double) count / LEN : 0;
+		}
+
+		long long total = 1;
+		vector<int> range;
+		for (int i = 0; i < group.size(); i++) {
+			int lo = INT_MAX, hi = INT_MIN;
+			for (int j = 0; j < group[i]->LEN; j++) {
+				lo = min(lo, group[i]->col_ptr[j]);
+				hi = max(hi, group[i]->col_ptr[j]);
+			}
+			if (lo > hi) lo = hi = 0;
+			total *= (long long) hi - lo + 1;
+			if (total > SPEC_MAX_GROUPS) {
+				fail("more than " + to_string(SPEC_MAX_GROUPS) + " groups");
+				return;
+			}
+			group_min.push_back(lo);
+			range.push_back(hi - lo + 1);
+		}
+		total_val = total;
+
+		//group hash of the kernels: sum of (value - min_val) * unique_val, the first dimension varies slowest
+		unique_val.resize(group.size());
+		for (int i = group.size() - 1, stride = 1; i >= 0; i--) {
+			unique_val[i] = stride;
+			stride *= range[i];
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef _QUERY_TRACE_H_
+#define _QUERY_TRACE_H_
+
+#include "common.h"
+
+//Timeline of query execution exported as Chrome Trace Event JSON (chrome://tracing, ui.perfetto.dev).
+//Compiled in with -DMORDRED_TRACE (make TRACE=1), enabled at runtime with QueryTrace::enable.
+//Without MORDRED_TRACE the TRACE_SCOPE macro expands to nothing.
+
+#define TRACE_RING_SIZE 65536 //events kept per thread, older events are overwritten
+
+struct TraceEvent {
+	const char* name;
+	int arg; //segment group, table or -1
+	unsigned long long begin, end; //ns since the tracer was created
+};
+
+//Ring buffer owned by one thread. Only the owner writes, the exporter reads head with acquire.
+struct TraceRing {
+	int tid;
+	atomic<unsigned long long> head;
+	TraceEvent event[TRACE_RING_SIZE];
+
+	TraceRing(int _tid) : tid(_tid), head(0) {};
+};
+
+class QueryTrace {
+public:
+	static QueryTrace& instance() {
+		static QueryTrace trace;
+		return trace;
+	}
+
+	static bool enabled() {
+		return instance().on;
+	}
+
+	static void enable(bool _on) {
+		instance().on = _on;
+	}
+
+	unsigned long long now() {
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+	}
+
+	void record(const char* name, int arg, unsigned long long begin, unsigned long long end) {
+		TraceRing* ring = local();
+		unsigned long long h = ring->head.load(memory_order_relaxed);
+		TraceEvent& e = ring->event[h % TRACE_RING_SIZE];
+		e.name = name; e.arg = arg; e.begin = begin; e.end = end;
+		ring->head.store(h + 1, memory_order_release);
+	}
+
+	void clear() {
+		unique_lock<mutex> guard(lock);
+		for (int i = 0; i < rings.size(); i++) rings[i]->head.store(0, memory_order_release);
+	}
+
+	//call between queries, events written while exporting may be torn
+	void exportJSON(string filename) {
+		FILE *fptr = fopen(filename.c_str(), "w");
+		if (fptr == NULL) {
+			printf("Could not open file %s\n", filename.c_str());
+			return;
+		}
+		fprintf(fptr, "{\"traceEvents\": [\n");
+		bool first = true;
+		unique_lock<mutex> guard(lock);
+		for (int i = 0; i < rings.size(); i++) {
+			TraceRing* ring = rings[i];
+			unsigned long long head = ring->head.load(memory_order_acquire);
+			unsigned long long start = (head > TRACE_RING_SIZE) ? head - TRACE_RING_SIZE : 0;
+			for (unsigned long long h = start; h < head; h++) {
+				TraceEvent& e = ring->event[h % TRACE_RING_SIZE];
+				fprintf(fptr, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"sg\": %d}}",
+					first ? "" : ",\n", e.name, ring->tid, e.begin / 1000.0, (e.end - e.begin) / 1000.0, e.arg);
+				first = false;
+			}
+		}
+		fprintf(fptr, "\n]}\n");
+		fclose(fptr);
+	}
+
+private:
+	bool on;
+	chrono::steady_clock::time_point origin;
+	mutex lock; //only taken when a thread registers its ring and on export
+	vector<TraceRing*> rings;
+
+	QueryTrace() : on(false), origin(chrono::steady_clock::now()) {};
+
+	~QueryTrace() {
+		for (int i = 0; i < rings.size(); i++) delete rings[i];
+	}
+
+	//rings outlive their threads so that events of finished TBB workers can still be exported
+	TraceRing* local() {
+		static thread_local TraceRing* ring = NULL;
+		if (ring == NULL) {
+			unique_lock<mutex> guard(lock);
+			ring = new TraceRing(rings.size());
+			rings.push_back(ring);
+		}
+		return ring;
+	}
+};
+
+class TraceScope {
+public:
+	const char* name;
+	int arg;
+	unsigned long long begin;
+
+	TraceScope(const char* _name, int _arg) : name(_name), arg(_arg), begin(0) {
+		if (QueryTrace::enabled()) begin = QueryTrace::instance().now();
+	}
+
+	~TraceScope() {
+		if (begin == 0) return; //tracing was off when the scope started
+		QueryTrace& trace = QueryTrace::instance();
+		trace.record(name, arg, begin, trace.now());
+	}
+};
+
+#ifdef MORDRED_TRACE
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name, arg) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, arg)
+#else
+#define TRACE_SCOPE(name, arg)
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+#include "CacheManager.h"
+
+//Replacement and migration logic of CacheManager on synthetic columns in a HostCacheTier. Needs no GPU
+//and no SSB data. Every segment holds distinct values, so a slot can be checked against its segment.
+//The exit status is 1 if any check fails.
+
+#define TEST_SEGMENT 4 //segments of each lineorder column
+#define TEST_CACHE 6 //cache slots, the segment policies place at most TEST_CACHE - 1 segments
+
+int failed = 0;
+
+#define CHECK(cond, what) do { if (!(cond)) { printf("FAILED %s: %s (line %d)\n", test.c_str(), what, __LINE__); failed++; } } while (0)
+
+struct TestData {
+	vector<int*> data;
+	vector<ColumnInfo*> columns;
+
+	//lineorder (table 0) with two columns, one dimension (table 1) with one column of a single segment
+	TestData() {
+		add("lo_a", "lo", TEST_SEGMENT * SEGMENT_SIZE, 0);
+		add("lo_b", "lo", TEST_SEGMENT * SEGMENT_SIZE, 0);
+		add("d_a", "d", SEGMENT_SIZE, 1);
+	}
+
+	~TestData() {
+		for (int i = 0; i < columns.size(); i++) {
+			delete columns[i];
+			free(data[i]);
+		}
+	}
+
+	void add(string name, string table, int len, int table_id) {
+		int id = columns.size();
+		int* col = (int*) malloc(len * sizeof(int));
+		for (int i = 0; i < len; i++) col[i] = id * 100000000 + i;
+		data.push_back(col);
+		columns.push_back(new ColumnInfo(name, table, len, id, table_id, col));
+	}
+
+	CacheManager* cache() {
+		return new CacheManager(columns, 2, (size_t) TEST_CACHE * SEGMENT_SIZE, new HostCacheTier());
+	}
+};
+
+//a query at logical time t touching the given (column, segment) pairs, as QueryOptimizer records them
+void touch(CacheManager* cm, vector<pair<int, int>> segments, double t, double speedup = 1) {
+	for (int i = 0; i < segments.size(); i++) {
+		ColumnInfo* column = cm->allColumn[segments[i].first];
+		Segment* segment = cm->index_to_segment[segments[i].first][segments[i].second];
+		cm->updateSegmentFreqDirect(column, segment);
+		cm->updateSegmentWeightDirect(column, segment, speedup);
+		cm->updateSegmentTimeDirect(column, segment, t);
+	}
+	cm->advanceClock();
+}
+
+//bitmap, slot list and mapper agree, cached slots hold their segment, free list and cached segments cover the tier
+void checkResidency(CacheManager* cm, string test, vector<pair<int, int>> expected) {
+	int cached = 0;
+	for (int i = 0; i < cm->TOT_COLUMN; i++) {
+		for (int j = 0; j < cm->allColumn[i]->total_segment; j++) {
+			Segment* segment = cm->index_to_segment[i][j];
+			bool in_bitmap = cm->segment_bitmap[i][j];
+			bool want = find(expected.begin(), expected.end(), make_pair(i, j)) != expected.end();
+			CHECK(in_bitmap == want, (cm->allColumn[i]->column_name + " segment " + to_string(j) + (want ? " not cached" : " cached")).c_str());
+			CHECK(in_bitmap == (cm->cache_mapper.find(segment) != cm->cache_mapper.end()), "bitmap and mapper disagree");
+			CHECK(in_bitmap == (cm->segment_list[i][j] != -1), "bitmap and slot list disagree");
+			if (in_bitmap) {
+				cached++;
+				int idx = cm->segment_list[i][j];
+				CHECK(memcmp(cm->tier->slotPtr(idx), segment->seg_ptr, SEGMENT_SIZE * sizeof(int)) == 0, "slot does not hold its segment");
+			}
+		}
+	}
+	CHECK(cached + cm->empty_gpu_segment.size() == cm->cache_total_seg, "free list and cached segments do not cover the tier");
+}
+
+int main() {
+	TestData td;
+	vector<pair<int, int>> hot = {{0, 0}, {0, 1}, {0, 2}, {1, 1}, {2, 0}};
+	vector<pair<int, int>> cold = {{0, 3}, {1, 2}};
+
+	//every segment policy caches the segments touched most often, most recently and with the highest benefit
+	vector<string> policies = {"Segmented", "LFUSegmented", "LRUSegmented", "LRU2Segmented", "GDSF", "ARC"};
+	for (int p = 0; p < policies.size(); p++) {
+		string test = policies[p];
+		CacheManager* cm = td.cache();
+		touch(cm, cold, 2);
+		for (int t = 3; t <= 5; t++) touch(cm, hot, t);
+		cm->runReplacement(parsePolicy(policies[p]));
+		checkResidency(cm, test, hot);
+		delete cm;
+	}
+
+	//GDSF priority is L + F * C / S with C the speedup of the last touch
+	{
+		string test = "GDSF priority";
+		CacheManager* cm = td.cache();
+		touch(cm, {{0, 0}}, 1, 2);
+		touch(cm, {{0, 0}}, 2, 2);
+		touch(cm, {{0, 0}}, 3, 5);
+		touch(cm, {{0, 1}}, 4, 6);
+		cm->runReplacement(GDSF);
+		CHECK(cm->gdsf_priority[cm->index_to_segment[0][0]] == 15, "H of a segment touched three times");
+		CHECK(cm->gdsf_priority[cm->index_to_segment[0][1]] == 6, "H of a segment touched once");
+		delete cm;
+	}
+
+	//continuous decay ages every statistic in the direction of its policy
+	{
+		string test = "decay";
+		CacheManager* cm = td.cache();
+		cm->setHalfLife(1);
+		touch(cm, {{0, 0}}, 1);
+		touch(cm, {{0, 0}}, 3);
+		int idx = cm->index_to_segment[0][0]->stats_idx;
+		cm->decaySegment(idx);
+		double freq = cm->seg_stats->col_freq[idx], speedup = cm->seg_stats->speedup[idx], backward = cm->seg_stats->backward_t[idx];
+		cm->advanceClock();
+		cm->decaySegment(idx);
+		CHECK(cm->seg_stats->col_freq[idx] == freq / 2, "col_freq is not halved");
+		CHECK(cm->seg_stats->speedup[idx] == speedup / 2, "speedup is not halved");
+		CHECK(cm->seg_stats->backward_t[idx] == backward * 2, "backward_t is not doubled");
+		delete cm;
+	}
+
+	//the migration engine applies a placement in the background, and the next one evicts what went cold
+	{
+		string test = "migration";
+		CacheManager* cm = td.cache();
+		cm->startMigration(0);
+		for (int t = 1; t <= 3; t++) touch(cm, hot, t);
+		cm->runReplacementAsync(Segmented);
+		cm->migration->wait();
+		checkResidency(cm, test, hot);
+
+		vector<pair<int, int>> next = {{0, 3}, {1, 0}, {1, 2}};
+		cm->newEpoch(0);
+		for (int t = 4; t <= 6; t++) touch(cm, next, t);
+		cm->runReplacementAsync(Segmented);
+		cm->migration->wait();
+		checkResidency(cm, test, next);
+		CHECK(cm->migration->traffic == (hot.size() + next.size()) * SEGMENT_SIZE * sizeof(int), "migration traffic");
+		delete cm;
+	}
+
+	//a slot evicted while a query runs stays off the free list until every query that started before the eviction ends
+	{
+		string test = "slot reclamation";
+		CacheManager* cm = td.cache();
+		cm->startMigration(0);
+		for (int t = 1; t <= 3; t++) touch(cm, hot, t);
+		cm->runReplacementAsync(Segmented);
+		cm->migration->wait();
+
+		unsigned long long before = cm->enterQuery();
+		int free_slots = cm->empty_gpu_segment.size();
+		int idx = cm->segment_list[0][0];
+		CHECK(cm->migrateSegmentOut(cm->index_to_segment[0][0]), "segment not evicted");
+		unsigned long long after = cm->enterQuery();
+		CHECK(cm->empty_gpu_segment.size() == free_slots && cm->retired_slots.size() == 1, "evicted slot reused while a query runs");
+		CHECK(memcmp(cm->tier->slotPtr(idx), cm->index_to_segment[0][0]->seg_ptr, SEGMENT_SIZE * sizeof(int)) == 0, "evicted slot overwritten");
+		cm->exitQuery(after);
+		CHECK(cm->retired_slots.size() == 1, "slot reclaimed by a query that started after the eviction");
+		cm->exitQuery(before);
+		CHECK(cm->retired_slots.empty() && cm->empty_gpu_segment.size() == free_slots + 1, "slot not reclaimed");
+		hot.erase(hot.begin());
+		checkResidency(cm, test, hot);
+		hot.insert(hot.begin(), make_pair(0, 0));
+		delete cm;
+	}
+
+	//a snapshot restores the placement and the policy state, a damaged one is rejected before anything changes
+	{
+		string test = "snapshot";
+		string file = "cachetest.snapshot";
+		CacheManager* cm = td.cache();
+		for (int t = 1; t <= 3; t++) touch(cm, hot, t);
+		cm->runReplacement(GDSF);
+		CHECK(cm->saveSnapshot(file, 3), "snapshot not saved");
+		CHECK(access((file + ".tmp").c_str(), F_OK) != 0, "temporary file left behind");
+		CHECK(!cm->saveSnapshot("cachetest.missing/" + file, 3), "snapshot saved into a missing directory");
+		delete cm;
+
+		cm = td.cache();
+		double logical_time = 0;
+		CHECK(cm->loadSnapshot(file, &logical_time), "snapshot not restored");
+		CHECK(logical_time == 3, "logical time");
+		checkResidency(cm, test, hot);
+		CHECK(cm->gdsf_priority.size() == hot.size(), "GDSF priorities");
+
+		//a stats index past the end of the table in the ARC tail, then a truncated file
+		FILE* fptr = fopen(file.c_str(), "r+b");
+		fseek(fptr, -(long) sizeof(int), SEEK_END);
+		int count = 1, idx = cm->seg_stats->total_segment;
+		double value = 1;
+		fwrite(&count, sizeof(int), 1, fptr);
+		fwrite(&idx, sizeof(int), 1, fptr);
+		fwrite(&value, sizeof(double), 1, fptr);
+		fclose(fptr);
+		CHECK(!cm->loadSnapshot(file, &logical_time), "snapshot with an index out of range restored");
+		checkResidency(cm, test, hot);
+		CHECK(cm->gdsf_priority.size() == hot.size(), "GDSF priorities changed by a rejected snapshot");
+
+		fptr = fopen(file.c_str(), "r+b");
+		fseek(fptr, 0, SEEK_END);
+		long size = ftell(fptr);
+		fclose(fptr);
+		CHECK(truncate(file.c_str(), size - sizeof(double)) == 0, "truncate");
+		CHECK(!cm->loadSnapshot(file, &logical_time), "truncated snapshot restored");
+		checkResidency(cm, test, hot);
+
+		remove(file.c_str());
+		delete cm;
+	}
+
+	printf("%s\n", failed ? "cachetest failed" : "cachetest passed");
+	return failed ? 1 : 0;
+}
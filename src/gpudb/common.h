@@ -9,10 +9,17 @@
 #include <vector>
 #include <unordered_map>
 #include <queue>
+#include <list>
+#include <deque>
 #include <assert.h>
+#include <limits.h>
 #include <unistd.h>
 #include <chrono>
 #include <atomic>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
 #include <random>
 
 #include <curand.h>
@@ -103,6 +110,9 @@ using namespace tbb;
 #endif
 
 #define SEGMENT_SIZE 1048576
+// #define MAX_GROUPS 128
+#define MAX_GROUPS 229
+#define LO_APPEND_SEGMENT 16 //segments reserved after lineorder for rows appended at runtime
 
 inline int index_of(string* arr, int len, string val) {
   for (int i=0; i<len; i++)
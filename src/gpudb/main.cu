@@ -51,6 +51,14 @@ int main() {
 
 	qp = new QueryProcessing(cgp, verbose, dist);
 
+	//restore the warm state of a previous run instead of warming up again
+	bool warm_state = false;
+	char* snapshot_env = getenv("MORDRED_SNAPSHOT");
+	string snapshot_file = (snapshot_env != NULL) ? snapshot_env : "";
+	if (snapshot_file != "" && access(snapshot_file.c_str(), F_OK) == 0) {
+		warm_state = cgp->cm->loadSnapshot(snapshot_file, &(qp->logical_time));
+	}
+
 	// if (dist == Zipf) {
 	// 	qp->qo->setDistributionZipfian(alpha);
 	// } else if (dist == Norm) {
@@ -69,6 +77,16 @@ int main() {
 		cout << "clear. Delete Columns from GPU" << endl;
 		cout << "custom. Toggle custom malloc" << endl;
 		cout << "skipping. Toggle segment skipping" << endl;
+		cout << "dist. Set query distribution" << endl;
+		cout << "decay. Set half-life of segment statistics" << endl;
+		cout << "async. Set background replacement bandwidth" << endl;
+		cout << "radix. Set hash table size for radix-partitioned probing" << endl;
+		cout << "positional. Toggle positional joins on dense dimension keys" << endl;
+		cout << "spec. Add a star-join query (run it with option 1)" << endl;
+		cout << "perf. Toggle per-operator performance counters" << endl;
+		cout << "trace. Toggle query timeline trace" << endl;
+		cout << "save. Save warm state snapshot" << endl;
+		cout << "load. Load warm state snapshot" << endl;
 		cout << "Your Input: ";
 		cin >> input;
 
@@ -166,6 +184,10 @@ int main() {
 				repl_policy = LRU2;
 			} else if (policy == "LRU2Segmented") {
 				repl_policy = LRU2Segmented;
+			} else if (policy == "GDSF") {
+				repl_policy = GDSF;
+			} else if (policy == "ARC") {
+				repl_policy = ARC;
 			} else if (policy == "SemanticAware") {
 				repl_policy = Segmented;
 			} else {
@@ -173,8 +195,10 @@ int main() {
 			}
 
 			cgp->resetTime();
+			if (cgp->cm->migration != NULL) cgp->cm->migration->traffic = 0;
 
 			// if (dist != Norm) {
+			if (!warm_state) {
 				cout << "Warmup" << endl;
 				for (int i = 0; i < 100; i++) {
 					qp->generate_rand_query();
@@ -182,6 +206,7 @@ int main() {
 					cgp->resetTime();
 				}
 				cgp->cm->runReplacement(repl_policy);				
+			}
 			// }
 
 
@@ -222,23 +247,30 @@ int main() {
 
 				}				
 
-				cgp->cm->runReplacement(repl_policy, &repl_traffic);
+				//the background replacement overlaps with the queries of the next epoch
+				if (cgp->cm->migration != NULL) cgp->cm->runReplacementAsync(repl_policy);
+				else cgp->cm->runReplacement(repl_policy, &repl_traffic);
 				qp->percentageData();
-				if (repl_policy == Segmented || repl_policy == LFUSegmented) cgp->cm->newEpoch(0.5);
-				if (repl_policy == LRU2Segmented) cgp->cm->newEpoch(2.0);
-
-				// if (dist == Norm) {
-				// 	time = 0; execution_time = 0; optimization_time = 0; merging_time = 0;
-				// 	if ((iter + 1) % 5 == 0) {
-				// 		if (iter == 4) mean = 4;
-				// 		else if (iter == 9) mean = 2;
-				// 		else if (iter == 14) mean = 5;
-				// 		qp->qo->setDistributionNormal(mean, 0.5);
-				// 	}
-				// }
+				//with continuous decay the statistics already age on every query
+				if (cgp->cm->half_life == 0) {
+					if (repl_policy == Segmented || repl_policy == LFUSegmented) cgp->cm->newEpoch(0.5);
+					if (repl_policy == LRU2Segmented) cgp->cm->newEpoch(2.0);
+				}
+
+				//shift the hot range every 5 epochs
+				if (dist == Norm && (iter + 1) % 5 == 0) {
+					if (iter == 4) mean = 4;
+					else if (iter == 9) mean = 2;
+					else if (iter == 14) mean = 5;
+					qp->qo->setDistributionNormal(mean, 0.5);
+				}
 
 			}
 
+			if (cgp->cm->migration != NULL) {
+				cgp->cm->migration->wait();
+				repl_traffic = cgp->cm->migration->traffic;
+			}
 			cout << "Replacement traffic: " << repl_traffic << endl;
 
 			srand(123);
@@ -259,6 +291,10 @@ int main() {
 				repl_policy = LRU2;
 			} else if (policy == "LRU2Segmented") {
 				repl_policy = LRU2Segmented;
+			} else if (policy == "GDSF") {
+				repl_policy = GDSF;
+			} else if (policy == "ARC") {
+				repl_policy = ARC;
 			} else if (policy == "SemanticAware") {
 				repl_policy = Segmented;
 			}
@@ -289,6 +325,93 @@ int main() {
 			qp->skipping = skipping;
 			if (skipping) cout << "Segment skipping is enabled" << endl;
 			else cout << "Segment skipping is disabled" << endl;
+		} else if (input.compare("dist") == 0) {
+			string dist_string;
+			cout << "Distribution (None/Zipf/Norm): ";
+			cin >> dist_string;
+			if (dist_string == "Zipf") {
+				cout << "Zipf alpha: ";
+				cin >> alpha;
+				dist = Zipf;
+				qp->qo->setDistributionZipfian(alpha);
+			} else if (dist_string == "Norm") {
+				mean = 1;
+				dist = Norm;
+				qp->qo->setDistributionNormal(mean, 0.5);
+			} else {
+				dist = None;
+			}
+			qp->dist = dist;
+			cout << "Distribution is " << dist_string << endl;
+		} else if (input.compare("decay") == 0) {
+			string half_life;
+			cout << "Half-life in queries (0 to decay per epoch): ";
+			cin >> half_life;
+			cgp->cm->setHalfLife(stod(half_life));
+			if (cgp->cm->half_life == 0) cout << "Continuous decay is disabled" << endl;
+			else cout << "Continuous decay is enabled" << endl;
+		} else if (input.compare("async") == 0) {
+			string bandwidth;
+			cout << "Replacement bandwidth in MB/s (0 for unlimited, negative for synchronous replacement): ";
+			cin >> bandwidth;
+			if (stod(bandwidth) < 0) {
+				cgp->cm->stopMigration();
+				cout << "Replacement is synchronous" << endl;
+			} else {
+				cgp->cm->startMigration(stod(bandwidth) * 1024 * 1024);
+				cout << "Replacement runs in the background" << endl;
+			}
+		} else if (input.compare("radix") == 0) {
+			string threshold;
+			cout << "Hash table size in MB above which CPU probes are radix-partitioned (0 to disable): ";
+			cin >> threshold;
+			cgp->qo->radix_probe_threshold = stod(threshold) * 1024 * 1024;
+			if (cgp->qo->radix_probe_threshold == 0) cout << "Radix-partitioned probing is disabled" << endl;
+			else cout << "Radix-partitioned probing is enabled" << endl;
+		} else if (input.compare("positional") == 0) {
+			cgp->qo->positional_join = !cgp->qo->positional_join;
+			if (cgp->qo->positional_join) cout << "Positional joins are enabled" << endl;
+			else cout << "Positional joins are disabled" << endl;
+		} else if (input.compare("spec") == 0) {
+			string text;
+			cout << "Query: ";
+			cin >> ws;
+			getline(cin, text);
+			int id = cgp->qo->addQuerySpec(text);
+			if (id >= 0) cout << "Added as query " << id << endl;
+		} else if (input.compare("perf") == 0) {
+			if (PerfCounters::enabled) {
+				PerfCounters::report(cout);
+				PerfCounters::enable(false);
+				cout << "Performance counters are disabled" << endl;
+			} else {
+				PerfCounters::reset();
+				PerfCounters::enable(true);
+				if (PerfCounters::enabled) cout << "Performance counters are enabled" << endl;
+			}
+		} else if (input.compare("trace") == 0) {
+#ifdef MORDRED_TRACE
+			if (QueryTrace::enabled()) {
+				string filename;
+				cout << "Trace file: ";
+				cin >> filename;
+				QueryTrace::enable(false);
+				QueryTrace::instance().exportJSON(filename);
+				cout << "Trace written to " << filename << endl;
+			} else {
+				QueryTrace::instance().clear();
+				QueryTrace::enable(true);
+				cout << "Tracing is enabled" << endl;
+			}
+#else
+			cout << "Tracing is not compiled in, rebuild with make TRACE=1" << endl;
+#endif
+		} else if (input.compare("save") == 0 || input.compare("load") == 0) {
+			string filename;
+			cout << "Snapshot file: ";
+			cin >> filename;
+			if (input.compare("save") == 0) cgp->cm->saveSnapshot(filename, qp->logical_time);
+			else warm_state = cgp->cm->loadSnapshot(filename, &(qp->logical_time)) || warm_state;
 		} else if (input.compare("custom") == 0) {
 			custom = !custom;
 			cgp->custom = custom;
@@ -297,6 +420,7 @@ int main() {
 			if (custom) cout << "Custom malloc is enabled" << endl;
 			else cout << "Custom malloc is disabled" << endl;			
 		} else {
+			if (snapshot_file != "") cgp->cm->saveSnapshot(snapshot_file, qp->logical_time);
 			exit = true;
 		}
 
@@ -307,7 +431,12 @@ int main() {
 		cout << "RESULT- Malloc time: " << malloc_time_total << endl;
 		cout << "RESULT- Execution time: " << execution_time << endl;
 		cout << "RESULT- Merging time: " << merging_time << endl;
+		cout << "RESULT- Processing memory high-water mark: " << cgp->cm->cpu_pool->high_water << " " << cgp->cm->pinned_pool->high_water << endl;
+		cout << "RESULT- Processing memory spilled: " << cgp->cm->cpu_pool->spilled_bytes << " " << cgp->cm->pinned_pool->spilled_bytes << endl;
 		cout << endl;
+		//the next command reports its own high-water mark and spills
+		cgp->cm->cpu_pool->resetHighWater();
+		cgp->cm->pinned_pool->resetHighWater();
 
 	}
 
@@ -0,0 +1,281 @@
+#include "CPUProcessing.h"
+#include "../cpu/generator.h"
+
+//Microbenchmarks of the CPUProcessing kernels on synthetic star schema data generated in memory,
+//so no SSB data files are needed. Options are given as --key=value, lists are comma separated:
+//
+//  kernels=filter,build,probe,probe_radix,probe_group_by,group_by,merge
+//  tuples=16777216         fact tuples (filter, probe, probe_group_by, group_by)
+//  selectivity=0.01,0.1,0.5,1    fraction of fact tuples passing the filter, or of dimension tuples in the hash table
+//  ht_size=1024,65536,1048576,16777216    dimension length, which is also the number of hash table slots
+//  groups=1,64,4096,262144     distinct group-by values
+//  threads=1,<all>         size of the TBB arena running the kernel
+//  reps=5                  measured repetitions, after one warmup
+//  output=microbench.csv   result file (-: stdout)
+//
+//TASK_SIZE and BATCH_SIZE are compile time constants, every pair is built as its own binary:
+//  make microbench TASK_SIZE=2048 BATCH_SIZE=128   (bin/gpudb/microbench_t2048_b128.bin)
+
+struct BenchConfig {
+	vector<string> kernels = {"filter", "build", "probe", "probe_radix", "probe_group_by", "group_by", "merge"};
+	int tuples = 1 << 24;
+	vector<double> selectivity = {0.01, 0.1, 0.5, 1};
+	vector<int> ht_size = {1024, 65536, 1048576, 16777216};
+	vector<int> groups = {1, 64, 4096, 262144};
+	vector<int> threads;
+	int reps = 5;
+	string output = "microbench.csv";
+};
+
+//one measured configuration, parameters that do not apply to a kernel are -1
+struct BenchPoint {
+	string kernel;
+	int threads;
+	int tuples;
+	double selectivity;
+	int ht_size;
+	int groups;
+};
+
+template<typename T>
+vector<T> parseList(string value) {
+	vector<T> list;
+	stringstream ss(value);
+	string item;
+	while (getline(ss, item, ',')) {
+		if (item.empty()) continue;
+		stringstream conv(item);
+		T v;
+		conv >> v;
+		list.push_back(v);
+	}
+	return list;
+}
+
+void setOption(BenchConfig& cfg, string key, string value) {
+	if (key == "kernels") cfg.kernels = parseList<string>(value);
+	else if (key == "tuples") cfg.tuples = stoi(value);
+	else if (key == "selectivity") cfg.selectivity = parseList<double>(value);
+	else if (key == "ht_size") cfg.ht_size = parseList<int>(value);
+	else if (key == "groups") cfg.groups = parseList<int>(value);
+	else if (key == "threads") cfg.threads = parseList<int>(value);
+	else if (key == "reps") cfg.reps = max(stoi(value), 1);
+	else if (key == "output") cfg.output = value;
+	else {
+		fprintf(stderr, "Unknown option %s\n", key.c_str());
+		exit(1);
+	}
+}
+
+//fact table and dimension of the current ht_size, regenerated when the dimension changes
+struct BenchData {
+	int tuples;
+	int* fact_filter; //uniform in [0, 1000)
+	int* fact_measure; //uniform in [1, 100]
+	int* fact_fk = NULL; //references dimension keys 1..dim_len
+	int* lo_off;
+	int* dim_off; //fact_fk - 1, the dimension offset of every fact tuple
+
+	int dim_len = 0;
+	int* dim_key = NULL; //unique keys 1..dim_len
+	int* dim_filter = NULL; //uniform in [0, 1000)
+	int* dim_group = NULL; //uniform in [1, groups]
+	int groups = 0;
+
+	short* segment_group; //identity, every segment is in the group
+
+	BenchData(int _tuples) : tuples(_tuples) {
+		create_column_uniform(fact_filter, tuples, 0, 999);
+		create_column_uniform(fact_measure, tuples, 1, 100);
+		lo_off = (int*) _mm_malloc(tuples * sizeof(int), 256);
+		dim_off = (int*) _mm_malloc(tuples * sizeof(int), 256);
+		for (int i = 0; i < tuples; i++) lo_off[i] = i;
+
+		int total_segment = (tuples + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+		assert(total_segment <= SHRT_MAX);
+		segment_group = new short[total_segment];
+		for (int i = 0; i < total_segment; i++) segment_group[i] = i;
+	}
+
+	~BenchData() {
+		_mm_free(fact_filter); _mm_free(fact_measure); _mm_free(lo_off); _mm_free(dim_off);
+		if (fact_fk != NULL) _mm_free(fact_fk);
+		if (dim_key != NULL) { _mm_free(dim_key); _mm_free(dim_filter); }
+		if (dim_group != NULL) _mm_free(dim_group);
+		delete[] segment_group;
+	}
+
+	void setDimension(int _dim_len) {
+		if (dim_len == _dim_len) return;
+		if (dim_key != NULL) { _mm_free(dim_key); _mm_free(dim_filter); _mm_free(fact_fk); }
+		if (dim_group != NULL) { _mm_free(dim_group); dim_group = NULL; groups = 0; }
+		dim_len = _dim_len;
+
+		int* vals;
+		create_relation_pk(dim_key, vals, dim_len);
+		_mm_free(vals);
+		create_column_uniform(dim_filter, dim_len, 0, 999);
+		create_relation_fk(fact_fk, vals, tuples, dim_len);
+		_mm_free(vals);
+		for (int i = 0; i < tuples; i++) dim_off[i] = fact_fk[i] - 1;
+	}
+
+	void setGroups(int _groups) {
+		if (groups == _groups) return;
+		if (dim_group != NULL) _mm_free(dim_group);
+		groups = _groups;
+		create_column_uniform(dim_group, dim_len, 1, groups);
+	}
+};
+
+//range predicate on a column uniform in [0, 1000) selecting a fraction sel of the tuples
+filterArgsCPU selectFilter(int* col, double sel) {
+	filterArgsCPU fargs = {col, NULL, 0, (int) (sel * 1000) - 1, 0, 0, 1, 0, NULL, NULL};
+	return fargs;
+}
+
+//hash table of the dimension with dim_group as value, as built for a group-by dimension in SSB
+int* buildTable(BenchData& data, double sel, bool with_group) {
+	int* ht = (int*) _mm_malloc(2 * data.dim_len * sizeof(int), 256);
+	memset(ht, 0, 2 * data.dim_len * sizeof(int));
+	buildArgsCPU bargs = {data.dim_key, with_group ? data.dim_group : NULL, data.dim_len, 1, 0};
+	build_CPU(selectFilter(data.dim_filter, sel), bargs, data.dim_len, ht, 0, data.segment_group);
+	return ht;
+}
+
+//runs the kernel of the point once and returns the number of output tuples or groups
+long long runKernel(BenchPoint& p, BenchData& data, int* ht, int* out, int* res, int* res_other) {
+	int total = 0;
+	if (p.kernel == "filter") {
+		filter_CPU(selectFilter(data.fact_filter, p.selectivity), out, p.tuples, &total, 0, data.segment_group);
+	} else if (p.kernel == "build") {
+		buildArgsCPU bargs = {data.dim_key, NULL, data.dim_len, 1, 0};
+		build_CPU(selectFilter(data.dim_filter, p.selectivity), bargs, data.dim_len, ht, 0, data.segment_group);
+	} else if (p.kernel == "probe") {
+		probeArgsCPU pargs = {data.fact_fk, NULL, NULL, NULL, ht, NULL, NULL, NULL, data.dim_len, 0, 0, 0, 1, 0, 0, 0};
+		offsetCPU out_off = {out, out + p.tuples, NULL, NULL, NULL};
+		probe_CPU(pargs, out_off, p.tuples, &total, 0, data.segment_group);
+	} else if (p.kernel == "probe_radix") {
+		probeArgsCPU pargs = {data.fact_fk, NULL, NULL, NULL, ht, NULL, NULL, NULL, data.dim_len, 0, 0, 0, 1, 0, 0, 0};
+		offsetCPU in_off = {NULL, NULL, NULL, NULL, NULL};
+		offsetCPU out_off = {out, out + p.tuples, NULL, NULL, NULL};
+		probe_radix_CPU(in_off, pargs, out_off, p.tuples, &total, radix_bits_CPU(data.dim_len), data.segment_group, NULL);
+	} else if (p.kernel == "probe_group_by") {
+		probeArgsCPU pargs = {data.fact_fk, NULL, NULL, NULL, ht, NULL, NULL, NULL, data.dim_len, 0, 0, 0, 1, 0, 0, 0};
+		groupbyArgsCPU gargs = {data.fact_measure, NULL, NULL, NULL, NULL, NULL, 1, 0, 0, 0, 1, 0, 0, 0, p.groups, 0, NULL};
+		probe_group_by_CPU(pargs, gargs, p.tuples, res, 0, data.segment_group);
+		total = p.groups;
+	} else if (p.kernel == "group_by") {
+		offsetCPU offset = {data.lo_off, data.dim_off, NULL, NULL, NULL};
+		groupbyArgsCPU gargs = {data.fact_measure, NULL, data.dim_group, NULL, NULL, NULL, 1, 0, 0, 0, 1, 0, 0, 0, p.groups, 0, NULL};
+		groupByCPU(offset, gargs, p.tuples, res);
+		total = p.groups;
+	} else if (p.kernel == "merge") {
+		merge(res, res_other, p.groups);
+		total = p.groups;
+	}
+	return total;
+}
+
+void runPoint(BenchPoint& p, BenchData& data, int reps, ostream& out) {
+	int* ht = NULL;
+	int* res = NULL;
+	int* res_other = NULL;
+	int* out_off = NULL;
+
+	if (p.kernel == "probe" || p.kernel == "probe_radix" || p.kernel == "probe_group_by") ht = buildTable(data, p.selectivity, p.kernel == "probe_group_by");
+	else if (p.kernel == "build") ht = (int*) _mm_malloc(2 * data.dim_len * sizeof(int), 256);
+	if (p.kernel == "filter") out_off = (int*) _mm_malloc(p.tuples * sizeof(int), 256);
+	else if (p.kernel == "probe" || p.kernel == "probe_radix") out_off = (int*) _mm_malloc(2 * (size_t) p.tuples * sizeof(int), 256);
+	if (p.groups > 0) {
+		res = (int*) _mm_malloc(6 * (size_t) p.groups * sizeof(int), 256);
+		res_other = (int*) _mm_malloc(6 * (size_t) p.groups * sizeof(int), 256);
+		for (size_t i = 0; i < 6 * (size_t) p.groups; i++) res_other[i] = i % 6 == 0 ? i / 6 + 1 : 1;
+	}
+
+	tbb::task_arena arena(p.threads);
+	vector<double> time;
+	long long output = 0;
+	for (int rep = 0; rep <= reps; rep++) {
+		if (p.kernel == "build") memset(ht, 0, 2 * data.dim_len * sizeof(int));
+		if (res != NULL) memset(res, 0, 6 * (size_t) p.groups * sizeof(int));
+
+		chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
+		arena.execute([&] {
+			output = runKernel(p, data, ht, out_off, res, res_other);
+		});
+		chrono::high_resolution_clock::time_point finish = chrono::high_resolution_clock::now();
+		if (rep > 0) time.push_back(chrono::duration<double, milli>(finish - st).count()); //the first run is a warmup
+	}
+
+	if (p.kernel == "build") {
+		output = 0;
+		for (int i = 0; i < data.dim_len; i++) output += (ht[2 * i + 1] != 0);
+	}
+
+	sort(time.begin(), time.end());
+	double median = time[time.size() / 2];
+	long long input = (p.kernel == "build") ? data.dim_len : (p.kernel == "merge") ? p.groups : p.tuples;
+	out << p.kernel << "," << p.threads << "," << TASK_SIZE << "," << BATCH_SIZE << "," << input << ","
+		<< p.selectivity << "," << p.ht_size << "," << p.groups << "," << median << "," << time[0] << ","
+		<< input / median / 1000 << "," << output << endl;
+
+	if (ht != NULL) _mm_free(ht);
+	if (out_off != NULL) _mm_free(out_off);
+	if (res != NULL) { _mm_free(res); _mm_free(res_other); }
+}
+
+int main(int argc, char** argv) {
+
+	BenchConfig cfg;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare(0, 2, "--") != 0 || arg.find('=') == string::npos) {
+			fprintf(stderr, "Usage: %s [--key=value ...]\n", argv[0]);
+			return 1;
+		}
+		setOption(cfg, arg.substr(2, arg.find('=') - 2), arg.substr(arg.find('=') + 1));
+	}
+	if (cfg.threads.empty()) {
+		cfg.threads.push_back(1);
+		if (thread::hardware_concurrency() > 1) cfg.threads.push_back(thread::hardware_concurrency());
+	}
+
+	ofstream file;
+	if (cfg.output != "-") file.open(cfg.output.c_str());
+	ostream& out = (cfg.output == "-") ? cout : file;
+	out << "kernel,threads,task_size,batch_size,input_tuples,selectivity,ht_size,groups,median_ms,min_ms,mtuples_per_s,output" << endl;
+
+	BenchData data(cfg.tuples);
+
+	for (int k = 0; k < cfg.kernels.size(); k++) {
+		string kernel = cfg.kernels[k];
+		bool use_sel = (kernel == "filter" || kernel == "build" || kernel == "probe" || kernel == "probe_radix" || kernel == "probe_group_by");
+		bool use_ht = (kernel == "build" || kernel == "probe" || kernel == "probe_radix" || kernel == "probe_group_by" || kernel == "group_by");
+		bool use_groups = (kernel == "probe_group_by" || kernel == "group_by" || kernel == "merge");
+		if (!use_sel && !use_ht && !use_groups) {
+			fprintf(stderr, "Unknown kernel %s\n", kernel.c_str());
+			continue;
+		}
+
+		vector<double> sels = use_sel ? cfg.selectivity : vector<double>(1, -1);
+		vector<int> hts = use_ht ? cfg.ht_size : vector<int>(1, -1);
+		vector<int> grps = use_groups ? cfg.groups : vector<int>(1, -1);
+
+		for (int h = 0; h < hts.size(); h++) {
+			if (use_ht) data.setDimension(hts[h]);
+			for (int g = 0; g < grps.size(); g++) {
+				if (use_ht && use_groups) data.setGroups(grps[g]);
+				for (int s = 0; s < sels.size(); s++) {
+					for (int t = 0; t < cfg.threads.size(); t++) {
+						BenchPoint p = {kernel, cfg.threads[t], cfg.tuples, sels[s], hts[h], grps[g]};
+						runPoint(p, data, cfg.reps, out);
+						fprintf(stderr, "%s threads=%d selectivity=%g ht_size=%d groups=%d done\n", kernel.c_str(), p.threads, p.selectivity, p.ht_size, p.groups);
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,268 @@
+#include "QueryProcessing.h"
+#include "QueryOptimizer.h"
+#include "CPUGPUProcessing.h"
+#include "CacheManager.h"
+#include "CPUProcessing.h"
+#include "CostModel.h"
+
+//SSB regression benchmark. Every query runs through the engine and through its standalone
+//reference implementation in src/cpu/ssb (make bin/cpu/ssb/qNN), both on the data of DATA_DIR.
+//The aggregates have to be identical, the ratio of the median times is recorded.
+//Options are given as --key=value:
+//
+//  queries=11,12,...,43    queries to check (default: all 13)
+//  trials=3                measured runs per query on both sides
+//  plan=v1                 v1 or v2
+//  policy=                 replacement run after a warmup pass so that the hybrid path is checked (empty: CPU only)
+//  ref_dir=bin/cpu/ssb     directory of the reference binaries
+//  specs=11,21,31,41,43    queries that are also run as a query spec (see QuerySpec.h, empty: none)
+//  output=regression.csv   result file (-: stdout)
+//
+//A spec restates its SSB query as text, so it runs on the group ranges, the passing key ranges and the segment
+//skipping that the spec derives from the data instead of the hardcoded ones. Its groups have to be identical
+//to those of the hardcoded query in the engine; it is written as query NNspec with the hardcoded query in
+//the reference columns.
+//
+//The exit status is 1 if any query or spec differs or a reference could not be run.
+
+struct RegressionConfig {
+	vector<int> queries = {11, 12, 13, 21, 22, 23, 31, 32, 33, 34, 41, 42, 43};
+	int trials = 3;
+	string plan = "v1";
+	string policy = "";
+	string ref_dir = "bin/cpu/ssb";
+	vector<int> specs = {11, 21, 31, 41, 43};
+	string output = "regression.csv";
+};
+
+struct ReferenceRun {
+	vector<vector<long long>> rows;
+	vector<double> time; //ms, one per trial
+	bool ok;
+};
+
+vector<int> parseQueries(string value) {
+	vector<int> queries;
+	stringstream ss(value);
+	string q;
+	while (getline(ss, q, ',')) if (!q.empty()) queries.push_back(stoi(q));
+	return queries;
+}
+
+void setOption(RegressionConfig& cfg, string key, string value) {
+	if (key == "queries") cfg.queries = parseQueries(value);
+	else if (key == "specs") cfg.specs = parseQueries(value);
+	else if (key == "trials") cfg.trials = max(stoi(value), 1);
+	else if (key == "plan") cfg.plan = value;
+	else if (key == "policy") cfg.policy = value;
+	else if (key == "ref_dir") cfg.ref_dir = value;
+	else if (key == "output") cfg.output = value;
+	else {
+		fprintf(stderr, "Unknown option %s\n", key.c_str());
+		exit(1);
+	}
+}
+
+//Rows are compared as the engine returns them: the group value of each dimension at position table_id - 1
+//(supplier, customer, part, date, 0 if the dimension is not grouped on) followed by the aggregate.
+#define GROUP_TUPLE 4
+
+//position in the group tuple of each column that the reference of a query prints before the aggregate
+vector<int> referenceColumns(int query) {
+	if (query >= 21 && query <= 23) return {3, 2}; //year, brand1
+	if (query >= 31 && query <= 34) return {3, 1, 0}; //year, customer nation or city, supplier nation or city
+	if (query == 41) return {3, 1}; //year, c_nation
+	if (query == 42 || query == 43) return {3, 0, 2}; //year, supplier nation or city, category or brand1
+	return {}; //q1.x: aggregate only
+}
+
+vector<long long> referenceRow(int query, vector<long long> val, long long aggr) {
+	vector<long long> row(GROUP_TUPLE + 1, 0);
+	vector<int> column = referenceColumns(query);
+	if (val.size() != column.size()) row.push_back(-1); //never equal to an engine row
+	for (int i = 0; i < min(val.size(), column.size()); i++) row[column[i]] = val[i];
+	row[GROUP_TUPLE] = aggr;
+	return row;
+}
+
+//the references print "Revenue: x" (q1.x) or the groups between "Result:" and "Res Count:" after
+//every trial, followed by {"query":..,"time_query":..}
+ReferenceRun runReference(string binary, int query, int trials) {
+	ReferenceRun ref;
+	string cmd = binary + " --t=" + to_string(trials) + " 2>&1";
+	FILE* pipe = popen(cmd.c_str(), "r");
+	if (pipe == NULL) {
+		ref.ok = false;
+		return ref;
+	}
+
+	char buf[4096];
+	bool in_result = false;
+	while (fgets(buf, sizeof(buf), pipe) != NULL) {
+		string line(buf);
+		size_t pos;
+		if (line.compare(0, 8, "Revenue:") == 0) {
+			ref.rows.clear();
+			ref.rows.push_back(referenceRow(query, {}, stoll(line.substr(8))));
+		} else if (line.compare(0, 7, "Result:") == 0) {
+			ref.rows.clear();
+			in_result = true;
+		} else if (line.compare(0, 10, "Res Count:") == 0) {
+			in_result = false;
+		} else if (in_result) {
+			stringstream ss(line);
+			vector<long long> val;
+			long long v;
+			while (ss >> v) val.push_back(v);
+			if (val.empty()) continue;
+			long long aggr = val.back();
+			val.pop_back();
+			ref.rows.push_back(referenceRow(query, val, aggr));
+		} else if ((pos = line.find("\"time_query\":")) != string::npos) {
+			ref.time.push_back(stod(line.substr(pos + 13)));
+		}
+	}
+	ref.ok = (pclose(pipe) == 0 && !ref.time.empty());
+	sort(ref.rows.begin(), ref.rows.end());
+	return ref;
+}
+
+//the SSB queries as specs, with the dictionary codes and ranges of their prepareQuery branch
+string specText(int query) {
+	if (query == 11) return "sum(lo_extendedprice * lo_discount) where d_year = 1993 and lo_discount between 1 and 3 and lo_quantity between 0 and 24";
+	if (query == 21) return "sum(lo_revenue) by d_year, p_brand1 where p_category = 1 and s_region = 1";
+	if (query == 31) return "sum(lo_revenue) by c_nation, s_nation, d_year where c_region = 2 and s_region = 2 and d_year between 1992 and 1997";
+	if (query == 41) return "sum(lo_revenue - lo_supplycost) by d_year, c_nation where c_region = 1 and s_region = 1 and p_mfgr in (0, 1)";
+	if (query == 43) return "sum(lo_revenue - lo_supplycost) by d_year, s_city, p_brand1 where c_region = 1 and s_nation = 24 and p_category = 3 and d_year between 1997 and 1998";
+	return "";
+}
+
+void printDifference(vector<vector<long long>>& rows, vector<vector<long long>>& expected, string what) {
+	for (int i = 0; i < max(rows.size(), expected.size()); i++) {
+		if (i < rows.size() && i < expected.size() && rows[i] == expected[i]) continue;
+		printf("  first difference at row %d: engine", i);
+		if (i < rows.size()) for (int j = 0; j < rows[i].size(); j++) printf(" %lld", rows[i][j]);
+		printf(", %s", what.c_str());
+		if (i < expected.size()) for (int j = 0; j < expected[i].size(); j++) printf(" %lld", expected[i][j]);
+		printf("\n");
+		break;
+	}
+}
+
+double median(vector<double> v) {
+	sort(v.begin(), v.end());
+	return v[v.size() / 2];
+}
+
+int main(int argc, char** argv) {
+
+	RegressionConfig cfg;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare(0, 2, "--") != 0 || arg.find('=') == string::npos) {
+			fprintf(stderr, "Usage: %s [--key=value ...]\n", argv[0]);
+			return 1;
+		}
+		setOption(cfg, arg.substr(2, arg.find('=') - 2), arg.substr(arg.find('=') + 1));
+	}
+
+	cudaSetDevice(0);
+
+	size_t size = 52428800 * 20; //200 MB
+	size_t processing = 52428800 * 10; //400MB
+	size_t pinned = 52428800 * 10; //400MB
+
+	CPUGPUProcessing* cgp = new CPUGPUProcessing(size, processing, pinned, false, true, false);
+	QueryProcessing* qp = new QueryProcessing(cgp, false);
+	qp->keep_result = true;
+
+	auto runEngine = [&] () {
+		double time = (cfg.plan == "v2") ? qp->processQuery2() : qp->processQuery(false);
+		cgp->resetTime();
+		return time;
+	};
+
+	//runs a query cfg.trials times, the sorted groups of the first run go to rows
+	auto runTrials = [&] (int query, vector<vector<long long>>& rows) {
+		vector<double> time;
+		qp->setQuery(query);
+		rows.clear();
+		for (int t = 0; t < cfg.trials; t++) {
+			time.push_back(runEngine());
+			if (t == 0) rows = qp->last_result;
+		}
+		sort(rows.begin(), rows.end());
+		return median(time);
+	};
+
+	vector<pair<int, int>> specs; //SSB query, spec id
+	for (int s = 0; s < cfg.specs.size(); s++) {
+		string text = specText(cfg.specs[s]);
+		int id = text.empty() ? -1 : cgp->qo->addQuerySpec(text);
+		if (id < 0) {
+			fprintf(stderr, "No spec of q%d\n", cfg.specs[s]);
+			return 1;
+		}
+		specs.push_back(make_pair(cfg.specs[s], id));
+	}
+
+	if (!cfg.policy.empty()) {
+		for (int q = 0; q < cfg.queries.size(); q++) {
+			qp->setQuery(cfg.queries[q]);
+			runEngine();
+		}
+		cgp->cm->runReplacement(parsePolicy(cfg.policy));
+	}
+
+	ofstream file;
+	if (cfg.output != "-") file.open(cfg.output.c_str());
+	ostream& out = (cfg.output == "-") ? cout : file;
+	out << "query,engine_ms,reference_ms,speedup,groups,match" << endl;
+
+	bool pass = true;
+	for (int q = 0; q < cfg.queries.size(); q++) {
+		int query = cfg.queries[q];
+
+		vector<vector<long long>> engine_rows;
+		double engine_ms = runTrials(query, engine_rows);
+
+		ReferenceRun ref = runReference(cfg.ref_dir + "/q" + to_string(query), query, cfg.trials);
+		bool match = ref.ok && (ref.rows == engine_rows);
+		pass = pass && match;
+
+		double reference_ms = ref.ok ? median(ref.time) : 0;
+		out << query << "," << engine_ms << "," << reference_ms << "," << (ref.ok ? reference_ms / engine_ms : 0) << ","
+			<< engine_rows.size() << "," << (match ? 1 : 0) << endl;
+
+		if (!ref.ok) {
+			printf("q%d: could not run reference %s/q%d\n", query, cfg.ref_dir.c_str(), query);
+		} else if (!match) {
+			printf("q%d: engine returned %d groups, reference %d groups\n", query, (int) engine_rows.size(), (int) ref.rows.size());
+			printDifference(engine_rows, ref.rows, "reference");
+		}
+	}
+
+	for (int s = 0; s < specs.size(); s++) {
+		int query = specs[s].first;
+		vector<vector<long long>> spec_rows, query_rows;
+		double spec_ms = runTrials(specs[s].second, spec_rows);
+		double query_ms = runTrials(query, query_rows);
+		bool match = (spec_rows == query_rows);
+		pass = pass && match;
+
+		out << query << "spec," << spec_ms << "," << query_ms << "," << query_ms / spec_ms << ","
+			<< spec_rows.size() << "," << (match ? 1 : 0) << endl;
+
+		if (!match) {
+			printf("q%d spec: engine returned %d groups, hardcoded query %d groups\n", query, (int) spec_rows.size(), (int) query_rows.size());
+			printDifference(spec_rows, query_rows, "hardcoded query");
+		}
+	}
+
+	printf("Regression %s\n", pass ? "passed" : "FAILED");
+
+	delete qp;
+	delete cgp;
+
+	return pass ? 0 : 1;
+}
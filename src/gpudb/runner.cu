@@ -0,0 +1,426 @@
+#include "QueryProcessing.h"
+#include "QueryOptimizer.h"
+#include "CPUGPUProcessing.h"
+#include "CacheManager.h"
+#include "CPUProcessing.h"
+#include "CostModel.h"
+
+//Non-interactive workload runner. Every option can be given on the command line as
+//--key=value or in a config file (one key=value per line, # starts a comment):
+//
+//  queries=50          queries per epoch
+//  epochs=20           replacement runs after every epoch
+//  warmup=100          queries before the first replacement (not measured)
+//  mix=11,21,31        queries to draw from (empty: all 13 SSB queries)
+//  spec=               file of star-join queries, one per line (see QuerySpec.h), numbered 101, 102, ... and
+//                      added to the mix (an empty mix draws from them only)
+//  dist=None           None, Zipf or Norm
+//  alpha=1.0           Zipf skew
+//  policy=SemanticAware
+//  plan=v1             v1, v2 or best (run both plans and keep the faster, like main.bin)
+//  concurrency=1       client threads issuing queries, each on its own engine over the shared cache
+//  half_life=0         continuous decay of segment statistics (0: decay per epoch)
+//  bandwidth=-1        background replacement in MB/s (negative: synchronous)
+//  skipping=0
+//  radix_mb=32         CPU hash tables above this size are probed radix-partitioned (0: never)
+//  positional=1        CPU joins on dense dimension keys probe by position instead of by hash
+//  perf=0              per-operator hardware counters, written to <output>.perf.csv
+//  ingest=             directory of lineorder column files (LINEORDER<i>) appended while the epochs run
+//  ingest_batch=1048576 rows per append
+//  ingest_ms=100       pause between appends
+//  trace=              timeline of the measured epochs as Chrome trace JSON (needs make TRACE=1)
+//  format=json         json or csv
+//  output=runner.json  result file (-: stdout, mixed with the log of the engine)
+
+struct RunnerConfig {
+	int queries = 50;
+	int epochs = 20;
+	int warmup = 100;
+	vector<int> mix;
+	string spec = "";
+	string dist = "None";
+	double alpha = 1.0;
+	string policy = "SemanticAware";
+	string plan = "v1";
+	int concurrency = 1;
+	double half_life = 0;
+	double bandwidth = -1;
+	bool skipping = false;
+	double radix_mb = RADIX_PROBE_THRESHOLD / 1048576.0;
+	bool positional = POSITIONAL_JOIN;
+	bool perf = false;
+	string ingest = "";
+	int ingest_batch = SEGMENT_SIZE;
+	double ingest_ms = 100;
+	string trace = "";
+	string format = "json";
+	string output = "";
+};
+
+struct QuerySample {
+	int query;
+	int epoch;
+	double latency; //ms, from submission to completion
+	double execution, optimization, merging; //ms, breakdown from CPUGPUProcessing
+	unsigned long long cpu_to_gpu, gpu_to_cpu; //bytes
+};
+
+void setOption(RunnerConfig& cfg, string key, string value) {
+	if (key == "queries") cfg.queries = stoi(value);
+	else if (key == "epochs") cfg.epochs = stoi(value);
+	else if (key == "warmup") cfg.warmup = stoi(value);
+	else if (key == "spec") cfg.spec = value;
+	else if (key == "dist") cfg.dist = value;
+	else if (key == "alpha") cfg.alpha = stod(value);
+	else if (key == "policy") cfg.policy = value;
+	else if (key == "plan") cfg.plan = value;
+	else if (key == "concurrency") cfg.concurrency = max(stoi(value), 1);
+	else if (key == "half_life") cfg.half_life = stod(value);
+	else if (key == "bandwidth") cfg.bandwidth = stod(value);
+	else if (key == "skipping") cfg.skipping = stoi(value);
+	else if (key == "radix_mb") cfg.radix_mb = stod(value);
+	else if (key == "positional") cfg.positional = stoi(value);
+	else if (key == "perf") cfg.perf = stoi(value);
+	else if (key == "ingest") cfg.ingest = value;
+	else if (key == "ingest_batch") cfg.ingest_batch = max(stoi(value), 1);
+	else if (key == "ingest_ms") cfg.ingest_ms = stod(value);
+	else if (key == "trace") cfg.trace = value;
+	else if (key == "format") cfg.format = value;
+	else if (key == "output") cfg.output = value;
+	else if (key == "mix") {
+		cfg.mix.clear();
+		stringstream ss(value);
+		string q;
+		while (getline(ss, q, ',')) if (!q.empty()) cfg.mix.push_back(stoi(q));
+	} else {
+		fprintf(stderr, "Unknown option %s\n", key.c_str());
+		exit(1);
+	}
+}
+
+void readConfig(RunnerConfig& cfg, string filename) {
+	ifstream file(filename.c_str());
+	if (!file) {
+		fprintf(stderr, "Could not open config %s\n", filename.c_str());
+		exit(1);
+	}
+	string line;
+	while (getline(file, line)) {
+		line = line.substr(0, line.find('#'));
+		size_t eq = line.find('=');
+		if (eq == string::npos) continue;
+		string key = line.substr(0, eq), value = line.substr(eq + 1);
+		key.erase(remove_if(key.begin(), key.end(), ::isspace), key.end());
+		value.erase(remove_if(value.begin(), value.end(), ::isspace), value.end());
+		setOption(cfg, key, value);
+	}
+}
+
+//lineorder columns of the ingest directory, in the order of CacheManager::appendLineorder
+vector<vector<int>> readIngest(CacheManager* cm, string dir) {
+	vector<vector<int>> columns;
+	for (int i = 0; i < cm->columns_in_table[0].size(); i++) {
+		string filename = dir + "/" + lookup(cm->allColumn[cm->columns_in_table[0][i]]->column_name);
+		ifstream file(filename.c_str(), ios::in | ios::binary | ios::ate);
+		if (!file) {
+			fprintf(stderr, "Could not open %s\n", filename.c_str());
+			exit(1);
+		}
+		columns.push_back(vector<int>(file.tellg() / sizeof(int)));
+		file.seekg(0);
+		file.read((char*) columns.back().data(), columns.back().size() * sizeof(int));
+	}
+	return columns;
+}
+
+//registers the queries of a spec file and returns their ids
+vector<int> readSpec(QueryOptimizer* qo, string filename) {
+	ifstream file(filename.c_str());
+	if (!file) {
+		fprintf(stderr, "Could not open spec %s\n", filename.c_str());
+		exit(1);
+	}
+	vector<int> ids;
+	string line;
+	while (getline(file, line)) {
+		line = line.substr(0, line.find('#'));
+		if (all_of(line.begin(), line.end(), ::isspace)) continue;
+		int query = qo->addQuerySpec(line);
+		if (query < 0) exit(1);
+		cout << "Query " << query << ": " << line << endl;
+		ids.push_back(query);
+	}
+	return ids;
+}
+
+double percentile(vector<double> v, double p) {
+	if (v.empty()) return 0;
+	sort(v.begin(), v.end());
+	size_t rank = (size_t) ceil(p / 100 * v.size());
+	return v[rank > 0 ? rank - 1 : 0];
+}
+
+//runs one query with the configured plan and returns its breakdown
+QuerySample runOne(QueryProcessing* qp, CPUGPUProcessing* cgp, string plan) {
+	QuerySample best;
+	double best_time = -1;
+	for (int v = 1; v <= 2; v++) {
+		if ((plan == "v1" && v == 2) || (plan == "v2" && v == 1)) continue;
+		double time = (v == 1) ? qp->processQuery(false) : qp->processQuery2();
+		if (best_time < 0 || time < best_time) {
+			best_time = time;
+			best.execution = cgp->execution_total;
+			best.optimization = cgp->optimization_total;
+			best.merging = cgp->merging_total;
+			best.cpu_to_gpu = cgp->cpu_to_gpu_total;
+			best.gpu_to_cpu = cgp->gpu_to_cpu_total;
+		}
+		cgp->resetTime();
+	}
+	best.query = qp->query;
+	return best;
+}
+
+void summary(ostream& out, vector<QuerySample>& samples, string indent, bool more) {
+	vector<double> latency;
+	double execution = 0, optimization = 0, merging = 0;
+	unsigned long long cpu_to_gpu = 0, gpu_to_cpu = 0;
+	for (int i = 0; i < samples.size(); i++) {
+		latency.push_back(samples[i].latency);
+		execution += samples[i].execution; optimization += samples[i].optimization; merging += samples[i].merging;
+		cpu_to_gpu += samples[i].cpu_to_gpu; gpu_to_cpu += samples[i].gpu_to_cpu;
+	}
+	out << indent << "\"queries\": " << samples.size() << "," << endl;
+	out << indent << "\"latency_ms\": {\"p50\": " << percentile(latency, 50) << ", \"p95\": " << percentile(latency, 95)
+		<< ", \"p99\": " << percentile(latency, 99) << ", \"max\": " << percentile(latency, 100) << "}," << endl;
+	out << indent << "\"execution_ms\": " << execution << ", \"optimization_ms\": " << optimization << ", \"merging_ms\": " << merging << "," << endl;
+	out << indent << "\"cpu_to_gpu_bytes\": " << cpu_to_gpu << ", \"gpu_to_cpu_bytes\": " << gpu_to_cpu << (more ? "," : "") << endl;
+}
+
+int main(int argc, char** argv) {
+
+	RunnerConfig cfg;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare(0, 2, "--") != 0 || arg.find('=') == string::npos) {
+			fprintf(stderr, "Usage: %s [--config=file] [--key=value ...]\n", argv[0]);
+			return 1;
+		}
+		string key = arg.substr(2, arg.find('=') - 2), value = arg.substr(arg.find('=') + 1);
+		if (key == "config") readConfig(cfg, value);
+		else setOption(cfg, key, value);
+	}
+
+	cudaSetDevice(0);
+
+	srand(123);
+
+	size_t size = 52428800 * 20; //200 MB
+	size_t processing = 52428800 * 10; //400MB
+	size_t pinned = 52428800 * 10; //400MB
+
+	CPUGPUProcessing* cgp = new CPUGPUProcessing(size, processing, pinned, false, true, cfg.skipping);
+	cgp->qo->skipping = cfg.skipping;
+	cgp->qo->radix_probe_threshold = cfg.radix_mb * 1024 * 1024;
+	cgp->qo->positional_join = cfg.positional;
+
+	Distribution dist = None;
+	if (cfg.dist == "Zipf") dist = Zipf;
+	else if (cfg.dist == "Norm") dist = Norm;
+
+	if (!cfg.spec.empty()) {
+		vector<int> ids = readSpec(cgp->qo, cfg.spec);
+		cfg.mix.insert(cfg.mix.end(), ids.begin(), ids.end());
+	}
+
+	//one engine per client: its own optimizer, plan state and processing arenas over the cache of the first one
+	vector<CPUGPUProcessing*> client_cgp = {cgp};
+	vector<QueryProcessing*> client_qp;
+	for (int c = 1; c < cfg.concurrency; c++) {
+		CPUGPUProcessing* engine = new CPUGPUProcessing(cgp->cm, false, true, cfg.skipping);
+		engine->qo->skipping = cfg.skipping;
+		engine->qo->radix_probe_threshold = cgp->qo->radix_probe_threshold;
+		engine->qo->positional_join = cfg.positional;
+		for (map<int, QuerySpec*>::iterator it = cgp->qo->specs.begin(); it != cgp->qo->specs.end(); it++) {
+			engine->qo->addQuerySpec(it->second->text);
+		}
+		client_cgp.push_back(engine);
+	}
+	for (int c = 0; c < client_cgp.size(); c++) {
+		QueryProcessing* client = new QueryProcessing(client_cgp[c], false, dist);
+		if (dist == Zipf) client->qo->setDistributionZipfian(cfg.alpha);
+		else if (dist == Norm) client->qo->setDistributionNormal(1, 0.5);
+		client_qp.push_back(client);
+	}
+	QueryProcessing* qp = client_qp[0];
+
+	ReplacementPolicy repl_policy = parsePolicy(cfg.policy);
+	cgp->cm->setHalfLife(cfg.half_life);
+	if (cfg.bandwidth >= 0) cgp->cm->startMigration(cfg.bandwidth * 1024 * 1024);
+
+	//a query id from the mix, or from the configured distribution if there is no mix
+	auto nextQuery = [&] (QueryProcessing* qp) {
+		if (cfg.mix.empty()) qp->generate_rand_query();
+		else qp->setQuery(cfg.mix[rand() % cfg.mix.size()]);
+	};
+
+	for (int i = 0; i < cfg.warmup; i++) {
+		nextQuery(qp);
+		qp->processQuery(false);
+		cgp->resetTime();
+	}
+	if (cfg.warmup > 0) cgp->cm->runReplacement(repl_policy);
+
+	if (cfg.perf) {
+		PerfCounters::reset();
+		PerfCounters::enable(true);
+	}
+
+#ifdef MORDRED_TRACE
+	if (!cfg.trace.empty()) {
+		QueryTrace::instance().clear();
+		QueryTrace::enable(true);
+	}
+#else
+	if (!cfg.trace.empty()) fprintf(stderr, "Tracing is not compiled in, rebuild with make TRACE=1\n");
+#endif
+
+	vector<QuerySample> samples;
+	unsigned long long repl_traffic = 0;
+	if (cgp->cm->migration != NULL) cgp->cm->migration->traffic = 0;
+	double mean = 1;
+
+	//rows are appended in the background, each query sees the lineorder rows published when it started
+	vector<vector<int>> ingest_columns;
+	size_t ingest_len = 0;
+	if (!cfg.ingest.empty()) {
+		ingest_columns = readIngest(cgp->cm, cfg.ingest);
+		ingest_len = ingest_columns[0].size();
+		for (int i = 1; i < ingest_columns.size(); i++) ingest_len = min(ingest_len, ingest_columns[i].size());
+	}
+	atomic<bool> ingest_stop(false);
+	size_t ingested = 0;
+	thread ingest_thread([&] {
+		while (!ingest_stop && ingested < ingest_len) {
+			vector<int*> rows;
+			for (int i = 0; i < ingest_columns.size(); i++) rows.push_back(ingest_columns[i].data() + ingested);
+			int appended = cgp->cm->appendLineorder(rows.data(), min((size_t) cfg.ingest_batch, ingest_len - ingested));
+			if (appended == 0) break; //the reserved segments are full
+			ingested += appended;
+			this_thread::sleep_for(chrono::duration<double, milli>(cfg.ingest_ms));
+		}
+	});
+
+	//the clients run their queries concurrently on their own engines, they only share the cache,
+	//its statistics and the processing memory pools
+	mutex samples_lock;
+	chrono::high_resolution_clock::time_point run_start = chrono::high_resolution_clock::now();
+
+	for (int epoch = 0; epoch < cfg.epochs; epoch++) {
+		atomic<int> issued(0);
+		vector<thread> clients;
+		for (int c = 0; c < cfg.concurrency; c++) {
+			clients.push_back(thread([&, c] {
+				while (issued++ < cfg.queries) {
+					chrono::high_resolution_clock::time_point submit = chrono::high_resolution_clock::now();
+					nextQuery(client_qp[c]);
+					QuerySample sample = runOne(client_qp[c], client_cgp[c], cfg.plan);
+					sample.epoch = epoch;
+					sample.latency = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - submit).count();
+					unique_lock<mutex> lock(samples_lock);
+					samples.push_back(sample);
+				}
+			}));
+		}
+		for (int c = 0; c < clients.size(); c++) clients[c].join();
+
+		if (cgp->cm->migration != NULL) cgp->cm->runReplacementAsync(repl_policy);
+		else cgp->cm->runReplacement(repl_policy, &repl_traffic);
+		if (cgp->cm->half_life == 0) {
+			if (repl_policy == Segmented || repl_policy == LFUSegmented) cgp->cm->newEpoch(0.5);
+			if (repl_policy == LRU2Segmented) cgp->cm->newEpoch(2.0);
+		}
+
+		//shift the hot range every 5 epochs, as in main.bin
+		if (dist == Norm && (epoch + 1) % 5 == 0) {
+			if (epoch == 4) mean = 4;
+			else if (epoch == 9) mean = 2;
+			else if (epoch == 14) mean = 5;
+			for (int c = 0; c < client_qp.size(); c++) client_qp[c]->qo->setDistributionNormal(mean, 0.5);
+		}
+	}
+
+	ingest_stop = true;
+	ingest_thread.join();
+
+	if (cgp->cm->migration != NULL) {
+		cgp->cm->migration->wait();
+		repl_traffic = cgp->cm->migration->traffic;
+	}
+	double wall = chrono::duration<double>(chrono::high_resolution_clock::now() - run_start).count();
+
+	if (cfg.output == "") cfg.output = "runner." + cfg.format;
+	ofstream file;
+	if (cfg.output != "-") file.open(cfg.output.c_str());
+	ostream& out = (cfg.output != "-") ? file : cout;
+
+	if (cfg.format == "csv") {
+		out << "epoch,queries,throughput_qps,p50_ms,p95_ms,p99_ms,max_ms,execution_ms,optimization_ms,merging_ms,cpu_to_gpu_bytes,gpu_to_cpu_bytes" << endl;
+		for (int epoch = -1; epoch < cfg.epochs; epoch++) {
+			vector<double> latency;
+			double execution = 0, optimization = 0, merging = 0, busy = 0;
+			unsigned long long cpu_to_gpu = 0, gpu_to_cpu = 0;
+			for (int i = 0; i < samples.size(); i++) {
+				if (epoch >= 0 && samples[i].epoch != epoch) continue;
+				latency.push_back(samples[i].latency);
+				execution += samples[i].execution; optimization += samples[i].optimization; merging += samples[i].merging;
+				cpu_to_gpu += samples[i].cpu_to_gpu; gpu_to_cpu += samples[i].gpu_to_cpu;
+			}
+			//the total row uses wall time, the epoch rows the time spent in their queries
+			busy = (epoch < 0) ? wall : (execution + optimization + merging) / 1000;
+			out << (epoch < 0 ? string("all") : to_string(epoch)) << "," << latency.size() << "," << (busy > 0 ? latency.size() / busy : 0) << ","
+				<< percentile(latency, 50) << "," << percentile(latency, 95) << "," << percentile(latency, 99) << "," << percentile(latency, 100) << ","
+				<< execution << "," << optimization << "," << merging << "," << cpu_to_gpu << "," << gpu_to_cpu << endl;
+		}
+	} else {
+		out << "{" << endl;
+		out << "  \"config\": {\"queries\": " << cfg.queries << ", \"epochs\": " << cfg.epochs << ", \"warmup\": " << cfg.warmup
+			<< ", \"dist\": \"" << cfg.dist << "\", \"alpha\": " << cfg.alpha << ", \"policy\": \"" << cfg.policy
+			<< "\", \"plan\": \"" << cfg.plan << "\", \"concurrency\": " << cfg.concurrency << ", \"half_life\": " << cfg.half_life
+			<< ", \"bandwidth\": " << cfg.bandwidth << ", \"skipping\": " << cfg.skipping << ", \"radix_mb\": " << cfg.radix_mb << ", \"positional\": " << cfg.positional << ", \"SF\": " << SF << "}," << endl;
+		out << "  \"wall_time_s\": " << wall << "," << endl;
+		out << "  \"throughput_qps\": " << (wall > 0 ? samples.size() / wall : 0) << "," << endl;
+		out << "  \"replacement_traffic_bytes\": " << repl_traffic << "," << endl;
+		out << "  \"ingested_rows\": " << ingested << ", \"lineorder_rows\": " << cgp->cm->lo_orderdate->LEN << "," << endl;
+		summary(out, samples, "  ", true);
+		out << "  \"epochs\": [" << endl;
+		for (int epoch = 0; epoch < cfg.epochs; epoch++) {
+			vector<QuerySample> epoch_samples;
+			for (int i = 0; i < samples.size(); i++) if (samples[i].epoch == epoch) epoch_samples.push_back(samples[i]);
+			out << "    {\"epoch\": " << epoch << "," << endl;
+			summary(out, epoch_samples, "     ", false);
+			out << "    }" << (epoch + 1 < cfg.epochs ? "," : "") << endl;
+		}
+		out << "  ]" << endl;
+		out << "}" << endl;
+	}
+
+	if (PerfCounters::enabled) {
+		ofstream perf_file((cfg.output == "-" ? string("runner") : cfg.output) + ".perf.csv");
+		PerfCounters::report(perf_file);
+	}
+
+#ifdef MORDRED_TRACE
+	if (QueryTrace::enabled()) {
+		QueryTrace::enable(false);
+		QueryTrace::instance().exportJSON(cfg.trace);
+	}
+#endif
+
+	for (int c = client_qp.size() - 1; c >= 0; c--) {
+		delete client_qp[c];
+		delete client_cgp[c]; //the first engine owns the cache and goes last
+	}
+
+	return 0;
+}
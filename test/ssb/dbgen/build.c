@@ -47,11 +47,11 @@ static void gen_phone PROTO((long ind, char *target, long seed));
 
 #ifdef SSBM
 static void gen_category PROTO((char *target, long seed));
-int gen_city PROTO((char *cityName, char *nationName));
+int gen_city PROTO((char *cityName, char *nationName, long seed));
 int gen_season PROTO((char * dest,int month,int day));
 int is_last_day_in_month PROTO((int year,int month,int day));
 int gen_holiday_fl PROTO((char * dest, int month, int day));
-int gen_city PROTO((char *cityName, char *nationName));
+int gen_city PROTO((char *cityName, char *nationName, long seed));
 int gen_color PROTO((char * source, char * dest));
 #endif
 
@@ -106,7 +106,7 @@ long mk_cust(long n_cust, customer_t *c)
     RANDOM(i, 0, nations.count-1, C_NTRG_SD);
 	strcpy(c->nation_name,nations.list[i].text);
 	strcpy(c->region_name,regions.list[nations.list[i].weight].text);
-	gen_city(c->city,c->nation_name);
+	gen_city(c->city,c->nation_name,C_CITY_SD);
 	gen_phone(i, c->phone, (long)C_PHNE_SD);
         pick_str(&c_mseg_set, C_MSEG_SD, c->mktsegment);
 	return (0);
@@ -479,8 +479,8 @@ mk_supp(long index, supplier_t *s)
 	RANDOM(i, 0, nations.count-1, S_NTRG_SD);
 	strcpy(s->nation_name,nations.list[i].text);
         strcpy(s->region_name,regions.list[nations.list[i].weight].text);
-	gen_city(s->city,s->nation_name);
-	gen_phone(i, s->phone, (long)C_PHNE_SD);
+	gen_city(s->city,s->nation_name,S_CITY_SD);
+	gen_phone(i, s->phone, (long)S_PHNE_SD);
 	return (0);
 }
 #else
@@ -596,7 +596,7 @@ mk_time(long index, dss_time_t *t)
 
 #ifdef SSBM
 		/*bug!*/
-int gen_city(char *cityName, char *nationName){
+int gen_city(char *cityName, char *nationName, long seed){
     int i=0;
     long randomPick;
 	int clen = strlen(cityName);
@@ -608,7 +608,7 @@ int gen_city(char *cityName, char *nationName){
       for(i = nlen ; i< CITY_FIX-1;i++)
         cityName[i] = ' ';
     }
-    RANDOM(randomPick, 0, 9, 98);
+    RANDOM(randomPick, 0, 9, seed);
     
     sprintf(cityName+CITY_FIX-1,"%d",randomPick);
     cityName[CITY_FIX] = '\0';
@@ -130,11 +130,23 @@ int pr_region (code_t * c, int mode);
 int ld_cust (customer_t * c, int mode);
 int ld_part (part_t * p, int mode);
 int ld_supp (supplier_t * s, int mode);
+int ld_date (date_t * d, int mode);
 
 /*todo: get rid of ld_order*/
 int ld_line (order_t * o, int mode);
 int ld_order (order_t * o, int mode);
 
+/* columnar output of -D, see load_columnar.c */
+void part_direct (int tbl, int s);
+void done_direct (int tbl);
+void merge_direct (int tbl, int children);
+
+/*
+ * set_state() cannot split PART, whose row count grows with log2(scale),
+ * or DATE, which has no seeds; -D generates them in a single process
+ */
+#define SERIAL_DIRECT(t)	(direct && ((t) == PART || (t) == DATE))
+
 #else
 int ld_cust (customer_t * c, int mode);
 int ld_line (order_t * o, int mode);
@@ -608,6 +620,10 @@ partial (int tbl, int s)
 	
 	if (direct == 0)
 		set_files (tbl, s);
+#ifdef SSBM
+	else
+		part_direct (tbl, s);
+#endif
 	
 	rowcnt = set_state(tbl, scale, children, s, &extra);
 
@@ -684,6 +700,10 @@ pload (int tbl)
 		c--;
 	}
 
+#ifdef SSBM
+	if (direct)
+		merge_direct (tbl, children);
+#endif
 	if (verbose > 0)
 		fprintf (stderr, "done\n");
 	return (0);
@@ -1071,7 +1091,22 @@ main (int ac, char **av)
 	for (i = PART; i <= REGION; i++)
 		if (table & (1 << i))
 		{
+#ifdef SSBM
+			if (SERIAL_DIRECT(i) && children > 1 && step > 1)
+			{
+				/* DATE rows advance the ORDER seeds that lineorder draws from */
+				if (i == DATE)
+				{
+					part_direct (i, -1);
+					gen_tbl (i, 1, tdefs[i].base, upd_num);
+					done_direct (i);
+				}
+				continue;
+			}
+			if (children > 1 && i < NATION && !SERIAL_DIRECT(i))
+#else
 			if (children > 1 && i < NATION)
+#endif
 				if (step >= 0)
 				{
 					if (validate)
@@ -1118,6 +1153,10 @@ main (int ac, char **av)
 						fprintf (stderr, "%s data for %s [pid: %ld]",
 						(validate)?"Validating":"Generating", tdefs[i].comment, DSS_PROC);
 					gen_tbl (i, minrow, rowcnt, upd_num);
+#ifdef SSBM
+					if (direct)
+						done_direct (i);
+#endif
 					if (verbose > 0)
 						fprintf (stderr, "done.\n");
 				}
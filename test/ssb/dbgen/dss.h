@@ -427,7 +427,7 @@ extern tdef tdefs[];
 #define  ENDDATE      98365
 #define  TOTDATE      2557
 #define  UPD_PCT      10
-#define  MAX_STREAM   47
+#define  MAX_STREAM   49
 #define  V_STR_LOW    0.4
 #define  PENNIES    100 /* for scaled int money arithmetic */
 #define  Q11_FRACTION (double)0.0001
@@ -589,6 +589,8 @@ sprintf(tgt, "19%02d-%02d-%02d", yr, mn, dy)
 #define  BBB_TYPE_SD   45         
 #define  BBB_CMNT_SD   46         
 #define  BBB_OFFSET_SD 47         
+#define  C_CITY_SD 48
+#define  S_CITY_SD 49
 
 #endif            /* DSS_H */
 
@@ -0,0 +1,398 @@
+/*****************************************************************
+ *  Title:      load_columnar.c
+ *  Description:
+ *              inline load (-D) of the SSBM tables into the binary
+ *              columnar layout of Mordred
+ *
+ *  Every generated row is written straight into <TABLE><i> under
+ *  DSS_PATH, one file per column, with the same contents that
+ *  dbgen, convert.py and test/ssb/loader produce over .tbl files:
+ *  integers as 4 bytes, strings zero-padded to the widths of
+ *  test/ssb/loader/include/schema.h, and city, nation, region,
+ *  mfgr, category and brand dictionary encoded as in convert.py.
+ *
+ *  With -C <n> every child writes its row range to <TABLE><i>.<step>
+ *  and the parent appends the parts in step order (merge_direct),
+ *  which gives the rows of a single process run. With -S <step>
+ *  the part files are left for the caller to append; PART and DATE
+ *  are always generated whole, by step 1, and the other steps still
+ *  generate DATE for its seeds (it shares its table id with ORDER).
+ *****************************************************************
+ */
+#ifdef SSBM
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "config.h"
+#include "dss.h"
+#include "dsstypes.h"
+
+#define COL_MAX		17
+#define COL_BUF		(1 << 20)	/* bytes buffered per column */
+
+typedef struct
+{
+	char	*name;
+	int		ncols;
+	int		width[COL_MAX];		/* 0: int */
+	int		fd[COL_MAX];
+	char	*buf[COL_MAX];
+	long	fill[COL_MAX];
+	int		step;				/* part written by a child, 0: whole table */
+} col_table_t;
+
+static col_table_t col_tables[] =
+{
+	{"PART", 9, {0, 22, 0, 0, 0, 11, 25, 0, 10}},
+	{NULL},
+	{"SUPPLIER", 7, {0, 25, 25, 0, 0, 0, 15}},
+	{"CUSTOMER", 8, {0, 25, 25, 0, 0, 0, 15, 10}},
+	{"DDATE", 17, {0, 18, 8, 9, 0, 0, 7, 0, 0, 0, 0, 0, 12, 1, 1, 1, 1}},
+	{"LINEORDER", 17, {0, 0, 0, 0, 0, 0, 16, 1, 0, 0, 0, 0, 0, 0, 0, 0, 10}},
+};
+
+/* dictionaries of convert.py */
+static char *col_nations[] =
+{
+	"ALGERIA", "ARGENTINA", "BRAZIL", "CANADA", "EGYPT", "ETHIOPIA", "FRANCE",
+	"GERMANY", "INDIA", "INDONESIA", "IRAN", "IRAQ", "JAPAN", "JORDAN", "KENYA",
+	"MOROCCO", "MOZAMBIQUE", "PERU", "CHINA", "ROMANIA", "SAUDI ARABIA",
+	"VIETNAM", "RUSSIA", "UNITED KINGDOM", "UNITED STATES"
+};
+
+static char *col_regions[] =
+{
+	"AFRICA", "AMERICA", "ASIA", "EUROPE", "MIDDLE EAST"
+};
+
+static int
+dict_index(char **dict, int n, char *val)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (strcmp(dict[i], val) == 0)
+			return(i);
+	fprintf(stderr, "ERROR: '%s' is not in the dictionary\n", val);
+	exit(1);
+}
+
+/* the number after the '#' of MFGR#<n> */
+static int
+mfgr_num(char *s, int skip)
+{
+	char *p = strchr(s, '#');
+
+	return((p == NULL)?0:atoi(p + 1 + skip));
+}
+
+static void
+col_path(char *path, int len, col_table_t *t, int col, int step)
+{
+	if (step < 0)
+		snprintf(path, len, "/dev/null");
+	else if (step)
+		snprintf(path, len, "%s%c%s%d.%d", env_config(PATH_TAG, PATH_DFLT),
+			PATH_SEP, t->name, col, step);
+	else
+		snprintf(path, len, "%s%c%s%d", env_config(PATH_TAG, PATH_DFLT),
+			PATH_SEP, t->name, col);
+}
+
+static void
+col_write(int fd, char *buf, long len)
+{
+	long n;
+
+	while (len > 0)
+	{
+		n = write(fd, buf, len);
+		if (n <= 0)
+		{
+			perror("column write");
+			exit(1);
+		}
+		buf += n;
+		len -= n;
+	}
+}
+
+static void
+col_open(col_table_t *t)
+{
+	char path[1024];
+	int i;
+
+	for (i = 0; i < t->ncols; i++)
+	{
+		col_path(path, sizeof(path), t, i, t->step);
+		t->fd[i] = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (t->fd[i] < 0)
+		{
+			perror(path);
+			exit(1);
+		}
+		t->buf[i] = (char *)malloc(COL_BUF);
+		MALLOC_CHECK(t->buf[i]);
+		t->fill[i] = 0;
+	}
+}
+
+static void
+col_close(col_table_t *t)
+{
+	int i;
+
+	if (t->buf[0] == NULL)
+		return;
+	for (i = 0; i < t->ncols; i++)
+	{
+		col_write(t->fd[i], t->buf[i], t->fill[i]);
+		close(t->fd[i]);
+		free(t->buf[i]);
+		t->buf[i] = NULL;
+	}
+}
+
+static void
+col_put(col_table_t *t, int col, void *val, int len)
+{
+	if (t->fill[col] + len > COL_BUF)
+	{
+		col_write(t->fd[col], t->buf[col], t->fill[col]);
+		t->fill[col] = 0;
+	}
+	memcpy(t->buf[col] + t->fill[col], val, len);
+	t->fill[col] += len;
+}
+
+static void
+col_int(col_table_t *t, int col, long val)
+{
+	int v = (int)val;
+
+	col_put(t, col, &v, sizeof(int));
+}
+
+static void
+col_str(col_table_t *t, int col, char *val)
+{
+	char pad[32];
+	int w = t->width[col];
+	int len = strlen(val);
+
+	memset(pad, 0, w);
+	memcpy(pad, val, (len < w)?len:w);
+	col_put(t, col, pad, w);
+}
+
+static col_table_t *
+col_table(int tbl)
+{
+	col_table_t *t = &col_tables[tbl];
+
+	if (t->buf[0] == NULL)
+		col_open(t);
+	return(t);
+}
+
+int
+close_direct(void)
+{
+	int i;
+
+	for (i = 0; i <= LINE; i++)
+		if (col_tables[i].name != NULL)
+			col_close(&col_tables[i]);
+	return(0);
+}
+
+static void
+exit_direct(void)
+{
+	close_direct();
+}
+
+int
+prep_direct(char *dbname)
+{
+	/* the children of -C leave through exit() */
+	atexit(exit_direct);
+	return(0);
+}
+
+/* rows of this process go to the part files of step s, or nowhere if s < 0 */
+void
+part_direct(int tbl, int s)
+{
+	col_tables[tbl].step = s;
+}
+
+/* the table is complete, nothing may stay buffered across a fork */
+void
+done_direct(int tbl)
+{
+	col_close(&col_tables[tbl]);
+}
+
+/* append the parts of the children in step order */
+void
+merge_direct(int tbl, int children)
+{
+	col_table_t *t = &col_tables[tbl];
+	char path[1024];
+	int i, s, out, in;
+	ssize_t n;
+	char *buf;
+
+	buf = (char *)malloc(COL_BUF);
+	MALLOC_CHECK(buf);
+	for (i = 0; i < t->ncols; i++)
+	{
+		col_path(path, sizeof(path), t, i, 0);
+		out = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (out < 0)
+		{
+			perror(path);
+			exit(1);
+		}
+		for (s = 1; s <= children; s++)
+		{
+			col_path(path, sizeof(path), t, i, s);
+			in = open(path, O_RDONLY);
+			if (in < 0)
+			{
+				perror(path);
+				exit(1);
+			}
+#ifdef LINUX
+			while ((n = copy_file_range(in, NULL, out, NULL, 1 << 30, 0)) > 0)
+				;
+			if (n < 0)
+#endif
+				while ((n = read(in, buf, COL_BUF)) > 0)
+					col_write(out, buf, n);
+			close(in);
+			unlink(path);
+		}
+		close(out);
+	}
+	free(buf);
+}
+
+int
+ld_cust(customer_t *c, int mode)
+{
+	col_table_t *t = col_table(CUST);
+	int nation = dict_index(col_nations, 25, c->nation_name);
+
+	col_int(t, 0, c->custkey);
+	col_str(t, 1, c->name);
+	col_str(t, 2, c->address);
+	col_int(t, 3, nation * 10 + (c->city[strlen(c->city) - 1] - '0'));
+	col_int(t, 4, nation);
+	col_int(t, 5, dict_index(col_regions, 5, c->region_name));
+	col_str(t, 6, c->phone);
+	col_str(t, 7, c->mktsegment);
+	return(0);
+}
+
+int
+ld_supp(supplier_t *s, int mode)
+{
+	col_table_t *t = col_table(SUPP);
+	int nation = dict_index(col_nations, 25, s->nation_name);
+
+	col_int(t, 0, s->suppkey);
+	col_str(t, 1, s->name);
+	col_str(t, 2, s->address);
+	col_int(t, 3, nation * 10 + (s->city[strlen(s->city) - 1] - '0'));
+	col_int(t, 4, nation);
+	col_int(t, 5, dict_index(col_regions, 5, s->region_name));
+	col_str(t, 6, s->phone);
+	return(0);
+}
+
+int
+ld_part(part_t *p, int mode)
+{
+	col_table_t *t = col_table(PART);
+	int mfgr = mfgr_num(p->mfgr, 0) - 1;
+	int category = mfgr * 5 + (mfgr_num(p->category, 0) % 10) - 1;
+	int brand = category * 40 + mfgr_num(p->brand, 2) - 1;
+
+	col_int(t, 0, p->partkey);
+	col_str(t, 1, p->name);
+	col_int(t, 2, mfgr);
+	col_int(t, 3, category);
+	col_int(t, 4, brand);
+	col_str(t, 5, p->color);
+	col_str(t, 6, p->type);
+	col_int(t, 7, p->size);
+	col_str(t, 8, p->container);
+	return(0);
+}
+
+int
+ld_date(date_t *d, int mode)
+{
+	col_table_t *t = col_table(DATE);
+
+	col_int(t, 0, d->datekey);
+	col_str(t, 1, d->date);
+	col_str(t, 2, d->dayofweek);
+	col_str(t, 3, d->month);
+	col_int(t, 4, d->year);
+	col_int(t, 5, d->yearmonthnum);
+	col_str(t, 6, d->yearmonth);
+	col_int(t, 7, d->daynuminweek);
+	col_int(t, 8, d->daynuminmonth);
+	col_int(t, 9, d->daynuminyear);
+	col_int(t, 10, d->monthnuminyear);
+	col_int(t, 11, d->weeknuminyear);
+	col_str(t, 12, d->sellingseason);
+	col_str(t, 13, d->lastdayinweekfl);
+	col_str(t, 14, d->lastdayinmonthfl);
+	col_str(t, 15, d->holidayfl);
+	col_str(t, 16, d->weekdayfl);
+	return(0);
+}
+
+int
+ld_line(order_t *o, int mode)
+{
+	col_table_t *t;
+	lineorder_t *l;
+	char sprio[16];
+	long i;
+
+	for (i = 0; i < o->lines; i++)
+	{
+		t = col_table(LINE);
+		l = &o->lineorders[i];
+		sprintf(sprio, "%ld", l->ship_priority);
+
+		col_int(t, 0, *l->okey);
+		col_int(t, 1, l->linenumber);
+		col_int(t, 2, l->custkey);
+		col_int(t, 3, l->partkey);
+		col_int(t, 4, l->suppkey);
+		col_int(t, 5, atol(l->orderdate));
+		col_str(t, 6, l->opriority);
+		col_str(t, 7, sprio);
+		col_int(t, 8, l->quantity);
+		col_int(t, 9, l->extended_price);
+		col_int(t, 10, l->order_totalprice);
+		col_int(t, 11, l->discount);
+		col_int(t, 12, l->revenue);
+		col_int(t, 13, l->supp_cost);
+		col_int(t, 14, l->tax);
+		col_int(t, 15, atol(l->commit_date));
+		col_str(t, 16, l->shipmode);
+	}
+	return(0);
+}
+#endif /* SSBM */
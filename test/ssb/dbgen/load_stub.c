@@ -14,19 +14,23 @@
 #include "dss.h"
 #include "dsstypes.h"
 
+#ifndef SSBM
 int 
 close_direct(void)
 {
     /* any post load cleanup goes here */
     return(0);
 }
+#endif
 
+#ifndef SSBM
 int 
 prep_direct(void)
 {
     /* any preload prep goes here */
     return(0);
 }
+#endif
 
 int 
 hd_cust (FILE *f)
@@ -39,6 +43,7 @@ hd_cust (FILE *f)
     return(0);
 }
 
+#ifndef SSBM
 int 
 ld_cust (customer_t *cp, int mode)
 {
@@ -51,6 +56,7 @@ ld_cust (customer_t *cp, int mode)
 
     return(0);
 }
+#endif
 
 int 
 hd_part (FILE *f)
@@ -63,6 +69,7 @@ hd_part (FILE *f)
     return(0);
 }
 
+#ifndef SSBM
 int 
 ld_part (part_t *pp, int mode)
 {
@@ -73,6 +80,7 @@ ld_part (part_t *pp, int mode)
 
     return(0);
 }
+#endif
 
 int 
 ld_psupp (part_t *pp, int mode)
@@ -100,6 +108,7 @@ hd_supp (FILE *f)
     return(0);
 }
 
+#ifndef SSBM
 int 
 ld_supp (supplier_t *sp, int mode)
 {
@@ -112,6 +121,7 @@ ld_supp (supplier_t *sp, int mode)
 
     return(0);
 }
+#endif
 
 
 int 
@@ -138,6 +148,7 @@ ld_order (order_t *p, int mode)
     return(0);
 }
 
+#ifndef SSBM
 ld_line (order_t *p, int mode)
 {
     static int count = 0;
@@ -149,6 +160,7 @@ ld_line (order_t *p, int mode)
 
     return(0);
 }
+#endif
 
 
 
@@ -264,16 +276,6 @@ hd_part_psupp (FILE *f)
 }
 #endif
 
-#ifdef SSBM
-int
-ld_date (date_t *d, int mode)
-{
-    /*do nothing for now*/
-    return(0);
-}
-
-#endif
-
 
 
 
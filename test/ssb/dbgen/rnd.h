@@ -76,5 +76,7 @@ seed_t     Seed[MAX_STREAM + 1] =
     {SUPP,   263032577,  0, 1},      /* BBB offset   44 */
     {SUPP,   753643799,  0, 1},      /* BBB type     45 */
     {SUPP,   202794285,  0, 1},      /* BBB comment  46 */
-    {SUPP,   715851524,  0, 1}       /* BBB junk     47 */
+    {SUPP,   715851524,  0, 1},      /* BBB junk     47 */
+    {CUST,   1286950487, 0, 1},      /* C_CITY_SD    48 */
+    {SUPP,   1578463319, 0, 1}       /* S_CITY_SD    49 */
 };
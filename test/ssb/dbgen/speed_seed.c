@@ -261,6 +261,12 @@ sd_line(int child, long skip_count)
 		{
 		ADVANCE_STREAM(O_ODATE_SD, skip_count);
 		ADVANCE_STREAM(O_LCNT_SD, skip_count);
+#ifdef SSBM
+		/* lineorder carries the order columns as well */
+		ADVANCE_STREAM(O_CKEY_SD, skip_count);
+		ADVANCE_STREAM(O_PRIO_SD, skip_count);
+		ADVANCE_STREAM(O_CLRK_SD, skip_count);
+#endif
 		}
 		
 	return(0L);
@@ -302,6 +308,7 @@ sd_cust(int child, long skip_count)
    FAKE_V_STR(C_ADDR_LEN, C_ADDR_SD, skip_count);
    FAKE_V_STR(C_CMNT_LEN, C_CMNT_SD, skip_count);
    ADVANCE_STREAM(C_NTRG_SD, skip_count);
+   ADVANCE_STREAM(C_CITY_SD, skip_count);
    ADVANCE_STREAM(C_PHNE_SD, 3L * skip_count);
    ADVANCE_STREAM(C_ABAL_SD, skip_count);
    ADVANCE_STREAM(C_MSEG_SD, skip_count);
@@ -312,6 +319,7 @@ long
 sd_supp(int child, long skip_count)
 {
    ADVANCE_STREAM(S_NTRG_SD, skip_count);
+   ADVANCE_STREAM(S_CITY_SD, skip_count);
    ADVANCE_STREAM(S_PHNE_SD, 3L * skip_count);
    ADVANCE_STREAM(S_ABAL_SD, skip_count);
    FAKE_V_STR(S_ADDR_LEN, S_ADDR_SD, skip_count);
@@ -1,4 +1,4 @@
- 
+
 /*
    Copyright (c) 2012-2013 The Ohio State University.
 
@@ -15,317 +15,113 @@
    limitations under the License.
 */
 
+#define _GNU_SOURCE
 
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/mman.h>
-#include "include/common.h"
+#include "include/sortColumns.h"
 
 /*
  * @file columnSort.c
  * Sort foreign key columns in LINEORDER table.
+ *
+ * The rows are sorted on the key column, optionally followed by a second key
+ * column, see include/sortColumns.h.
  */
 
-struct sortObject{
-	int key;
-	int id;	
+struct columnKey{
+	const int *primary;
+	const int *secondary;
+	int primaryMin;
+	int secondaryMin;
+	int secondaryBits;
 };
 
-static void bubbleSort(struct sortObject *obj, int start,int num){
-
-	for(int i=start;i<start+num-1;i++){
-		struct sortObject tmp = obj[i];
-		int pos = i;
-		for(int j=i+1;j<start+num;j++){
-			if(obj[j].key < tmp.key){
-				tmp = obj[j];
-				pos = j;
-			}
-		}
-		obj[pos] = obj[i];
-		obj[i] = tmp;
-		
-	}
-}
-
-/*
- * start to middle-1(inclusive) is the first part
- * middle to end is the second part
- * start, middle, and end are all array indexes
- */
-
-static void mergeSort(struct sortObject *obj, int start, int middle, int end){
-
-	int firstNum = middle - start;
-	int secondNum = end - middle + 1;
-
-	if(firstNum > 1000){
-		int mid = firstNum/2;
-		mergeSort(obj, start, start+mid,middle-1);
-	}else{
-		bubbleSort(obj, start, firstNum);
-	}
-
-	if(secondNum > 1000){
-		int mid = secondNum /2;
-		mergeSort(obj, middle, middle+mid, end);
-	}else{
-		bubbleSort(obj, middle, secondNum);
-	}
-
-	struct sortObject * result = (struct sortObject *) malloc(sizeof(struct sortObject) * (end-start+1));
-	if(!result){
-		printf("Malloc failed in merge sort. Not enough memory.\n");
-		exit(-1);
-	}
-
-	int i,j,k;
-	for(i = start, j = middle, k=0; i<=middle-1 &&j<=end;){
-		if(obj[i].key < obj[j].key){
-			result[k++] = obj[i++];
-		}else{
-			result[k++] = obj[j++];
-		}
+/* the key is biased to start at 0 */
+static void buildKey(void *ctx, uint64_t *key, unsigned long start, unsigned long end){
+	struct columnKey *ck = (struct columnKey *) ctx;
+	for(unsigned long i = start; i < end; i++){
+		uint64_t k = (uint32_t) (ck->primary[i] - ck->primaryMin);
+		if(ck->secondary != NULL)
+			k = (k << ck->secondaryBits) | (uint32_t) (ck->secondary[i] - ck->secondaryMin);
+		key[i] = k;
 	}
-
-	while(i<=middle-1){
-		result[k++] = obj[i++];
-	}
-
-	while(j<=end)
-		result[k++] = obj[j++];
-
-	memcpy(&obj[start],result, sizeof(struct sortObject)*(end-start+1));
-
-	free(result);
-
-}
-
-static void primarySort(struct sortObject * obj, int num){
-	int start = 0, middle = num/2, end = num-1;
-
-	mergeSort(obj,start,middle,end);
-
 }
 
 /*
  * Input:
  * 	@inputPrefix: the name of the table to be sorted.
- * 	@inputPrefix: the name of the table after sorting.
+ * 	@outputPrefix: the name of the table after sorting.
  *	@index:	the index of the column that will be sorted.
- *	@columnNum: the total number of columns in the table.
- *  @columnSize: the size of the column.
+ *	@columnNum: the largest column index of the table.
+ *	@columnSize: the number of rows.
+ *	@secondIndex: optional, the column that orders rows with the same key (-1: none).
+ *	@threads: optional, worker threads (default: all online CPUs).
  *
  * Prerequisite:
- * 	The memory is large enough to hold each column.	
+ * 	The memory is large enough to hold 24 bytes per row, the columns are
+ * 	mapped and not loaded.
  */
 
 //	./columnSort ../data/s40_columnar/LINEORDER ../data/s40_columnar/LINEORDERSORT 5 16 240012412
 //	./columnSort ../data/s160_columnar/LINEORDER ../data/s160_columnar/LINEORDERSORT 5 16 960017453
+//	./columnSort ../data/s160_columnar/LINEORDER ../data/s160_columnar/LINEORDERSORT 5 16 960017453 2
 
 int main(int argc, char **argv){
 
-	if(argc != 6){
-		printf("./columnSort inputPrefix outputPrefix index columnNum columnSize\n");
+	if(argc < 6 || argc > 8){
+		printf("./columnSort inputPrefix outputPrefix index columnNum columnSize [secondIndex] [threads]\n");
 		exit(-1);
 	}
 
-	int inFd;
 	unsigned int primaryIndex, largestIndex, LEN;
-	// struct columnHeader header;
+	int secondIndex = -1;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
 
 	primaryIndex = atoi(argv[3]);
-	largestIndex = atoi(argv[4]); 
+	largestIndex = atoi(argv[4]);
 	LEN = atoi(argv[5]);
+	if(argc > 6)
+		secondIndex = atoi(argv[6]);
+	if(argc > 7)
+		threads = atoi(argv[7]);
 
-	char buf[32] = {0};
-
-	sprintf(buf,"%s%d",argv[1],primaryIndex);
-
-	inFd = open(buf, O_RDONLY);
-	if(inFd == -1){
-		printf("Failed to open the primaryIndex column\n");
-		exit(-1);
-	}
-
-	// read(inFd, &header ,sizeof(struct columnHeader));
-	// if(header.format != UNCOMPRESSED){
-	// 	printf("Cannot sort compressed data\n");
-	// 	printf("%d\n", header.format)
-	// 	exit(-1);
-	// }
-
-	// long size = header.totalTupleNum * sizeof(int);
-	// long tupleNum = header.totalTupleNum;
-	// int blockTotal = header.blockTotal;
-
-	unsigned long size = LEN * sizeof(int);
 	unsigned long tupleNum = LEN;
-	int blockTotal = 1;
+	struct timeval t0, t1, t2;
+	gettimeofday(&t0, NULL);
 
-	char * raw = (char *) malloc(size);
-	if(!raw){
-		printf("Malloc failed. Not enough memory\n");
-		exit(-1);
-	}
-
-	// long offset = sizeof(struct columnHeader);
-	unsigned long offset = 0;
-	unsigned long inOffset = 0;
-	// size = header.tupleNum * sizeof(int);
-	size = LEN * sizeof(int);
-
-	char *outTable =(char *) mmap(0,size,PROT_READ,MAP_SHARED,inFd, offset);
-
-	memcpy(raw + inOffset, outTable, size);
-   munmap(outTable,size);
-	// offset += size;
-	// inOffset += size;
-
-	// for(int i=1;i<blockTotal;i++){
-	// 	lseek(inFd, offset,SEEK_SET);
-
-	// 	read(inFd,&header,sizeof(struct columnHeader));
-	// 	offset += sizeof(struct columnHeader);
-	// 	size = header.tupleNum * sizeof(int); 
-	// 	outTable =(char *) mmap(0,size,PROT_READ,MAP_SHARED,inFd, offset);
-
-	// 	memcpy(raw + inOffset, outTable, size);
- //      munmap(outTable,size);
-
-	// 	offset += size;
-	// 	inOffset += size;
-	// }
-
-   close(inFd);
+	struct column *columns = mapTable(argv[1], largestIndex, tupleNum);
 
-	struct sortObject * obj = (struct sortObject *) malloc(sizeof(struct sortObject ) * tupleNum);
-
-	if(!obj){
-		printf("Malloc failed. Not enough memory!\n");
+	if(columns[primaryIndex].tupleSize != sizeof(int) || (secondIndex >= 0 && columns[secondIndex].tupleSize != sizeof(int))){
+		printf("Can only sort on integer columns\n");
 		exit(-1);
 	}
 
-	for(int i=0;i<tupleNum;i++){
-		obj[i].key = ((int *)raw)[i];
-		obj[i].id = i;
-	}
-
-	free(raw);
-
-	primarySort(obj,tupleNum);
-
-	printf("Sorting done\n");
-
-	for(int i=0;i<= largestIndex;i++){
-
-		printf("Writing %s%d\n",argv[1],i);
-		sprintf(buf,"%s%d",argv[1],i);
-		inFd = open(buf,O_RDONLY);
-		if(inFd == -1){
-			printf("Failed to open input column %d\n", i);
-			exit(-1);
-		}
-		size = lseek(inFd,0,SEEK_END);
-		// int tupleSize = (size - blockTotal*sizeof(struct columnHeader))/tupleNum;
-		// printf("%ld\n",size);
-		unsigned int tupleSize = size/tupleNum;
-
-		raw = (char *) malloc(size);
-		if(!raw){
-			printf("Malloc failed when trying to write the new result. Not enough memory !\n");
-			exit(-1);
-		}
-
-		inOffset = 0;
-		offset = 0;
-
-		// printf("hi\n");
-
-		// for(int j=0;j<blockTotal;j++){
-			lseek(inFd, offset, SEEK_SET);
-			// read(inFd, &header,sizeof(struct columnHeader));
-			// offset += sizeof(struct columnHeader);
-			// size = header.tupleNum * tupleSize;
-			size = LEN * tupleSize;
-			// printf("%d %d %ld\n",LEN, tupleSize, size);
-			outTable = (char *) mmap(0,size ,PROT_READ,MAP_SHARED,inFd, offset);
-			if (!outTable) {
-				printf ("Mmap failed!\n"); exit(-1);
-			}
-			// printf("ho\n");
-			memcpy(raw+inOffset, outTable,size);
-			// printf("ho\n");
-			munmap(outTable,size);
-			// printf("ho\n");
-
-			// offset += size;
-			// inOffset += size;
-		// }
-
-		
-
-		close(inFd);
-
-		sprintf(buf,"%s%d",argv[2],i);
-		int outFd = open(buf, O_RDWR|O_CREAT,S_IRWXU|S_IRUSR);
-		if(outFd == -1){
-			printf("Failed to create output column\n");
-			exit(-1);
-		}
-
-		// header.totalTupleNum = tupleNum;
-		// header.blockId = 0;
-		// header.blockTotal = blockTotal;
-		// header.format = UNCOMPRESSED;
-
-		long tupleUnit, tupleRemain, tupleCount;
-		tupleRemain = tupleNum;
-		tupleCount = 0;
-
-		if(tupleNum > BLOCKNUM)
-			tupleUnit = BLOCKNUM;
-		else
-			tupleUnit = tupleNum;
-
-		// header.tupleNum = tupleUnit;
-		// write(outFd, &header, sizeof(struct columnHeader));
-
-		for(int j=0;j<tupleNum;j++){
-
-			int writeHeader = 0;
-			tupleCount ++;
-
-			if(tupleCount > BLOCKNUM){
-				tupleCount = 1;
-				tupleRemain -= BLOCKNUM;
-				if(tupleRemain > BLOCKNUM)
-					tupleUnit = BLOCKNUM;
-				else
-					tupleUnit = tupleRemain;
-				// header.tupleNum = tupleUnit;
-				// header.blockId ++;
-				// writeHeader = 1;
-				writeHeader = 0;
-			}
-
-			if(writeHeader == 1){
-				// write(outFd,&header, sizeof(struct columnHeader));
-			}
-
-			int id = obj[j].id;
-			write(outFd, raw+id*tupleSize, tupleSize);
-		}
-
-		free(raw);
-		close(outFd);
-	}
+	const int *primary = (const int *) columns[primaryIndex].data;
+	const int *secondary = (secondIndex >= 0) ? (const int *) columns[secondIndex].data : NULL;
+	madvise(columns[primaryIndex].data, columns[primaryIndex].size, MADV_SEQUENTIAL);
+
+	int primaryMin, primaryMax, secondaryMin = 0, secondaryMax = 0;
+	minMax(primary, tupleNum, &primaryMin, &primaryMax);
+	if(secondary != NULL)
+		minMax(secondary, tupleNum, &secondaryMin, &secondaryMax);
+
+	struct columnKey ck;
+	ck.primary = primary;
+	ck.secondary = secondary;
+	ck.primaryMin = primaryMin;
+	ck.secondaryMin = secondaryMin;
+	ck.secondaryBits = bitsOf((uint32_t) (secondaryMax - secondaryMin));
+	int keyBits = bitsOf((uint32_t) (primaryMax - primaryMin)) + ck.secondaryBits;
+
+	printf("Sorting %lu rows on column %d", tupleNum, primaryIndex);
+	if(secondary != NULL)
+		printf(" then column %d", secondIndex);
+	printf(": ");
+	sortColumns(columns, largestIndex + 1, tupleNum, argv[2], keyBits, threads, buildKey, &ck);
+
+	gettimeofday(&t1, NULL);
+	unmapTable(columns, largestIndex + 1, tupleNum);
+	gettimeofday(&t2, NULL);
+	printf("Sorting done: sort and gather %.1f ms, unmap %.1f ms\n", timeDiff(&t0, &t1), timeDiff(&t1, &t2));
 
-	free(obj);
 	return 0;
 }
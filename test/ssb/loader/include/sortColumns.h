@@ -0,0 +1,333 @@
+/*
+    Copyright (c) 2012-2013 The Ohio State University.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __SSB_SORT_COLUMNS__
+#define __SSB_SORT_COLUMNS__
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "common.h"
+
+/*
+ * Reorders all columns of a table on a 64-bit key per row.
+ *
+ * A key builder fills the keys of a range of rows. The rows are sorted with
+ * a parallel LSD radix sort of (key, row id) pairs, 8 bits per pass and only
+ * over the key bits the caller asks for, and all columns are then permuted in
+ * one pass over the row ids: every thread takes a block of ids and gathers it
+ * from each input column into the mmaped output columns with non-temporal
+ * stores. Used by columnSort and zorderSort.
+ */
+
+#define RADIX_BITS	8
+#define RADIX_FANOUT	(1 << RADIX_BITS)
+#define GATHER_BLOCK	(64 * 1024)	/* rows per gather task, the ids stay in the cache across the columns */
+#define MAX_THREADS	256
+
+struct column{
+	char *data;	/* mmaped input */
+	char *out;	/* mmaped output */
+	unsigned long size;
+	unsigned int tupleSize;
+};
+
+/* fills key[start, end) */
+typedef void (*keyBuilder)(void *ctx, uint64_t *key, unsigned long start, unsigned long end);
+
+struct sortShared{
+	uint64_t *key[2];	/* ping-pong buffers */
+	uint32_t *id[2];
+	unsigned long tupleNum;
+	int passes;
+	int threads;
+	unsigned long hist[MAX_THREADS][RADIX_FANOUT];
+	pthread_barrier_t barrier;
+
+	keyBuilder build;
+	void *ctx;
+
+	struct column *columns;
+	int columnTotal;
+	unsigned long nextBlock;	/* gather blocks handed out so far */
+	int result;	/* buffer holding the sorted ids */
+};
+
+struct sortArg{
+	int tid;
+	struct sortShared *shared;
+};
+
+static double timeDiff(struct timeval *start, struct timeval *end){
+	return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_usec - start->tv_usec) / 1000.0;
+}
+
+static int bitsOf(uint64_t range){
+	int bits = 0;
+	while(bits < 64 && (range >> bits) != 0)
+		bits++;
+	return bits;
+}
+
+static void *mapColumn(const char *name, unsigned long *size){
+	int fd = open(name, O_RDONLY);
+	if(fd == -1){
+		printf("Failed to open %s\n", name);
+		exit(-1);
+	}
+	*size = lseek(fd, 0, SEEK_END);
+	void *data = mmap(0, *size, PROT_READ, MAP_SHARED, fd, 0);
+	if(data == MAP_FAILED){
+		printf("Mmap failed for %s\n", name);
+		exit(-1);
+	}
+	madvise(data, *size, MADV_RANDOM);
+	close(fd);
+	return data;
+}
+
+static void *createColumn(const char *name, unsigned long size){
+	int fd = open(name, O_RDWR|O_CREAT|O_TRUNC, S_IRWXU|S_IRUSR);
+	if(fd == -1){
+		printf("Failed to create output column %s\n", name);
+		exit(-1);
+	}
+	if(ftruncate(fd, size) != 0){
+		printf("Failed to resize output column %s\n", name);
+		exit(-1);
+	}
+	void *data = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if(data == MAP_FAILED){
+		printf("Mmap failed for %s\n", name);
+		exit(-1);
+	}
+	close(fd);
+	return data;
+}
+
+static void chunkOf(unsigned long n, int threads, int tid, unsigned long *start, unsigned long *end){
+	*start = n * tid / threads;
+	*end = n * (tid + 1) / threads;
+}
+
+static void minMax(const int *col, unsigned long n, int *min, int *max){
+	*min = col[0];
+	*max = col[0];
+	for(unsigned long i = 1; i < n; i++){
+		if(col[i] < *min) *min = col[i];
+		if(col[i] > *max) *max = col[i];
+	}
+}
+
+/*
+ * Maps prefix0 .. prefix<largestIndex> and derives the width of every column
+ * from its file size.
+ */
+static struct column *mapTable(const char *prefix, int largestIndex, unsigned long tupleNum){
+	char buf[4096];
+	struct column *columns = (struct column *) malloc(sizeof(struct column) * (largestIndex + 1));
+	CHECK_POINTER(columns);
+
+	for(int i = 0; i <= largestIndex; i++){
+		snprintf(buf, sizeof(buf), "%s%d", prefix, i);
+		columns[i].data = (char *) mapColumn(buf, &columns[i].size);
+		columns[i].tupleSize = columns[i].size / tupleNum;
+		columns[i].out = NULL;
+		if(columns[i].tupleSize == 0){
+			printf("Column %d has fewer than %lu rows\n", i, tupleNum);
+			exit(-1);
+		}
+	}
+	return columns;
+}
+
+static void gatherBlock(struct column *col, const uint32_t *id, unsigned long start, unsigned long end){
+	if(col->tupleSize == sizeof(int)){
+		const int *in = (const int *) col->data;
+		int *out = (int *) col->out;
+		for(unsigned long j = start; j < end; j++){
+#ifdef __SSE2__
+			_mm_stream_si32(out + j, in[id[j]]);
+#else
+			out[j] = in[id[j]];
+#endif
+		}
+	}else{
+		unsigned int w = col->tupleSize;
+		for(unsigned long j = start; j < end; j++)
+			memcpy(col->out + j * w, col->data + (unsigned long) id[j] * w, w);
+	}
+}
+
+static void *sortThread(void *param){
+	struct sortArg *arg = (struct sortArg *) param;
+	struct sortShared *sh = arg->shared;
+	int tid = arg->tid;
+	unsigned long start, end;
+	chunkOf(sh->tupleNum, sh->threads, tid, &start, &end);
+
+	uint32_t *id = sh->id[0];
+	sh->build(sh->ctx, sh->key[0], start, end);
+	for(unsigned long i = start; i < end; i++)
+		id[i] = i;
+
+	int src = 0;
+	for(int pass = 0; pass < sh->passes; pass++){
+		int shift = pass * RADIX_BITS;
+		unsigned long *hist = sh->hist[tid];
+		unsigned long offset[RADIX_FANOUT];
+		const uint64_t *inKey = sh->key[src];
+		const uint32_t *inId = sh->id[src];
+
+		memset(hist, 0, sizeof(sh->hist[tid]));
+		for(unsigned long i = start; i < end; i++)
+			hist[(inKey[i] >> shift) & (RADIX_FANOUT - 1)]++;
+
+		pthread_barrier_wait(&sh->barrier);
+
+		/* digit-major, thread-minor offsets keep the sort stable */
+		unsigned long sum = 0;
+		int single = 0;
+		for(int d = 0; d < RADIX_FANOUT; d++){
+			unsigned long total = 0;
+			for(int t = 0; t < sh->threads; t++){
+				if(t == tid)
+					offset[d] = sum + total;
+				total += sh->hist[t][d];
+			}
+			if(total == sh->tupleNum)
+				single = 1;
+			sum += total;
+		}
+
+		/* every key has the same digit, this pass would not move anything */
+		if(!single){
+			uint64_t *outKey = sh->key[1 - src];
+			uint32_t *outId = sh->id[1 - src];
+			for(unsigned long i = start; i < end; i++){
+				unsigned long pos = offset[(inKey[i] >> shift) & (RADIX_FANOUT - 1)]++;
+				outKey[pos] = inKey[i];
+				outId[pos] = inId[i];
+			}
+			src = 1 - src;
+		}
+
+		pthread_barrier_wait(&sh->barrier);
+	}
+
+	if(tid == 0)
+		sh->result = src;
+	pthread_barrier_wait(&sh->barrier);
+
+	const uint32_t *sorted = sh->id[sh->result];
+	unsigned long blocks = (sh->tupleNum + GATHER_BLOCK - 1) / GATHER_BLOCK;
+	unsigned long block;
+	while((block = __atomic_fetch_add(&sh->nextBlock, 1, __ATOMIC_RELAXED)) < blocks){
+		unsigned long from = block * GATHER_BLOCK;
+		unsigned long to = from + GATHER_BLOCK < sh->tupleNum ? from + GATHER_BLOCK : sh->tupleNum;
+		for(int c = 0; c < sh->columnTotal; c++)
+			gatherBlock(&sh->columns[c], sorted, from, to);
+	}
+#ifdef __SSE2__
+	_mm_sfence();
+#endif
+
+	return NULL;
+}
+
+/*
+ * Creates outPrefix0 .. outPrefix<columnTotal - 1> and writes the columns to
+ * them in the order of the keys built by build(ctx, ...), which must fit in
+ * keyBits bits. Rows with equal keys keep their input order. The output
+ * columns stay mapped in columns[i].out.
+ *
+ * Prerequisite:
+ * 	The memory is large enough to hold 24 bytes per row.
+ */
+static void sortColumns(struct column *columns, int columnTotal, unsigned long tupleNum, const char *outPrefix,
+		int keyBits, int threads, keyBuilder build, void *ctx){
+	char buf[4096];
+	if(threads < 1) threads = 1;
+	if(threads > MAX_THREADS) threads = MAX_THREADS;
+
+	struct sortShared *sh = (struct sortShared *) malloc(sizeof(struct sortShared));
+	CHECK_POINTER(sh);
+	for(int i = 0; i < 2; i++){
+		sh->key[i] = (uint64_t *) malloc(sizeof(uint64_t) * tupleNum);
+		sh->id[i] = (uint32_t *) malloc(sizeof(uint32_t) * tupleNum);
+		CHECK_POINTER(sh->key[i]);
+		CHECK_POINTER(sh->id[i]);
+	}
+	sh->tupleNum = tupleNum;
+	sh->passes = (keyBits + RADIX_BITS - 1) / RADIX_BITS;
+	sh->threads = threads;
+	sh->build = build;
+	sh->ctx = ctx;
+	sh->nextBlock = 0;
+	sh->result = 0;
+	pthread_barrier_init(&sh->barrier, NULL, threads);
+
+	for(int i = 0; i < columnTotal; i++){
+		snprintf(buf, sizeof(buf), "%s%d", outPrefix, i);
+		columns[i].out = (char *) createColumn(buf, (unsigned long) columns[i].tupleSize * tupleNum);
+	}
+	sh->columns = columns;
+	sh->columnTotal = columnTotal;
+
+	printf("%d key bits, %d passes, %d threads\n", keyBits, sh->passes, threads);
+
+	pthread_t tid[MAX_THREADS];
+	struct sortArg args[MAX_THREADS];
+	for(int t = 0; t < threads; t++){
+		args[t].tid = t;
+		args[t].shared = sh;
+		if(pthread_create(&tid[t], NULL, sortThread, &args[t]) != 0){
+			printf("Failed to create thread %d\n", t);
+			exit(-1);
+		}
+	}
+	for(int t = 0; t < threads; t++)
+		pthread_join(tid[t], NULL);
+
+	pthread_barrier_destroy(&sh->barrier);
+	for(int i = 0; i < 2; i++){
+		free(sh->key[i]);
+		free(sh->id[i]);
+	}
+	free(sh);
+}
+
+static void unmapTable(struct column *columns, int columnTotal, unsigned long tupleNum){
+	for(int i = 0; i < columnTotal; i++){
+		if(columns[i].out != NULL)
+			munmap(columns[i].out, (unsigned long) columns[i].tupleSize * tupleNum);
+		munmap(columns[i].data, columns[i].size);
+	}
+	free(columns);
+}
+
+#endif
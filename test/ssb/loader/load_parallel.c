@@ -0,0 +1,370 @@
+/*
+ * Parallel loader for the SSB .tbl files, writes the same columns as load_modified.c.
+ *
+ * The .tbl file is mapped and cut into newline-aligned chunks, one per thread.
+ * The threads first count the rows of their chunk, a prefix sum over the counts
+ * gives the first row of every chunk, and the threads then parse their chunk in
+ * place: fields are found with a SIMD delimiter search, integers are parsed
+ * without copying and every column is written through a large buffer with pwrite
+ * at the row offset of the chunk, so no thread waits for another.
+ *
+ * String columns are written zero-padded (or truncated) to the width of the field
+ * in include/schema.h. load_modified.c left the bytes after the terminator of the
+ * previous row in the padding.
+ */
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS       64
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <linux/limits.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "include/schema.h"
+#include "include/common.h"
+
+#define MAX_COLUMNS 17
+#define MAX_THREADS 256
+#define BUF_ROWS    (32 * 1024)   /* rows buffered per column before a pwrite */
+
+#define WIDTH(table, field) sizeof(((struct table *) 0)->field)
+#define COL_INT           {INT, sizeof(int)}
+#define COL_STR(t, f)     {STRING, WIDTH(t, f)}
+
+struct columnDef {
+  int type;
+  int width;
+};
+
+struct tableDef {
+  const char *name;
+  int columnNum;
+  struct columnDef columns[MAX_COLUMNS];
+};
+
+/* the dictionary encoded columns (convert.py) are integers */
+static const struct tableDef supplierDef = {"SUPPLIER", 7, {
+  COL_INT, COL_STR(supplier, s_name), COL_STR(supplier, s_address), COL_INT, COL_INT, COL_INT,
+  COL_STR(supplier, s_phone)}};
+
+static const struct tableDef customerDef = {"CUSTOMER", 8, {
+  COL_INT, COL_STR(customer, c_name), COL_STR(customer, c_address), COL_INT, COL_INT, COL_INT,
+  COL_STR(customer, c_phone), COL_STR(customer, c_mktsegment)}};
+
+static const struct tableDef partDef = {"PART", 9, {
+  COL_INT, COL_STR(part, p_name), COL_INT, COL_INT, COL_INT, COL_STR(part, p_color),
+  COL_STR(part, p_type), COL_INT, COL_STR(part, p_container)}};
+
+static const struct tableDef ddateDef = {"DDATE", 17, {
+  COL_INT, COL_STR(ddate, d_date), COL_STR(ddate, d_dayofweek), COL_STR(ddate, d_month), COL_INT,
+  COL_INT, COL_STR(ddate, d_yearmonth), COL_INT, COL_INT, COL_INT, COL_INT, COL_INT,
+  COL_STR(ddate, d_sellingseason), COL_STR(ddate, d_lastdayinweekfl), COL_STR(ddate, d_lastdayinmonthfl),
+  COL_STR(ddate, d_holidayfl), COL_STR(ddate, d_weekdayfl)}};
+
+static const struct tableDef lineorderDef = {"LINEORDER", 17, {
+  COL_INT, COL_INT, COL_INT, COL_INT, COL_INT, COL_INT, COL_STR(lineorder, lo_orderpriority),
+  COL_STR(lineorder, lo_shippriority), COL_INT, COL_INT, COL_INT, COL_INT, COL_INT, COL_INT,
+  COL_INT, COL_INT, COL_STR(lineorder, lo_shipmode)}};
+
+static char delimiter = '|';
+static int threadNum = 0;
+
+struct chunk {
+  const char *start;
+  const char *end;
+  long rows;
+  long offset;    /* first row of the chunk */
+};
+
+struct loadArg {
+  const struct tableDef *table;
+  struct chunk *chunk;
+  int *fd;
+};
+
+static double timeDiff(struct timeval *start, struct timeval *end){
+  return (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* first delimiter or newline in [p, end), end if there is none */
+static inline const char *nextDelimiter(const char *p, const char *end){
+#ifdef __SSE2__
+  const __m128i d = _mm_set1_epi8(delimiter);
+  const __m128i n = _mm_set1_epi8('\n');
+  while(p + 16 <= end){
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, n)));
+    if(mask)
+      return p + __builtin_ctz(mask);
+    p += 16;
+  }
+#endif
+  while(p < end && *p != delimiter && *p != '\n')
+    p++;
+  return p;
+}
+
+static long countNewlines(const char *p, const char *end){
+  long count = 0;
+#ifdef __SSE2__
+  const __m128i n = _mm_set1_epi8('\n');
+  while(p + 16 <= end){
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, n)));
+    p += 16;
+  }
+#endif
+  for(; p < end; p++)
+    count += (*p == '\n');
+  return count;
+}
+
+/* strtol on a field that is not terminated */
+static inline int parseInt(const char *p, const char *end){
+  long v = 0;
+  int neg = 0;
+  while(p < end && *p == ' ')
+    p++;
+  if(p < end && (*p == '-' || *p == '+'))
+    neg = (*p++ == '-');
+  for(; p < end && (unsigned) (*p - '0') < 10; p++)
+    v = v * 10 + (*p - '0');
+  return neg ? -v : v;
+}
+
+static void writeAll(int fd, const char *buf, size_t len, off_t offset){
+  while(len > 0){
+    ssize_t n = pwrite(fd, buf, len, offset);
+    if(n <= 0){
+      perror("Failed to write column");
+      exit(-1);
+    }
+    buf += n;
+    len -= n;
+    offset += n;
+  }
+}
+
+static void *countThread(void *param){
+  struct chunk *c = (struct chunk *) param;
+  c->rows = countNewlines(c->start, c->end);
+  /* the last line of the file may have no newline */
+  if(c->end > c->start && c->end[-1] != '\n')
+    c->rows++;
+  return NULL;
+}
+
+static void *parseThread(void *param){
+  struct loadArg *arg = (struct loadArg *) param;
+  const struct tableDef *t = arg->table;
+  const char *p = arg->chunk->start, *end = arg->chunk->end;
+  char *buf[MAX_COLUMNS];
+  long row = arg->chunk->offset, buffered = 0;
+
+  for(int i = 0; i < t->columnNum; i++){
+    buf[i] = (char *) malloc((size_t) BUF_ROWS * t->columns[i].width);
+    CHECK_POINTER(buf[i]);
+  }
+
+  while(p < end){
+    for(int i = 0; i < t->columnNum; i++){
+      const struct columnDef *col = &t->columns[i];
+      char *out = buf[i] + buffered * col->width;
+      const char *e = (p < end && *p != '\n') ? nextDelimiter(p, end) : p;
+
+      if(col->type == INT){
+        *(int *) out = parseInt(p, e);
+      }else{
+        long len = e - p < col->width ? e - p : col->width;
+        memcpy(out, p, len);
+        memset(out + len, 0, col->width - len);
+      }
+
+      /* a short line leaves the remaining columns empty */
+      p = (e < end && *e == delimiter) ? e + 1 : e;
+    }
+
+    /* skip the trailing delimiter and the newline */
+    while(p < end && *p != '\n')
+      p++;
+    p++;
+
+    if(++buffered == BUF_ROWS || p >= end){
+      for(int i = 0; i < t->columnNum; i++){
+        int w = t->columns[i].width;
+        writeAll(arg->fd[i], buf[i], (size_t) buffered * w, (off_t) row * w);
+      }
+      row += buffered;
+      buffered = 0;
+    }
+  }
+
+  for(int i = 0; i < t->columnNum; i++)
+    free(buf[i]);
+  return NULL;
+}
+
+static void loadTable(const char *inName, const struct tableDef *t){
+  struct timeval t0, t1;
+  gettimeofday(&t0, NULL);
+
+  int in = open(inName, O_RDONLY);
+  if(in == -1){
+    printf("Failed to open %s\n", inName);
+    exit(-1);
+  }
+  struct stat st;
+  fstat(in, &st);
+  size_t size = st.st_size;
+  const char *data = "";
+  if(size > 0){
+    data = (const char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, in, 0);
+    if(data == MAP_FAILED){
+      printf("Mmap failed for %s\n", inName);
+      exit(-1);
+    }
+    madvise((void *) data, size, MADV_SEQUENTIAL);
+  }
+  close(in);
+
+  /* newline-aligned chunks */
+  int threads = threadNum;
+  struct chunk chunks[MAX_THREADS];
+  const char *prev = data;
+  for(int i = 0; i < threads; i++){
+    const char *e = data + size * (i + 1) / threads;
+    if(e < prev) e = prev;
+    while(e < data + size && e > data && e[-1] != '\n')
+      e++;
+    chunks[i].start = prev;
+    chunks[i].end = e;
+    prev = e;
+  }
+
+  pthread_t tid[MAX_THREADS];
+  for(int i = 0; i < threads; i++)
+    pthread_create(&tid[i], NULL, countThread, &chunks[i]);
+  for(int i = 0; i < threads; i++)
+    pthread_join(tid[i], NULL);
+
+  long tupleNum = 0;
+  for(int i = 0; i < threads; i++){
+    chunks[i].offset = tupleNum;
+    tupleNum += chunks[i].rows;
+  }
+
+  int fd[MAX_COLUMNS];
+  for(int i = 0; i < t->columnNum; i++){
+    char path[PATH_MAX] = {0};
+    sprintf(path, "%s%d", t->name, i);
+    fd[i] = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd[i] == -1){
+      printf("Failed to open %s\n", path);
+      exit(-1);
+    }
+    if(ftruncate(fd[i], (off_t) tupleNum * t->columns[i].width) != 0){
+      printf("Failed to resize %s\n", path);
+      exit(-1);
+    }
+  }
+
+  struct loadArg args[MAX_THREADS];
+  for(int i = 0; i < threads; i++){
+    args[i].table = t;
+    args[i].chunk = &chunks[i];
+    args[i].fd = fd;
+    pthread_create(&tid[i], NULL, parseThread, &args[i]);
+  }
+  for(int i = 0; i < threads; i++)
+    pthread_join(tid[i], NULL);
+
+  for(int i = 0; i < t->columnNum; i++)
+    close(fd[i]);
+  if(size > 0)
+    munmap((void *) data, size);
+
+  gettimeofday(&t1, NULL);
+  double s = timeDiff(&t0, &t1);
+  printf("%s: %ld rows in %.2f s (%.0f MB/s), %d threads\n", t->name, tupleNum, s,
+    size / 1048576.0 / (s > 0 ? s : 1), threads);
+}
+
+int main(int argc, char ** argv){
+  int table;
+  int setPath = 0;
+  char path[PATH_MAX];
+  char cwd[PATH_MAX];
+  char in[PATH_MAX];
+
+  int long_index;
+  struct option long_options[] = {
+    {"supplier",required_argument,0,'0'},
+    {"customer",required_argument,0,'1'},
+    {"part",required_argument,0,'2'},
+    {"ddate",required_argument,0,'3'},
+    {"lineorder",required_argument,0,'4'},
+    {"delimiter",required_argument,0,'5'},
+    {"datadir",required_argument,0,'6'},
+    {"threads",required_argument,0,'7'},
+    {0,0,0,0}
+  };
+
+  threadNum = sysconf(_SC_NPROCESSORS_ONLN);
+  while((table=getopt_long(argc,argv,"",long_options,&long_index))!=-1){
+    switch(table){
+      case '5':
+        delimiter = optarg[0];
+        break;
+      case '6':
+        setPath = 1;
+        strcpy(path,optarg);
+        break;
+      case '7':
+        threadNum = atoi(optarg);
+        break;
+    }
+  }
+  if(threadNum < 1) threadNum = 1;
+  if(threadNum > MAX_THREADS) threadNum = MAX_THREADS;
+
+  optind=1;
+
+  getcwd(cwd,PATH_MAX);
+  while((table=getopt_long(argc,argv,"",long_options,&long_index))!=-1){
+    const struct tableDef *t = NULL;
+    switch(table){
+      case '0': t = &supplierDef; break;
+      case '1': t = &customerDef; break;
+      case '2': t = &partDef; break;
+      case '3': t = &ddateDef; break;
+      case '4': t = &lineorderDef; break;
+    }
+    if(t == NULL)
+      continue;
+
+    /* the input path is relative to the directory we were started in */
+    if(optarg[0] == '/')
+      snprintf(in, sizeof(in), "%s", optarg);
+    else
+      snprintf(in, sizeof(in), "%s/%s", cwd, optarg);
+
+    if (setPath == 1){
+      chdir(path);
+    }
+    loadTable(in, t);
+    if (setPath == 1){
+      chdir(cwd);
+    }
+  }
+
+  return 0;
+}
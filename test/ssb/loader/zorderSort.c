@@ -0,0 +1,325 @@
+
+/*
+   Copyright (c) 2012-2013 The Ohio State University.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#define _GNU_SOURCE
+
+#include "include/sortColumns.h"
+
+/*
+ * @file zorderSort.c
+ * Cluster the LINEORDER table on several dimension attributes at once.
+ *
+ * Every row gets the dimension attributes of its foreign keys (d_year,
+ * c_region, s_region, p_category). Their bits are interleaved into a
+ * Z-order or Hilbert key, followed by lo_orderdate to order rows in the same
+ * cell, and the table is sorted on that key (include/sortColumns.h). Rows of
+ * one segment then share few values of each attribute.
+ *
+ * Besides LINEORDERSORT<i>, the zone maps of the attributes over the sorted
+ * LINEORDER segments are written to lo_<attribute>minmax ("min max" per
+ * segment, like the <column>minmax files). The engine reads them in
+ * CacheManager::readSegmentMinMax and skips LINEORDER segments on dimension
+ * predicates in QueryOptimizer::checkPredicate.
+ */
+
+#define SEGMENT_SIZE	1048576	/* src/gpudb/common.h */
+#define LO_COLUMNS	17
+#define LO_ORDERDATE	5
+#define MAX_DIMS	8
+
+enum curveType{
+	ZORDER = 0,
+	HILBERT
+};
+
+struct dimAttr{
+	const char *name;	/* engine column name */
+	const char *table;	/* columnar file prefix */
+	int keyIndex;
+	int attrIndex;
+	int foreignKey;	/* LINEORDER column */
+
+	int *lookup;	/* attribute - attrMin by key - keyMin */
+	int keyMin;
+	int keyMax;
+	int attrMin;
+	int attrMax;
+	int bits;
+};
+
+static struct dimAttr dims[] = {
+	{"d_year", "DDATE", 0, 4, 5},
+	{"c_region", "CUSTOMER", 0, 5, 2},
+	{"s_region", "SUPPLIER", 0, 5, 4},
+	{"p_category", "PART", 0, 3, 3},
+};
+
+struct curveKey{
+	struct dimAttr *dims;
+	int dimNum;
+	int curve;
+	int curveBits;	/* bits per attribute for Hilbert */
+	const int *lineorder[LO_COLUMNS];
+	int dateMin;
+	int dateBits;
+};
+
+/* the attribute of row i, biased to start at 0 */
+static inline uint32_t attrOf(const struct dimAttr *d, const int *fk, unsigned long i){
+	return d->lookup[fk[i] - d->keyMin];
+}
+
+/* interleaves the bits MSB first, attributes with fewer bits drop out of the high levels */
+static uint64_t zorder(const uint32_t *v, const struct dimAttr *d, int n){
+	int levels = 0;
+	for(int j = 0; j < n; j++)
+		if(d[j].bits > levels) levels = d[j].bits;
+
+	uint64_t k = 0;
+	for(int l = levels - 1; l >= 0; l--)
+		for(int j = 0; j < n; j++)
+			if(l < d[j].bits)
+				k = (k << 1) | ((v[j] >> l) & 1);
+	return k;
+}
+
+/*
+ * Hilbert index of n coordinates of b bits each: Skilling's transform of the
+ * coordinates to the transposed index, whose bits are then interleaved.
+ */
+static uint64_t hilbert(uint32_t *x, int n, int b){
+	uint32_t M = 1u << (b - 1), P, Q, t;
+
+	/* inverse undo */
+	for(Q = M; Q > 1; Q >>= 1){
+		P = Q - 1;
+		for(int i = 0; i < n; i++){
+			if(x[i] & Q){
+				x[0] ^= P;
+			}else{
+				t = (x[0] ^ x[i]) & P;
+				x[0] ^= t;
+				x[i] ^= t;
+			}
+		}
+	}
+
+	/* Gray encode */
+	for(int i = 1; i < n; i++)
+		x[i] ^= x[i - 1];
+	t = 0;
+	for(Q = M; Q > 1; Q >>= 1)
+		if(x[n - 1] & Q)
+			t ^= Q - 1;
+	for(int i = 0; i < n; i++)
+		x[i] ^= t;
+
+	uint64_t k = 0;
+	for(int l = b - 1; l >= 0; l--)
+		for(int i = 0; i < n; i++)
+			k = (k << 1) | ((x[i] >> l) & 1);
+	return k;
+}
+
+static void buildKey(void *ctx, uint64_t *key, unsigned long start, unsigned long end){
+	struct curveKey *ck = (struct curveKey *) ctx;
+	const int *date = ck->lineorder[LO_ORDERDATE];
+	uint32_t v[MAX_DIMS];
+
+	for(unsigned long i = start; i < end; i++){
+		for(int j = 0; j < ck->dimNum; j++)
+			v[j] = attrOf(&ck->dims[j], ck->lineorder[ck->dims[j].foreignKey], i);
+
+		uint64_t k;
+		if(ck->curve == HILBERT)
+			k = hilbert(v, ck->dimNum, ck->curveBits);
+		else
+			k = zorder(v, ck->dims, ck->dimNum);
+
+		key[i] = (k << ck->dateBits) | (uint32_t) (date[i] - ck->dateMin);
+	}
+}
+
+/* maps the key and attribute columns of a dimension and builds the key to attribute lookup */
+static void loadDim(const char *dataDir, struct dimAttr *d){
+	char buf[4096];
+	unsigned long keySize, attrSize;
+
+	snprintf(buf, sizeof(buf), "%s%s%d", dataDir, d->table, d->keyIndex);
+	const int *keys = (const int *) mapColumn(buf, &keySize);
+	snprintf(buf, sizeof(buf), "%s%s%d", dataDir, d->table, d->attrIndex);
+	const int *attrs = (const int *) mapColumn(buf, &attrSize);
+
+	unsigned long len = keySize / sizeof(int);
+	if(attrSize / sizeof(int) != len){
+		printf("%s: key and attribute columns differ in length\n", d->name);
+		exit(-1);
+	}
+
+	minMax(keys, len, &d->keyMin, &d->keyMax);
+	minMax(attrs, len, &d->attrMin, &d->attrMax);
+	d->bits = bitsOf((uint32_t) (d->attrMax - d->attrMin));
+	if(d->bits == 0)
+		d->bits = 1;
+
+	unsigned long range = (unsigned long) (d->keyMax - d->keyMin) + 1;
+	d->lookup = (int *) calloc(range, sizeof(int));
+	CHECK_POINTER(d->lookup);
+	for(unsigned long i = 0; i < len; i++)
+		d->lookup[keys[i] - d->keyMin] = attrs[i] - d->attrMin;
+
+	munmap((void *) keys, keySize);
+	munmap((void *) attrs, attrSize);
+}
+
+/* foreign keys outside the dimension would read past the lookup */
+static void checkForeignKeys(const struct dimAttr *d, const int *fk, unsigned long tupleNum){
+	int min, max;
+	minMax(fk, tupleNum, &min, &max);
+	if(min < d->keyMin || max > d->keyMax){
+		printf("%s: foreign keys [%d, %d] outside of the dimension keys [%d, %d]\n", d->name, min, max, d->keyMin, d->keyMax);
+		exit(-1);
+	}
+}
+
+/* per segment min and max of the attribute over the sorted LINEORDER */
+static void writeZoneMap(const char *dataDir, const struct dimAttr *d, const int *fk, unsigned long tupleNum){
+	char buf[4096];
+	snprintf(buf, sizeof(buf), "%slo_%sminmax", dataDir, d->name);
+	FILE *out = fopen(buf, "w");
+	if(out == NULL){
+		printf("Failed to create %s\n", buf);
+		exit(-1);
+	}
+
+	unsigned long segments = (tupleNum + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+	unsigned long width = 0;
+	for(unsigned long s = 0; s < segments; s++){
+		unsigned long from = s * SEGMENT_SIZE;
+		unsigned long to = from + SEGMENT_SIZE < tupleNum ? from + SEGMENT_SIZE : tupleNum;
+		uint32_t min = attrOf(d, fk, from), max = min;
+		for(unsigned long i = from + 1; i < to; i++){
+			uint32_t v = attrOf(d, fk, i);
+			if(v < min) min = v;
+			if(v > max) max = v;
+		}
+		fprintf(out, "%d %d\n", (int) min + d->attrMin, (int) max + d->attrMin);
+		width += max - min + 1;
+	}
+	fclose(out);
+
+	printf("%s: a segment spans %.1f of %d values on average\n", d->name,
+		(double) width / segments, d->attrMax - d->attrMin + 1);
+}
+
+/*
+ * Input:
+ * 	@dataDir: the directory of the columnar tables (with the trailing '/').
+ *	@columnSize: the number of LINEORDER rows.
+ *	@curve: optional, zorder (default) or hilbert.
+ *	@threads: optional, worker threads (default: all online CPUs).
+ *
+ * Output:
+ *	dataDir/LINEORDERSORT<i> and dataDir/lo_<attribute>minmax.
+ *
+ * Prerequisite:
+ * 	The memory is large enough to hold 24 bytes per row and the lookups of
+ * 	the dimension keys.
+ */
+
+//	./zorderSort ../data/s40_columnar/ 240012412
+//	./zorderSort ../data/s160_columnar/ 960017453 hilbert
+
+int main(int argc, char **argv){
+
+	if(argc < 3 || argc > 5){
+		printf("./zorderSort dataDir columnSize [zorder|hilbert] [threads]\n");
+		exit(-1);
+	}
+
+	const char *dataDir = argv[1];
+	unsigned long tupleNum = atol(argv[2]);
+	int curve = ZORDER;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if(argc > 3){
+		if(strcmp(argv[3], "hilbert") == 0)
+			curve = HILBERT;
+		else if(strcmp(argv[3], "zorder") != 0){
+			printf("Unknown curve %s\n", argv[3]);
+			exit(-1);
+		}
+	}
+	if(argc > 4)
+		threads = atoi(argv[4]);
+
+	char buf[4096];
+	struct timeval t0, t1, t2;
+	gettimeofday(&t0, NULL);
+
+	snprintf(buf, sizeof(buf), "%sLINEORDER", dataDir);
+	struct column *columns = mapTable(buf, LO_COLUMNS - 1, tupleNum);
+
+	struct curveKey ck;
+	ck.dims = dims;
+	ck.dimNum = sizeof(dims) / sizeof(dims[0]);
+	ck.curve = curve;
+	ck.curveBits = 0;
+	for(int i = 0; i < LO_COLUMNS; i++)
+		ck.lineorder[i] = (const int *) columns[i].data;
+
+	int curveBits = 0;
+	for(int j = 0; j < ck.dimNum; j++){
+		struct dimAttr *d = &dims[j];
+		if(columns[d->foreignKey].tupleSize != sizeof(int)){
+			printf("%s: the foreign key is not an integer column\n", d->name);
+			exit(-1);
+		}
+		loadDim(dataDir, d);
+		checkForeignKeys(d, ck.lineorder[d->foreignKey], tupleNum);
+		if(d->bits > ck.curveBits)
+			ck.curveBits = d->bits;
+		curveBits += d->bits;
+	}
+	if(curve == HILBERT)
+		curveBits = ck.curveBits * ck.dimNum;
+
+	int dateMax;
+	minMax(ck.lineorder[LO_ORDERDATE], tupleNum, &ck.dateMin, &dateMax);
+	ck.dateBits = bitsOf((uint32_t) (dateMax - ck.dateMin));
+
+	printf("Clustering %lu rows on a %s key of", tupleNum, curve == HILBERT ? "Hilbert" : "Z-order");
+	for(int j = 0; j < ck.dimNum; j++)
+		printf(" %s (%d bits)", dims[j].name, curve == HILBERT ? ck.curveBits : dims[j].bits);
+	printf(" then lo_orderdate: ");
+
+	snprintf(buf, sizeof(buf), "%sLINEORDERSORT", dataDir);
+	sortColumns(columns, LO_COLUMNS, tupleNum, buf, curveBits + ck.dateBits, threads, buildKey, &ck);
+
+	gettimeofday(&t1, NULL);
+
+	for(int j = 0; j < ck.dimNum; j++)
+		writeZoneMap(dataDir, &dims[j], (const int *) columns[dims[j].foreignKey].out, tupleNum);
+
+	unmapTable(columns, LO_COLUMNS, tupleNum);
+	for(int j = 0; j < ck.dimNum; j++)
+		free(dims[j].lookup);
+
+	gettimeofday(&t2, NULL);
+	printf("Clustering done: sort and gather %.1f ms, zone maps and unmap %.1f ms\n", timeDiff(&t0, &t1), timeDiff(&t1, &t2));
+
+	return 0;
+}
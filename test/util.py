@@ -21,6 +21,14 @@ def gen_data(dataset, scale_factor):
         os.system('mkdir -p ../data/s%d' % scale_factor)
         os.system('mv *.tbl ../data/s%d/' % scale_factor)
 
+def stream(dataset, scale_factor):
+    # generate straight into the columnar layout, one dbgen process per CPU
+    path = './' + dataset + '/dbgen/'
+    op = '../data/s%d_columnar/' % scale_factor
+    with cd(path):
+        os.system('mkdir -p %s' % op)
+        os.system('DSS_PATH=%s ./dbgen -s %d -T a -D -f -C %d' % (op, scale_factor, os.cpu_count()))
+
 def transform(dataset, scale_factor):
     path = './' + dataset + '/loader/'
     ip = '../data/s%d/' % scale_factor
@@ -34,11 +42,13 @@ if __name__ == "__main__":
     parser = argparse.ArgumentParser(description = 'data gen')
     parser.add_argument('dataset', type=str, choices=['ssb'])
     parser.add_argument('scale_factor', type=int)
-    parser.add_argument('action', type=str, choices=['gen', 'transform'])
+    parser.add_argument('action', type=str, choices=['gen', 'transform', 'stream'])
     args = parser.parse_args()
 
     if args.action == 'gen':
         gen_data(args.dataset, args.scale_factor)
     elif args.action == 'transform':
         transform(args.dataset, args.scale_factor)
+    elif args.action == 'stream':
+        stream(args.dataset, args.scale_factor)
 